@@ -0,0 +1,146 @@
+// bench/EffectsBenchmark.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Стоимость узлов эффектов и полной цепочки на один период.
+// Сигнал затухает в тишину: так проверяется и защита от денормализованных чисел.
+
+#include "Effects.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <vector>
+
+namespace {
+
+constexpr float kSampleRate = 48000.0f;
+constexpr size_t kIterations = 4000;
+
+using ChainFactory = std::function<std::unique_ptr<EffectChain>()>;
+
+void fillPeriod(std::vector<float>* pBuffer, size_t periodFrames, size_t iteration)
+{
+    // Первая половина прогонов — тон, вторая — тишина с хвостом реверберации
+    const bool isSilent = iteration >= kIterations / 2;
+    for (size_t i = 0; i < periodFrames; ++i) {
+        const double t = static_cast<double>(iteration * periodFrames + i) / kSampleRate;
+        const float value = isSilent ? 0.0f : static_cast<float>(0.3 * std::sin(2.0 * std::numbers::pi * 220.0 * t));
+        (*pBuffer)[i * 2] = value;
+        (*pBuffer)[i * 2 + 1] = value;
+    }
+}
+
+void run(const char* name, const ChainFactory& factory, size_t periodFrames)
+{
+    EffectChainSlot slot;
+    slot.publish(factory());
+    std::vector<float> buffer(periodFrames * 2);
+    std::vector<double> timings;
+    timings.reserve(kIterations);
+
+    for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+        fillPeriod(&buffer, periodFrames, iteration);
+        const auto start = std::chrono::steady_clock::now();
+        slot.process(buffer.data(), periodFrames);
+        timings.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    double total = 0.0;
+    for (double timing : timings) {
+        total += timing;
+    }
+    std::sort(timings.begin(), timings.end());
+    const double average = total / kIterations;
+    const double p99 = timings[kIterations * 99 / 100];
+    const double budget = periodFrames * 1.0e6 / kSampleRate;
+    std::printf("%-10s %-8zu %10.2f %10.2f %9.2f%%\n", name, periodFrames, average, p99, 100.0 * average / budget);
+}
+
+} // namespace
+
+int main()
+{
+    const struct {
+        const char* name;
+        ChainFactory factory;
+    } chains[] = {
+        {"highpass", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighPass, kSampleRate, 80.0f));
+             return chain;
+         }},
+        {"eq3", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::LowShelf, kSampleRate, 200.0f, 3.0f));
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::Peaking, kSampleRate, 1000.0f, -4.0f, 1.0f));
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighShelf, kSampleRate, 4000.0f, 2.0f));
+             return chain;
+         }},
+        {"bitcrush", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<BitcrushEffect>(kSampleRate, 8.0f, 4.0f, 1.0f));
+             return chain;
+         }},
+        {"robot", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<RobotVoiceEffect>(kSampleRate, 50.0f, 1.0f));
+             return chain;
+         }},
+        {"reverb", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<ReverbEffect>(kSampleRate, 0.6f, 0.4f, 0.25f));
+             return chain;
+         }},
+        {"gate", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<NoiseGateEffect>(kSampleRate, -45.0f));
+             return chain;
+         }},
+        {"denoise", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<NoiseSuppressor>(kSampleRate, 12.0f));
+             return chain;
+         }},
+        {"full", [] {
+             auto chain = std::make_unique<EffectChain>();
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighPass, kSampleRate, 80.0f));
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::LowShelf, kSampleRate, 200.0f, 3.0f));
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::Peaking, kSampleRate, 1000.0f, -4.0f, 1.0f));
+             chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighShelf, kSampleRate, 4000.0f, 2.0f));
+             chain->append(std::make_unique<BitcrushEffect>(kSampleRate, 8.0f, 4.0f, 1.0f));
+             chain->append(std::make_unique<RobotVoiceEffect>(kSampleRate, 50.0f, 1.0f));
+             chain->append(std::make_unique<ReverbEffect>(kSampleRate, 0.6f, 0.4f, 0.25f));
+             return chain;
+         }},
+    };
+    const size_t periods[] = {128, 256, 480};
+
+    std::printf("%-10s %-8s %10s %10s %10s\n", "chain", "period", "avg us", "p99 us", "of period");
+    for (const auto& chain : chains) {
+        for (size_t periodFrames : periods) {
+            run(chain.name, chain.factory, periodFrames);
+        }
+    }
+    return 0;
+}
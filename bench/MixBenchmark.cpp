@@ -0,0 +1,168 @@
+// bench/MixBenchmark.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Масштабирование ParallelMixer по ядрам: N голосов с растяжением и эквалайзером
+// сводятся за период на 0..M рабочих потоках. Голос устроен как дека движка —
+// своя полоса буфера, сумма в порядке голосов, — поэтому выход сверяется побитово
+// с однопоточным прогоном.
+
+#include "ParallelMixer.h"
+#include "TimeStretcher.h"
+#include "Effects.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSampleRate = 48000;
+constexpr size_t kSourceFrames = kSampleRate * 2;
+constexpr size_t kPeriodFrames = 256;
+constexpr size_t kIterations = 2000;
+
+struct Voice {
+    std::vector<float> source;
+    size_t position = 0;
+    TimeStretcher stretcher;
+    EffectChainSlot effects;
+};
+
+struct Mix {
+    std::vector<std::unique_ptr<Voice>> voices;
+    std::vector<float> lanes; // Полоса на голос, как m_deckBuffer движка
+};
+
+size_t readLooped(void* pUserData, float* pOut, size_t frameCount)
+{
+    Voice* pVoice = static_cast<Voice*>(pUserData);
+    for (size_t i = 0; i < frameCount; ++i) {
+        pOut[i * 2] = pVoice->source[pVoice->position * 2];
+        pOut[i * 2 + 1] = pVoice->source[pVoice->position * 2 + 1];
+        pVoice->position = (pVoice->position + 1) % kSourceFrames;
+    }
+    return frameCount;
+}
+
+void renderJob(void* pContext, int job)
+{
+    Mix* pMix = static_cast<Mix*>(pContext);
+    Voice* pVoice = pMix->voices[job].get();
+    float* pLane = pMix->lanes.data() + static_cast<size_t>(job) * kPeriodFrames * 2;
+    pVoice->stretcher.render(pLane, kPeriodFrames, readLooped, pVoice);
+    pVoice->effects.process(pLane, kPeriodFrames);
+}
+
+std::unique_ptr<Mix> makeMix(int voiceCount)
+{
+    auto mix = std::make_unique<Mix>();
+    mix->lanes.resize(static_cast<size_t>(voiceCount) * kPeriodFrames * 2);
+    for (int v = 0; v < voiceCount; ++v) {
+        auto voice = std::make_unique<Voice>();
+        // У каждого голоса своя нота и свой темп: склейки WSOLA не совпадают по периодам
+        const double frequency = 110.0 * std::pow(2.0, (v % 24) / 12.0);
+        voice->source.resize(kSourceFrames * 2);
+        for (size_t i = 0; i < kSourceFrames; ++i) {
+            const double t = static_cast<double>(i) / kSampleRate;
+            const float value = static_cast<float>(0.2 * std::sin(2.0 * std::numbers::pi * frequency * t));
+            voice->source[i * 2] = value;
+            voice->source[i * 2 + 1] = value;
+        }
+        voice->stretcher.setParameters(0.8f + 0.05f * (v % 8), (v % 3) * 2.0f);
+
+        auto chain = std::make_unique<EffectChain>();
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::LowShelf, float(kSampleRate), 200.0f, 3.0f));
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::Peaking, float(kSampleRate), 1000.0f, -4.0f, 1.0f));
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighShelf, float(kSampleRate), 4000.0f, 2.0f));
+        voice->effects.publish(std::move(chain));
+        mix->voices.push_back(std::move(voice));
+    }
+    return mix;
+}
+
+// Возвращает среднее и p99 в микросекундах; pOutput — последний период для сверки
+void run(int voiceCount, int workerCount, double* pAverage, double* pP99, std::vector<float>* pOutput)
+{
+    std::unique_ptr<Mix> mix = makeMix(voiceCount);
+    ParallelMixer mixer;
+    mixer.start(workerCount, false);
+    std::vector<float> output(kPeriodFrames * 2);
+    std::vector<double> timings(kIterations);
+
+    for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+        const auto start = std::chrono::steady_clock::now();
+        mixer.run(voiceCount, renderJob, mix.get());
+        std::fill(output.begin(), output.end(), 0.0f);
+        for (int v = 0; v < voiceCount; ++v) {
+            const float* pLane = mix->lanes.data() + static_cast<size_t>(v) * kPeriodFrames * 2;
+            for (size_t i = 0; i < output.size(); ++i) {
+                output[i] += pLane[i];
+            }
+        }
+        timings[iteration] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double total = 0.0;
+    for (double timing : timings) {
+        total += timing;
+    }
+    std::sort(timings.begin(), timings.end());
+    *pAverage = total / kIterations;
+    *pP99 = timings[kIterations * 99 / 100];
+    *pOutput = output;
+}
+
+} // namespace
+
+int main()
+{
+    const int cpuCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int maxWorkers = std::min(cpuCount - 1, ParallelMixer::kMaxWorkers);
+    const int voiceCounts[] = {4, 16, 64, 128};
+    const double periodMicros = 1e6 * static_cast<double>(kPeriodFrames) / kSampleRate;
+
+    std::printf("cores %d, period %zu frames (%.0f us)\n", cpuCount, kPeriodFrames, periodMicros);
+    std::printf("%-8s %-8s %10s %10s %10s %10s %8s\n", "voices", "workers", "avg us", "p99 us", "of period",
+                "speedup", "exact");
+    for (int voiceCount : voiceCounts) {
+        double serialAverage = 0.0;
+        std::vector<float> serialOutput;
+        for (int workerCount = 0; workerCount <= maxWorkers; ++workerCount) {
+            double average = 0.0;
+            double p99 = 0.0;
+            std::vector<float> output;
+            run(voiceCount, workerCount, &average, &p99, &output);
+            if (workerCount == 0) {
+                serialAverage = average;
+                serialOutput = output;
+            }
+            const bool isExact = std::memcmp(output.data(), serialOutput.data(), output.size() * sizeof(float)) == 0;
+            std::printf("%-8d %-8d %10.2f %10.2f %9.1f%% %9.2fx %8s\n", voiceCount, workerCount, average, p99,
+                        100.0 * average / periodMicros, serialAverage / average, isExact ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
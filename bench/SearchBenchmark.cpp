@@ -0,0 +1,104 @@
+// bench/SearchBenchmark.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Время одного нажатия клавиши в поиске по 100 000 трекам: запрос набирается по букве,
+// после каждой буквы выполняется полный поиск, как в строке поиска окна.
+
+#include "SearchIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kTrackCount = 100000;
+
+const char* const kWords[] = {
+    "kick", "snare", "clap", "airhorn", "applause", "laugh", "boo", "drumroll", "rimshot", "crickets",
+    "wow", "sad", "trombone", "bruh", "vine", "boom", "alert", "siren", "bell", "whoosh",
+    "intro", "outro", "theme", "jingle", "sting", "transition", "riser", "impact", "glitch", "scratch",
+};
+const char* const kFolders[] = {"memes", "drums", "fx", "music", "voices", "stingers", "ambience", "games"};
+
+std::u16string widen(const std::string& text)
+{
+    return std::u16string(text.begin(), text.end());
+}
+
+// Имя, теги и путь трека в том виде, в каком их индексирует окно
+std::u16string makeTrack(std::mt19937& random)
+{
+    std::uniform_int_distribution<size_t> word(0, std::size(kWords) - 1);
+    std::uniform_int_distribution<size_t> folder(0, std::size(kFolders) - 1);
+    std::uniform_int_distribution<int> number(1, 999);
+    const std::string name = std::string(kWords[word(random)]) + "_" + kWords[word(random)] + "_" +
+                             std::to_string(number(random)) + ".wav";
+    // Папка берется относительно библиотеки: общий для всех префикс пути не индексируется
+    const std::string folders = std::string(kFolders[folder(random)]) + "/" + kFolders[folder(random)];
+    return widen(name + " " + kWords[word(random)] + " " + folders);
+}
+
+void typeQuery(SearchIndex* pIndex, const char* query)
+{
+    const std::u16string fullQuery = widen(query);
+    double totalMicros = 0.0;
+    double worstMicros = 0.0;
+    size_t matchCount = 0;
+    for (size_t length = 1; length <= fullQuery.size(); ++length) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<SearchIndex::Id> best = pIndex->search(std::u16string_view(fullQuery).substr(0, length), 20);
+        const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        totalMicros += micros;
+        worstMicros = std::max(worstMicros, micros);
+        if (length == fullQuery.size()) {
+            matchCount = 0;
+            for (SearchIndex::Id id = 0; id < kTrackCount; ++id) {
+                matchCount += pIndex->matches(id) ? 1 : 0;
+            }
+        }
+    }
+    std::printf("%-22s %3zu keystrokes  mean %7.1f us  worst %7.1f us  %6zu matches\n",
+                query, fullQuery.size(), totalMicros / fullQuery.size(), worstMicros, matchCount);
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(42);
+    SearchIndex index;
+    const auto buildStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kTrackCount; ++i) {
+        index.add(makeTrack(random));
+    }
+    const double buildMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    std::printf("Indexed %zu tracks in %.1f ms\n\n", kTrackCount, buildMillis);
+
+    typeQuery(&index, "airhorn");
+    typeQuery(&index, "airhron");        // Опечатка
+    typeQuery(&index, "sad trombone 42");
+    typeQuery(&index, "memes boom");
+    typeQuery(&index, "wav");            // Есть почти у всех треков — худший случай
+    return 0;
+}
@@ -0,0 +1,119 @@
+// bench/StretchBenchmark.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Сколько растянутых голосов укладывается в один период на одном ядре.
+// Источник — заранее посчитанный сигнал, поэтому измеряется только TimeStretcher.
+
+#include "TimeStretcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+namespace {
+
+constexpr size_t kSampleRate = 48000;
+constexpr size_t kSourceFrames = kSampleRate * 4;
+
+struct Source {
+    const std::vector<float>* pFrames;
+    size_t position;
+};
+
+size_t readLooped(void* pUserData, float* pOut, size_t frameCount)
+{
+    Source* pSource = static_cast<Source*>(pUserData);
+    for (size_t i = 0; i < frameCount; ++i) {
+        pOut[i * 2] = (*pSource->pFrames)[pSource->position * 2];
+        pOut[i * 2 + 1] = (*pSource->pFrames)[pSource->position * 2 + 1];
+        pSource->position = (pSource->position + 1) % kSourceFrames;
+    }
+    return frameCount;
+}
+
+std::vector<float> makeSignal()
+{
+    // Аккорд с медленной амплитудной модуляцией: корреляционный поиск не вырождается
+    std::vector<float> frames(kSourceFrames * 2);
+    for (size_t i = 0; i < kSourceFrames; ++i) {
+        const double t = static_cast<double>(i) / kSampleRate;
+        const double envelope = 0.6 + 0.4 * std::sin(2.0 * std::numbers::pi * 3.0 * t);
+        const double value = envelope * (0.3 * std::sin(2.0 * std::numbers::pi * 220.0 * t) +
+                                         0.2 * std::sin(2.0 * std::numbers::pi * 277.2 * t) +
+                                         0.1 * std::sin(2.0 * std::numbers::pi * 329.6 * t));
+        frames[i * 2] = static_cast<float>(value);
+        frames[i * 2 + 1] = static_cast<float>(value * 0.9);
+    }
+    return frames;
+}
+
+} // namespace
+
+int main()
+{
+    const std::vector<float> signal = makeSignal();
+    const size_t periods[] = {128, 256, 480};
+    const float settings[][2] = {{1.25f, 0.0f}, {0.75f, 0.0f}, {1.0f, 7.0f}, {1.0f, -12.0f}, {2.0f, -12.0f}};
+
+    std::printf("%-8s %-8s %-8s %10s %10s %10s %10s\n", "period", "tempo", "pitch",
+                "avg us", "p99 us", "staggered", "aligned");
+    for (size_t periodFrames : periods) {
+        const double periodMicros = 1e6 * static_cast<double>(periodFrames) / kSampleRate;
+        std::vector<float> output(periodFrames * 2);
+
+        for (const auto& setting : settings) {
+            TimeStretcher stretcher;
+            stretcher.setParameters(setting[0], setting[1]);
+            Source source{&signal, 0};
+
+            // Прогрев: первые вызовы заполняют внутренние буферы
+            for (int i = 0; i < 100; ++i) {
+                stretcher.render(output.data(), periodFrames, readLooped, &source);
+            }
+
+            // Десять секунд звука с замером каждого периода. Склейка WSOLA приходится
+            // примерно на каждый 1536-й выходной кадр, поэтому стоимость периодов неравномерна:
+            // staggered — голоса запущены в разное время и склейки распределены (по среднему),
+            // aligned — все голоса запущены одновременно и склеиваются в одном периоде (по p99)
+            const size_t iterations = 10 * kSampleRate / periodFrames;
+            std::vector<double> timings(iterations);
+            for (size_t i = 0; i < iterations; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                stretcher.render(output.data(), periodFrames, readLooped, &source);
+                timings[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            double totalMicros = 0.0;
+            for (double micros : timings) {
+                totalMicros += micros;
+            }
+            const double averageMicros = totalMicros / iterations;
+            std::sort(timings.begin(), timings.end());
+            const double p99Micros = timings[iterations * 99 / 100];
+
+            std::printf("%-8zu %-8.2f %-+8.1f %10.2f %10.2f %10.0f %10.0f\n", periodFrames, setting[0], setting[1],
+                        averageMicros, p99Micros, periodMicros / averageMicros, periodMicros / p99Micros);
+        }
+    }
+    return 0;
+}
@@ -19,230 +19,2284 @@
  */
 
 #include "AudioEngine.h"
-#include <QDebug>
+#include "Log.h"
 #include <QMetaObject> // Для безопасного вызова методов между потоками
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QSet>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <numbers>
 
-#define MA_DEBUG_OUTPUT
 #define MA_IMPLEMENTATION
 #include "miniaudio.h"
 
+namespace {
+
+// Сколько самых частых клипов держать в хранилище дольше остальных (в пределах половины бюджета)
+const int kPreferredSounds = 32;
+
+// Сообщения miniaudio идут в общий журнал; из потока устройства они отбрасываются
+void miniaudioLogCallback(void*, ma_uint32 level, const char* pMessage)
+{
+    const Log::Level logLevel = level == MA_LOG_LEVEL_ERROR ? Log::Error
+                              : level == MA_LOG_LEVEL_WARNING ? Log::Warning
+                              : level == MA_LOG_LEVEL_INFO ? Log::Info
+                              : Log::Debug;
+    if (!Log::isEnabled(logLevel, Log::Device)) {
+        return;
+    }
+    // У miniaudio сообщения заканчиваются переводом строки, в журнале он лишний
+    int length = static_cast<int>(std::strlen(pMessage));
+    while (length > 0 && (pMessage[length - 1] == '\n' || pMessage[length - 1] == '\r')) {
+        --length;
+    }
+    Log::write(logLevel, Log::Device, "miniaudio: %.*s", length, pMessage);
+}
+
+} // namespace
+
 void AudioEngine::dataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
 {
     AudioEngine* engine = static_cast<AudioEngine*>(pDevice->pUserData);
     if (engine == nullptr) {
         return;
     }
+    Log::markRealtimeThread(); // Поток устройства может смениться при переоткрытии, поэтому на каждом вызове
+
+    // Скользящее среднее интервала между вызовами — реальный период устройства
+    const qint64 now = clockNanoseconds();
+    const qint64 lastCallback = engine->m_lastCallbackNs.exchange(now);
+    if (lastCallback != 0) {
+        const qint64 interval = now - lastCallback;
+        const qint64 average = engine->m_callbackIntervalNs.load();
+        engine->m_callbackIntervalNs.store(average == 0 ? interval : average + (interval - average) / 8);
+    }
+
+    float* pFrames = static_cast<float*>(pOutput);
+    int activeVoices = 0;
+    int streamedVoices = 0;
+    engine->mixBlock(pFrames, static_cast<const float*>(pInput), frameCount, now, &activeVoices, &streamedVoices);
+    engine->m_outputRecorder->capture(pFrames, frameCount); // Только копия в кольцо: диск ждет не колбэк
+
+    engine->m_stats.recordCallback(clockNanoseconds() - now, lastCallback != 0 ? now - lastCallback : 0,
+                                   frameCount, pDevice->sampleRate, activeVoices, streamedVoices);
+
+    // Главный поток по этому счетчику понимает, что снятый голос больше не используется
+    engine->m_callbackSerial.fetch_add(1, std::memory_order_release);
+}
+
+void AudioEngine::mixBlock(float* pOutput, const float* pInput, ma_uint32 frameCount, qint64 now,
+                           int* pActiveVoices, int* pStreamedVoices)
+{
+    ma_silence_pcm_frames(pOutput, frameCount, ma_format_f32, kEngineChannels);
+
+    // Запуски из triggerSound() встают на деки до сбора заданий блока
+    for (Deck& deck : m_decks) {
+        if (Voice* pTriggered = deck.pTriggeredVoice.exchange(nullptr, std::memory_order_acquire)) {
+            startTriggeredVoice(&deck, pTriggered);
+        }
+    }
+
+    // Играющие деки — задания блока. Голоса независимы, поэтому их можно рендерить на пуле
+    int jobCount = 0;
+    for (int deck = 0; deck < kDeckCount; ++deck) {
+        Voice* pVoice = playingVoice(m_decks[deck]);
+        if (pVoice == nullptr || pVoice->isFinished.load(std::memory_order_relaxed) || m_decks[deck].isPaused.load()) {
+            continue;
+        }
+        ++*pActiveVoices;
+        *pStreamedVoices += pVoice->pDecoder != nullptr ? 1 : 0;
+        m_deckJobs[jobCount].pVoice = pVoice;
+        m_deckJobs[jobCount].durationNs = 0;
+        ++jobCount;
+    }
+
+    // Каждая дека рендерится кусками в свою полосу рабочего буфера; сумма идет в порядке дек,
+    // поэтому выход не зависит от того, на каком потоке и в каком порядке считались голоса
+    const ma_uint32 chunkFrames = static_cast<ma_uint32>(m_deckBuffer.size() / (kDeckCount * kEngineChannels));
+    for (ma_uint32 offset = 0; offset < frameCount && jobCount > 0; offset += chunkFrames) {
+        const ma_uint32 framesInChunk = std::min(chunkFrames, frameCount - offset);
+        const size_t sampleCount = static_cast<size_t>(framesInChunk) * kEngineChannels;
+        float* pChunk = pOutput + static_cast<size_t>(offset) * kEngineChannels;
+        m_jobFrames = framesInChunk;
+        m_jobNow = now;
+
+        int expected = ParallelIdle;
+        if (m_isParallelActive && jobCount > 1 && m_parallelState.compare_exchange_strong(expected, ParallelBusy)) {
+            m_parallelMixer.run(jobCount, renderDeckJob, this);
+            m_parallelState.store(ParallelIdle);
+        } else {
+            for (int job = 0; job < jobCount; ++job) {
+                renderDeckJob(this, job);
+            }
+        }
+
+        for (int job = 0; job < jobCount; ++job) {
+            if (!m_deckJobs[job].isRendered) {
+                continue;
+            }
+            const float* pDeckFrames = m_deckBuffer.data() + static_cast<size_t>(job) * chunkFrames * kEngineChannels;
+            for (size_t i = 0; i < sampleCount; ++i) {
+                pChunk[i] += pDeckFrames[i];
+            }
+        }
+    }
+    updateParallelMode(jobCount, frameCount);
+
+    // Дуплексный режим: микрофон проходит через свою шину и подмешивается к звукам
+    if (pInput != nullptr) {
+        mixMicrophone(pInput, pOutput, frameCount);
+    }
+    m_masterEffects.process(pOutput, frameCount);
+}
+
+void AudioEngine::renderDeckJob(void* pContext, int job)
+{
+    AudioEngine* engine = static_cast<AudioEngine*>(pContext);
+    Log::markRealtimeThread(); // Рабочие пула — тоже потоки реального времени
+    DeckJob& deckJob = engine->m_deckJobs[job];
+
+    // Голос, закончившийся в прошлом куске, больше не рендерится
+    deckJob.isRendered = !deckJob.pVoice->isFinished.load(std::memory_order_relaxed);
+    if (!deckJob.isRendered) {
+        return;
+    }
+    const ma_uint32 chunkFrames = static_cast<ma_uint32>(engine->m_deckBuffer.size() / (kDeckCount * kEngineChannels));
+    const size_t laneOffset = static_cast<size_t>(job) * chunkFrames * kEngineChannels;
+    const qint64 start = clockNanoseconds();
+    engine->renderDeck(deckJob.pVoice, engine->m_deckBuffer.data() + laneOffset, engine->m_queueBuffer.data() + laneOffset,
+                       engine->m_jobFrames, engine->m_jobNow);
+    deckJob.durationNs += clockNanoseconds() - start;
+}
+
+AudioEngine::Voice* AudioEngine::playingVoice(const Deck& deck)
+{
+    // Отыгравший голос, уступивший деку очереди, снимает главный поток; до тех пор звучит очередь
+    Voice* pVoice = deck.pVoice.load();
+    if (pVoice != nullptr && pVoice->isFinished.load(std::memory_order_acquire) && pVoice->isHandedOver.load(std::memory_order_acquire)) {
+        if (Voice* pNext = deck.pNextVoice.load()) {
+            return pNext;
+        }
+    }
+    return pVoice;
+}
+
+void AudioEngine::startTriggeredVoice(Deck* pDeck, Voice* pVoice)
+{
+    // Снятые здесь голос и очередь удалит главный поток. Указатели деки главный поток
+    // тоже только обменивает, поэтому каждый голос достается ровно одному из потоков
+    Voice* pOldVoice = pDeck->pVoice.exchange(pVoice);
+    if (pOldVoice != nullptr) {
+        pushReplaced(pOldVoice);
+    }
+    // Очередь, играющая в начатом переходе, принадлежит аудиопотоку; очередь, которую главный
+    // поток уже забрал себе (isQueueClaimed), он снимет сам. Если главный поток успел
+    // переставить очередь на место голоса, она уже снята вместе с ним
+    Voice* pQueued = pDeck->pNextVoice.load();
+    if (pQueued != nullptr && pQueued != pOldVoice &&
+        ((pOldVoice != nullptr && pOldVoice->isHandedOver.load(std::memory_order_relaxed)) || !pQueued->isQueueClaimed.exchange(true)) &&
+        pDeck->pNextVoice.compare_exchange_strong(pQueued, nullptr)) {
+        pushReplaced(pQueued);
+    }
+    pDeck->isPaused.store(false);
+    pDeck->positionMillis.store((pVoice->startFrame * 1000) / kEngineSampleRate);
+
+    // Группа глушения, как в playSound(); деки на паузе остановит главный поток
+    if (pVoice->chokeGroup != 0) {
+        for (Deck& other : m_decks) {
+            Voice* pOther = playingVoice(other);
+            if (&other != pDeck && pOther != nullptr && pOther->chokeGroup == pVoice->chokeGroup && !other.isPaused.load()) {
+                pOther->isChoked.store(true);
+            }
+        }
+    }
+}
 
-    // Загружаем указатель на декодер атомарно.
-    ma_decoder* pDecoder = engine->m_pDecoder.load();
+void AudioEngine::pushReplaced(Voice* pVoice)
+{
+    pVoice->pNextReplaced = m_replacedVoices.load(std::memory_order_relaxed);
+    while (!m_replacedVoices.compare_exchange_weak(pVoice->pNextReplaced, pVoice, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+    }
+}
 
-    if (pDecoder == nullptr) {
-        // Если декодера нет, просто заполняем буфер тишиной.
-        ma_silence_pcm_frames(pOutput, frameCount, pDevice->playback.format, pDevice->playback.channels);
+void AudioEngine::updateParallelMode(int jobCount, ma_uint32 frameCount)
+{
+    if (m_parallelState.load(std::memory_order_relaxed) == ParallelOff) {
+        m_isParallelActive = false;
+        return;
+    }
+    if (m_isOffline) {
+        // У офлайн-рендера нет периода, который надо успеть: включенный пул работает всегда
+        m_isParallelActive = true;
         return;
     }
+    // Нагрузка — суммарное время голосов, как если бы они шли в одном потоке. Пул
+    // подключается выше 30% периода и отключается ниже 15%: на легкой нагрузке
+    // пробуждение рабочих стоит дороже, чем сами голоса
+    qint64 serialNs = 0;
+    for (int job = 0; job < jobCount; ++job) {
+        serialNs += m_deckJobs[job].durationNs;
+    }
+    const qint64 budgetNs = static_cast<qint64>(frameCount) * 1000000000LL / kEngineSampleRate;
+    if (!m_isParallelActive && serialNs * 10 > budgetNs * 3) {
+        m_isParallelActive = true;
+    } else if (m_isParallelActive && serialNs * 20 < budgetNs * 3) {
+        m_isParallelActive = false;
+    }
+}
+
+void AudioEngine::renderDeck(Voice* pVoice, float* pOutput, float* pQueueOutput, ma_uint32 frameCount, qint64 now)
+{
+    Deck* pDeck = pVoice->pDeck;
+    Voice* pNext = pDeck->pNextVoice.load(std::memory_order_acquire);
+    // Начатый переход доводится до конца; заглушенная дека глушит и очередь
+    const bool canAdvance = pNext != nullptr && pNext != pVoice &&
+                            (pVoice->isHandedOver.load(std::memory_order_relaxed) || (!pVoice->loop && !pDeck->isRepeatEnabled.load(std::memory_order_relaxed) &&
+                                                      !pVoice->isChoked.load(std::memory_order_relaxed)));
+    if (canAdvance && pVoice->isHandedOver.load(std::memory_order_relaxed) && pVoice->isChoked.load(std::memory_order_relaxed)) {
+        pNext->isChoked.store(true, std::memory_order_relaxed);
+    }
+
+    // Где в этом куске вступает очередь: за длину склейки до конца текущего голоса.
+    // Конец с растяжением оценивается по темпу, прочитанное им вперед звучит раньше остатка файла;
+    // если файл кончится раньше, очередь встанет сразу за ним
+    const ma_uint64 fadeFrames = canAdvance ? pNext->queueFadeGains.size() : 0;
+    ma_uint32 nextOffset = frameCount;
+    if (canAdvance && pVoice->isHandedOver.load(std::memory_order_relaxed)) {
+        nextOffset = 0;
+    } else if (canAdvance && pVoice->endFrame != UINT64_MAX) {
+        ma_uint64 remaining = pVoice->endFrame - std::min(pVoice->position, pVoice->endFrame);
+        if (pVoice->stretcher.isActive()) {
+            remaining = static_cast<ma_uint64>(remaining / pVoice->stretcher.tempo());
+        }
+        remaining += pVoice->stretcher.bufferedFrames();
+        if (remaining < frameCount + fadeFrames) {
+            nextOffset = static_cast<ma_uint32>(remaining > fadeFrames ? remaining - fadeFrames : 0);
+        }
+    }
+
+    const ma_uint32 framesRendered = renderVoice(pVoice, pOutput, frameCount, now);
+    nextOffset = std::min(nextOffset, framesRendered);
+
+    // Первый кусок перехода: голос из очереди забираем, если главный поток не успел его заменить
+    const bool isAdvancing = canAdvance && nextOffset < frameCount &&
+                             (pVoice->isHandedOver.load(std::memory_order_relaxed) || !pNext->isQueueClaimed.exchange(true));
+    if (isAdvancing) {
+        pVoice->isHandedOver.store(true, std::memory_order_release);
+        const ma_uint32 nextFrames = frameCount - nextOffset;
+        if (!pNext->isFinished.load(std::memory_order_relaxed)) {
+            renderVoice(pNext, pQueueOutput, nextFrames, now);
+        } else {
+            ma_silence_pcm_frames(pQueueOutput, nextFrames, ma_format_f32, kEngineChannels);
+        }
+
+        // Текущий голос уже отрендерен с тишиной после конца, поэтому склейка — просто сумма с весами
+        float* pMixed = pOutput + static_cast<size_t>(nextOffset) * kEngineChannels;
+        for (ma_uint32 i = 0; i < nextFrames; ++i) {
+            const ma_uint64 k = pNext->queueFadePosition + i;
+            const float tailGain = k < fadeFrames ? pNext->queueFadeGains[k] : 0.0f;
+            const float headGain = k < fadeFrames ? pNext->queueFadeGains[fadeFrames - 1 - k] : 1.0f;
+            for (ma_uint32 ch = 0; ch < kEngineChannels; ++ch) {
+                pMixed[i * kEngineChannels + ch] = pMixed[i * kEngineChannels + ch] * tailGain +
+                                                   pQueueOutput[i * kEngineChannels + ch] * headGain;
+            }
+        }
+        pNext->queueFadePosition += nextFrames;
+        if (pNext->queueFadePosition >= fadeFrames) {
+            pVoice->isFinished.store(true, std::memory_order_release); // Хвост затих: дальше звучит только очередь
+        }
+    }
+
+    // Просим главный поток снять голос; офлайн-рендер забирает сообщения сразу после блока.
+    // Очередь, отыгравшую в самом переходе, снимет postQueueAdvanced()
+    if (pVoice->isFinished.load(std::memory_order_relaxed)) {
+        m_notifications.push({pVoice->isHandedOver.load(std::memory_order_relaxed) ? NotificationQueue::QueueAdvanced : NotificationQueue::PlaybackFinished,
+                              pVoice->deckIndex, 0});
+    }
+}
+
+ma_uint32 AudioEngine::renderVoice(Voice* pVoice, float* pOutput, ma_uint32 frameCount, qint64 now)
+{
+    Deck* pDeck = pVoice->pDeck;
+
+    // Первый колбэк этого голоса после playSound(): фиксируем, сколько он ждал
+    if (pVoice->triggerTimeNs != 0) {
+        m_triggerToCallbackNs.store(now - pVoice->triggerTimeNs);
+        pVoice->triggerTimeNs = 0;
+    }
 
     // 1. Проверка на запрос перемотки
-    ma_int64 seekRequest = engine->m_seekRequestMillis.exchange(-1);
+    ma_int64 seekRequest = pDeck->seekRequestMillis.exchange(-1);
     if (seekRequest != -1) {
-        ma_uint64 targetFrame = (seekRequest * pDecoder->outputSampleRate) / 1000;
-        ma_decoder_seek_to_pcm_frame(pDecoder, targetFrame);
-        engine->m_currentPositionMillis.store(seekRequest);
+        ma_uint64 targetFrame = (seekRequest * kEngineSampleRate) / 1000;
+        seekVoice(pVoice, targetFrame);
+    }
+
+    // 2. Чтение данных (обрезка, петли и метки обрабатываются внутри).
+    // Темп и тон могли поменяться через setVoiceParams() — подхватываем на границе блока
+    const float tempo = pVoice->tempo.load(std::memory_order_relaxed);
+    const float pitchSemitones = pVoice->pitchSemitones.load(std::memory_order_relaxed);
+    if (tempo != pVoice->stretcher.tempo() || pitchSemitones != pVoice->stretcher.pitchSemitones()) {
+        pVoice->stretcher.setParameters(tempo, pitchSemitones);
+    }
+
+    // Триггер с меткой времени звучит через один период после события, а не с начала
+    // ближайшего колбэка: смещение внутри буфера убирает дрожание на величину периода
+    ma_uint32 delayFrames = 0;
+    if (pVoice->eventTimeNs != 0) {
+        const qint64 delayNs = pVoice->eventTimeNs + m_callbackIntervalNs.load() - now;
+        if (delayNs > 0) {
+            delayFrames = static_cast<ma_uint32>(std::min<qint64>(frameCount - 1, delayNs * kEngineSampleRate / 1000000000LL));
+            ma_silence_pcm_frames(pOutput, delayFrames, ma_format_f32, kEngineChannels);
+        }
+        pVoice->eventTimeNs = 0;
+    }
+    float* pVoiceOutput = pOutput + delayFrames * kEngineChannels;
+    const ma_uint32 voiceFrames = frameCount - delayFrames;
+
+    ma_uint64 framesRead = 0;
+    if (pVoice->stretcher.isActive()) {
+        framesRead = pVoice->stretcher.render(pVoiceOutput, voiceFrames, readStretcherSource, pVoice);
+    } else {
+        // После возврата к исходным темпу и тону сначала звучит то, что растяжение уже прочитало из источника
+        framesRead = pVoice->stretcher.drain(pVoiceOutput, voiceFrames, readStretcherSource, pVoice);
+        if (framesRead < voiceFrames) {
+            framesRead += readVoice(pVoice, pVoiceOutput + framesRead * kEngineChannels, voiceFrames - framesRead);
+        }
+    }
+    if (framesRead < voiceFrames) {
+        ma_silence_pcm_frames(pVoiceOutput + framesRead * kEngineChannels, voiceFrames - framesRead, ma_format_f32, kEngineChannels);
+    }
+
+    // 3. Эффекты голоса и громкость
+    pVoice->effects.process(pOutput, frameCount);
+    ma_apply_volume_factor_pcm_frames_f32(pOutput, frameCount, kEngineChannels,
+                                          m_monitoringVolume.load() * pDeck->volume.load(std::memory_order_relaxed) *
+                                          pVoice->gain.load(std::memory_order_relaxed));
+
+    // Заглушенный голос уходит в тишину линейно за этот блок: без щелчка и без лишних колбэков
+    const bool isChoked = pVoice->isChoked.load(std::memory_order_relaxed);
+    if (isChoked) {
+        for (ma_uint32 i = 0; i < frameCount; ++i) {
+            const float fade = 1.0f - static_cast<float>(i + 1) / frameCount;
+            for (ma_uint32 ch = 0; ch < kEngineChannels; ++ch) {
+                pOutput[i * kEngineChannels + ch] *= fade;
+            }
+        }
+    }
+
+    // 4. Обновление текущей позиции (абсолютной: после петли она возвращается назад)
+    pDeck->positionMillis.store((pVoice->position * 1000) / kEngineSampleRate);
+
+    if (framesRead < voiceFrames || isChoked) {
+        pVoice->isFinished.store(true, std::memory_order_release); // Файл закончился
+    }
+    return delayFrames + static_cast<ma_uint32>(framesRead);
+}
+
+void AudioEngine::mixMicrophone(const float* pInput, float* pOutput, ma_uint32 frameCount)
+{
+    const float micVolume = m_micVolume.load();
+    const ma_uint32 chunkFrames = static_cast<ma_uint32>(m_micBuffer.size() / kEngineChannels);
+    const bool isSuppressing = m_micSuppressor.chain() != nullptr;
+    const bool isGating = m_micGate.chain() != nullptr;
+    qint64 suppressionNs = 0;
+    qint64 gateNs = 0;
+
+    for (ma_uint32 offset = 0; offset < frameCount; offset += chunkFrames) {
+        const ma_uint32 framesInChunk = std::min(chunkFrames, frameCount - offset);
+        const size_t sampleCount = static_cast<size_t>(framesInChunk) * kEngineChannels;
+        const size_t sampleOffset = static_cast<size_t>(offset) * kEngineChannels;
+
+        std::copy(pInput + sampleOffset, pInput + sampleOffset + sampleCount, m_micBuffer.begin());
+        if (isSuppressing) {
+            const qint64 start = clockNanoseconds();
+            m_micSuppressor.process(m_micBuffer.data(), framesInChunk);
+            suppressionNs += clockNanoseconds() - start;
+        }
+        if (isGating) {
+            const qint64 start = clockNanoseconds();
+            m_micGate.process(m_micBuffer.data(), framesInChunk);
+            gateNs += clockNanoseconds() - start;
+        }
+        m_micEffects.process(m_micBuffer.data(), framesInChunk);
+        for (size_t i = 0; i < sampleCount; ++i) {
+            pOutput[sampleOffset + i] += m_micBuffer[i] * micVolume;
+        }
+    }
+    m_stats.recordMicCleanup(suppressionNs, gateNs);
+}
+
+ma_uint64 AudioEngine::readVoice(Voice* pVoice, float* pOutput, ma_uint64 frameCount)
+{
+    const bool loop = pVoice->loop || pVoice->pDeck->isRepeatEnabled.load();
+    ma_uint64 framesDone = 0;
+
+    while (framesDone < frameCount) {
+        const ma_uint64 segmentEnd = loop ? pVoice->loopEndFrame : pVoice->endFrame;
+
+        if (pVoice->position >= segmentEnd) {
+            if (!loop || pVoice->loopEndFrame <= pVoice->loopStartFrame) {
+                break;
+            }
+            // Переход петли внутри того же вызова: голова уже вмешана в хвост,
+            // поэтому продолжаем сразу после нее — без паузы и с точностью до семпла
+            const ma_uint64 resumeFrame = pVoice->loopStartFrame + pVoice->crossfadeFrames;
+            seekSource(pVoice, resumeFrame);
+            pVoice->position = resumeFrame;
+            pVoice->nextCue = std::lower_bound(pVoice->cueFrames.begin(), pVoice->cueFrames.end(), resumeFrame) - pVoice->cueFrames.begin();
+            continue;
+        }
+
+        float* pChunk = pOutput + framesDone * kEngineChannels;
+        // Промах планировщика: блок файла еще не прочитан. Диск в колбэке не ждем — остаток
+        // куска звучит тишиной, а голос продолжит с того же кадра в следующем колбэке
+        if (!isSourceReady(pVoice)) {
+            ma_silence_pcm_frames(pChunk, frameCount - framesDone, ma_format_f32, kEngineChannels);
+            return frameCount;
+        }
+        const ma_uint64 framesRead = readSource(pVoice, pChunk, std::min(frameCount - framesDone, segmentEnd - pVoice->position));
+
+        if (framesRead == 0) {
+            // Файл оказался короче заявленного — запоминаем реальный конец
+            pVoice->endFrame = pVoice->position;
+            pVoice->loopEndFrame = std::min(pVoice->loopEndFrame, pVoice->position);
+            if (pVoice->loopEndFrame <= pVoice->loopStartFrame + pVoice->crossfadeFrames * 2) {
+                pVoice->crossfadeFrames = 0;
+            }
+            if (!loop || pVoice->loopEndFrame <= pVoice->loopStartFrame) {
+                break;
+            }
+            continue;
+        }
+
+        if (loop && pVoice->crossfadeFrames > 0) {
+            applyLoopCrossfade(pVoice, pChunk, framesRead);
+        }
+        fireCues(pVoice, pVoice->position + framesRead);
+
+        pVoice->position += framesRead;
+        framesDone += framesRead;
+    }
+
+    return framesDone;
+}
+
+size_t AudioEngine::readStretcherSource(void* pUserData, float* pOutput, size_t frameCount)
+{
+    Voice* pVoice = static_cast<Voice*>(pUserData);
+    return pVoice->pEngine->readVoice(pVoice, pOutput, frameCount);
+}
+
+void AudioEngine::applyLoopCrossfade(const Voice* pVoice, float* pFrames, ma_uint64 frameCount)
+{
+    const ma_uint64 fadeStart = pVoice->loopEndFrame - pVoice->crossfadeFrames;
+    if (pVoice->position + frameCount <= fadeStart || pVoice->position >= pVoice->loopEndFrame) {
+        return;
+    }
+
+    const ma_uint64 first = pVoice->position < fadeStart ? fadeStart - pVoice->position : 0;
+    const ma_uint64 last = std::min(frameCount, pVoice->loopEndFrame - pVoice->position);
+    for (ma_uint64 i = first; i < last; ++i) {
+        const ma_uint64 k = pVoice->position + i - fadeStart;
+        const float tailGain = pVoice->crossfadeGains[k];
+        const float headGain = pVoice->crossfadeGains[pVoice->crossfadeFrames - 1 - k];
+        for (ma_uint32 ch = 0; ch < kEngineChannels; ++ch) {
+            pFrames[i * kEngineChannels + ch] = pFrames[i * kEngineChannels + ch] * tailGain +
+                                                pVoice->crossfadeHead[k * kEngineChannels + ch] * headGain;
+        }
+    }
+}
+
+void AudioEngine::fireCues(Voice* pVoice, ma_uint64 endPosition)
+{
+    while (pVoice->nextCue < pVoice->cueFrames.size() && pVoice->cueFrames[pVoice->nextCue] < endPosition) {
+        if (pVoice->cueFrames[pVoice->nextCue] >= pVoice->position) {
+            m_notifications.push({NotificationQueue::CueReached, pVoice->deckIndex, static_cast<int>(pVoice->nextCue)});
+        }
+        ++pVoice->nextCue;
+    }
+}
+
+void AudioEngine::seekVoice(Voice* pVoice, ma_uint64 frame)
+{
+    const ma_uint64 target = std::clamp(frame, pVoice->startFrame, pVoice->endFrame);
+    seekSource(pVoice, target);
+    pVoice->stretcher.reset();
+    pVoice->position = target;
+    pVoice->nextCue = std::lower_bound(pVoice->cueFrames.begin(), pVoice->cueFrames.end(), target) - pVoice->cueFrames.begin();
+}
+
+void AudioEngine::setupRegion(Voice* pVoice, const PlaybackRegion& region, ma_uint64 lengthFrames)
+{
+    auto toFrames = [](ma_uint64 millis) { return (millis * kEngineSampleRate) / 1000; };
+
+    // Длина может быть неизвестна (0) — тогда конец уточнится при чтении
+    pVoice->endFrame = lengthFrames > 0 ? lengthFrames : UINT64_MAX;
+    if (region.endMillis > 0) {
+        pVoice->endFrame = std::min(pVoice->endFrame, toFrames(region.endMillis));
+    }
+    pVoice->startFrame = std::min(toFrames(region.startMillis), pVoice->endFrame);
+
+    pVoice->loop = region.loop;
+    pVoice->loopStartFrame = region.loopStartMillis > 0
+        ? std::clamp(toFrames(region.loopStartMillis), pVoice->startFrame, pVoice->endFrame)
+        : pVoice->startFrame;
+    pVoice->loopEndFrame = region.loopEndMillis > 0
+        ? std::clamp(toFrames(region.loopEndMillis), pVoice->loopStartFrame, pVoice->endFrame)
+        : pVoice->endFrame;
+
+    // Склейка требует знать конец петли и не может быть длиннее половины петли
+    pVoice->crossfadeFrames = 0;
+    if (region.crossfadeMillis > 0 && pVoice->loopEndFrame != UINT64_MAX) {
+        const ma_uint64 crossfadeFrames = std::min(toFrames(region.crossfadeMillis),
+                                                   (pVoice->loopEndFrame - pVoice->loopStartFrame) / 2);
+        if (crossfadeFrames > 0) {
+            pVoice->crossfadeHead.resize(crossfadeFrames * kEngineChannels);
+            seekSource(pVoice, pVoice->loopStartFrame);
+            pVoice->crossfadeFrames = readSource(pVoice, pVoice->crossfadeHead.data(), crossfadeFrames);
+
+            pVoice->crossfadeGains.resize(pVoice->crossfadeFrames);
+            for (ma_uint64 i = 0; i < pVoice->crossfadeFrames; ++i) {
+                const double t = (i + 0.5) / pVoice->crossfadeFrames;
+                pVoice->crossfadeGains[i] = static_cast<float>(std::cos(t * std::numbers::pi / 2.0));
+            }
+        }
+    }
+
+    for (ma_uint64 cue : region.cueMillis) {
+        pVoice->cueFrames.push_back(toFrames(cue));
+    }
+    std::sort(pVoice->cueFrames.begin(), pVoice->cueFrames.end());
+
+    seekVoice(pVoice, pVoice->startFrame);
+}
+
+ma_uint64 AudioEngine::readSource(Voice* pVoice, float* pOutput, ma_uint64 frameCount)
+{
+    if (pVoice->clip) {
+        return pVoice->clipReader.read(pOutput, frameCount);
+    }
+
+    // Сначала начало, подготовленное заранее, затем декодер с кадра за ним
+    ma_uint64 headRead = 0;
+    const ma_uint64 headFrames = pVoice->primedHead.size() / kEngineChannels;
+    if (pVoice->primedCursor < headFrames) {
+        headRead = std::min(frameCount, headFrames - pVoice->primedCursor);
+        std::memcpy(pOutput, pVoice->primedHead.data() + pVoice->primedCursor * kEngineChannels,
+                    headRead * kEngineChannels * sizeof(float));
+        pVoice->primedCursor += headRead;
+        if (headRead == frameCount) {
+            return headRead;
+        }
+        pOutput += headRead * kEngineChannels;
+        frameCount -= headRead;
     }
+    pVoice->isDecoderAtHeadEnd = false;
 
-    // 2. Чтение данных
     ma_uint64 framesRead = 0;
-    ma_result result = ma_decoder_read_pcm_frames(pDecoder, pOutput, frameCount, &framesRead);
+    if (ma_decoder_read_pcm_frames(pVoice->pDecoder, pOutput, frameCount, &framesRead) != MA_SUCCESS) {
+        return headRead;
+    }
+    return headRead + framesRead;
+}
+
+bool AudioEngine::isSourceReady(const Voice* pVoice) const
+{
+    // Клип и подготовленное начало — в памяти; потоковому декодеру нужен блок в планировщике
+    const ma_uint64 headFrames = pVoice->primedHead.size() / kEngineChannels;
+    return pVoice->pDecoder == nullptr || pVoice->clip || pVoice->primedCursor < headFrames ||
+           m_streamScheduler->isReady(pVoice->pDecoder->data.vfs.file);
+}
+
+void AudioEngine::seekSource(Voice* pVoice, ma_uint64 frame)
+{
+    if (pVoice->clip) {
+        pVoice->clipReader.seek(frame);
+        return;
+    }
+
+    // Внутри подготовленного начала читаем из памяти, а декодер ждет сразу за ним
+    const ma_uint64 headFrames = pVoice->primedHead.size() / kEngineChannels;
+    if (frame >= pVoice->primedStartFrame && frame < pVoice->primedStartFrame + headFrames) {
+        pVoice->primedCursor = frame - pVoice->primedStartFrame;
+        if (!pVoice->isDecoderAtHeadEnd) {
+            ma_decoder_seek_to_pcm_frame(pVoice->pDecoder, pVoice->primedStartFrame + headFrames);
+            pVoice->isDecoderAtHeadEnd = true;
+        }
+        return;
+    }
+    pVoice->primedCursor = headFrames;
+    pVoice->isDecoderAtHeadEnd = false;
+    ma_decoder_seek_to_pcm_frame(pVoice->pDecoder, frame);
+}
 
-    // 3. Применение громкости
-    if (result == MA_SUCCESS && framesRead > 0) {
-        // Умножаем каждый семпл на значение громкости
-        ma_apply_volume_factor_pcm_frames_f32((float*)pOutput, framesRead, pDecoder->outputChannels, engine->m_monitoringVolume.load());
+void AudioEngine::notificationCallback(const ma_device_notification* pNotification)
+{
+    AudioEngine* engine = static_cast<AudioEngine*>(pNotification->pDevice->pUserData);
+    if (engine == nullptr) {
+        return;
     }
 
-    // 3. Обновление текущей позиции
-    ma_uint64 positionIncrement = (framesRead * 1000) / pDecoder->outputSampleRate;
-    engine->m_currentPositionMillis.fetch_add(positionIncrement);
+    switch (pNotification->type) {
+    case ma_device_notification_type_stopped:
+        // Устройство остановилось не по нашей просьбе — скорее всего, его отключили
+        if (!engine->m_isStopRequested.load()) {
+            QMetaObject::invokeMethod(engine, "onDeviceLost", Qt::QueuedConnection);
+        }
+        break;
+    case ma_device_notification_type_rerouted:
+        QMetaObject::invokeMethod(engine, "onDeviceRerouted", Qt::QueuedConnection);
+        break;
+    default:
+        break;
+    }
+}
 
-    if (framesRead < frameCount) {
-        // Файл закончился. Безопасно просим главный поток вызвать postPlaybackFinished()
-        QMetaObject::invokeMethod(engine, "postPlaybackFinished", Qt::QueuedConnection);
+void AudioEngine::destroyVoice(Voice* pVoice)
+{
+    if (pVoice->pDecoder != nullptr) {
+        ma_decoder_uninit(pVoice->pDecoder);
+        delete pVoice->pDecoder;
     }
+    delete pVoice;
 }
 
 AudioEngine::AudioEngine(QObject *parent)
     : QObject(parent),
       m_context(new ma_context),
+      m_log(new ma_log),
+      m_isLogInitialized(false),
       m_playbackDevice(new ma_device),
-      m_pDecoder(nullptr), // Инициализируем атомарный указатель как nullptr
+      m_parallelState(ParallelOff),
+      m_isParallelActive(false),
+      m_jobFrames(0),
+      m_jobNow(0),
       m_monitoringVolume(0.8f), // Начальная громкость 80%
       m_isDeviceInitialized(false),      
-      m_playbackState(Stopped),
-      m_seekRequestMillis(-1),
-      m_currentPositionMillis(0)
+      m_reportedDroppedNotifications(0),
+      m_isUsingFallbackDevice(false),
+      m_periodSizeInFrames(0),
+      m_periods(0),
+      m_isRealtimePriority(false),
+      m_isExclusiveMode(false),
+      m_isContextInitialized(false),
+      m_isStopRequested(false),
+      m_isOffline(false),
+      m_deviceWatchSerial(0),
+      m_isDeviceWatchPending(false),
+      m_triggerToCallbackNs(0),
+      m_lastCallbackNs(0),
+      m_callbackIntervalNs(0),
+      m_callbackSerial(0),
+      m_replacedVoices(nullptr),
+      m_isMicPassthroughEnabled(false),
+      m_micVolume(1.0f),
+      m_sampleStore(std::make_shared<SampleStore>(256 * 1024 * 1024)),
+      m_streamScheduler(std::make_unique<StreamScheduler>()),
+      m_decoderPrimer(std::make_unique<DecoderPrimer>(m_streamScheduler.get(), kEngineChannels, kEngineSampleRate,
+                                                      64 * 1024 * 1024)),
+      m_isSampleStoreEnabled(false),
+      m_armGeneration(std::make_shared<std::atomic<quint64>>(0)),
+      m_usageStore(std::make_shared<UsageStore>()),
+      m_outputRecorder(std::make_unique<OutputRecorder>(kEngineChannels, kEngineSampleRate)),
+      m_isInitSucceeded(false),
+      m_isInitPending(false)
 {
     m_positionUpdateTimer = new QTimer(this);
     m_positionUpdateTimer->setInterval(100); // Обновлять позицию 10 раз в секунду
     connect(m_positionUpdateTimer, &QTimer::timeout, this, &AudioEngine::onUpdatePositionTimer);
+
+    // Метки и концы голосов ждут не дольше 10 мс; таймер работает, пока что-то играет
+    m_notificationTimer = new QTimer(this);
+    m_notificationTimer->setInterval(10);
+    m_notificationTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_notificationTimer, &QTimer::timeout, this, &AudioEngine::onNotificationTimer);
+
+    // Не все бэкенды сообщают о смене устройства по умолчанию, поэтому опрашиваем список
+    m_deviceWatchPool.setMaxThreadCount(1);
+    m_deviceWatchTimer = new QTimer(this);
+    m_deviceWatchTimer->setInterval(2000);
+    connect(m_deviceWatchTimer, &QTimer::timeout, this, &AudioEngine::onDeviceWatchTimer);
+
+    m_usageSaveTimer = new QTimer(this);
+    m_usageSaveTimer->setInterval(60 * 1000);
+    connect(m_usageSaveTimer, &QTimer::timeout, this, &AudioEngine::onUsageSaveTimer);
+    m_usageSaveTimer->start();
+
+    // Итог записи приходит из потока записи — в главный поток через очередь
+    m_outputRecorder->setSavedCallback([this](const QString& filePath, bool isSaved) {
+        QMetaObject::invokeMethod(this, [this, filePath, isSaved]() { emit recordingSaved(filePath, isSaved); },
+                                  Qt::QueuedConnection);
+    });
+
+    m_micBuffer.resize(512 * kEngineChannels);
+    m_deckBuffer.resize(kDeckCount * 2048 * kEngineChannels); // Кусок не меньше обычного периода: метка времени триггера смещает звук внутри куска
+    m_queueBuffer.resize(m_deckBuffer.size());
+    OSD_LOG_INFO(Engine, "Stream read-ahead backend=%s", m_streamScheduler->backendName());
 }
 
 AudioEngine::~AudioEngine()
 {
+    if (m_initThread.joinable()) {
+        m_initThread.join();
+    }
+    m_isInitPending = false;
+    m_deviceWatchPool.waitForDone(); // Опрос держит контекст
     stopAllSounds(); 
-
-    if (m_isDeviceInitialized) {
-        ma_device_uninit(m_playbackDevice);
+    closeDevice();
+    // Колбэк больше не пишет в кольцо: начатые файлы дописываются здесь, без сигналов
+    m_outputRecorder->setSavedCallback(nullptr);
+    m_outputRecorder.reset();
+    if (m_isContextInitialized) {
+        ma_context_uninit(m_context);
     }
 
+    for (Deck& deck : m_decks) {
+        if (Voice* pPending = deck.pTriggeredVoice.exchange(nullptr)) {
+            destroyVoice(pPending);
+        }
+    }
+    collectRetired(); // Устройство закрыто — все снятые голоса можно удалить
+    if (m_isLogInitialized) {
+        ma_log_uninit(m_log);
+    }
     delete m_context;
+    delete m_log;
     delete m_playbackDevice;
-    // Указатель m_pDecoder управляется атомарно и удаляется в stopAllSounds
+    // Голоса дек управляются атомарно и удаляются в stopAllSounds
+
+    m_usageStore->save(); // Последняя пачка запусков
 }
 
 bool AudioEngine::init()
 {
-    if (ma_context_init(NULL, 0, NULL, m_context) != MA_SUCCESS) {
-        qCritical() << "Failed to initialize miniaudio context.";
-        return false;
-    }
-    qDebug() << "Miniaudio context initialized.";
-    return true;
+    beginInit();
+    return waitForInit();
 }
 
-void AudioEngine::playSound(const QString &filePath)
+void AudioEngine::beginInit()
 {
-    // Сначала останавливаем любой играющий звук
-    stopAllSounds();
+    // Контекст и устройство — самые долгие шаги запуска (загрузка бэкенда, опрос PulseAudio/ALSA).
+    // Устройство открывается заранее, чтобы первый триггер не платил за ma_device_init()
+    m_isInitPending = true;
+    m_initThread = std::thread([this]() {
+        m_isInitSucceeded = initContext();
+        if (m_isInitSucceeded && !openDevice()) {
+            OSD_LOG_WARNING(Device, "Playback device is not available yet, will retry on first playback");
+        }
+    });
+}
 
-    // Создаем новый декодер
-    ma_decoder* pNewDecoder = new ma_decoder;
-    if (ma_decoder_init_file(filePath.toStdString().c_str(), NULL, pNewDecoder) != MA_SUCCESS) {
-        qWarning() << "Failed to open or decode file:" << filePath;
-        delete pNewDecoder;
-        return;
+bool AudioEngine::waitForInit()
+{
+    if (m_initThread.joinable()) {
+        m_initThread.join();
     }
-
-    // Если устройство не запущено, запускаем его
-    if (m_isDeviceInitialized && !ma_device_is_started(m_playbackDevice)) {
-        if (ma_device_start(m_playbackDevice) != MA_SUCCESS) {
-            qWarning() << "Failed to re-start playback device.";
-            return;
+    if (m_isInitPending) {
+        m_isInitPending = false;
+        // Поток инициализации сигналов не шлет: получатели живут в главном потоке
+        if (m_isDeviceInitialized) {
+            emit outputDeviceChanged(m_activeDeviceName);
         }
+        applyDeferredSettings();
+    }
+    if (!m_isInitSucceeded) {
+        return false;
     }
+    // Со сквозным микрофоном или записью устройство работает постоянно, а не только во время воспроизведения
+    if (isDeviceAlwaysOn() && m_isDeviceInitialized && ma_device_start(m_playbackDevice) != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to start the device for microphone passthrough or recording");
+    }
+    m_deviceWatchTimer->start();
+    return true;
+}
 
-    // Инициализируем и запускаем устройство, если оно еще не работает
-    if (!m_isDeviceInitialized) {
-        ma_device_config config = ma_device_config_init(ma_device_type_playback);
-        config.playback.format   = pNewDecoder->outputFormat;
-        config.playback.channels = pNewDecoder->outputChannels;
-        config.sampleRate        = pNewDecoder->outputSampleRate;
-        config.dataCallback      = dataCallback;
-        config.pUserData         = this;
+void AudioEngine::initOffline()
+{
+    // Ни контекста, ни устройства: retireVoice() и collectRetired() видят остановленное
+    // устройство и удаляют голоса сразу, а блоки забирает renderOffline()
+    m_isOffline = true;
+    m_monitoringVolume.store(1.0f);
+}
 
-        if (ma_device_init(m_context, &config, m_playbackDevice) != MA_SUCCESS) {
-            qWarning() << "Failed to initialize playback device.";
-            ma_decoder_uninit(pNewDecoder);
-            delete pNewDecoder;
-            return;
-        }
+void AudioEngine::renderOffline(float* pOutput, ma_uint32 frameCount)
+{
+    int activeVoices = 0;
+    int streamedVoices = 0;
+    mixBlock(pOutput, nullptr, frameCount, clockNanoseconds(), &activeVoices, &streamedVoices);
 
-        if (ma_device_start(m_playbackDevice) != MA_SUCCESS) {
-            qWarning() << "Failed to start playback device.";
-            ma_device_uninit(m_playbackDevice);
-            ma_decoder_uninit(pNewDecoder);
-            delete pNewDecoder;
-            return;
-        }
-        m_isDeviceInitialized = true;
+    // То же, что сообщения из колбэка, но сразу: следующий блок уже без этих голосов
+    drainNotifications();
+}
+
+bool AudioEngine::initContext()
+{
+    if (!m_isLogInitialized && ma_log_init(NULL, m_log) == MA_SUCCESS) {
+        ma_log_register_callback(m_log, ma_log_callback_init(miniaudioLogCallback, nullptr));
+        m_isLogInitialized = true;
     }
 
-    // Получаем длительность и отправляем сигнал в UI
-    ma_uint64 durationFrames;
-    ma_decoder_get_length_in_pcm_frames(pNewDecoder, &durationFrames);
-    ma_uint64 durationMillis = (durationFrames * 1000) / pNewDecoder->outputSampleRate;
-    emit durationReady(durationMillis);
+    ma_context_config contextConfig = ma_context_config_init();
+    contextConfig.pLog = m_isLogInitialized ? m_log : NULL;
+    contextConfig.threadPriority = m_isRealtimePriority ? ma_thread_priority_realtime : ma_thread_priority_highest;
 
-    // Атомарно подменяем указатель на новый декодер
-    m_pDecoder.store(pNewDecoder);
+    ma_backend backend;
+    const bool hasBackend = !m_backendName.isEmpty() &&
+                            ma_get_backend_from_name(m_backendName.toUtf8().constData(), &backend) == MA_SUCCESS;
 
-    m_currentPositionMillis.store(0);
-    m_positionUpdateTimer->start();
+    ma_result result = ma_context_init(hasBackend ? &backend : NULL, hasBackend ? 1 : 0, &contextConfig, m_context);
+    if (result != MA_SUCCESS && hasBackend) {
+        OSD_LOG_WARNING(Device, "Failed to initialize backend, falling back to automatic selection backend=%s",
+                        qUtf8Printable(m_backendName));
+        result = ma_context_init(NULL, 0, &contextConfig, m_context);
+    }
+    if (result != MA_SUCCESS) {
+        OSD_LOG_ERROR(Device, "Failed to initialize miniaudio context");
+        return false;
+    }
 
-    m_playbackState = Playing;
-    qDebug() << "Playback started for:" << filePath;
+    m_isContextInitialized = true;
+    OSD_LOG_INFO(Device, "Miniaudio context initialized backend=%s realtime=%d",
+                 ma_get_backend_name(m_context->backend), m_isRealtimePriority ? 1 : 0);
+    return true;
 }
 
-void AudioEngine::pause()
+QStringList AudioEngine::availableBackends() const
 {
-    if (m_playbackState == Playing && m_isDeviceInitialized && ma_device_is_started(m_playbackDevice)) {
-        ma_device_stop(m_playbackDevice);
-        m_positionUpdateTimer->stop();
-        m_playbackState = Paused;
-        qDebug() << "Playback paused.";
+    QStringList names;
+    ma_backend backends[MA_BACKEND_COUNT];
+    size_t backendCount = 0;
+    if (ma_get_enabled_backends(backends, MA_BACKEND_COUNT, &backendCount) != MA_SUCCESS) {
+        return names;
     }
-}
-
-void AudioEngine::resume()
-{
-    if (m_playbackState == Paused && m_isDeviceInitialized) {
-        if (ma_device_start(m_playbackDevice) != MA_SUCCESS) {
-            qWarning() << "Failed to resume playback device.";
-            stopAllSounds(); // В случае ошибки останавливаем все
-            return;
+    for (size_t i = 0; i < backendCount; ++i) {
+        if (backends[i] != ma_backend_null && backends[i] != ma_backend_custom) {
+            names.append(QString::fromUtf8(ma_get_backend_name(backends[i])));
         }
-        m_positionUpdateTimer->start();
-        m_playbackState = Playing;
-        qDebug() << "Playback resumed.";
     }
+    return names;
 }
 
-void AudioEngine::stopAllSounds()
+void AudioEngine::setContextOptions(const QString &backendName, bool realtimePriority)
 {
-    // Атомарно забираем указатель на текущий декодер и заменяем его на nullptr
-    ma_decoder* pOldDecoder = m_pDecoder.exchange(nullptr);
+    if (m_isInitPending) {
+        m_deferredSettings.contextOptions = qMakePair(backendName, realtimePriority);
+        return;
+    }
+    if (backendName == m_backendName && realtimePriority == m_isRealtimePriority) {
+        return;
+    }
+    m_backendName = backendName;
+    m_isRealtimePriority = realtimePriority;
+
+    // Приоритет рабочих пула задается при их запуске
+    if (m_parallelMixer.workerCount() > 0) {
+        setParallelMixingEnabled(false);
+        setParallelMixingEnabled(true);
+    }
 
-    // Если был старый декодер, безопасно его удаляем
-    if (pOldDecoder != nullptr) {
-        ma_decoder_uninit(pOldDecoder);
-        delete pOldDecoder;
-        qDebug() << "Previous sound stopped and decoder uninitialized.";
+    if (!m_isContextInitialized) {
+        return; // Применится в init()
     }
 
-    if (m_isDeviceInitialized && ma_device_is_started(m_playbackDevice)) {
-        ma_device_stop(m_playbackDevice);
-        m_positionUpdateTimer->stop();
-        m_currentPositionMillis.store(0);
-        m_playbackState = Stopped;
-        qDebug() << "Playback device stopped.";
+    // Устройство принадлежит контексту, поэтому закрываем его и открываем заново в новом контексте
+    const bool hadDevice = m_isDeviceInitialized;
+    m_deviceWatchPool.waitForDone();
+    ++m_deviceWatchSerial;
+    closeDevice();
+    ma_context_uninit(m_context);
+    m_isContextInitialized = false;
+
+    if (!initContext()) {
+        return;
+    }
+    if (hadDevice) {
+        reopenDevice();
     }
 }
 
-void AudioEngine::seek(ma_uint64 positionMillis)
+void AudioEngine::setExclusiveMode(bool exclusive)
 {
-    m_seekRequestMillis.store(positionMillis);
+    if (m_isInitPending) {
+        m_deferredSettings.isExclusiveMode = exclusive;
+        return;
+    }
+    if (exclusive == m_isExclusiveMode) {
+        return;
+    }
+    m_isExclusiveMode = exclusive;
+    if (m_isDeviceInitialized) {
+        reopenDevice();
+    }
 }
 
-void AudioEngine::setMonitoringVolume(float volume)
+void AudioEngine::setParallelMixingEnabled(bool enabled)
 {
-    float clampedVolume = std::max(0.0f, std::min(1.0f, volume));
-    m_monitoringVolume.store(clampedVolume);
-    qDebug() << "Monitoring volume set to" << clampedVolume;
+    if (enabled == (m_parallelMixer.workerCount() > 0)) {
+        return;
+    }
+    if (!enabled) {
+        // Колбэк может быть внутри run(): ждем конца его куска, дальше он рендерит сам
+        int expected = ParallelIdle;
+        while (!m_parallelState.compare_exchange_weak(expected, ParallelOff)) {
+            expected = ParallelIdle;
+            std::this_thread::yield();
+        }
+        m_parallelMixer.stop();
+        OSD_LOG_INFO(Engine, "Parallel mixing disabled");
+        return;
+    }
+
+    // Деке нужен один участник; вызывающий колбэк — тоже участник, поэтому рабочих на один меньше
+    const int cpuCount = static_cast<int>(std::thread::hardware_concurrency());
+    const int workerCount = std::min(kDeckCount - 1, cpuCount - 1);
+    if (workerCount <= 0) {
+        OSD_LOG_INFO(Engine, "Parallel mixing needs more than one core, staying single-threaded");
+        return;
+    }
+    if (!m_parallelMixer.start(workerCount, m_isRealtimePriority)) {
+        OSD_LOG_WARNING(Engine, "Parallel mixing workers could not be pinned or raised to realtime priority");
+    }
+    m_parallelState.store(ParallelIdle);
+    OSD_LOG_INFO(Engine, "Parallel mixing enabled workers=%d realtime=%d", workerCount, m_isRealtimePriority ? 1 : 0);
 }
 
-AudioEngine::PlaybackState AudioEngine::getPlaybackState() const
+qint64 AudioEngine::clockNanoseconds()
 {
-    return m_playbackState;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void AudioEngine::onUpdatePositionTimer()
+AudioEngine::LatencyInfo AudioEngine::latencyInfo() const
 {
-    emit positionChanged(m_currentPositionMillis.load());
+    LatencyInfo info = {};
+    if (!m_isInitPending && m_isDeviceInitialized && m_playbackDevice->playback.internalSampleRate > 0) {
+        const double frameMillis = 1000.0 / m_playbackDevice->playback.internalSampleRate;
+        info.periodMillis = m_playbackDevice->playback.internalPeriodSizeInFrames * frameMillis;
+        info.bufferMillis = info.periodMillis * m_playbackDevice->playback.internalPeriods;
+    }
+    info.callbackIntervalMillis = m_callbackIntervalNs.load() / 1e6;
+    info.triggerToCallbackMillis = m_triggerToCallbackNs.load() / 1e6;
+    if (info.triggerToCallbackMillis > 0) {
+        info.outputLatencyMillis = info.triggerToCallbackMillis + info.bufferMillis;
+    }
+    return info;
 }
 
-// Этот слот будет вызван безопасно в главном потоке
-void AudioEngine::postPlaybackFinished()
+EngineStats::Snapshot AudioEngine::statsSnapshot() const
 {
-    stopAllSounds();
-    emit playbackFinished();
-    qDebug() << "Playback finished signal emitted.";
+    EngineStats::Snapshot snapshot = m_stats.snapshot();
+    if (!isDeviceRunning()) {
+        // Последний колбэк видел голоса, которые с тех пор остановлены
+        snapshot.activeVoices = 0;
+        snapshot.streamedVoices = 0;
+    }
+    if (m_isSampleStoreEnabled) {
+        snapshot.armedClips = m_sampleStore->pinnedCount();
+        snapshot.armedReady = m_sampleStore->pinnedResidentCount();
+        snapshot.residentBytes = m_sampleStore->residentBytes();
+        snapshot.budgetBytes = m_sampleStore->budget();
+    }
+    const StreamScheduler::Stats streamStats = m_streamScheduler->stats();
+    snapshot.streamHits = streamStats.hits - m_streamStatsBase.hits;
+    snapshot.streamMisses = streamStats.misses - m_streamStatsBase.misses;
+    return snapshot;
+}
+
+void AudioEngine::resetStats()
+{
+    m_stats.requestReset();
+    m_streamStatsBase = m_streamScheduler->stats();
+}
+
+QList<AudioEngine::DeviceInfo> AudioEngine::playbackDevices() const
+{
+    QList<DeviceInfo> devices;
+    if (m_isInitPending) {
+        return devices; // Контекст еще открывается в другом потоке
+    }
+
+    ma_device_info* pPlaybackInfos = nullptr;
+    ma_uint32 playbackCount = 0;
+    if (ma_context_get_devices(m_context, &pPlaybackInfos, &playbackCount, NULL, NULL) != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to enumerate playback devices");
+        return devices;
+    }
+
+    for (ma_uint32 i = 0; i < playbackCount; ++i) {
+        DeviceInfo info;
+        info.name = QString::fromUtf8(pPlaybackInfos[i].name);
+        info.id = QByteArray(reinterpret_cast<const char*>(&pPlaybackInfos[i].id), sizeof(ma_device_id));
+        info.isDefault = pPlaybackInfos[i].isDefault;
+        devices.append(info);
+    }
+    return devices;
+}
+
+void AudioEngine::requestPlaybackDevices()
+{
+    if (m_isInitPending || !m_isContextInitialized) {
+        // Контекст еще открывается в другом потоке: пустой список, как у playbackDevices()
+        QMetaObject::invokeMethod(this, [this]() { emit playbackDevicesListed({}); }, Qt::QueuedConnection);
+        return;
+    }
+    // Пересоздание контекста ждет пул, поэтому m_context здесь жив
+    m_deviceWatchPool.start([this]() {
+        const QList<DeviceInfo> devices = listDevices(m_context);
+        QMetaObject::invokeMethod(this, [this, devices]() { emit playbackDevicesListed(devices); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+QList<AudioEngine::DeviceInfo> AudioEngine::listDevices(ma_context* pContext)
+{
+    QList<DeviceInfo> devices;
+    // Как watchDevices(): не трогает общий массив контекста, которым пользуется playbackDevices()
+    const ma_result result = ma_context_enumerate_devices(
+        pContext,
+        [](ma_context*, ma_device_type deviceType, const ma_device_info* pInfo, void* pUserData) -> ma_bool32 {
+            if (deviceType == ma_device_type_playback) {
+                DeviceInfo info;
+                info.name = QString::fromUtf8(pInfo->name);
+                info.id = QByteArray(reinterpret_cast<const char*>(&pInfo->id), sizeof(ma_device_id));
+                info.isDefault = pInfo->isDefault;
+                static_cast<QList<DeviceInfo>*>(pUserData)->append(info);
+            }
+            return MA_TRUE;
+        },
+        &devices);
+    if (result != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to enumerate playback devices");
+    }
+    return devices;
+}
+
+void AudioEngine::setOutputDevice(const QByteArray &deviceId, const QString &deviceName)
+{
+    if (m_isInitPending) {
+        m_deferredSettings.outputDevice = qMakePair(deviceId, deviceName);
+        return;
+    }
+    if (deviceId == m_selectedDeviceId && deviceName == m_selectedDeviceName) {
+        return;
+    }
+    m_selectedDeviceId = deviceId;
+    m_selectedDeviceName = deviceName;
+    ++m_deviceWatchSerial;
+    OSD_LOG_INFO(Device, "Output device selected name=\"%s\"",
+                 deviceId.isEmpty() ? "<default>" : qUtf8Printable(deviceName));
+
+    if (m_isDeviceInitialized) {
+        reopenDevice();
+    }
+}
+
+void AudioEngine::setBufferSize(ma_uint32 periodSizeInFrames, ma_uint32 periods)
+{
+    if (m_isInitPending) {
+        m_deferredSettings.bufferSize = qMakePair(periodSizeInFrames, periods);
+        return;
+    }
+    if (periodSizeInFrames == m_periodSizeInFrames && periods == m_periods) {
+        return;
+    }
+    m_periodSizeInFrames = periodSizeInFrames;
+    m_periods = periods;
+    OSD_LOG_INFO(Device, "Buffer size set period=%u periods=%u", periodSizeInFrames, periods);
+
+    if (m_isDeviceInitialized) {
+        reopenDevice();
+    }
+}
+
+QString AudioEngine::currentDeviceName() const
+{
+    return m_isInitPending ? QString() : m_activeDeviceName;
+}
+
+bool AudioEngine::isSameDevice(const QByteArray& deviceId, const ma_device_id& id)
+{
+    // Байты ID могут отличаться в неиспользуемом хвосте объединения, поэтому сравнивает miniaudio
+    if (deviceId.size() != sizeof(ma_device_id)) {
+        return false;
+    }
+    ma_device_id storedId;
+    memcpy(&storedId, deviceId.constData(), sizeof(ma_device_id));
+    return ma_device_id_equal(&storedId, &id);
+}
+
+bool AudioEngine::findSelectedDevice(ma_device_id* pDeviceId) const
+{
+    if (m_selectedDeviceId.size() != sizeof(ma_device_id)) {
+        return false;
+    }
+
+    // Ищем сначала по ID, затем по имени: некоторые бэкенды меняют ID после переподключения
+    const QList<DeviceInfo> devices = playbackDevices();
+    for (const DeviceInfo& device : devices) {
+        ma_device_id id;
+        memcpy(&id, device.id.constData(), sizeof(ma_device_id));
+        if (isSameDevice(m_selectedDeviceId, id)) {
+            *pDeviceId = id;
+            return true;
+        }
+    }
+    for (const DeviceInfo& device : devices) {
+        if (device.name == m_selectedDeviceName) {
+            memcpy(pDeviceId, device.id.constData(), sizeof(ma_device_id));
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioEngine::applyDeferredSettings()
+{
+    const DeferredSettings deferred = m_deferredSettings;
+    m_deferredSettings = DeferredSettings();
+
+    // Поля задаются напрямую, а устройство переоткрывается не больше одного раза
+    bool isReopenNeeded = false;
+    if (deferred.outputDevice &&
+        (deferred.outputDevice->first != m_selectedDeviceId || deferred.outputDevice->second != m_selectedDeviceName)) {
+        m_selectedDeviceId = deferred.outputDevice->first;
+        m_selectedDeviceName = deferred.outputDevice->second;
+        ++m_deviceWatchSerial;
+        isReopenNeeded = true;
+        OSD_LOG_INFO(Device, "Output device selected name=\"%s\"",
+                     m_selectedDeviceId.isEmpty() ? "<default>" : qUtf8Printable(m_selectedDeviceName));
+    }
+    if (deferred.bufferSize &&
+        (deferred.bufferSize->first != m_periodSizeInFrames || deferred.bufferSize->second != m_periods)) {
+        m_periodSizeInFrames = deferred.bufferSize->first;
+        m_periods = deferred.bufferSize->second;
+        isReopenNeeded = true;
+        OSD_LOG_INFO(Device, "Buffer size set period=%u periods=%u", m_periodSizeInFrames, m_periods);
+    }
+    if (deferred.isExclusiveMode && *deferred.isExclusiveMode != m_isExclusiveMode) {
+        m_isExclusiveMode = *deferred.isExclusiveMode;
+        isReopenNeeded = true;
+    }
+    if (deferred.isMicPassthroughEnabled && *deferred.isMicPassthroughEnabled != m_isMicPassthroughEnabled) {
+        m_isMicPassthroughEnabled = *deferred.isMicPassthroughEnabled;
+        isReopenNeeded = true;
+        OSD_LOG_INFO(Device, "Microphone passthrough enabled=%d", m_isMicPassthroughEnabled ? 1 : 0);
+    }
+
+    // Новый контекст сам открывает устройство заново — уже с новыми полями
+    if (deferred.contextOptions && (deferred.contextOptions->first != m_backendName ||
+                                    deferred.contextOptions->second != m_isRealtimePriority)) {
+        setContextOptions(deferred.contextOptions->first, deferred.contextOptions->second);
+        return;
+    }
+    if (isReopenNeeded && m_isContextInitialized && (m_isDeviceInitialized || m_isMicPassthroughEnabled)) {
+        collectRetired();
+        reopenDevice();
+    }
+}
+
+bool AudioEngine::openDevice()
+{
+    ma_device_id deviceId;
+    const bool wantsSpecificDevice = !m_selectedDeviceId.isEmpty();
+    const bool hasSelectedDevice = wantsSpecificDevice && findSelectedDevice(&deviceId);
+
+    // Со сквозным микрофоном захват идет тем же устройством: один колбэк без лишней буферизации
+    ma_device_config config = ma_device_config_init(m_isMicPassthroughEnabled ? ma_device_type_duplex : ma_device_type_playback);
+    config.playback.pDeviceID = hasSelectedDevice ? &deviceId : NULL;
+    config.playback.format    = ma_format_f32;
+    config.playback.channels  = kEngineChannels;
+    config.sampleRate         = kEngineSampleRate;
+    config.periodSizeInFrames = m_periodSizeInFrames;
+    config.periods            = m_periods;
+    config.performanceProfile = ma_performance_profile_low_latency;
+    config.playback.shareMode = m_isExclusiveMode ? ma_share_mode_exclusive : ma_share_mode_shared;
+    config.capture.pDeviceID  = NULL;
+    config.capture.format     = ma_format_f32;
+    config.capture.channels   = kEngineChannels;
+    config.capture.shareMode  = ma_share_mode_shared;
+    config.dataCallback       = dataCallback;
+    config.notificationCallback = notificationCallback;
+    config.pUserData          = this;
+
+    ma_result result = ma_device_init(m_context, &config, m_playbackDevice);
+    if (result != MA_SUCCESS && m_isExclusiveMode) {
+        OSD_LOG_WARNING(Device, "Exclusive mode is not available, using shared mode");
+        config.playback.shareMode = ma_share_mode_shared;
+        result = ma_device_init(m_context, &config, m_playbackDevice);
+    }
+    if (result != MA_SUCCESS && hasSelectedDevice) {
+        OSD_LOG_WARNING(Device, "Failed to open selected output device, falling back to default");
+        config.playback.pDeviceID = NULL;
+        result = ma_device_init(m_context, &config, m_playbackDevice);
+    }
+    if (result != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to initialize playback device");
+        return false;
+    }
+
+    m_isDeviceInitialized = true;
+    m_lastCallbackNs.store(0);
+    m_callbackIntervalNs.store(0);
+    m_isUsingFallbackDevice = wantsSpecificDevice && config.playback.pDeviceID == NULL;
+    m_activeDeviceName = QString::fromUtf8(m_playbackDevice->playback.name);
+    OSD_LOG_INFO(Device, "Playback device opened name=\"%s\" period=%u periods=%u", qUtf8Printable(m_activeDeviceName),
+                 m_playbackDevice->playback.internalPeriodSizeInFrames, m_playbackDevice->playback.internalPeriods);
+    if (!m_isInitPending) {
+        emit outputDeviceChanged(m_activeDeviceName); // Иначе сообщит waitForInit() из главного потока
+    }
+    return true;
+}
+
+void AudioEngine::closeDevice()
+{
+    if (!m_isDeviceInitialized) {
+        return;
+    }
+    m_isStopRequested.store(true);
+    ma_device_uninit(m_playbackDevice);
+    m_isStopRequested.store(false);
+    m_isDeviceInitialized = false;
+}
+
+void AudioEngine::stopDevice()
+{
+    m_isStopRequested.store(true);
+    ma_device_stop(m_playbackDevice);
+    m_isStopRequested.store(false);
+    m_lastCallbackNs.store(0); // Пауза между остановкой и запуском — не интервал колбэка
+}
+
+void AudioEngine::reopenDevice()
+{
+    // Голос, позиция и громкость живут в движке, а не в устройстве,
+    // поэтому после переоткрытия воспроизведение продолжается с того же места
+    ++m_deviceWatchSerial;
+    closeDevice();
+    if (!openDevice()) {
+        return;
+    }
+
+    if ((isAnyDeckPlaying() || isDeviceAlwaysOn()) && ma_device_start(m_playbackDevice) != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to restart playback on the new device");
+    }
+}
+
+AudioEngine::Voice* AudioEngine::createVoice(const QString& filePath, const PlaybackRegion& region,
+                                             const VoiceParams& params, int deck, ma_uint64* pDurationFrames)
+{
+    // Создаем новый голос: из резидентного хранилища, если клип там есть, иначе потоковый декодер
+    *pDurationFrames = 0;
+    Voice* pNewVoice = new Voice;
+    pNewVoice->pEngine = this;
+    pNewVoice->pDeck = &m_decks[deck];
+    pNewVoice->deckIndex = deck;
+    pNewVoice->chokeGroup = std::max(params.chokeGroup, 0);
+
+    if (m_isSampleStoreEnabled) {
+        pNewVoice->clip = m_sampleStore->find(filePath);
+    }
+
+    if (pNewVoice->clip) {
+        pNewVoice->clipReader.reset(pNewVoice->clip.get());
+        *pDurationFrames = pNewVoice->clip->frameCount();
+    } else {
+        DecoderPrimer::Primed primed;
+        if (m_decoderPrimer->take(filePath, (region.startMillis * kEngineSampleRate) / 1000, &primed)) {
+            // Декодер открыт заранее и уже стоит за декодированным началом области
+            pNewVoice->pDecoder = primed.pDecoder;
+            pNewVoice->primedHead = std::move(primed.head);
+            pNewVoice->primedStartFrame = primed.startFrame;
+            *pDurationFrames = primed.lengthFrames;
+            OSD_LOG_DEBUG(Engine, "Primed decoder taken path=\"%s\"", qUtf8Printable(filePath));
+        } else {
+            pNewVoice->pDecoder = new ma_decoder;
+            ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_f32, kEngineChannels, kEngineSampleRate);
+            // Файл читается через планировщик: аудиопоток берет байты из блоков, прочитанных заранее
+            if (ma_decoder_init_vfs(m_streamScheduler->vfs(), filePath.toStdString().c_str(), &decoderConfig,
+                                    pNewVoice->pDecoder) != MA_SUCCESS) {
+                OSD_LOG_WARNING(Engine, "Failed to open or decode file path=\"%s\"", qUtf8Printable(filePath));
+                delete pNewVoice->pDecoder;
+                delete pNewVoice;
+                return nullptr;
+            }
+            ma_decoder_get_length_in_pcm_frames(pNewVoice->pDecoder, pDurationFrames);
+        }
+
+        // В следующий раз клип будет играть из памяти
+        preloadSound(filePath);
+    }
+
+    setupRegion(pNewVoice, region, *pDurationFrames);
+    if (pNewVoice->pDecoder != nullptr) {
+        // Петля и повтор деки перематывают декодер сюда на каждом круге: этот блок файла
+        // планировщик держит в памяти, и переход не становится промахом
+        const ma_uint64 resumeFrame = pNewVoice->loopStartFrame + pNewVoice->crossfadeFrames;
+        if (resumeFrame != pNewVoice->startFrame) {
+            seekSource(pNewVoice, resumeFrame);
+            m_streamScheduler->pinPosition(pNewVoice->pDecoder->data.vfs.file);
+            seekVoice(pNewVoice, pNewVoice->startFrame);
+        } else {
+            m_streamScheduler->pinPosition(pNewVoice->pDecoder->data.vfs.file);
+        }
+
+        // Декодер уже стоит на начале области: дальше его читает только колбэк (офлайн-рендер
+        // может ждать диск). Срочность потока — по байтам файла на секунду звука
+        ma_file_info fileInfo = {};
+        double bytesPerSecond = 0.0;
+        if (*pDurationFrames > 0 && ma_vfs_info(m_streamScheduler->vfs(), pNewVoice->pDecoder->data.vfs.file, &fileInfo) == MA_SUCCESS) {
+            bytesPerSecond = static_cast<double>(fileInfo.sizeInBytes) * kEngineSampleRate / *pDurationFrames;
+        }
+        m_streamScheduler->startPlayback(pNewVoice->pDecoder->data.vfs.file, bytesPerSecond, !m_isOffline);
+    }
+    pNewVoice->durationFrames = *pDurationFrames;
+    pNewVoice->regionFrames = pNewVoice->endFrame - pNewVoice->startFrame;
+    pNewVoice->stretcher.setParameters(params.tempo, params.pitchSemitones);
+    pNewVoice->tempo.store(pNewVoice->stretcher.tempo());
+    pNewVoice->pitchSemitones.store(pNewVoice->stretcher.pitchSemitones());
+    pNewVoice->gain.store(std::clamp(params.gain, 0.0f, kMaxVoiceGain));
+    applyEffectSettings(&pNewVoice->effects, &pNewVoice->effectSettings, params.effects);
+
+    return pNewVoice;
+}
+
+void AudioEngine::playSound(const QString &filePath, const PlaybackRegion &region, const VoiceParams &params,
+                            qint64 eventTimeNs, int deck)
+{
+    if (!isValidDeck(deck)) {
+        OSD_LOG_WARNING(Engine, "Invalid deck deck=%d", deck);
+        return;
+    }
+    Deck& target = m_decks[deck];
+
+    // Сначала останавливаем звук этой деки; остальные деки продолжают играть.
+    // Ручной запуск отменяет и очередь деки
+    Voice* pOldVoice = target.pVoice.exchange(nullptr);
+    if (pOldVoice != nullptr) {
+        retireVoice(pOldVoice);
+    }
+    if (Voice* pQueuedVoice = target.pNextVoice.exchange(nullptr)) {
+        retireVoice(pQueuedVoice);
+    }
+    target.isPaused.store(false);
+    target.state = Stopped;
+    collectRetired();
+
+    const qint64 triggerTime = clockNanoseconds();
+    ma_uint64 durationFrames = 0;
+    Voice* pNewVoice = createVoice(filePath, region, params, deck, &durationFrames);
+    if (pNewVoice == nullptr) {
+        return;
+    }
+    pNewVoice->eventTimeNs = eventTimeNs;
+    pNewVoice->triggerTimeNs = triggerTime;
+    m_stats.recordTrigger(pNewVoice->clip != nullptr);
+    m_usageStore->recordTrigger(filePath);
+    const bool isResident = pNewVoice->clip != nullptr;
+
+    startVoice(pNewVoice, deck);
+    if (target.state == Playing) {
+        OSD_LOG_DEBUG(Engine, "Playback started deck=%d source=%s path=\"%s\"", deck,
+                      isResident ? "resident" : "streamed", qUtf8Printable(filePath));
+    }
+}
+
+void AudioEngine::triggerSound(const QString& filePath, const PlaybackRegion& region, const VoiceParams& params,
+                               qint64 eventTimeNs, int deck)
+{
+    if (!isValidDeck(deck)) {
+        OSD_LOG_WARNING(Engine, "Invalid deck deck=%d", deck);
+        return;
+    }
+    // Поток вызывающего: открытие голоса не трогает ни деки, ни устройство
+    const qint64 triggerTime = clockNanoseconds();
+    ma_uint64 durationFrames = 0;
+    Voice* pNewVoice = createVoice(filePath, region, params, deck, &durationFrames);
+    if (pNewVoice == nullptr) {
+        return;
+    }
+    pNewVoice->eventTimeNs = eventTimeNs;
+    pNewVoice->triggerTimeNs = triggerTime;
+    m_stats.recordTrigger(pNewVoice->clip != nullptr);
+    m_usageStore->recordTrigger(filePath);
+
+    // Два запуска на деке до колбэка: звучит последний
+    if (Voice* pSuperseded = m_decks[deck].pTriggeredVoice.exchange(pNewVoice, std::memory_order_acq_rel)) {
+        pushReplaced(pSuperseded);
+    }
+    // Звук от главного потока уже не зависит: он лишь отметит запуск, когда дойдет до сообщения
+    QMetaObject::invokeMethod(this, [this, deck]() { adoptTriggeredVoice(deck); }, Qt::QueuedConnection);
+}
+
+// Вызывается в главном потоке после triggerSound()
+void AudioEngine::adoptTriggeredVoice(int deck)
+{
+    Deck& target = m_decks[deck];
+    collectRetired(); // Голоса, которые колбэк снял при запуске
+
+    // Колбэк голос еще не забрал (устройство стоит): ставим его сами, как playSound()
+    if (Voice* pPending = target.pTriggeredVoice.exchange(nullptr)) {
+        if (Voice* pOldVoice = target.pVoice.exchange(nullptr)) {
+            retireVoice(pOldVoice);
+        }
+        if (Voice* pQueuedVoice = target.pNextVoice.exchange(nullptr)) {
+            retireVoice(pQueuedVoice);
+        }
+        target.isPaused.store(false);
+        target.state = Stopped;
+        startVoice(pPending, deck);
+        return;
+    }
+
+    // Колбэк уже играет голос: нужны только состояние деки, сигналы и таймеры
+    Voice* pVoice = target.pVoice.load();
+    if (pVoice == nullptr) {
+        return; // Уже отыграл и снят
+    }
+    if (!ensureDeviceStarted()) {
+        stopDeck(deck); // Устройство остановили, пока сообщение шло, и снова не запустить
+        return;
+    }
+    chokeDecks(deck, pVoice->chokeGroup, true);
+    emit durationReady(deck, (pVoice->durationFrames * 1000) / kEngineSampleRate);
+    if (!m_isOffline) {
+        startNotificationTimers();
+    }
+    target.state = Playing;
+}
+
+bool AudioEngine::ensureDeviceStarted()
+{
+    if (m_isOffline) {
+        return true;
+    }
+    // Открываем устройство при первом воспроизведении и запускаем, если оно остановлено
+    if (!m_isDeviceInitialized && !openDevice()) {
+        return false;
+    }
+    if (!ma_device_is_started(m_playbackDevice) && ma_device_start(m_playbackDevice) != MA_SUCCESS) {
+        OSD_LOG_WARNING(Device, "Failed to start playback device");
+        return false;
+    }
+    return true;
+}
+
+void AudioEngine::startVoice(Voice* pNewVoice, int deck)
+{
+    Deck& target = m_decks[deck];
+    if (!ensureDeviceStarted()) {
+        destroyVoice(pNewVoice);
+        updateDeviceState();
+        return;
+    }
+    chokeDecks(deck, pNewVoice->chokeGroup, false);
+
+    // Получаем длительность и отправляем сигнал в UI
+    ma_uint64 durationMillis = (pNewVoice->durationFrames * 1000) / kEngineSampleRate;
+    emit durationReady(deck, durationMillis);
+
+    // Атомарно подменяем указатель на новый голос. Обмен, а не запись: колбэк мог успеть
+    // поставить на деку голос из triggerSound()
+    target.positionMillis.store((pNewVoice->startFrame * 1000) / kEngineSampleRate);
+    if (Voice* pRacedVoice = target.pVoice.exchange(pNewVoice)) {
+        retireVoice(pRacedVoice);
+    }
+    if (!m_isOffline) {
+        startNotificationTimers();
+    }
+    target.state = Playing;
+}
+
+void AudioEngine::chokeDecks(int deck, int chokeGroup, bool isPausedOnly)
+{
+    // Группа глушения: голоса той же группы на других деках затихают в ближайшем колбэке.
+    // Стоящий на паузе голос колбэк не рендерит, поэтому его деку останавливаем сразу
+    if (chokeGroup == 0) {
+        return;
+    }
+    for (int i = 0; i < kDeckCount; ++i) {
+        Voice* pOther = playingVoice(m_decks[i]);
+        if (i == deck || pOther == nullptr || pOther->chokeGroup != chokeGroup) {
+            continue;
+        }
+        if (m_decks[i].isPaused.load()) {
+            stopDeck(i);
+            emit playbackFinished(i);
+        } else if (!isPausedOnly) {
+            pOther->isChoked.store(true);
+        }
+    }
+}
+
+bool AudioEngine::queueSound(const QString& filePath, const PlaybackRegion& region, const VoiceParams& params,
+                             int deck, ma_uint64 crossfadeMillis)
+{
+    if (!isValidDeck(deck)) {
+        OSD_LOG_WARNING(Engine, "Invalid deck deck=%d", deck);
+        return false;
+    }
+    Deck& target = m_decks[deck];
+    Voice* pCurrent = target.pVoice.load();
+    // Переход уже начат: очередь сменится после queueAdvanced()
+    if (pCurrent == nullptr || target.state == Stopped || pCurrent->isHandedOver.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // Прежнюю очередь заменяем, только если колбэк еще не начал ее играть
+    Voice* pOldQueued = target.pNextVoice.load();
+    if (pOldQueued != nullptr) {
+        if (pOldQueued->isQueueClaimed.exchange(true)) {
+            return false;
+        }
+        target.pNextVoice.store(nullptr);
+        retireVoice(pOldQueued);
+    }
+
+    // Декодер открывается сейчас, пока играет текущий трек: к стыку начало уже прочитано
+    ma_uint64 durationFrames = 0;
+    Voice* pNewVoice = createVoice(filePath, region, params, deck, &durationFrames);
+    if (pNewVoice == nullptr) {
+        return false;
+    }
+
+    // Склейка не длиннее половины любого из треков; та же косинусная кривая, что у fade области.
+    // Вес хвоста — gains[k], вес начала — тот же массив с конца
+    const ma_uint64 fadeFrames = std::min({(crossfadeMillis * kEngineSampleRate) / 1000, pNewVoice->regionFrames / 2,
+                                           pCurrent->regionFrames / 2});
+    pNewVoice->queueFadeGains.resize(fadeFrames);
+    for (ma_uint64 i = 0; i < fadeFrames; ++i) {
+        const double phase = (static_cast<double>(i) + 0.5) / static_cast<double>(fadeFrames);
+        pNewVoice->queueFadeGains[i] = static_cast<float>(std::cos(phase * std::numbers::pi / 2.0));
+    }
+
+    target.pNextVoice.store(pNewVoice, std::memory_order_release);
+    OSD_LOG_DEBUG(Engine, "Queued deck=%d crossfadeFrames=%llu source=%s path=\"%s\"", deck,
+                  static_cast<unsigned long long>(fadeFrames), pNewVoice->clip ? "resident" : "streamed",
+                  qUtf8Printable(filePath));
+    return true;
+}
+
+void AudioEngine::clearQueue(int deck)
+{
+    if (!isValidDeck(deck)) {
+        return;
+    }
+    // Очередь, которую колбэк уже играет, остается: она сменит текущий голос сама
+    Voice* pQueuedVoice = m_decks[deck].pNextVoice.load();
+    if (pQueuedVoice == nullptr || pQueuedVoice->isQueueClaimed.exchange(true)) {
+        return;
+    }
+    m_decks[deck].pNextVoice.store(nullptr);
+    retireVoice(pQueuedVoice);
+}
+
+void AudioEngine::pause(int deck)
+{
+    if (!isValidDeck(deck) || m_decks[deck].state != Playing) {
+        return;
+    }
+    // Пауза — флаг деки: остальные деки и микрофон продолжают звучать
+    m_decks[deck].isPaused.store(true);
+    m_decks[deck].state = Paused;
+    updateDeviceState();
+    OSD_LOG_DEBUG(Engine, "Paused deck=%d", deck);
+}
+
+void AudioEngine::resume(int deck)
+{
+    if (!isValidDeck(deck) || m_decks[deck].state != Paused) {
+        return;
+    }
+    m_decks[deck].isPaused.store(false);
+    m_decks[deck].state = Playing;
+    if (m_isOffline) {
+        return;
+    }
+    // Устройство могло быть закрыто, если его отключили во время паузы
+    if (!isDeviceRunning() &&
+        ((!m_isDeviceInitialized && !openDevice()) || ma_device_start(m_playbackDevice) != MA_SUCCESS)) {
+        OSD_LOG_WARNING(Device, "Failed to resume playback device");
+        stopDeck(deck); // В случае ошибки останавливаем деку
+        return;
+    }
+    startNotificationTimers();
+    OSD_LOG_DEBUG(Engine, "Resumed deck=%d", deck);
+}
+
+void AudioEngine::stopDeck(int deck)
+{
+    if (!isValidDeck(deck)) {
+        return;
+    }
+    // Атомарно забираем указатель на голос деки и заменяем его на nullptr
+    Deck& target = m_decks[deck];
+    Voice* pOldVoice = target.pVoice.exchange(nullptr);
+    Voice* pQueuedVoice = target.pNextVoice.exchange(nullptr);
+    target.isPaused.store(false);
+    target.positionMillis.store(0);
+    target.state = Stopped;
+    updateDeviceState();
+
+    if (pQueuedVoice != nullptr) {
+        retireVoice(pQueuedVoice);
+    }
+    if (pOldVoice != nullptr) {
+        retireVoice(pOldVoice);
+        OSD_LOG_DEBUG(Engine, "Stopped deck=%d", deck);
+    }
+}
+
+void AudioEngine::stopAllSounds()
+{
+    for (int deck = 0; deck < kDeckCount; ++deck) {
+        stopDeck(deck);
+    }
+}
+
+void AudioEngine::updateDeviceState()
+{
+    if (isAnyDeckPlaying()) {
+        return;
+    }
+    // Со сквозным микрофоном и во время записи устройство продолжает работать без голосов
+    if (isDeviceRunning() && !isDeviceAlwaysOn()) {
+        stopDevice();
+        OSD_LOG_DEBUG(Device, "Playback device stopped");
+    }
+    m_positionUpdateTimer->stop();
+}
+
+bool AudioEngine::isValidDeck(int deck) const
+{
+    return deck >= 0 && deck < kDeckCount;
+}
+
+bool AudioEngine::isAnyDeckPlaying() const
+{
+    return std::any_of(std::begin(m_decks), std::end(m_decks), [](const Deck& deck) { return deck.state == Playing; });
+}
+
+void AudioEngine::retireVoice(Voice* pVoice)
+{
+    // Остановленное устройство не вызывает dataCallback: ma_device_stop ждет его
+    // завершения, поэтому голос можно удалить сразу. Иначе — ждем следующего колбэка.
+    if (!isDeviceRunning()) {
+        destroyVoice(pVoice);
+        return;
+    }
+    m_retiredVoices.push_back({pVoice, m_callbackSerial.load(std::memory_order_acquire)});
+}
+
+void AudioEngine::collectRetired()
+{
+    const bool isStopped = !isDeviceRunning();
+    const quint64 serial = m_callbackSerial.load(std::memory_order_acquire);
+
+    // Голоса, которые колбэк снял при запуске из triggerSound(), колбэк больше не видит
+    for (Voice* pVoice = m_replacedVoices.exchange(nullptr, std::memory_order_acquire); pVoice != nullptr;) {
+        Voice* pNext = pVoice->pNextReplaced;
+        m_retiredVoices.push_back({pVoice, serial});
+        pVoice = pNext;
+    }
+
+    // Колбэк, успевший загрузить снятый голос, увеличивает счетчик только в конце,
+    // поэтому любое изменение счетчика после отметки означает, что голос свободен
+    auto isDone = [isStopped, serial](const RetiredVoice& retired) {
+        return isStopped || serial > retired.callbackSerial;
+    };
+    for (const RetiredVoice& retired : m_retiredVoices) {
+        if (isDone(retired)) {
+            destroyVoice(retired.pVoice);
+        }
+    }
+    m_retiredVoices.erase(std::remove_if(m_retiredVoices.begin(), m_retiredVoices.end(), isDone), m_retiredVoices.end());
+
+    m_masterEffects.collect(isStopped);
+    m_micEffects.collect(isStopped);
+    m_micSuppressor.collect(isStopped);
+    m_micGate.collect(isStopped);
+    for (Deck& deck : m_decks) {
+        if (Voice* pVoice = deck.pVoice.load()) {
+            pVoice->effects.collect(isStopped);
+        }
+        if (Voice* pVoice = deck.pNextVoice.load()) {
+            pVoice->effects.collect(isStopped);
+        }
+    }
+}
+
+bool AudioEngine::isDeviceRunning() const
+{
+    // Во время инициализации устройство еще не запущено, а его поля пишет другой поток
+    return !m_isInitPending && m_isDeviceInitialized && ma_device_is_started(m_playbackDevice);
+}
+
+bool AudioEngine::isDeviceAlwaysOn() const
+{
+    return m_isMicPassthroughEnabled || m_outputRecorder->isRecording();
+}
+
+void AudioEngine::seek(ma_uint64 positionMillis, int deck)
+{
+    if (isValidDeck(deck)) {
+        m_decks[deck].seekRequestMillis.store(positionMillis);
+    }
+}
+
+void AudioEngine::setVoiceParams(const VoiceParams &params, int deck)
+{
+    // Голос удаляется только в главном потоке, поэтому указатель здесь действителен
+    Voice* pVoice = isValidDeck(deck) ? m_decks[deck].pVoice.load() : nullptr;
+    if (pVoice == nullptr) {
+        return;
+    }
+    pVoice->tempo.store(std::clamp(params.tempo, TimeStretcher::kMinTempo, TimeStretcher::kMaxTempo));
+    pVoice->pitchSemitones.store(std::clamp(params.pitchSemitones, -TimeStretcher::kMaxPitchSemitones,
+                                            TimeStretcher::kMaxPitchSemitones));
+    pVoice->gain.store(std::clamp(params.gain, 0.0f, kMaxVoiceGain));
+    applyEffectSettings(&pVoice->effects, &pVoice->effectSettings, params.effects);
+}
+
+namespace {
+
+// Собирает цепочку в фиксированном порядке узлов; nullptr, если все выключено
+std::unique_ptr<EffectChain> buildEffectChain(const AudioEngine::EffectSettings& settings)
+{
+    if (settings.isDefault()) {
+        return nullptr;
+    }
+    const float sampleRate = static_cast<float>(AudioEngine::kEngineSampleRate);
+    auto chain = std::make_unique<EffectChain>();
+    if (settings.highPassEnabled) {
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighPass, sampleRate, settings.highPassHz));
+    }
+    if (settings.eqEnabled) {
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::LowShelf, sampleRate, 200.0f, settings.eqLowGainDb));
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::Peaking, sampleRate, settings.eqMidHz, settings.eqMidGainDb, 1.0f));
+        chain->append(std::make_unique<BiquadFilter>(BiquadFilter::HighShelf, sampleRate, 4000.0f, settings.eqHighGainDb));
+    }
+    if (settings.bitcrushEnabled) {
+        chain->append(std::make_unique<BitcrushEffect>(sampleRate, settings.bitcrushBits, settings.bitcrushDownsample, settings.bitcrushMix));
+    }
+    if (settings.robotEnabled) {
+        chain->append(std::make_unique<RobotVoiceEffect>(sampleRate, settings.robotHz, settings.robotMix));
+    }
+    if (settings.reverbEnabled) {
+        chain->append(std::make_unique<ReverbEffect>(sampleRate, settings.reverbRoomSize, settings.reverbDamping, settings.reverbWet));
+    }
+    return chain;
+}
+
+// Переносит параметры в уже работающую цепочку того же состава (порядок как в buildEffectChain)
+void updateEffectChain(EffectChain* pChain, const AudioEngine::EffectSettings& settings)
+{
+    size_t index = 0;
+    if (settings.highPassEnabled) {
+        pChain->node(index++)->setParameter(BiquadFilter::Frequency, settings.highPassHz);
+    }
+    if (settings.eqEnabled) {
+        pChain->node(index++)->setParameter(BiquadFilter::GainDb, settings.eqLowGainDb);
+        EffectNode* pMid = pChain->node(index++);
+        pMid->setParameter(BiquadFilter::Frequency, settings.eqMidHz);
+        pMid->setParameter(BiquadFilter::GainDb, settings.eqMidGainDb);
+        pChain->node(index++)->setParameter(BiquadFilter::GainDb, settings.eqHighGainDb);
+    }
+    if (settings.bitcrushEnabled) {
+        EffectNode* pNode = pChain->node(index++);
+        pNode->setParameter(BitcrushEffect::Bits, settings.bitcrushBits);
+        pNode->setParameter(BitcrushEffect::Downsample, settings.bitcrushDownsample);
+        pNode->setParameter(BitcrushEffect::Mix, settings.bitcrushMix);
+    }
+    if (settings.robotEnabled) {
+        EffectNode* pNode = pChain->node(index++);
+        pNode->setParameter(RobotVoiceEffect::Frequency, settings.robotHz);
+        pNode->setParameter(RobotVoiceEffect::Mix, settings.robotMix);
+    }
+    if (settings.reverbEnabled) {
+        EffectNode* pNode = pChain->node(index++);
+        pNode->setParameter(ReverbEffect::RoomSize, settings.reverbRoomSize);
+        pNode->setParameter(ReverbEffect::Damping, settings.reverbDamping);
+        pNode->setParameter(ReverbEffect::Wet, settings.reverbWet);
+    }
+}
+
+} // namespace
+
+void AudioEngine::applyEffectSettings(EffectChainSlot* pSlot, EffectSettings* pCurrent, const EffectSettings& settings)
+{
+    // Тот же набор узлов — плавно меняем параметры, иначе подменяем цепочку целиком
+    if (pSlot->chain() != nullptr && settings.hasSameNodes(*pCurrent)) {
+        updateEffectChain(pSlot->chain(), settings);
+    } else if (pSlot->chain() != nullptr || !settings.isDefault()) {
+        pSlot->publish(buildEffectChain(settings));
+    }
+    *pCurrent = settings;
+}
+
+void AudioEngine::setMasterEffects(const EffectSettings &settings)
+{
+    applyEffectSettings(&m_masterEffects, &m_masterEffectSettings, settings);
+    collectRetired();
+}
+
+void AudioEngine::setMicEffects(const EffectSettings &settings)
+{
+    applyEffectSettings(&m_micEffects, &m_micEffectSettings, settings);
+    collectRetired();
+}
+
+void AudioEngine::setMicPassthroughEnabled(bool enabled)
+{
+    if (m_isInitPending) {
+        m_deferredSettings.isMicPassthroughEnabled = enabled;
+        return;
+    }
+    if (enabled == m_isMicPassthroughEnabled) {
+        return;
+    }
+    m_isMicPassthroughEnabled = enabled;
+    OSD_LOG_INFO(Device, "Microphone passthrough enabled=%d", enabled ? 1 : 0);
+
+    if (!m_isContextInitialized) {
+        return; // Устройство откроется с нужным режимом при первом запуске
+    }
+    // Режим устройства (вывод или дуплекс) задается только при открытии
+    if (m_isDeviceInitialized || enabled) {
+        collectRetired();
+        reopenDevice(); // Без микрофона устройство запустится, только если что-то играет
+    }
+}
+
+void AudioEngine::setMicNoiseSuppression(bool enabled, float reductionDb)
+{
+    if (enabled && m_micSuppressor.chain() != nullptr) {
+        m_micSuppressor.chain()->node(0)->setParameter(NoiseSuppressor::ReductionDb, reductionDb);
+        return;
+    }
+    if (enabled) {
+        auto chain = std::make_unique<EffectChain>();
+        chain->append(std::make_unique<NoiseSuppressor>(static_cast<float>(kEngineSampleRate), reductionDb));
+        m_micSuppressor.publish(std::move(chain));
+    } else if (m_micSuppressor.chain() != nullptr) {
+        m_micSuppressor.publish(nullptr);
+    } else {
+        return;
+    }
+    OSD_LOG_INFO(Engine, "Microphone noise suppression enabled=%d reduction_db=%.1f latency_frames=%zu",
+                 enabled ? 1 : 0, reductionDb, NoiseSuppressor::kLatencyFrames);
+    collectRetired();
+}
+
+void AudioEngine::setMicNoiseGate(bool enabled, float thresholdDb)
+{
+    if (enabled && m_micGate.chain() != nullptr) {
+        m_micGate.chain()->node(0)->setParameter(NoiseGateEffect::ThresholdDb, thresholdDb);
+        return;
+    }
+    if (enabled) {
+        auto chain = std::make_unique<EffectChain>();
+        chain->append(std::make_unique<NoiseGateEffect>(static_cast<float>(kEngineSampleRate), thresholdDb));
+        m_micGate.publish(std::move(chain));
+    } else if (m_micGate.chain() != nullptr) {
+        m_micGate.publish(nullptr);
+    } else {
+        return;
+    }
+    OSD_LOG_INFO(Engine, "Microphone noise gate enabled=%d threshold_db=%.1f", enabled ? 1 : 0, thresholdDb);
+    collectRetired();
+}
+
+void AudioEngine::setMicVolume(float volume)
+{
+    m_micVolume.store(std::clamp(volume, 0.0f, 1.0f));
+}
+
+void AudioEngine::setMonitoringVolume(float volume)
+{
+    float clampedVolume = std::max(0.0f, std::min(1.0f, volume));
+    m_monitoringVolume.store(clampedVolume);
+}
+
+void AudioEngine::setDeckVolume(int deck, float volume)
+{
+    if (isValidDeck(deck)) {
+        m_decks[deck].volume.store(std::clamp(volume, 0.0f, 1.0f));
+    }
+}
+
+void AudioEngine::setRepeatEnabled(bool enabled, int deck)
+{
+    if (isValidDeck(deck)) {
+        m_decks[deck].isRepeatEnabled.store(enabled);
+    }
+}
+
+AudioEngine::PlaybackState AudioEngine::getPlaybackState(int deck) const
+{
+    return isValidDeck(deck) ? m_decks[deck].state : Stopped;
+}
+
+void AudioEngine::setSampleStoreEnabled(bool enabled)
+{
+    m_isSampleStoreEnabled = enabled;
+    if (!enabled) {
+        m_sampleStore->clear();
+    } else {
+        updatePreferredSounds(true);
+    }
+    OSD_LOG_INFO(Store, "Compressed sample store enabled=%d", enabled ? 1 : 0);
+}
+
+bool AudioEngine::isSampleStoreEnabled() const
+{
+    return m_isSampleStoreEnabled;
+}
+
+void AudioEngine::setSampleStoreBudget(size_t budgetBytes)
+{
+    m_sampleStore->setBudget(budgetBytes);
+}
+
+void AudioEngine::preloadSound(const QString &filePath)
+{
+    if (!m_isSampleStoreEnabled || m_sampleStore->contains(filePath)) {
+        return;
+    }
+
+    // Декодирование и сжатие — в пуле потоков, чтобы не блокировать UI
+    std::shared_ptr<SampleStore> store = m_sampleStore;
+    QThreadPool::globalInstance()->start([store, filePath]() {
+        store->load(filePath, kEngineChannels, kEngineSampleRate);
+    });
+}
+
+void AudioEngine::forgetSound(const QString &filePath)
+{
+    // Играющий голос держит свою копию клипа и доиграет ее
+    m_sampleStore->remove(filePath);
+    m_decoderPrimer->forget(filePath);
+}
+
+void AudioEngine::armSounds(const QStringList &filePaths)
+{
+    if (!m_isSampleStoreEnabled) {
+        return;
+    }
+    m_sampleStore->setPinned(QSet<QString>(filePaths.cbegin(), filePaths.cend()));
+
+    // Одна задача на весь набор: клипы грузятся в порядке строк, а при переключении
+    // на другой банк до окончания загрузки оставшиеся файлы этого набора пропускаются
+    const quint64 generation = m_armGeneration->fetch_add(1) + 1;
+    std::shared_ptr<std::atomic<quint64>> currentGeneration = m_armGeneration;
+    std::shared_ptr<SampleStore> store = m_sampleStore;
+    QThreadPool::globalInstance()->start([store, currentGeneration, generation, filePaths]() {
+        for (const QString& filePath : filePaths) {
+            if (currentGeneration->load() != generation) {
+                return;
+            }
+            store->load(filePath, kEngineChannels, kEngineSampleRate);
+        }
+    });
+}
+
+void AudioEngine::primeSounds(const QList<QPair<QString, PlaybackRegion>>& sounds)
+{
+    QList<DecoderPrimer::Request> requests;
+    for (const auto& [filePath, region] : sounds) {
+        if (m_isSampleStoreEnabled && m_sampleStore->contains(filePath)) {
+            continue;
+        }
+        const DecoderPrimer::Request request{filePath, (region.startMillis * kEngineSampleRate) / 1000};
+        if (!requests.contains(request)) {
+            requests.append(request);
+        }
+    }
+    m_decoderPrimer->prime(requests);
+}
+
+void AudioEngine::setPrimeBudget(size_t budgetBytes)
+{
+    m_decoderPrimer->setBudget(budgetBytes);
+}
+
+int AudioEngine::primedSoundCount() const
+{
+    return m_decoderPrimer->primedCount();
+}
+
+void AudioEngine::setUsageFile(const QString& filePath)
+{
+    m_usageStore->load(filePath);
+    updatePreferredSounds(true);
+}
+
+void AudioEngine::setReplaySeconds(int seconds)
+{
+    m_outputRecorder->setReplaySeconds(seconds);
+}
+
+bool AudioEngine::startRecording(const QString& filePath)
+{
+    if (!m_outputRecorder->startRecording(filePath)) {
+        return false;
+    }
+    // Тишина между звуками тоже идет в файл: устройство запускается сразу, а не с первым голосом
+    if (!m_isOffline && m_isContextInitialized && !isDeviceRunning() &&
+        ((!m_isDeviceInitialized && !openDevice()) || ma_device_start(m_playbackDevice) != MA_SUCCESS)) {
+        OSD_LOG_WARNING(Device, "Failed to start the device for recording");
+    }
+    return true;
+}
+
+void AudioEngine::stopRecording()
+{
+    m_outputRecorder->stopRecording();
+    updateDeviceState();
+}
+
+bool AudioEngine::isRecording() const
+{
+    return m_outputRecorder->isRecording();
+}
+
+bool AudioEngine::saveReplay(const QString& filePath)
+{
+    return m_outputRecorder->saveReplay(filePath);
+}
+
+OutputRecorder::Stats AudioEngine::recordingStats() const
+{
+    return m_outputRecorder->stats();
+}
+
+void AudioEngine::updatePreferredSounds(bool isPreloading)
+{
+    const QStringList filePaths = m_usageStore->ranked(kPreferredSounds);
+    m_sampleStore->setPreferred(QSet<QString>(filePaths.cbegin(), filePaths.cend()));
+    if (!isPreloading || !m_isSampleStoreEnabled) {
+        return;
+    }
+    for (const QString& filePath : filePaths) {
+        if (QFileInfo::exists(filePath)) { // Статистика переживает переименования и удаления
+            preloadSound(filePath);
+        }
+    }
+}
+
+void AudioEngine::onUsageSaveTimer()
+{
+    // Частые клипы за сессию меняются медленно: набор обновляется вместе с записью
+    updatePreferredSounds(false);
+    if (!m_usageStore->isDirty()) {
+        return;
+    }
+    std::shared_ptr<UsageStore> store = m_usageStore;
+    QThreadPool::globalInstance()->start([store]() { store->save(); });
+}
+
+void AudioEngine::onUpdatePositionTimer()
+{
+    collectRetired();
+    for (int deck = 0; deck < kDeckCount; ++deck) {
+        if (m_decks[deck].state == Playing) {
+            emit positionChanged(deck, m_decks[deck].positionMillis.load());
+        }
+    }
+}
+
+void AudioEngine::startNotificationTimers()
+{
+    m_positionUpdateTimer->start();
+    if (!m_notificationTimer->isActive()) {
+        m_notificationTimer->start();
+    }
+}
+
+void AudioEngine::onNotificationTimer()
+{
+    drainNotifications();
+    // Останавливается сам, а не в updateDeviceState(): сообщения последних блоков еще в очереди
+    if (!isAnyDeckPlaying()) {
+        m_notificationTimer->stop();
+    }
+}
+
+void AudioEngine::drainNotifications()
+{
+    NotificationQueue::Notification notification;
+    while (m_notifications.pop(&notification)) {
+        switch (notification.type) {
+        case NotificationQueue::PlaybackFinished:
+            postPlaybackFinished(notification.deck);
+            break;
+        case NotificationQueue::QueueAdvanced:
+            postQueueAdvanced(notification.deck);
+            break;
+        case NotificationQueue::CueReached:
+            emit cueReached(notification.deck, notification.cueIndex);
+            break;
+        }
+    }
+    const quint64 dropped = m_notifications.droppedCount();
+    if (dropped != m_reportedDroppedNotifications) {
+        OSD_LOG_WARNING(Engine, "Engine notifications dropped count=%llu",
+                        static_cast<unsigned long long>(dropped - m_reportedDroppedNotifications));
+        m_reportedDroppedNotifications = dropped;
+    }
+}
+
+// Вызывается в главном потоке из drainNotifications()
+void AudioEngine::postPlaybackFinished(int deck)
+{
+    // Пока сообщение шло, на деке мог запуститься новый голос — его не трогаем
+    Voice* pVoice = isValidDeck(deck) ? m_decks[deck].pVoice.load() : nullptr;
+    if (pVoice == nullptr || !pVoice->isFinished.load(std::memory_order_acquire) || pVoice->isHandedOver.load(std::memory_order_acquire)) {
+        return;
+    }
+    // Обмен, а не stopDeck() напрямую: колбэк мог только что поставить голос из triggerSound()
+    if (!m_decks[deck].pVoice.compare_exchange_strong(pVoice, nullptr)) {
+        return;
+    }
+    retireVoice(pVoice);
+    stopDeck(deck);
+    emit playbackFinished(deck);
+}
+
+void AudioEngine::postQueueAdvanced(int deck)
+{
+    Voice* pVoice = isValidDeck(deck) ? m_decks[deck].pVoice.load() : nullptr;
+    Voice* pNext = pVoice != nullptr ? m_decks[deck].pNextVoice.load() : nullptr;
+    if (pNext == nullptr || !pVoice->isFinished.load(std::memory_order_acquire) || !pVoice->isHandedOver.load(std::memory_order_acquire)) {
+        return;
+    }
+    // Колбэк уже играет очередь через playingVoice(): порядок записей не дает ему пропустить блок.
+    // Голос мог смениться запуском из triggerSound() — тогда колбэк снял и его, и очередь
+    if (!m_decks[deck].pVoice.compare_exchange_strong(pVoice, pNext)) {
+        return;
+    }
+    m_decks[deck].pNextVoice.store(nullptr);
+    retireVoice(pVoice);
+    OSD_LOG_DEBUG(Engine, "Queue advanced deck=%d", deck);
+
+    emit durationReady(deck, (pNext->durationFrames * 1000) / kEngineSampleRate);
+    emit queueAdvanced(deck);
+    // Очередь короче склейки могла отыграть целиком внутри перехода
+    if (pNext->isFinished.load(std::memory_order_acquire)) {
+        postPlaybackFinished(deck);
+    }
+}
+
+void AudioEngine::onDeviceLost()
+{
+    OSD_LOG_WARNING(Device, "Playback device lost name=\"%s\"", qUtf8Printable(m_activeDeviceName));
+    if (isAnyDeckPlaying() || m_isMicPassthroughEnabled) {
+        reopenDevice();
+    } else {
+        // Откроем заново при следующем воспроизведении
+        closeDevice();
+    }
+}
+
+void AudioEngine::onDeviceRerouted()
+{
+    if (!m_isDeviceInitialized) {
+        return;
+    }
+    m_activeDeviceName = QString::fromUtf8(m_playbackDevice->playback.name);
+    OSD_LOG_INFO(Device, "Playback rerouted name=\"%s\"", qUtf8Printable(m_activeDeviceName));
+    emit outputDeviceChanged(m_activeDeviceName);
+}
+
+void AudioEngine::onDeviceWatchTimer()
+{
+    collectRetired();
+    if (!m_isDeviceInitialized) {
+        m_lastDefaultDeviceName.clear();
+        return;
+    }
+    // Остановленное устройство не сверяем: смену заметит первый опрос после запуска.
+    // Медленный бэкенд может не успеть за интервал — новый опрос ждет предыдущий
+    if (!isDeviceRunning() || m_isDeviceWatchPending) {
+        return;
+    }
+
+    m_isDeviceWatchPending = true;
+    const quint64 serial = m_deviceWatchSerial;
+    const QByteArray selectedId = m_selectedDeviceId;
+    const QString selectedName = m_selectedDeviceName;
+    m_deviceWatchPool.start([this, serial, selectedId, selectedName]() {
+        const DeviceWatch watch = watchDevices(m_context, selectedId, selectedName);
+        // Движок ждет пул в деструкторе, поэтому this здесь жив; событие удаленному объекту Qt не доставит
+        QMetaObject::invokeMethod(this, [this, serial, watch]() {
+            m_isDeviceWatchPending = false;
+            if (serial == m_deviceWatchSerial && m_isDeviceInitialized) {
+                applyDeviceWatch(watch);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+AudioEngine::DeviceWatch AudioEngine::watchDevices(ma_context* pContext, const QByteArray& selectedId,
+                                                   const QString& selectedName)
+{
+    struct Enumeration {
+        DeviceWatch* pWatch;
+        const QByteArray* pSelectedId;
+        const QString* pSelectedName;
+    };
+    DeviceWatch watch;
+    Enumeration enumeration{&watch, &selectedId, &selectedName};
+
+    // В отличие от ma_context_get_devices(), перечисление не пишет в общий массив контекста
+    // и не мешает playbackDevices() в главном потоке
+    const ma_result result = ma_context_enumerate_devices(
+        pContext,
+        [](ma_context*, ma_device_type deviceType, const ma_device_info* pInfo, void* pUserData) -> ma_bool32 {
+            if (deviceType != ma_device_type_playback) {
+                return MA_TRUE;
+            }
+            Enumeration* pEnumeration = static_cast<Enumeration*>(pUserData);
+            const QString name = QString::fromUtf8(pInfo->name);
+            if (pInfo->isDefault) {
+                pEnumeration->pWatch->defaultDeviceName = name;
+            }
+            if (!pEnumeration->pSelectedId->isEmpty() &&
+                (isSameDevice(*pEnumeration->pSelectedId, pInfo->id) || name == *pEnumeration->pSelectedName)) {
+                pEnumeration->pWatch->isSelectedPresent = true;
+            }
+            return MA_TRUE;
+        },
+        &enumeration);
+    watch.isListed = result == MA_SUCCESS;
+    return watch;
+}
+
+void AudioEngine::applyDeviceWatch(const DeviceWatch& watch)
+{
+    if (!watch.isListed) {
+        OSD_LOG_WARNING(Device, "Failed to enumerate playback devices");
+        return;
+    }
+
+    const bool defaultChanged = !m_lastDefaultDeviceName.isEmpty() && watch.defaultDeviceName != m_lastDefaultDeviceName;
+    m_lastDefaultDeviceName = watch.defaultDeviceName;
+
+    if (m_selectedDeviceId.isEmpty()) {
+        // Следуем за системным устройством по умолчанию
+        if (defaultChanged && watch.defaultDeviceName != m_activeDeviceName) {
+            OSD_LOG_INFO(Device, "Default output device changed name=\"%s\"", qUtf8Printable(watch.defaultDeviceName));
+            reopenDevice();
+        }
+    } else if (m_isUsingFallbackDevice && watch.isSelectedPresent) {
+        OSD_LOG_INFO(Device, "Selected output device is back name=\"%s\"", qUtf8Printable(m_selectedDeviceName));
+        reopenDevice();
+    } else if (!m_isUsingFallbackDevice && !watch.isSelectedPresent) {
+        OSD_LOG_WARNING(Device, "Selected output device disappeared name=\"%s\"", qUtf8Printable(m_selectedDeviceName));
+        reopenDevice();
+    }
 }
@@ -22,9 +22,28 @@
 
 #include <QObject>
 #include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+#include <QPair>
 #include <atomic> // Для атомарных операций
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
 #include <QTimer>
+#include <QThreadPool>
 #include "miniaudio.h"
+#include "SampleStore.h"
+#include "TimeStretcher.h"
+#include "Effects.h"
+#include "EngineStats.h"
+#include "ParallelMixer.h"
+#include "StreamScheduler.h"
+#include "DecoderPrimer.h"
+#include "UsageStore.h"
+#include "OutputRecorder.h"
+#include "NotificationQueue.h"
 
 class AudioEngine : public QObject
 {
@@ -37,39 +56,474 @@ public:
         Paused
     };
 
+    // Внутренний формат движка: все источники приводятся к нему при декодировании
+    static constexpr ma_uint32 kEngineChannels = 2;
+    static constexpr ma_uint32 kEngineSampleRate = 48000;
+
+    // Деки (банки) играют одновременно и сводятся в один выход. У каждой свой голос,
+    // пауза, перемотка, повтор и громкость; новый звук на деке заменяет ее прежний голос.
+    static constexpr int kDeckCount = 4;
+
+    // Описание устройства вывода для UI и сохранения в настройках
+    struct DeviceInfo {
+        QString name;
+        QByteArray id; // Сырые байты ma_device_id
+        bool isDefault;
+    };
+
+    // Снимок задержек для индикатора в настройках
+    struct LatencyInfo {
+        double periodMillis;            // Фактический период устройства
+        double bufferMillis;            // Период * число периодов
+        double callbackIntervalMillis;  // Измеренный интервал между вызовами dataCallback
+        double triggerToCallbackMillis; // От playSound() до первого колбэка с новым голосом
+        double outputLatencyMillis;     // Оценка от нажатия до выхода: колбэк + буфер устройства
+    };
+
+    // Область воспроизведения трека: обрезка, петля и метки. Нули означают «по умолчанию».
+    struct PlaybackRegion {
+        ma_uint64 startMillis = 0;
+        ma_uint64 endMillis = 0;       // 0 — до конца файла
+        bool loop = false;
+        ma_uint64 loopStartMillis = 0; // 0 — с начала области
+        ma_uint64 loopEndMillis = 0;   // 0 — до конца области
+        ma_uint64 crossfadeMillis = 0; // Склейка конца петли с ее началом
+        QList<ma_uint64> cueMillis;
+
+        bool isDefault() const {
+            return startMillis == 0 && endMillis == 0 && !loop && loopStartMillis == 0 &&
+                   loopEndMillis == 0 && crossfadeMillis == 0 && cueMillis.isEmpty();
+        }
+    };
+
+    // Настройки цепочки эффектов. Порядок узлов фиксирован:
+    // срез низов -> эквалайзер -> bitcrush -> робот -> реверберация.
+    struct EffectSettings {
+        bool highPassEnabled = false;
+        float highPassHz = 80.0f;
+        bool eqEnabled = false;
+        float eqLowGainDb = 0.0f;   // Полка 200 Гц
+        float eqMidGainDb = 0.0f;
+        float eqMidHz = 1000.0f;
+        float eqHighGainDb = 0.0f;  // Полка 4 кГц
+        bool bitcrushEnabled = false;
+        float bitcrushBits = 8.0f;
+        float bitcrushDownsample = 4.0f;
+        float bitcrushMix = 1.0f;
+        bool robotEnabled = false;
+        float robotHz = 50.0f;
+        float robotMix = 1.0f;
+        bool reverbEnabled = false;
+        float reverbRoomSize = 0.6f;
+        float reverbDamping = 0.4f;
+        float reverbWet = 0.25f;
+
+        bool isDefault() const {
+            return !highPassEnabled && !eqEnabled && !bitcrushEnabled && !robotEnabled && !reverbEnabled;
+        }
+        // Совпадает набор узлов — параметры можно менять на лету без пересборки цепочки
+        bool hasSameNodes(const EffectSettings& other) const {
+            return highPassEnabled == other.highPassEnabled && eqEnabled == other.eqEnabled &&
+                   bitcrushEnabled == other.bitcrushEnabled && robotEnabled == other.robotEnabled &&
+                   reverbEnabled == other.reverbEnabled;
+        }
+    };
+
+    static constexpr float kMaxVoiceGain = 2.0f;
+
+    // Темп, высота тона, громкость и эффекты голоса. Значения по умолчанию отключают обработку полностью.
+    struct VoiceParams {
+        float tempo = 1.0f;          // 0.5..2.0
+        float pitchSemitones = 0.0f; // -12..+12
+        float gain = 1.0f;           // 0..kMaxVoiceGain, поверх громкости мониторинга
+        int chokeGroup = 0;          // Запуск глушит голоса той же группы на других деках; 0 — без группы
+        EffectSettings effects;
+
+        bool isDefault() const {
+            return tempo == 1.0f && pitchSemitones == 0.0f && gain == 1.0f && chokeGroup == 0 && effects.isDefault();
+        }
+    };
+
     explicit AudioEngine(QObject *parent = nullptr);
     ~AudioEngine();
 
     bool init();
-    void playSound(const QString& filePath);
-    void pause();
-    void resume();
+    // Открывает контекст и устройство в фоновом потоке, пока главный поток строит окно.
+    // До waitForInit() можно вызывать только сеттеры настроек, громкость и setMicVolume().
+    // Настройки контекста и устройства до waitForInit() только запоминаются: он применяет
+    // их после открытия одним переоткрытием и сам сообщает outputDeviceChanged().
+    void beginInit();
+    bool waitForInit();
+    // Движок без устройства для офлайн-рендера (см. OfflineRenderer.h): вместо init().
+    // Громкость мониторинга 1.0; звук забирается renderOffline() тем же микшером, что у колбэка,
+    // поэтому одинаковая последовательность вызовов дает побитово одинаковый результат.
+    void initOffline();
+    void renderOffline(float* pOutput, ma_uint32 frameCount);
+    // eventTimeNs — момент события (clockNanoseconds()) для внешних триггеров с меткой времени:
+    // звук ставится с постоянной задержкой от события с точностью до семпла. 0 — как можно раньше.
+    void playSound(const QString& filePath, const PlaybackRegion& region = PlaybackRegion(),
+                   const VoiceParams& params = VoiceParams(), qint64 eventTimeNs = 0, int deck = 0);
+    // Запуск из потока входа (MIDI) в обход цикла событий главного потока: голос готовится
+    // в вызывающем потоке, и ближайший колбэк сам ставит его на деку. Главный поток потом
+    // только отмечает запуск (состояние деки, durationReady), а если устройство стоит —
+    // запускает его и голос. Параметры — как у playSound(); вызывать можно из любого потока.
+    void triggerSound(const QString& filePath, const PlaybackRegion& region, const VoiceParams& params,
+                      qint64 eventTimeNs, int deck);
+    void setVoiceParams(const VoiceParams& params, int deck = 0); // Меняет темп, тон, громкость и эффекты на лету
+    // Бесшовная очередь: голос открывается сразу, а вступает в колбэке с точностью до семпла,
+    // когда текущий голос деки доходит до конца (с равномощной склейкой crossfadeMillis).
+    // Новый вызов заменяет прежнюю очередь; false — деке нечего продолжать или переход уже идет.
+    // Повтор деки и петля области держат текущий голос, очередь ждет.
+    bool queueSound(const QString& filePath, const PlaybackRegion& region = PlaybackRegion(),
+                    const VoiceParams& params = VoiceParams(), int deck = 0, ma_uint64 crossfadeMillis = 0);
+    void clearQueue(int deck = 0);
+    void pause(int deck = 0);
+    void resume(int deck = 0);
+    void stopDeck(int deck);
     void stopAllSounds();
-    void seek(ma_uint64 positionMillis);
+    void seek(ma_uint64 positionMillis, int deck = 0);
     void setMonitoringVolume(float volume);
-    PlaybackState getPlaybackState() const;
+    void setDeckVolume(int deck, float volume);
+    void setRepeatEnabled(bool enabled, int deck = 0); // Бесшовно зацикливает текущую область
+    PlaybackState getPlaybackState(int deck = 0) const;
+    bool isAnyDeckPlaying() const;
+
+    // Шины эффектов и сквозной микрофон. При включенном микрофоне устройство
+    // открывается в дуплексе и работает постоянно, а не только во время воспроизведения.
+    void setMasterEffects(const EffectSettings& settings);
+    void setMicEffects(const EffectSettings& settings);
+    void setMicPassthroughEnabled(bool enabled);
+    void setMicVolume(float volume);
+    // Очистка микрофона до его эффектов: шумоподавление (задержка NoiseSuppressor::kLatencyFrames),
+    // затем гейт без задержки. Порог и глубина меняются плавно, без пересборки
+    void setMicNoiseSuppression(bool enabled, float reductionDb);
+    void setMicNoiseGate(bool enabled, float thresholdDb);
+
+    // Устройства вывода. Пустой deviceId означает системное устройство по умолчанию.
+    QList<DeviceInfo> playbackDevices() const;
+    // То же на потоке опроса устройств: медленный бэкенд не держит UI. Список придет
+    // сигналом playbackDevicesListed()
+    void requestPlaybackDevices();
+    void setOutputDevice(const QByteArray& deviceId, const QString& deviceName);
+    void setBufferSize(ma_uint32 periodSizeInFrames, ma_uint32 periods);
+    QString currentDeviceName() const;
+
+    // Параметры низкой задержки. Смена бэкенда или приоритета пересоздает контекст.
+    QStringList availableBackends() const;
+    void setContextOptions(const QString& backendName, bool realtimePriority);
+    void setExclusiveMode(bool exclusive);
+    // Рендер дек на пуле закрепленных потоков: до kDeckCount - 1 рабочих, по деке на участника.
+    // Пул включается в колбэке, только когда голоса занимают заметную часть периода (офлайн —
+    // всегда); сумма дек от этого не меняется ни на бит.
+    void setParallelMixingEnabled(bool enabled);
+    LatencyInfo latencyInfo() const;
+    // Телеметрия колбэка и хранилища клипов для панели диагностики и STATS
+    EngineStats::Snapshot statsSnapshot() const;
+    void resetStats();
+    static qint64 clockNanoseconds(); // steady_clock, общий для движка и источников событий
+
+    // Резидентное хранилище сжатых клипов
+    void setSampleStoreEnabled(bool enabled);
+    bool isSampleStoreEnabled() const;
+    void setSampleStoreBudget(size_t budgetBytes);
+    void preloadSound(const QString& filePath);
+    void forgetSound(const QString& filePath); // Файл изменен или удален: клип в памяти устарел
+    // Клипы активного банка: закрепляются от вытеснения и загружаются в фоне по порядку.
+    // Новый вызов отменяет незаконченную загрузку предыдущего набора.
+    void armSounds(const QStringList& filePaths);
+
+    // Декодеры, открытые заранее: звуки, которые вероятно запустят следующими, по убыванию
+    // приоритета. Звуки из хранилища клипов пропускаются — они и так играют из памяти.
+    void primeSounds(const QList<QPair<QString, PlaybackRegion>>& sounds);
+    void setPrimeBudget(size_t budgetBytes); // 0 — не готовить
+    int primedSoundCount() const;            // Готовые и еще не взятые декодеры
+
+    // Статистика запусков между сессиями; пустой путь — только на эту сессию. Самые частые
+    // клипы держатся в хранилище дольше остальных и прогреваются, когда оно включается
+    void setUsageFile(const QString& filePath);
+    const UsageStore& usage() const { return *m_usageStore; }
+
+    // Запись выхода и буфер повтора (см. OutputRecorder.h). Пока идет запись, устройство
+    // работает и без голосов, чтобы время в файле совпадало с эфиром. Итог — recordingSaved()
+    void setReplaySeconds(int seconds); // 0 — без буфера повтора
+    bool startRecording(const QString& filePath);
+    void stopRecording();
+    bool isRecording() const;
+    bool saveReplay(const QString& filePath);
+    OutputRecorder::Stats recordingStats() const;
 
 signals:
     // Сигналы для обратной связи с UI
-    void positionChanged(ma_uint64 positionMillis);
-    void durationReady(ma_uint64 durationMillis);
-    void playbackFinished();
+    void positionChanged(int deck, ma_uint64 positionMillis);
+    void durationReady(int deck, ma_uint64 durationMillis);
+    void playbackFinished(int deck);
+    void cueReached(int deck, int cueIndex);
+    void queueAdvanced(int deck); // Дека перешла на голос из очереди; очередь пуста
+    void outputDeviceChanged(const QString& deviceName);
+    void playbackDevicesListed(const QList<AudioEngine::DeviceInfo>& devices);
+    void recordingSaved(const QString& filePath, bool isSaved); // Файл записи или повтора закрыт
+
+private slots:
+    void postPlaybackFinished(int deck); // Вспомогательная функция для безопасного вызова сигнала
+    void postQueueAdvanced(int deck);
+    void onDeviceLost();
+    void onDeviceRerouted();
+    void onDeviceWatchTimer();
+    void onNotificationTimer();
+    void onUsageSaveTimer();
 
 private:
+    struct Deck;
+
+    // Сеттеры устройства, вызванные во время фоновой инициализации (см. beginInit())
+    struct DeferredSettings {
+        std::optional<QPair<QString, bool>> contextOptions; // Бэкенд и приоритет
+        std::optional<QPair<QByteArray, QString>> outputDevice;
+        std::optional<QPair<ma_uint32, ma_uint32>> bufferSize;
+        std::optional<bool> isExclusiveMode;
+        std::optional<bool> isMicPassthroughEnabled;
+    };
+
+    // Итог опроса устройств в фоне: системное устройство по умолчанию и есть ли выбранное
+    struct DeviceWatch {
+        QString defaultDeviceName;
+        bool isSelectedPresent = false;
+        bool isListed = false; // Бэкенд вернул список
+    };
+
+    // Источник звука для воспроизведения: потоковый декодер либо сжатый клип из SampleStore
+    struct Voice {
+        ma_decoder* pDecoder = nullptr;
+        std::shared_ptr<const CompressedClip> clip;
+        ClipReader clipReader;
+
+        // Область в кадрах исходника; позиция абсолютная
+        ma_uint64 position = 0;
+        ma_uint64 startFrame = 0;
+        ma_uint64 endFrame = 0;
+        bool loop = false;
+        ma_uint64 loopStartFrame = 0;
+        ma_uint64 loopEndFrame = 0;
+        ma_uint64 crossfadeFrames = 0;
+        std::vector<float> crossfadeHead;  // Начало петли, прочитанное заранее для склейки
+        std::vector<float> crossfadeGains; // Равномощная кривая затухания хвоста
+        std::vector<ma_uint64> cueFrames;  // Отсортированы по возрастанию
+        size_t nextCue = 0;
+
+        // Начало, декодированное DecoderPrimer заранее: кадры с primedStartFrame
+        std::vector<float> primedHead;
+        ma_uint64 primedStartFrame = 0;
+        ma_uint64 primedCursor = 0;
+        bool isDecoderAtHeadEnd = true; // Декодер стоит сразу за началом: петля на начало его не перематывает
+
+        ma_uint64 durationFrames = 0; // Длина файла и области; пишутся до публикации голоса
+        ma_uint64 regionFrames = 0;
+
+        // Голос в очереди деки (Deck::pNextVoice) вступает за queueFadeGains.size() кадров до
+        // конца текущего. Кто первым выставит isQueueClaimed — аудиопоток, начиная переход,
+        // или главный поток, заменяя очередь, — тот и распоряжается голосом
+        std::vector<float> queueFadeGains; // Затухание текущего голоса, как у петли; пусто — стык без склейки
+        ma_uint64 queueFadePosition = 0;
+        std::atomic<bool> isQueueClaimed{false};
+        // Текущий голос уже уступает деку голосу из очереди. Пишет аудиопоток (release),
+        // главный поток читает с acquire, как isChoked и isQueueClaimed
+        std::atomic<bool> isHandedOver{false};
+
+        // Растяжение стоит после области: петли и метки считаются в кадрах исходника
+        AudioEngine* pEngine = nullptr;
+        TimeStretcher stretcher;
+        std::atomic<float> tempo{1.0f};
+        std::atomic<float> pitchSemitones{0.0f};
+        std::atomic<float> gain{1.0f};
+
+        qint64 eventTimeNs = 0; // Метка времени триггера; аудиопоток сбрасывает после первого колбэка
+        // Момент вызова playSound(); первый кадр голоса записывает задержку и сбрасывает его.
+        // У голоса из очереди 0: его начало назначено стыком, а не триггером
+        qint64 triggerTimeNs = 0;
+
+        Deck* pDeck = nullptr;
+        int deckIndex = 0;
+        int chokeGroup = 0;
+        std::atomic<bool> isChoked{false}; // Аудиопоток уводит голос в тишину за один блок и завершает его
+
+        EffectChainSlot effects;
+        EffectSettings effectSettings; // То, что опубликовано в effects (только главный поток)
+        std::atomic<bool> isFinished{false}; // Конец уже отправлен в главный поток; порядок — как у isHandedOver
+        Voice* pNextReplaced = nullptr; // Звено списка m_replacedVoices
+    };
+
+    // Транспорт одной деки. Атомарные поля читает аудиопоток, state — только главный поток
+    struct Deck {
+        std::atomic<Voice*> pVoice{nullptr};
+        std::atomic<Voice*> pNextVoice{nullptr}; // Очередь; после перехода играет, пока главный поток не переставит указатели
+        std::atomic<Voice*> pTriggeredVoice{nullptr}; // Из triggerSound(): колбэк ставит его вместо pVoice
+        std::atomic<float> volume{1.0f};
+        std::atomic<bool> isPaused{false};
+        std::atomic<bool> isRepeatEnabled{false};
+        std::atomic<ma_int64> seekRequestMillis{-1}; // -1, если нет запроса на перемотку
+        std::atomic<ma_uint64> positionMillis{0};
+        PlaybackState state = Stopped;
+    };
+
     static void dataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount);
+    // Сведение одного блока: деки, микрофон, мастер-шина. Общее для колбэка и офлайн-рендера
+    void mixBlock(float* pOutput, const float* pInput, ma_uint32 frameCount, qint64 now,
+                  int* pActiveVoices, int* pStreamedVoices);
+    void renderDeck(Voice* pVoice, float* pOutput, float* pQueueOutput, ma_uint32 frameCount, qint64 now);
+    ma_uint32 renderVoice(Voice* pVoice, float* pOutput, ma_uint32 frameCount, qint64 now);
+    static Voice* playingVoice(const Deck& deck);
+    void startTriggeredVoice(Deck* pDeck, Voice* pVoice); // Аудиопоток: подмена голоса деки из triggerSound()
+    void pushReplaced(Voice* pVoice);                      // Любой поток
+    static void renderDeckJob(void* pContext, int job); // Задание ParallelMixer: одна дека за кусок
+    void updateParallelMode(int jobCount, ma_uint32 frameCount);
+    bool isValidDeck(int deck) const;
+    void updateDeviceState(); // Останавливает устройство и таймер позиции, когда ни одна дека не играет
+    void startNotificationTimers();
+    bool ensureDeviceStarted(); // Открывает и запускает устройство для нового голоса
+    void startVoice(Voice* pNewVoice, int deck);
+    void chokeDecks(int deck, int chokeGroup, bool isPausedOnly);
+    void adoptTriggeredVoice(int deck);
+    void drainNotifications();
+    void mixMicrophone(const float* pInput, float* pOutput, ma_uint32 frameCount);
+    ma_uint64 readVoice(Voice* pVoice, float* pOutput, ma_uint64 frameCount);
+    void fireCues(Voice* pVoice, ma_uint64 endPosition);
+    static void seekVoice(Voice* pVoice, ma_uint64 frame);
+    static void setupRegion(Voice* pVoice, const PlaybackRegion& region, ma_uint64 lengthFrames);
+    static void applyLoopCrossfade(const Voice* pVoice, float* pFrames, ma_uint64 frameCount);
+    static ma_uint64 readSource(Voice* pVoice, float* pOutput, ma_uint64 frameCount);
+    bool isSourceReady(const Voice* pVoice) const;
+    static size_t readStretcherSource(void* pUserData, float* pOutput, size_t frameCount);
+    static void seekSource(Voice* pVoice, ma_uint64 frame);
+    Voice* createVoice(const QString& filePath, const PlaybackRegion& region, const VoiceParams& params, int deck,
+                       ma_uint64* pDurationFrames);
+    static void destroyVoice(Voice* pVoice);
+    void retireVoice(Voice* pVoice);
+    void collectRetired();
+    void updatePreferredSounds(bool isPreloading);
+    bool isDeviceRunning() const;
+    bool isDeviceAlwaysOn() const; // Микрофон или запись: устройство не останавливается без голосов
+    static void applyEffectSettings(EffectChainSlot* pSlot, EffectSettings* pCurrent, const EffectSettings& settings);
+    static void notificationCallback(const ma_device_notification* pNotification);
     void onUpdatePositionTimer();
-    void postPlaybackFinished(); // Вспомогательная функция для безопасного вызова сигнала
+    bool initContext();
+    bool openDevice();
+    void closeDevice();
+    void reopenDevice();
+    void stopDevice();
+    bool findSelectedDevice(ma_device_id* pDeviceId) const;
+    void applyDeferredSettings();
+    static bool isSameDevice(const QByteArray& deviceId, const ma_device_id& id);
+    static QList<DeviceInfo> listDevices(ma_context* pContext);
+    static DeviceWatch watchDevices(ma_context* pContext, const QByteArray& selectedId, const QString& selectedName);
+    void applyDeviceWatch(const DeviceWatch& watch);
 
 private:
     ma_context* m_context;
+    ma_log* m_log; // Журнал miniaudio, общий для всех пересозданий контекста
+    bool m_isLogInitialized;
     ma_device* m_playbackDevice;
-    std::atomic<ma_decoder*> m_pDecoder; // Атомарный указатель на декодер
+    Deck m_decks[kDeckCount];
+    // Выделен заранее: у каждой деки своя полоса, деки рендерятся в них кусками
+    // (возможно, параллельно) и подмешиваются к выходу в порядке дек
+    std::vector<float> m_deckBuffer;
+    std::vector<float> m_queueBuffer; // Такие же полосы для голоса из очереди во время перехода
+
+    // Параллельный рендер. Задания куска заполняет аудиопоток до ParallelMixer::run(),
+    // рабочие только читают их и пишут каждый в свою полосу и свою ячейку времени
+    enum ParallelState {
+        ParallelOff,
+        ParallelIdle,
+        ParallelBusy // Аудиопоток внутри run(): главный поток не останавливает пул, пока не дождется Idle
+    };
+    struct DeckJob {
+        Voice* pVoice = nullptr;
+        bool isRendered = false;
+        qint64 durationNs = 0;
+    };
+    ParallelMixer m_parallelMixer;
+    std::atomic<int> m_parallelState;
+    bool m_isParallelActive; // Только аудиопоток: решение с гистерезисом по нагрузке прошлых блоков
+    DeckJob m_deckJobs[kDeckCount];
+    ma_uint32 m_jobFrames;
+    qint64 m_jobNow;
 
     std::atomic<float> m_monitoringVolume;
     bool m_isDeviceInitialized;
     QTimer* m_positionUpdateTimer;
-    PlaybackState m_playbackState;
+    // Конец голоса, переход очереди и метки из колбэка; главный поток забирает их по таймеру
+    NotificationQueue m_notifications;
+    QTimer* m_notificationTimer;
+    quint64 m_reportedDroppedNotifications;
+
+    // Выбор устройства и горячая замена
+    QByteArray m_selectedDeviceId;
+    QString m_selectedDeviceName;
+    QString m_activeDeviceName;
+    QString m_lastDefaultDeviceName;
+    bool m_isUsingFallbackDevice;
+    ma_uint32 m_periodSizeInFrames; // 0 — значение бэкенда по умолчанию
+    ma_uint32 m_periods;
+    QString m_backendName; // Пустая строка — автоматический выбор miniaudio
+    bool m_isRealtimePriority;
+    bool m_isExclusiveMode;
+    bool m_isContextInitialized;
+    std::atomic<bool> m_isStopRequested; // Отличает нашу остановку устройства от отключения
+    bool m_isOffline; // initOffline(): устройство не открывается никогда
+    QTimer* m_deviceWatchTimer;
+    // Опрос списка устройств: у PulseAudio/PipeWire он занимает десятки мс, поэтому идет
+    // в своем потоке. Контекст закрывается только после waitForDone()
+    QThreadPool m_deviceWatchPool;
+    quint64 m_deviceWatchSerial; // Смена выбора или устройства: ответ начатого опроса устарел
+    bool m_isDeviceWatchPending;
+
+    // Измерение задержки (наносекунды steady_clock)
+    std::atomic<qint64> m_triggerToCallbackNs;
+    std::atomic<qint64> m_lastCallbackNs;
+    std::atomic<qint64> m_callbackIntervalNs;
+    EngineStats m_stats;
+
+    // Голоса, снятые с воспроизведения при работающем устройстве: удаляются,
+    // когда счетчик колбэков ушел дальше отметки
+    struct RetiredVoice {
+        Voice* pVoice;
+        quint64 callbackSerial;
+    };
+    std::atomic<quint64> m_callbackSerial;
+    std::vector<RetiredVoice> m_retiredVoices;
+    // Голоса, которые снял колбэк или triggerSound() (запуск поверх них): стек без блокировок
+    // через Voice::pNextReplaced, главный поток забирает его целиком в collectRetired()
+    std::atomic<Voice*> m_replacedVoices;
+
+    // Шины эффектов и микрофон
+    EffectChainSlot m_masterEffects;
+    EffectChainSlot m_micEffects;
+    EffectChainSlot m_micSuppressor; // Отдельные слоты: стоимость каждой ступени видна в статистике
+    EffectChainSlot m_micGate;
+    EffectSettings m_masterEffectSettings;
+    EffectSettings m_micEffectSettings;
+    bool m_isMicPassthroughEnabled;
+    std::atomic<float> m_micVolume;
+    std::vector<float> m_micBuffer; // Выделен заранее: шина микрофона обрабатывается кусками
+
+    std::shared_ptr<SampleStore> m_sampleStore; // shared_ptr: фоновые загрузки могут пережить движок
+    // Упреждающее чтение потоковых голосов; объявлен после голосов дек, удаляется после них
+    std::unique_ptr<StreamScheduler> m_streamScheduler;
+    StreamScheduler::Stats m_streamStatsBase; // Снимок на момент resetStats()
+    std::unique_ptr<DecoderPrimer> m_decoderPrimer; // Закрывает свои декодеры раньше планировщика
+    std::atomic<bool> m_isSampleStoreEnabled; // Читает и поток MIDI в triggerSound()
+    std::shared_ptr<std::atomic<quint64>> m_armGeneration; // Номер последнего armSounds(): старая загрузка прекращается
+    std::shared_ptr<UsageStore> m_usageStore; // shared_ptr: запись в пуле может пережить движок
+    QTimer* m_usageSaveTimer; // Пачка записей статистики раз в минуту
+    std::unique_ptr<OutputRecorder> m_outputRecorder; // Пишет колбэк: удаляется после закрытия устройства
+
+    std::thread m_initThread;
+    bool m_isInitSucceeded;
+    // Между beginInit() и waitForInit() поля контекста и устройства принадлежат потоку
+    // инициализации. Флаг меняется только до запуска потока и после join(), поэтому он не атомарный
+    bool m_isInitPending;
+    DeferredSettings m_deferredSettings;
+};
 
-    std::atomic<ma_int64> m_seekRequestMillis; // -1, если нет запроса на перемотку
-    std::atomic<ma_uint64> m_currentPositionMillis;
-};
\ No newline at end of file
+Q_DECLARE_METATYPE(AudioEngine::PlaybackRegion)
+Q_DECLARE_METATYPE(AudioEngine::VoiceParams)
+Q_DECLARE_METATYPE(AudioEngine::EffectSettings)
@@ -0,0 +1,409 @@
+// src/ControlServer.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ControlServer.h"
+#include "EngineSettings.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include "Log.h"
+#include <chrono>
+
+namespace {
+
+// Длинная строка без перевода строки — не наш клиент; не копим ее бесконечно
+constexpr qint64 kMaxLineLength = 4096;
+
+qint64 nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Аргументы через пробел; имя с пробелами берется в двойные кавычки
+QList<QByteArray> splitArguments(const QByteArray& line)
+{
+    QList<QByteArray> args;
+    QByteArray current;
+    bool isQuoted = false;
+    bool hasToken = false;
+    for (char c : line) {
+        if (c == '"') {
+            isQuoted = !isQuoted;
+            hasToken = true;
+        } else if (!isQuoted && (c == ' ' || c == '\t')) {
+            if (hasToken) {
+                args.append(current);
+                current.clear();
+                hasToken = false;
+            }
+        } else {
+            current += c;
+            hasToken = true;
+        }
+    }
+    if (hasToken) {
+        args.append(current);
+    }
+    return args;
+}
+
+QByteArray error(const char* message)
+{
+    return QByteArray("ERR ") + message + '\n';
+}
+
+} // namespace
+
+ControlServer::ControlServer(AudioEngine* engine, QObject* parent)
+    : QObject(parent),
+      m_engine(engine),
+      m_server(new QLocalServer(this)),
+      m_currentDeck(0),
+      m_hasVoice(false),
+      m_commandCount(0),
+      m_triggerCount(0),
+      m_lastDispatchNs(0)
+{
+    // Сокет доступен только владельцу: команды запускают звук в чужой эфир
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+    connect(m_engine, &AudioEngine::playbackFinished, this, &ControlServer::onPlaybackFinished);
+}
+
+QString ControlServer::defaultSocketPath()
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (directory.isEmpty()) {
+        directory = QDir::tempPath();
+    }
+    return QDir(directory).filePath("opensounddeck.sock");
+}
+
+bool ControlServer::listen(const QString& socketPath)
+{
+    // Сокет от упавшего прошлого запуска мешает bind(), а живой сервер мы бы заметили при подключении
+    QLocalSocket probe;
+    probe.connectToServer(socketPath);
+    if (probe.waitForConnected(100)) {
+        OSD_LOG_WARNING(Control, "Another instance is already listening path=%s", qUtf8Printable(socketPath));
+        return false;
+    }
+    QLocalServer::removeServer(socketPath);
+
+    if (!m_server->listen(socketPath)) {
+        OSD_LOG_WARNING(Control, "Failed to listen path=%s error=\"%s\"", qUtf8Printable(socketPath),
+                        qUtf8Printable(m_server->errorString()));
+        return false;
+    }
+    OSD_LOG_INFO(Control, "Control socket listening path=%s", qUtf8Printable(m_server->fullServerName()));
+    return true;
+}
+
+QString ControlServer::socketPath() const
+{
+    return m_server->fullServerName();
+}
+
+void ControlServer::setTracks(const QList<PlaylistEntry>& tracks)
+{
+    m_tracks = tracks;
+}
+
+bool ControlServer::triggerTrack(int index, float gain, qint64 eventTimeNs)
+{
+    if (index < 0 || index >= m_tracks.size()) {
+        return false;
+    }
+    AudioEngine::VoiceParams params = m_tracks[index].params;
+    params.gain *= gain;
+    return play(m_tracks[index].filePath, m_tracks[index].region, params, m_tracks[index].bank, eventTimeNs);
+}
+
+void ControlServer::onTrackTriggered(int index, int deck, float gain)
+{
+    if (index < 0 || index >= m_tracks.size()) {
+        return;
+    }
+    m_currentDeck = deck;
+    m_currentParams = m_tracks[index].params;
+    m_currentParams.gain *= gain;
+    m_hasVoice = true;
+    ++m_triggerCount;
+}
+
+bool ControlServer::play(const QString& filePath, const AudioEngine::PlaybackRegion& region,
+                         const AudioEngine::VoiceParams& params, int deck, qint64 eventTimeNs)
+{
+    m_engine->playSound(filePath, region, params, eventTimeNs, deck);
+    if (m_engine->getPlaybackState(deck) != AudioEngine::Playing) {
+        return false;
+    }
+    m_currentDeck = deck;
+    m_currentParams = params;
+    m_hasVoice = true;
+    ++m_triggerCount;
+    return true;
+}
+
+void ControlServer::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &ControlServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void ControlServer::onReadyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr) {
+        return;
+    }
+
+    // Все пришедшие целые строки выполняются подряд, ответы отправляются одной записью
+    QByteArray responses;
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine(kMaxLineLength);
+        if (line.size() == kMaxLineLength - 1 && !line.endsWith('\n')) {
+            // Слишком длинная строка: ошибка вместо команды, хвост до перевода строки
+            // отбрасывается, иначе он выполнился бы отдельной командой
+            QByteArray rest;
+            do {
+                rest = socket->readLine(kMaxLineLength);
+            } while (!rest.isEmpty() && !rest.endsWith('\n'));
+            responses += error("line too long");
+            continue;
+        }
+        line = line.trimmed();
+        if (!line.isEmpty()) {
+            responses += execute(line);
+        }
+    }
+    if (!socket->canReadLine() && socket->bytesAvailable() >= kMaxLineLength) {
+        socket->write(error("line too long"));
+        socket->disconnectFromServer();
+        return;
+    }
+    if (!responses.isEmpty()) {
+        socket->write(responses);
+        socket->flush();
+    }
+}
+
+void ControlServer::onPlaybackFinished(int deck)
+{
+    if (deck == m_currentDeck) {
+        m_hasVoice = false;
+    }
+}
+
+QByteArray ControlServer::execute(const QByteArray& line)
+{
+    const qint64 receivedNs = nowNanoseconds();
+    const QList<QByteArray> args = splitArguments(line);
+    if (args.isEmpty()) {
+        return error("empty command");
+    }
+    const QByteArray command = args.first().toUpper();
+    ++m_commandCount;
+
+    if (command == "TRIGGER") {
+        const QByteArray response = trigger(args);
+        m_lastDispatchNs = nowNanoseconds() - receivedNs;
+        return response;
+    }
+    if (command == "STOP") {
+        m_engine->stopAllSounds();
+        m_hasVoice = false;
+        return "OK\n";
+    }
+    if (command == "GAIN") {
+        return setGain(args);
+    }
+    if (command == "LIST") {
+        return list();
+    }
+    if (command == "RECORD") {
+        return record(args);
+    }
+    if (command == "REPLAY") {
+        return saveReplay();
+    }
+    if (command == "STATS") {
+        return stats();
+    }
+    if (command == "PING") {
+        return "OK\n";
+    }
+    return error("unknown command");
+}
+
+QByteArray ControlServer::trigger(const QList<QByteArray>& args)
+{
+    if (args.size() < 2 || args.size() > 3) {
+        return error("usage: TRIGGER <track> [gain]");
+    }
+
+    float gain = 1.0f;
+    if (args.size() == 3) {
+        bool ok = false;
+        gain = args[2].toFloat(&ok);
+        if (!ok || gain < 0.0f || gain > AudioEngine::kMaxVoiceGain) {
+            return error("gain must be between 0 and 2");
+        }
+    }
+
+    const int index = findTrack(args[1]);
+    if (index >= 0) {
+        if (!triggerTrack(index, gain)) {
+            return error("playback failed");
+        }
+        return "OK " + QByteArray::number(index + 1) + '\n';
+    }
+
+    // Файл не из плейлиста играет на первой деке с параметрами по умолчанию
+    const QString filePath = QString::fromUtf8(args[1]);
+    if (!QFileInfo(filePath).isAbsolute() || !QFileInfo::exists(filePath)) {
+        return error("no such track");
+    }
+    AudioEngine::VoiceParams params;
+    params.gain = gain;
+    if (!play(filePath, AudioEngine::PlaybackRegion(), params, 0, 0)) {
+        return error("playback failed");
+    }
+    return "OK " + args[1] + '\n';
+}
+
+QByteArray ControlServer::setGain(const QList<QByteArray>& args)
+{
+    bool ok = false;
+    const float gain = args.size() == 2 ? args[1].toFloat(&ok) : 0.0f;
+    if (!ok || gain < 0.0f || gain > AudioEngine::kMaxVoiceGain) {
+        return error("usage: GAIN <0..2>");
+    }
+    if (!m_hasVoice) {
+        return error("nothing is playing");
+    }
+    m_currentParams.gain = gain;
+    m_engine->setVoiceParams(m_currentParams, m_currentDeck);
+    return "OK\n";
+}
+
+QByteArray ControlServer::record(const QList<QByteArray>& args)
+{
+    const QByteArray mode = args.size() == 2 ? args[1].toLower() : QByteArray();
+    if (mode == "off") {
+        m_engine->stopRecording(); // Хвост дописывается в фоне
+        return "OK\n";
+    }
+    if (mode != "on") {
+        return error("usage: RECORD on|off");
+    }
+    if (m_engine->isRecording()) {
+        return error("already recording");
+    }
+    const QString filePath = EngineSettings::captureFilePath("Recording");
+    if (!m_engine->startRecording(filePath)) {
+        return error("recording failed");
+    }
+    return "OK " + filePath.toUtf8() + '\n';
+}
+
+QByteArray ControlServer::saveReplay()
+{
+    const QString filePath = EngineSettings::captureFilePath("Replay");
+    if (!m_engine->saveReplay(filePath)) {
+        return error("replay buffer is off or empty");
+    }
+    return "OK " + filePath.toUtf8() + '\n';
+}
+
+QByteArray ControlServer::list() const
+{
+    QByteArray response = "OK " + QByteArray::number(m_tracks.size()) + '\n';
+    for (int i = 0; i < m_tracks.size(); ++i) {
+        const QFileInfo fileInfo(m_tracks[i].filePath);
+        response += QByteArray::number(i + 1) + '\t' + fileInfo.fileName().toUtf8() + '\t' +
+                    m_tracks[i].filePath.toUtf8() + '\n';
+    }
+    return response;
+}
+
+QByteArray ControlServer::stats() const
+{
+    static const char* const kStateNames[] = {"stopped", "playing", "paused"};
+    const AudioEngine::LatencyInfo latency = m_engine->latencyInfo();
+    const EngineStats::Snapshot engineStats = m_engine->statsSnapshot();
+    const OutputRecorder::Stats captureStats = m_engine->recordingStats();
+
+    QString text = QString("OK state=%1 device=\"%2\" tracks=%3 commands=%4 triggers=%5 dispatch_ms=%6 "
+                           "period_ms=%7 buffer_ms=%8 callback_ms=%9 trigger_ms=%10 output_ms=%11 "
+                           "load_avg=%12 load_peak=%13 over_budget=%14 xruns=%15 voices=%16 cache_hit_rate=%17 stream_misses=%18 "
+                           "recording=%19 replay_s=%20 capture_dropped=%21 capture_lost=%22 "
+                           "mic_denoise_load=%23 mic_gate_load=%24")
+                       .arg(kStateNames[m_engine->getPlaybackState(m_currentDeck)])
+                       .arg(m_engine->currentDeviceName())
+                       .arg(m_tracks.size())
+                       .arg(m_commandCount)
+                       .arg(m_triggerCount)
+                       .arg(m_lastDispatchNs / 1e6, 0, 'f', 3)
+                       .arg(latency.periodMillis, 0, 'f', 2)
+                       .arg(latency.bufferMillis, 0, 'f', 2)
+                       .arg(latency.callbackIntervalMillis, 0, 'f', 2)
+                       .arg(latency.triggerToCallbackMillis, 0, 'f', 2)
+                       .arg(latency.outputLatencyMillis, 0, 'f', 2)
+                       .arg(engineStats.averageLoad, 0, 'f', 3)
+                       .arg(engineStats.peakLoad, 0, 'f', 3)
+                       .arg(engineStats.overBudget)
+                       .arg(engineStats.xruns)
+                       .arg(engineStats.activeVoices)
+                       .arg(engineStats.cacheHitRate(), 0, 'f', 3)
+                       .arg(engineStats.streamMisses)
+                       .arg(captureStats.isRecording ? 1 : 0)
+                       .arg(captureStats.replayMillis / 1000)
+                       .arg(captureStats.droppedFrames)
+                       .arg(captureStats.lostFrames)
+                       .arg(engineStats.micSuppressionLoad, 0, 'f', 4)
+                       .arg(engineStats.micGateLoad, 0, 'f', 4);
+    return text.toUtf8() + '\n';
+}
+
+int ControlServer::findTrack(const QByteArray& token) const
+{
+    bool isNumber = false;
+    const int number = token.toInt(&isNumber);
+    if (isNumber) {
+        return number >= 1 && number <= m_tracks.size() ? number - 1 : -1;
+    }
+
+    const QString name = QString::fromUtf8(token);
+    for (int i = 0; i < m_tracks.size(); ++i) {
+        const QFileInfo fileInfo(m_tracks[i].filePath);
+        if (fileInfo.fileName().compare(name, Qt::CaseInsensitive) == 0 ||
+            fileInfo.completeBaseName().compare(name, Qt::CaseInsensitive) == 0 ||
+            m_tracks[i].filePath == name) {
+            return i;
+        }
+    }
+    return -1;
+}
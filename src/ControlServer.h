@@ -0,0 +1,98 @@
+// src/ControlServer.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include "AudioEngine.h"
+#include "Playlist.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// Управление движком через локальный сокет (Unix domain socket, на Windows — именованный канал).
+//
+// Протокол строковый: одна команда на строку, ответ на каждую команду в том же порядке.
+// Клиент может отправить сразу несколько команд, не дожидаясь ответов: все целые строки,
+// пришедшие за одно чтение, выполняются подряд, а ответы уходят одной записью.
+//
+//   TRIGGER <трек> [gain]  — трек: номер (с 1), имя файла или путь   -> OK <номер или путь>
+//                            играет на деке своего банка, путь — на первой
+//   STOP                   — все деки                                -> OK
+//   GAIN <0..2>            — громкость последнего запущенного голоса -> OK
+//   LIST                   -> OK <n>, затем n строк "<номер>\t<имя>\t<путь>"
+//   RECORD on|off          — запись выхода в папку записей           -> OK [путь]
+//   REPLAY                 — сохранить буфер повтора                 -> OK <путь>
+//   STATS                  -> OK key=value ...
+//   PING                   -> OK
+// Имена с пробелами берутся в двойные кавычки. Ошибка: ERR <описание>.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlServer(AudioEngine* engine, QObject* parent = nullptr);
+
+    static QString defaultSocketPath();
+    bool listen(const QString& socketPath);
+    QString socketPath() const;
+
+    void setTracks(const QList<PlaylistEntry>& tracks);
+
+public slots:
+    // Запуск трека по номеру; eventTimeNs — момент события для движка
+    bool triggerTrack(int index, float gain, qint64 eventTimeNs = 0);
+    // Трек уже запущен входом MIDI прямо в движке: GAIN и STOP дальше относятся к нему
+    void onTrackTriggered(int index, int deck, float gain);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onPlaybackFinished(int deck);
+
+private:
+    QByteArray execute(const QByteArray& line);
+    bool play(const QString& filePath, const AudioEngine::PlaybackRegion& region,
+              const AudioEngine::VoiceParams& params, int deck, qint64 eventTimeNs);
+    QByteArray trigger(const QList<QByteArray>& args);
+    QByteArray setGain(const QList<QByteArray>& args);
+    QByteArray record(const QList<QByteArray>& args);
+    QByteArray saveReplay();
+    QByteArray list() const;
+    QByteArray stats() const;
+    int findTrack(const QByteArray& token) const; // -1, если не найден
+
+    AudioEngine* m_engine;
+    QLocalServer* m_server;
+    QList<PlaylistEntry> m_tracks;
+
+    // Параметры последнего запущенного голоса: GAIN меняет только громкость
+    int m_currentDeck;
+    AudioEngine::VoiceParams m_currentParams;
+    bool m_hasVoice;
+
+    // Статистика для STATS
+    quint64 m_commandCount;
+    quint64 m_triggerCount;
+    qint64 m_lastDispatchNs; // От чтения из сокета до возврата из playSound()
+};
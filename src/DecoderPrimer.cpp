@@ -0,0 +1,261 @@
+// src/DecoderPrimer.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DecoderPrimer.h"
+#include "StreamScheduler.h"
+#include "Log.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+DecoderPrimer::DecoderPrimer(StreamScheduler* pScheduler, ma_uint32 channels, ma_uint32 sampleRate, size_t budgetBytes)
+    : m_pScheduler(pScheduler)
+    , m_channels(channels)
+    , m_sampleRate(sampleRate)
+    , m_budgetBytes(budgetBytes)
+    , m_forgetSerial(0)
+    , m_isStopping(false)
+{
+    // Подготовка — чистая спекуляция: уступает и UI, и фоновой загрузке клипов
+    m_pThread = QThread::create([this]() { run(); });
+    m_pThread->start(QThread::LowestPriority);
+}
+
+DecoderPrimer::~DecoderPrimer()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isStopping = true;
+    }
+    m_wake.wakeAll();
+    m_pThread->wait();
+    delete m_pThread;
+
+    for (Entry& entry : m_entries) {
+        close(&entry.primed);
+    }
+}
+
+void DecoderPrimer::prime(const QList<Request>& requests)
+{
+    std::vector<Primed> evicted;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_wanted == requests) {
+            return;
+        }
+        m_wanted = requests;
+        evictLocked(&evicted);
+    }
+    m_wake.wakeAll();
+
+    // Закрытие файла — не под мьютексом: поток подготовки не ждет главный
+    for (Primed& primed : evicted) {
+        close(&primed);
+    }
+}
+
+bool DecoderPrimer::take(const QString& filePath, ma_uint64 startFrame, Primed* pPrimed)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const Request request{filePath, startFrame};
+        auto it = std::find_if(m_entries.begin(), m_entries.end(), [&request](const Entry& entry) {
+            return entry.request == request && entry.primed.pDecoder != nullptr;
+        });
+        if (it == m_entries.end()) {
+            return false;
+        }
+        *pPrimed = std::move(it->primed);
+        m_entries.erase(it);
+    }
+    // Звук остался в наборе: к следующему запуску он будет готов снова
+    m_wake.wakeAll();
+    return true;
+}
+
+void DecoderPrimer::forget(const QString& filePath)
+{
+    std::vector<Primed> evicted;
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_forgetSerial;
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->request.filePath == filePath) {
+                evicted.push_back(std::move(it->primed));
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    m_wake.wakeAll();
+    for (Primed& primed : evicted) {
+        close(&primed);
+    }
+}
+
+void DecoderPrimer::setBudget(size_t budgetBytes)
+{
+    std::vector<Primed> evicted;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_budgetBytes = budgetBytes;
+        evictLocked(&evicted);
+    }
+    m_wake.wakeAll();
+    for (Primed& primed : evicted) {
+        close(&primed);
+    }
+}
+
+size_t DecoderPrimer::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budgetBytes;
+}
+
+size_t DecoderPrimer::entryCost() const
+{
+    // Начало в f32, окно планировщика у открытого файла и сам декодер
+    const size_t headBytes = static_cast<size_t>(kHeadMillis * m_sampleRate / 1000) * m_channels * sizeof(float);
+    return headBytes + StreamScheduler::kIdleBlocksPerStream * StreamScheduler::kBlockBytes + kDecoderBytes;
+}
+
+int DecoderPrimer::primedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(std::count_if(m_entries.begin(), m_entries.end(),
+                                          [](const Entry& entry) { return entry.primed.pDecoder != nullptr; }));
+}
+
+void DecoderPrimer::run()
+{
+    for (;;) {
+        Request request;
+        quint64 forgetSerial = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_isStopping && !nextRequestLocked(&request)) {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_isStopping) {
+                return;
+            }
+            forgetSerial = m_forgetSerial;
+        }
+
+        Primed primed;
+        if (!open(request, &primed)) {
+            OSD_LOG_DEBUG(Engine, "Priming failed path=\"%s\"", qUtf8Printable(request.filePath));
+        }
+
+        QMutexLocker locker(&m_mutex);
+        // Пока файл открывался, набор могли сменить, а файл — изменить
+        if (m_isStopping || forgetSerial != m_forgetSerial || !isWantedLocked(request)) {
+            locker.unlock();
+            close(&primed);
+            continue;
+        }
+        m_entries.push_back(Entry{request, std::move(primed)});
+    }
+}
+
+bool DecoderPrimer::open(const Request& request, Primed* pPrimed) const
+{
+    ma_decoder* pDecoder = new ma_decoder;
+    ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_f32, m_channels, m_sampleRate);
+    if (ma_decoder_init_vfs(m_pScheduler->vfs(), request.filePath.toStdString().c_str(), &decoderConfig,
+                            pDecoder) != MA_SUCCESS) {
+        delete pDecoder;
+        return false;
+    }
+    pPrimed->pDecoder = pDecoder;
+    pPrimed->startFrame = request.startFrame;
+    ma_decoder_get_length_in_pcm_frames(pDecoder, &pPrimed->lengthFrames);
+
+    if (request.startFrame > 0 && ma_decoder_seek_to_pcm_frame(pDecoder, request.startFrame) != MA_SUCCESS) {
+        close(pPrimed);
+        return false;
+    }
+
+    const ma_uint64 headFrames = kHeadMillis * m_sampleRate / 1000;
+    pPrimed->head.resize(headFrames * m_channels);
+    ma_uint64 framesRead = 0;
+    if (ma_decoder_read_pcm_frames(pDecoder, pPrimed->head.data(), headFrames, &framesRead) != MA_SUCCESS) {
+        framesRead = 0; // Область за концом файла: голос просто сразу закончится
+    }
+    pPrimed->head.resize(framesRead * m_channels);
+    return true;
+}
+
+void DecoderPrimer::close(Primed* pPrimed)
+{
+    if (pPrimed->pDecoder != nullptr) {
+        ma_decoder_uninit(pPrimed->pDecoder);
+        delete pPrimed->pDecoder;
+        pPrimed->pDecoder = nullptr;
+    }
+}
+
+int DecoderPrimer::wantedCountLocked() const
+{
+    const size_t cost = entryCost();
+    return static_cast<int>(std::min<size_t>(static_cast<size_t>(m_wanted.size()), m_budgetBytes / cost));
+}
+
+bool DecoderPrimer::isWantedLocked(const Request& request) const
+{
+    const int count = wantedCountLocked();
+    for (int i = 0; i < count; ++i) {
+        if (m_wanted[i] == request) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DecoderPrimer::nextRequestLocked(Request* pRequest) const
+{
+    // Первый по приоритету звук в пределах бюджета, которого еще нет
+    const int count = wantedCountLocked();
+    for (int i = 0; i < count; ++i) {
+        const Request& request = m_wanted[i];
+        const bool isPresent = std::any_of(m_entries.begin(), m_entries.end(),
+                                           [&request](const Entry& entry) { return entry.request == request; });
+        if (!isPresent) {
+            *pRequest = request;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DecoderPrimer::evictLocked(std::vector<Primed>* pEvicted)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!isWantedLocked(it->request)) {
+            pEvicted->push_back(std::move(it->primed));
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// src/DecoderPrimer.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <vector>
+#include "miniaudio.h"
+
+class QThread;
+class StreamScheduler;
+
+// Декодеры, открытые заранее для звуков, которые вероятно запустят следующими (выделенная
+// строка, соседние треки, частые хоткеи). Поток с низшим приоритетом открывает файл через
+// StreamScheduler, разбирает заголовок, перематывает к началу области и декодирует первые
+// kHeadMillis в память. playSound() забирает готовый декодер и начинает с декодированного
+// начала, пока планировщик дочитывает файл, — первый запуск не ждет диска и заголовка.
+//
+// Каждый подготовленный звук стоит entryCost() байт; звуки сверх бюджета не готовятся.
+class DecoderPrimer
+{
+public:
+    static constexpr ma_uint64 kHeadMillis = 250;
+    static constexpr size_t kDecoderBytes = 64 * 1024; // Оценка состояния декодера и его буферов
+
+    struct Request {
+        QString filePath;
+        ma_uint64 startFrame = 0; // Начало области: туда перематывается декодер
+
+        bool operator==(const Request& other) const {
+            return filePath == other.filePath && startFrame == other.startFrame;
+        }
+    };
+
+    // Владение переходит к забравшему: он закрывает декодер сам
+    struct Primed {
+        ma_decoder* pDecoder = nullptr;
+        ma_uint64 lengthFrames = 0;
+        ma_uint64 startFrame = 0;
+        std::vector<float> head; // Кадры с startFrame; декодер стоит сразу после них
+    };
+
+    DecoderPrimer(StreamScheduler* pScheduler, ma_uint32 channels, ma_uint32 sampleRate, size_t budgetBytes);
+    ~DecoderPrimer();
+    DecoderPrimer(const DecoderPrimer&) = delete;
+    DecoderPrimer& operator=(const DecoderPrimer&) = delete;
+
+    // Новый набор по убыванию приоритета заменяет прежний: лишние декодеры закрываются,
+    // недостающие готовятся в фоне
+    void prime(const QList<Request>& requests);
+    bool take(const QString& filePath, ma_uint64 startFrame, Primed* pPrimed);
+    void forget(const QString& filePath); // Файл изменен: готовый декодер устарел
+
+    void setBudget(size_t budgetBytes);
+    size_t budget() const;
+    size_t entryCost() const;
+    int primedCount() const;
+
+private:
+    struct Entry {
+        Request request;
+        Primed primed; // pDecoder == nullptr — файл не открылся, повторять не нужно
+    };
+
+    void run();
+    bool open(const Request& request, Primed* pPrimed) const;
+    static void close(Primed* pPrimed);
+    int wantedCountLocked() const;
+    bool isWantedLocked(const Request& request) const;
+    bool nextRequestLocked(Request* pRequest) const;
+    void evictLocked(std::vector<Primed>* pEvicted);
+
+    StreamScheduler* m_pScheduler;
+    ma_uint32 m_channels;
+    ma_uint32 m_sampleRate;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Request> m_wanted;
+    std::vector<Entry> m_entries;
+    size_t m_budgetBytes;
+    quint64 m_forgetSerial; // Растет в forget(): декодер, открытый до него, отбрасывается
+    bool m_isStopping;
+    QThread* m_pThread;
+};
@@ -0,0 +1,174 @@
+#include "DiagnosticsDialog.h"
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QTimer>
+
+namespace {
+
+// Четыре часа раз в секунду — длина обычного эфира
+constexpr int kMaxHistory = 4 * 60 * 60;
+
+const char* const kBucketNames[EngineStats::kHistogramBuckets] = {
+    "0-10%", "10-20%", "20-30%", "30-40%", "40-50%", "50-60%",
+    "60-70%", "70-80%", "80-90%", "90-100%", "100-150%", ">150%"
+};
+
+} // namespace
+
+DiagnosticsDialog::DiagnosticsDialog(AudioEngine *engine, QWidget *parent)
+    : QDialog(parent),
+      m_engine(engine)
+{
+    setWindowTitle(tr("Engine Diagnostics"));
+
+    m_callbacksLabel = new QLabel(this);
+    m_callbackTimeLabel = new QLabel(this);
+    m_loadLabel = new QLabel(this);
+    m_overBudgetLabel = new QLabel(this);
+    m_xrunsLabel = new QLabel(this);
+    m_micCleanupLabel = new QLabel(this);
+    m_voicesLabel = new QLabel(this);
+    m_armedLabel = new QLabel(this);
+    m_cacheLabel = new QLabel(this);
+    m_residentLabel = new QLabel(this);
+    m_streamLabel = new QLabel(this);
+
+    QGroupBox *callbackGroup = new QGroupBox(tr("Audio callback"), this);
+    QFormLayout *callbackLayout = new QFormLayout(callbackGroup);
+    callbackLayout->addRow(tr("Callbacks:"), m_callbacksLabel);
+    callbackLayout->addRow(tr("Duration:"), m_callbackTimeLabel);
+    callbackLayout->addRow(tr("Budget used:"), m_loadLabel);
+    callbackLayout->addRow(tr("Over budget:"), m_overBudgetLabel);
+    callbackLayout->addRow(tr("Xruns:"), m_xrunsLabel);
+    callbackLayout->addRow(tr("Microphone cleanup:"), m_micCleanupLabel);
+
+    QGroupBox *voicesGroup = new QGroupBox(tr("Voices and clips"), this);
+    QFormLayout *voicesLayout = new QFormLayout(voicesGroup);
+    voicesLayout->addRow(tr("Active voices:"), m_voicesLabel);
+    voicesLayout->addRow(tr("Active bank loaded:"), m_armedLabel);
+    voicesLayout->addRow(tr("Cache hits:"), m_cacheLabel);
+    voicesLayout->addRow(tr("Resident clips:"), m_residentLabel);
+    voicesLayout->addRow(tr("Disk read-ahead:"), m_streamLabel);
+
+    // Доля колбэков в каждой корзине нагрузки
+    QGroupBox *histogramGroup = new QGroupBox(tr("Callback duration, % of budget"), this);
+    QGridLayout *histogramLayout = new QGridLayout(histogramGroup);
+    for (int i = 0; i < EngineStats::kHistogramBuckets; ++i) {
+        m_histogramBars[i] = new QProgressBar(this);
+        m_histogramBars[i]->setRange(0, 1000);
+        m_histogramBars[i]->setTextVisible(true);
+        histogramLayout->addWidget(new QLabel(QString::fromLatin1(kBucketNames[i]), this), i, 0);
+        histogramLayout->addWidget(m_histogramBars[i], i, 1);
+    }
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *resetButton = buttonBox->addButton(tr("Reset"), QDialogButtonBox::ResetRole);
+    QPushButton *saveButton = buttonBox->addButton(tr("Save..."), QDialogButtonBox::ActionRole);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(resetButton, &QPushButton::clicked, this, &DiagnosticsDialog::onResetClicked);
+    connect(saveButton, &QPushButton::clicked, this, &DiagnosticsDialog::onSaveClicked);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(callbackGroup);
+    mainLayout->addWidget(voicesGroup);
+    mainLayout->addWidget(histogramGroup);
+    mainLayout->addWidget(buttonBox);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(1000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &DiagnosticsDialog::onRefreshTimer);
+    m_refreshTimer->start();
+    onRefreshTimer();
+}
+
+void DiagnosticsDialog::onRefreshTimer()
+{
+    const EngineStats::Snapshot snapshot = m_engine->statsSnapshot();
+    if (m_history.size() >= kMaxHistory) {
+        m_history.removeFirst();
+    }
+    m_history.append(snapshot);
+    if (isVisible()) {
+        showSnapshot(snapshot);
+    }
+}
+
+void DiagnosticsDialog::showSnapshot(const EngineStats::Snapshot& snapshot)
+{
+    m_callbacksLabel->setText(tr("%1 (period %2 ms)").arg(snapshot.callbacks).arg(snapshot.budgetMillis, 0, 'f', 2));
+    m_callbackTimeLabel->setText(tr("avg %1 ms, max %2 ms")
+                                     .arg(snapshot.averageCallbackMillis, 0, 'f', 3)
+                                     .arg(snapshot.maxCallbackMillis, 0, 'f', 3));
+    m_loadLabel->setText(tr("avg %1%, peak %2%")
+                             .arg(snapshot.averageLoad * 100, 0, 'f', 1)
+                             .arg(snapshot.peakLoad * 100, 0, 'f', 1));
+    m_overBudgetLabel->setText(QString::number(snapshot.overBudget));
+    m_xrunsLabel->setText(QString::number(snapshot.xruns));
+    m_micCleanupLabel->setText(tr("noise suppression %1%, gate %2% of budget")
+                                   .arg(snapshot.micSuppressionLoad * 100, 0, 'f', 2)
+                                   .arg(snapshot.micGateLoad * 100, 0, 'f', 2));
+    m_voicesLabel->setText(tr("%1 (%2 streamed from disk)").arg(snapshot.activeVoices).arg(snapshot.streamedVoices));
+    m_armedLabel->setText(tr("%1 of %2 clips").arg(snapshot.armedReady).arg(snapshot.armedClips));
+    m_cacheLabel->setText(tr("%1% (%2 hits, %3 misses)")
+                              .arg(snapshot.cacheHitRate() * 100, 0, 'f', 1)
+                              .arg(snapshot.cacheHits)
+                              .arg(snapshot.cacheMisses));
+    m_residentLabel->setText(tr("%1 of %2 MiB")
+                                 .arg(snapshot.residentBytes / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(snapshot.budgetBytes / (1024.0 * 1024.0), 0, 'f', 0));
+    m_streamLabel->setText(tr("%1 reads, %2 missed").arg(snapshot.streamHits + snapshot.streamMisses).arg(snapshot.streamMisses));
+
+    for (int i = 0; i < EngineStats::kHistogramBuckets; ++i) {
+        const int permille = snapshot.callbacks > 0 ? static_cast<int>(snapshot.histogram[i] * 1000 / snapshot.callbacks) : 0;
+        m_histogramBars[i]->setValue(permille);
+        m_histogramBars[i]->setFormat(QString("%1").arg(snapshot.histogram[i]));
+    }
+}
+
+void DiagnosticsDialog::onResetClicked()
+{
+    m_engine->resetStats();
+    m_history.clear();
+}
+
+void DiagnosticsDialog::onSaveClicked()
+{
+    const QString defaultName = QString("opensounddeck-stats-%1.csv")
+                                    .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    QString selectedFilter;
+    const QString filePath = QFileDialog::getSaveFileName(this, tr("Save Diagnostics"), defaultName,
+                                                          tr("CSV (*.csv);;JSON (*.json)"), &selectedFilter);
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    // CSV — одна строка на секунду истории; JSON — текущий снимок и та же история
+    const bool isJson = filePath.endsWith(".json", Qt::CaseInsensitive) ||
+                        (!filePath.endsWith(".csv", Qt::CaseInsensitive) && selectedFilter.startsWith("JSON"));
+    const EngineStats::Snapshot current = m_engine->statsSnapshot();
+    QByteArray data;
+    if (isJson) {
+        data = EngineStats::toJson(current, m_history);
+    } else {
+        data = EngineStats::csvHeader();
+        for (const EngineStats::Snapshot& snapshot : m_history) {
+            data += EngineStats::toCsvRow(snapshot);
+        }
+        data += EngineStats::toCsvRow(current);
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        QMessageBox::warning(this, tr("Save Diagnostics"), tr("Could not write %1").arg(filePath));
+    }
+}
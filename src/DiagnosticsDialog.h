@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QDialog>
+#include <QList>
+#include "AudioEngine.h"
+
+class QLabel;
+class QProgressBar;
+class QTimer;
+
+// Панель состояния движка: нагрузка колбэка, xrun, голоса, загрузка банка и кэш клипов.
+// Раз в секунду снимает телеметрию и копит историю, пока окно существует (и скрытым тоже),
+// чтобы после эфира можно было сохранить ее в JSON или CSV.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(AudioEngine* engine, QWidget *parent = nullptr);
+
+private slots:
+    void onRefreshTimer();
+    void onResetClicked();
+    void onSaveClicked();
+
+private:
+    void showSnapshot(const EngineStats::Snapshot& snapshot);
+
+    AudioEngine* m_engine;
+    QTimer* m_refreshTimer;
+    QList<EngineStats::Snapshot> m_history;
+
+    QLabel *m_callbacksLabel;
+    QLabel *m_callbackTimeLabel;
+    QLabel *m_loadLabel;
+    QLabel *m_overBudgetLabel;
+    QLabel *m_xrunsLabel;
+    QLabel *m_micCleanupLabel;
+    QLabel *m_voicesLabel;
+    QLabel *m_armedLabel;
+    QLabel *m_cacheLabel;
+    QLabel *m_residentLabel;
+    QLabel *m_streamLabel;
+    QProgressBar *m_histogramBars[EngineStats::kHistogramBuckets];
+};
@@ -0,0 +1,668 @@
+// src/Effects.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Effects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OSD_HAS_MXCSR
+#endif
+
+namespace {
+
+// Хвосты фильтров и реверберации затухают в денормализованные числа, которые
+// на x86 обрабатываются в десятки раз медленнее. На время обработки цепочки
+// включаем flush-to-zero / denormals-are-zero и возвращаем прежний режим.
+class DenormalGuard
+{
+public:
+    DenormalGuard()
+    {
+#if defined(OSD_HAS_MXCSR)
+        m_state = _mm_getcsr();
+        _mm_setcsr(m_state | 0x8040); // FTZ | DAZ
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+        __asm__ volatile("mrs %0, fpcr" : "=r"(m_state));
+        __asm__ volatile("msr fpcr, %0" : : "r"(m_state | (1ULL << 24))); // FZ
+#endif
+    }
+
+    ~DenormalGuard()
+    {
+#if defined(OSD_HAS_MXCSR)
+        _mm_setcsr(m_state);
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+        __asm__ volatile("msr fpcr, %0" : : "r"(m_state));
+#endif
+    }
+
+private:
+#if defined(OSD_HAS_MXCSR)
+    unsigned int m_state;
+#else
+    unsigned long long m_state = 0;
+#endif
+};
+
+// Доля пути к цели за блок из 64 кадров: ~20 мс постоянной времени при 48 кГц
+constexpr float kSmoothingFactor = 0.064f;
+
+// Настройки Freeverb для 44.1 кГц, масштабируются под частоту движка
+constexpr size_t kCombTuning[] = {1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617};
+constexpr size_t kAllpassTuning[] = {556, 441, 341, 225};
+constexpr size_t kStereoSpread = 23;
+constexpr float kReverbInputGain = 0.015f;
+constexpr float kReverbWetScale = 3.0f;
+
+// Шумовой гейт
+constexpr float kGateAttackSeconds = 0.001f;
+constexpr float kGateReleaseSeconds = 0.080f;
+constexpr float kGateHoldSeconds = 0.120f;
+constexpr float kGateEnvelopeSeconds = 0.020f;
+constexpr float kGateHysteresis = 0.5f;  // Закрывается на 6 дБ ниже порога открытия
+constexpr float kGateFloor = 0.01f;      // -40 дБ: закрытый гейт глушит, но не обрывает в ноль
+
+// Шумоподавление
+constexpr float kPowerSmoothingSeconds = 0.020f;
+constexpr float kMinimumWindowSeconds = 0.4f;  // 4 подокна — шум отслеживается за ~1.6 с
+constexpr float kMinimumBias = 1.5f;           // Минимум сглаженной мощности ниже среднего уровня шума
+constexpr float kSnrSmoothingPer10ms = 0.98f;  // Классическая константа decision-directed для шага 10 мс
+
+// Коэффициент однополюсного сглаживания с постоянной времени seconds при шаге stepFrames
+inline float smoothingCoefficient(float seconds, float sampleRate, float stepFrames = 1.0f)
+{
+    return std::exp(-stepFrames / (seconds * sampleRate));
+}
+
+inline float periodicHann(size_t n, size_t length)
+{
+    return 0.5f - 0.5f * static_cast<float>(std::cos(2.0 * std::numbers::pi * static_cast<double>(n) / length));
+}
+
+// Смешивание сухого и обработанного сигнала с линейным переходом коэффициента внутри блока
+inline void mixWithRamp(float* pDry, const float* pWet, size_t sampleCount, float fromMix, float toMix)
+{
+    const float step = (toMix - fromMix) / static_cast<float>(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i) {
+        const float mix = fromMix + step * static_cast<float>(i);
+        pDry[i] += (pWet[i] - pDry[i]) * mix;
+    }
+}
+
+} // namespace
+
+float SmoothedParameter::next()
+{
+    const float target = m_target.load(std::memory_order_relaxed);
+    const float difference = target - m_current;
+    if (std::fabs(difference) <= 1.0e-4f * std::max(1.0f, std::fabs(target))) {
+        m_current = target;
+    } else {
+        m_current += difference * kSmoothingFactor;
+    }
+    return m_current;
+}
+
+EffectNode::EffectNode(size_t parameterCount, float sampleRate)
+    : m_sampleRate(sampleRate),
+      m_parameterCount(parameterCount),
+      m_parameters(new SmoothedParameter[parameterCount])
+{
+}
+
+void EffectNode::setParameter(size_t index, float value)
+{
+    if (index < m_parameterCount) {
+        m_parameters[index].setTarget(value);
+    }
+}
+
+// --- BiquadFilter ---
+
+BiquadFilter::BiquadFilter(Type type, float sampleRate, float frequency, float gainDb, float q)
+    : EffectNode(ParameterCount, sampleRate),
+      m_type(type)
+{
+    parameter(Frequency).setTarget(frequency);
+    parameter(GainDb).setTarget(gainDb);
+    parameter(Q).setTarget(q);
+    for (size_t i = 0; i < ParameterCount; ++i) {
+        parameter(i).snap();
+    }
+    updateCoefficients(frequency, gainDb, q);
+    reset();
+}
+
+void BiquadFilter::reset()
+{
+    std::fill(std::begin(m_z1), std::end(m_z1), 0.0f);
+    std::fill(std::begin(m_z2), std::end(m_z2), 0.0f);
+}
+
+void BiquadFilter::updateCoefficients(float frequency, float gainDb, float q)
+{
+    const double w0 = 2.0 * std::numbers::pi * std::clamp(frequency, 10.0f, m_sampleRate * 0.45f) / m_sampleRate;
+    const double cosW0 = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * std::max(q, 0.1f));
+    const double a = std::pow(10.0, gainDb / 40.0);
+    const double shelfAlpha = 2.0 * std::sqrt(a) * alpha;
+
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (m_type) {
+    case HighPass:
+        b0 = (1.0 + cosW0) / 2.0;
+        b1 = -(1.0 + cosW0);
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosW0;
+        a2 = 1.0 - alpha;
+        break;
+    case LowPass:
+        b0 = (1.0 - cosW0) / 2.0;
+        b1 = 1.0 - cosW0;
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosW0;
+        a2 = 1.0 - alpha;
+        break;
+    case Peaking:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cosW0;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cosW0;
+        a2 = 1.0 - alpha / a;
+        break;
+    case LowShelf:
+        b0 = a * ((a + 1.0) - (a - 1.0) * cosW0 + shelfAlpha);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosW0);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cosW0 - shelfAlpha);
+        a0 = (a + 1.0) + (a - 1.0) * cosW0 + shelfAlpha;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosW0);
+        a2 = (a + 1.0) + (a - 1.0) * cosW0 - shelfAlpha;
+        break;
+    case HighShelf:
+        b0 = a * ((a + 1.0) + (a - 1.0) * cosW0 + shelfAlpha);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosW0);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cosW0 - shelfAlpha);
+        a0 = (a + 1.0) - (a - 1.0) * cosW0 + shelfAlpha;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosW0);
+        a2 = (a + 1.0) - (a - 1.0) * cosW0 - shelfAlpha;
+        break;
+    }
+
+    m_b0 = static_cast<float>(b0 / a0);
+    m_b1 = static_cast<float>(b1 / a0);
+    m_b2 = static_cast<float>(b2 / a0);
+    m_a1 = static_cast<float>(a1 / a0);
+    m_a2 = static_cast<float>(a2 / a0);
+}
+
+void BiquadFilter::process(float* pFrames, size_t frameCount)
+{
+    // Коэффициенты пересчитываются только пока параметр в движении
+    if (parameter(Frequency).isSmoothing() || parameter(GainDb).isSmoothing() || parameter(Q).isSmoothing()) {
+        updateCoefficients(parameter(Frequency).next(), parameter(GainDb).next(), parameter(Q).next());
+    }
+
+    // Рекурсия идет по времени, поэтому параллелим только каналы
+    for (size_t i = 0; i < frameCount; ++i) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            const float x = pFrames[i * kChannels + c];
+            const float y = m_b0 * x + m_z1[c];
+            m_z1[c] = m_b1 * x - m_a1 * y + m_z2[c];
+            m_z2[c] = m_b2 * x - m_a2 * y;
+            pFrames[i * kChannels + c] = y;
+        }
+    }
+}
+
+// --- ReverbEffect ---
+
+ReverbEffect::ReverbEffect(float sampleRate, float roomSize, float damping, float wet)
+    : EffectNode(ParameterCount, sampleRate)
+{
+    parameter(RoomSize).setTarget(roomSize);
+    parameter(Damping).setTarget(damping);
+    parameter(Wet).setTarget(wet);
+    for (size_t i = 0; i < ParameterCount; ++i) {
+        parameter(i).snap();
+    }
+    m_lastWet = wet;
+
+    const double scale = sampleRate / 44100.0;
+    for (size_t c = 0; c < kChannels; ++c) {
+        const size_t spread = c * kStereoSpread;
+        for (size_t i = 0; i < kCombCount; ++i) {
+            m_combs[c][i].buffer.assign(static_cast<size_t>((kCombTuning[i] + spread) * scale), 0.0f);
+        }
+        for (size_t i = 0; i < kAllpassCount; ++i) {
+            m_allpasses[c][i].buffer.assign(static_cast<size_t>((kAllpassTuning[i] + spread) * scale), 0.0f);
+        }
+    }
+}
+
+void ReverbEffect::reset()
+{
+    for (size_t c = 0; c < kChannels; ++c) {
+        for (Comb& comb : m_combs[c]) {
+            std::fill(comb.buffer.begin(), comb.buffer.end(), 0.0f);
+            comb.filterStore = 0.0f;
+        }
+        for (Allpass& allpass : m_allpasses[c]) {
+            std::fill(allpass.buffer.begin(), allpass.buffer.end(), 0.0f);
+        }
+    }
+}
+
+void ReverbEffect::process(float* pFrames, size_t frameCount)
+{
+    const float feedback = parameter(RoomSize).next() * 0.28f + 0.7f;
+    const float damping = parameter(Damping).next() * 0.4f;
+    const float wet = parameter(Wet).next();
+
+    // Оба канала реверберации питаются одним моно-входом, различаются длины линий задержки
+    float input[kBlockFrames];
+    for (size_t i = 0; i < frameCount; ++i) {
+        input[i] = (pFrames[i * kChannels] + pFrames[i * kChannels + 1]) * kReverbInputGain;
+    }
+
+    float wetFrames[kBlockFrames * kChannels];
+    for (size_t c = 0; c < kChannels; ++c) {
+        for (size_t i = 0; i < frameCount; ++i) {
+            float output = 0.0f;
+            for (Comb& comb : m_combs[c]) {
+                const float delayed = comb.buffer[comb.index];
+                comb.filterStore = delayed * (1.0f - damping) + comb.filterStore * damping;
+                comb.buffer[comb.index] = input[i] + comb.filterStore * feedback;
+                comb.index = comb.index + 1 < comb.buffer.size() ? comb.index + 1 : 0;
+                output += delayed;
+            }
+            for (Allpass& allpass : m_allpasses[c]) {
+                const float delayed = allpass.buffer[allpass.index];
+                allpass.buffer[allpass.index] = output + delayed * 0.5f;
+                allpass.index = allpass.index + 1 < allpass.buffer.size() ? allpass.index + 1 : 0;
+                output = delayed - output;
+            }
+            wetFrames[i * kChannels + c] = output * kReverbWetScale;
+        }
+    }
+
+    // Хвост добавляется к сухому сигналу; сухой слегка приглушается при большом wet
+    const size_t sampleCount = frameCount * kChannels;
+    const float fromWet = m_lastWet;
+    const float step = (wet - fromWet) / static_cast<float>(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i) {
+        const float mix = fromWet + step * static_cast<float>(i);
+        pFrames[i] = pFrames[i] * (1.0f - 0.5f * mix) + wetFrames[i] * mix;
+    }
+    m_lastWet = wet;
+}
+
+// --- BitcrushEffect ---
+
+BitcrushEffect::BitcrushEffect(float sampleRate, float bits, float downsample, float mix)
+    : EffectNode(ParameterCount, sampleRate)
+{
+    parameter(Bits).setTarget(bits);
+    parameter(Downsample).setTarget(downsample);
+    parameter(Mix).setTarget(mix);
+    for (size_t i = 0; i < ParameterCount; ++i) {
+        parameter(i).snap();
+    }
+    m_lastMix = mix;
+    reset();
+}
+
+void BitcrushEffect::reset()
+{
+    std::fill(std::begin(m_held), std::end(m_held), 0.0f);
+    m_holdCounter = 0;
+}
+
+void BitcrushEffect::process(float* pFrames, size_t frameCount)
+{
+    const float levels = std::exp2(std::clamp(parameter(Bits).next(), 1.0f, 16.0f) - 1.0f);
+    const float inverseLevels = 1.0f / levels;
+    const size_t holdFrames = static_cast<size_t>(std::clamp(parameter(Downsample).next(), 1.0f, 64.0f));
+    const float mix = parameter(Mix).next();
+
+    float crushed[kBlockFrames * kChannels];
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (m_holdCounter == 0) {
+            for (size_t c = 0; c < kChannels; ++c) {
+                m_held[c] = std::round(pFrames[i * kChannels + c] * levels) * inverseLevels;
+            }
+        }
+        m_holdCounter = m_holdCounter + 1 < holdFrames ? m_holdCounter + 1 : 0;
+        crushed[i * kChannels] = m_held[0];
+        crushed[i * kChannels + 1] = m_held[1];
+    }
+
+    mixWithRamp(pFrames, crushed, frameCount * kChannels, m_lastMix, mix);
+    m_lastMix = mix;
+}
+
+// --- RobotVoiceEffect ---
+
+RobotVoiceEffect::RobotVoiceEffect(float sampleRate, float frequency, float mix)
+    : EffectNode(ParameterCount, sampleRate),
+      m_phase(0.0)
+{
+    parameter(Frequency).setTarget(frequency);
+    parameter(Mix).setTarget(mix);
+    for (size_t i = 0; i < ParameterCount; ++i) {
+        parameter(i).snap();
+    }
+    m_lastMix = mix;
+}
+
+void RobotVoiceEffect::reset()
+{
+    m_phase = 0.0;
+}
+
+void RobotVoiceEffect::process(float* pFrames, size_t frameCount)
+{
+    const double increment = 2.0 * std::numbers::pi * parameter(Frequency).next() / m_sampleRate;
+    const float mix = parameter(Mix).next();
+
+    // Несущая считается отдельно, чтобы модуляция и смешивание шли плоскими циклами
+    for (size_t i = 0; i < frameCount; ++i) {
+        m_carrier[i] = static_cast<float>(std::sin(m_phase));
+        m_phase += increment;
+    }
+    m_phase = std::fmod(m_phase, 2.0 * std::numbers::pi);
+
+    float modulated[kBlockFrames * kChannels];
+    for (size_t i = 0; i < frameCount; ++i) {
+        modulated[i * kChannels] = pFrames[i * kChannels] * m_carrier[i];
+        modulated[i * kChannels + 1] = pFrames[i * kChannels + 1] * m_carrier[i];
+    }
+
+    mixWithRamp(pFrames, modulated, frameCount * kChannels, m_lastMix, mix);
+    m_lastMix = mix;
+}
+
+// --- NoiseGateEffect ---
+
+NoiseGateEffect::NoiseGateEffect(float sampleRate, float thresholdDb)
+    : EffectNode(ParameterCount, sampleRate),
+      m_envelopeRelease(smoothingCoefficient(kGateEnvelopeSeconds, sampleRate)),
+      m_attack(1.0f - smoothingCoefficient(kGateAttackSeconds, sampleRate)),
+      m_release(1.0f - smoothingCoefficient(kGateReleaseSeconds, sampleRate)),
+      m_holdFrames(static_cast<size_t>(kGateHoldSeconds * sampleRate))
+{
+    parameter(ThresholdDb).setTarget(thresholdDb);
+    parameter(ThresholdDb).snap();
+    reset();
+}
+
+void NoiseGateEffect::reset()
+{
+    m_envelope = 0.0f;
+    m_gain = kGateFloor;
+    m_holdCounter = 0;
+    m_isOpen = false;
+}
+
+void NoiseGateEffect::process(float* pFrames, size_t frameCount)
+{
+    const float openLevel = std::pow(10.0f, parameter(ThresholdDb).next() / 20.0f);
+    const float closeLevel = openLevel * kGateHysteresis;
+
+    for (size_t i = 0; i < frameCount; ++i) {
+        float* pFrame = pFrames + i * kChannels;
+        const float peak = std::max(std::fabs(pFrame[0]), std::fabs(pFrame[1]));
+        m_envelope = peak > m_envelope ? peak : m_envelope * m_envelopeRelease;
+
+        // Между порогами гейт сохраняет состояние: тихий хвост слова не дребезжит
+        if (m_envelope >= openLevel) {
+            m_isOpen = true;
+            m_holdCounter = m_holdFrames;
+        } else if (m_envelope < closeLevel) {
+            if (m_holdCounter > 0) {
+                --m_holdCounter;
+            } else {
+                m_isOpen = false;
+            }
+        }
+
+        const float target = m_isOpen ? 1.0f : kGateFloor;
+        m_gain += (target - m_gain) * (target > m_gain ? m_attack : m_release);
+        pFrame[0] *= m_gain;
+        pFrame[1] *= m_gain;
+    }
+}
+
+// --- NoiseSuppressor ---
+
+NoiseSuppressor::NoiseSuppressor(float sampleRate, float reductionDb)
+    : EffectNode(ParameterCount, sampleRate),
+      m_fft(kFftSize),
+      m_powerSmoothing(smoothingCoefficient(kPowerSmoothingSeconds, sampleRate, kHopFrames)),
+      m_snrSmoothing(std::pow(kSnrSmoothingPer10ms, kHopFrames / (0.01f * sampleRate))),
+      m_windowFrames(std::max<size_t>(1, static_cast<size_t>(kMinimumWindowSeconds * sampleRate / kHopFrames)))
+{
+    parameter(ReductionDb).setTarget(reductionDb);
+    parameter(ReductionDb).snap();
+
+    // Анализирующее окно: подъем — корень из Ханна длины 2(N - M), спад — корень из Ханна длины 2M.
+    // Синтезирующее на последних 2M отсчетах дополняет его до Ханна длины 2M, который
+    // при шаге M складывается в единицу: без обработки выход равен входу с задержкой 2M
+    const size_t riseFrames = kFftSize - kHopFrames;
+    m_analysisWindow.resize(kFftSize);
+    for (size_t n = 0; n < kFftSize; ++n) {
+        m_analysisWindow[n] = n < riseFrames ? std::sqrt(periodicHann(n, 2 * riseFrames))
+                                             : std::sqrt(periodicHann(n - (kFftSize - 2 * kHopFrames), 2 * kHopFrames));
+    }
+    m_synthesisWindow.resize(2 * kHopFrames);
+    for (size_t i = 0; i < 2 * kHopFrames; ++i) {
+        const float analysis = m_analysisWindow[kFftSize - 2 * kHopFrames + i];
+        m_synthesisWindow[i] = analysis > 0.0f ? periodicHann(i, 2 * kHopFrames) / analysis : 0.0f;
+    }
+
+    const size_t binCount = m_fft.binCount();
+    m_frame.resize(kFftSize);
+    m_re.resize(binCount);
+    m_im.resize(binCount);
+    for (Channel& channel : m_channels) {
+        channel.input.resize(kFftSize);
+        channel.overlap.resize(2 * kHopFrames);
+        channel.output.resize(kHopFrames);
+        channel.smoothedPower.resize(binCount);
+        channel.windowMinimum.resize(binCount);
+        channel.pastMinimum.resize(binCount * kMinimumWindows);
+        channel.cleanSnr.resize(binCount);
+    }
+    reset();
+}
+
+void NoiseSuppressor::reset()
+{
+    for (Channel& channel : m_channels) {
+        std::fill(channel.input.begin(), channel.input.end(), 0.0f);
+        std::fill(channel.overlap.begin(), channel.overlap.end(), 0.0f);
+        std::fill(channel.output.begin(), channel.output.end(), 0.0f);
+        std::fill(channel.smoothedPower.begin(), channel.smoothedPower.end(), 0.0f);
+        std::fill(channel.windowMinimum.begin(), channel.windowMinimum.end(), std::numeric_limits<float>::max());
+        std::fill(channel.pastMinimum.begin(), channel.pastMinimum.end(), std::numeric_limits<float>::max());
+        std::fill(channel.cleanSnr.begin(), channel.cleanSnr.end(), 0.0f);
+    }
+    m_hopPosition = 0;
+    m_windowPosition = 0;
+    m_pastIndex = 0;
+    m_isPrimed = false;
+}
+
+void NoiseSuppressor::process(float* pFrames, size_t frameCount)
+{
+    const float floorGain = std::pow(10.0f, -std::max(parameter(ReductionDb).next(), 0.0f) / 20.0f);
+
+    for (size_t i = 0; i < frameCount; ++i) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            Channel& channel = m_channels[c];
+            channel.input[kFftSize - kHopFrames + m_hopPosition] = pFrames[i * kChannels + c];
+            pFrames[i * kChannels + c] = channel.output[m_hopPosition];
+        }
+        if (++m_hopPosition < kHopFrames) {
+            continue;
+        }
+        m_hopPosition = 0;
+        for (Channel& channel : m_channels) {
+            processFrame(&channel, floorGain);
+        }
+        m_isPrimed = true;
+
+        // Подокно поиска минимума закончилось: оно становится прошлым, самое старое забывается
+        if (++m_windowPosition >= m_windowFrames) {
+            m_windowPosition = 0;
+            const size_t binCount = m_fft.binCount();
+            for (Channel& channel : m_channels) {
+                for (size_t k = 0; k < binCount; ++k) {
+                    channel.pastMinimum[k * kMinimumWindows + m_pastIndex] = channel.windowMinimum[k];
+                }
+                std::copy(channel.smoothedPower.begin(), channel.smoothedPower.end(), channel.windowMinimum.begin());
+            }
+            m_pastIndex = (m_pastIndex + 1) % kMinimumWindows;
+        }
+    }
+}
+
+void NoiseSuppressor::processFrame(Channel* pChannel, float floorGain)
+{
+    for (size_t n = 0; n < kFftSize; ++n) {
+        m_frame[n] = pChannel->input[n] * m_analysisWindow[n];
+    }
+    std::copy(pChannel->input.begin() + kHopFrames, pChannel->input.end(), pChannel->input.begin());
+    m_fft.forward(m_frame.data(), m_re.data(), m_im.data());
+
+    // Плоские циклы по полосам без ветвлений: компилятор их векторизует
+    const size_t binCount = m_fft.binCount();
+    float* pSmoothed = pChannel->smoothedPower.data();
+    float* pMinimum = pChannel->windowMinimum.data();
+    float* pCleanSnr = pChannel->cleanSnr.data();
+    const float smoothing = m_isPrimed ? m_powerSmoothing : 0.0f; // Первый кадр — сразу к текущему уровню
+    for (size_t k = 0; k < binCount; ++k) {
+        const float power = m_re[k] * m_re[k] + m_im[k] * m_im[k];
+        pSmoothed[k] = smoothing * pSmoothed[k] + (1.0f - smoothing) * power;
+        pMinimum[k] = std::min(pMinimum[k], pSmoothed[k]);
+
+        const float* pPast = pChannel->pastMinimum.data() + k * kMinimumWindows;
+        float noise = pMinimum[k];
+        for (size_t w = 0; w < kMinimumWindows; ++w) {
+            noise = std::min(noise, pPast[w]);
+        }
+        noise *= kMinimumBias;
+
+        const float snr = power / (noise + 1.0e-20f);
+        const float prioriSnr = m_snrSmoothing * pCleanSnr[k] + (1.0f - m_snrSmoothing) * std::max(snr - 1.0f, 0.0f);
+        const float gain = std::max(prioriSnr / (1.0f + prioriSnr), floorGain);
+        pCleanSnr[k] = gain * gain * snr;
+        m_re[k] *= gain;
+        m_im[k] *= gain;
+    }
+
+    m_fft.inverse(m_re.data(), m_im.data(), m_frame.data());
+    const float* pTail = m_frame.data() + kFftSize - 2 * kHopFrames;
+    for (size_t i = 0; i < 2 * kHopFrames; ++i) {
+        pChannel->overlap[i] += pTail[i] * m_synthesisWindow[i];
+    }
+    // Первые kHopFrames больше не получат вкладов от следующих кадров — они готовы
+    std::copy(pChannel->overlap.begin(), pChannel->overlap.begin() + kHopFrames, pChannel->output.begin());
+    std::copy(pChannel->overlap.begin() + kHopFrames, pChannel->overlap.end(), pChannel->overlap.begin());
+    std::fill(pChannel->overlap.begin() + kHopFrames, pChannel->overlap.end(), 0.0f);
+}
+
+// --- EffectChain ---
+
+void EffectChain::append(std::unique_ptr<EffectNode> node)
+{
+    m_nodes.push_back(std::move(node));
+}
+
+void EffectChain::process(float* pFrames, size_t frameCount)
+{
+    DenormalGuard denormalGuard;
+
+    // Блоки по 64 кадра: сглаживание параметров и стековые буферы узлов рассчитаны на этот размер
+    for (size_t offset = 0; offset < frameCount; offset += EffectNode::kBlockFrames) {
+        const size_t blockFrames = std::min(EffectNode::kBlockFrames, frameCount - offset);
+        float* pBlock = pFrames + offset * EffectNode::kChannels;
+        for (const std::unique_ptr<EffectNode>& node : m_nodes) {
+            node->process(pBlock, blockFrames);
+        }
+    }
+}
+
+void EffectChain::reset()
+{
+    for (const std::unique_ptr<EffectNode>& node : m_nodes) {
+        node->reset();
+    }
+}
+
+// --- EffectChainSlot ---
+
+EffectChainSlot::~EffectChainSlot()
+{
+    // Владелец уничтожает слот только когда аудиопоток к нему больше не обращается
+    delete m_chain.load();
+    for (const Retired& retired : m_retired) {
+        delete retired.chain;
+    }
+}
+
+void EffectChainSlot::process(float* pFrames, size_t frameCount)
+{
+    EffectChain* pChain = m_chain.load(std::memory_order_acquire);
+    if (pChain != nullptr) {
+        pChain->process(pFrames, frameCount);
+    }
+    // Счетчик говорит главному потоку, что цепочка, загруженная выше, больше не используется
+    m_processSerial.fetch_add(1, std::memory_order_release);
+}
+
+void EffectChainSlot::publish(std::unique_ptr<EffectChain> chain)
+{
+    EffectChain* pOldChain = m_chain.exchange(chain.release());
+    if (pOldChain != nullptr) {
+        m_retired.push_back({pOldChain, m_processSerial.load(std::memory_order_acquire)});
+    }
+}
+
+void EffectChainSlot::collect(bool isAudioStopped)
+{
+    const uint64_t serial = m_processSerial.load(std::memory_order_acquire);
+    auto isDone = [serial, isAudioStopped](const Retired& retired) {
+        return isAudioStopped || serial > retired.processSerial;
+    };
+    for (const Retired& retired : m_retired) {
+        if (isDone(retired)) {
+            delete retired.chain;
+        }
+    }
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), isDone), m_retired.end());
+}
@@ -0,0 +1,283 @@
+// src/Effects.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "RealFft.h"
+
+// Параметр эффекта со сглаживанием. Цель пишет главный поток, аудиопоток
+// на каждом блоке приближает к ней текущее значение (постоянная времени ~20 мс).
+class SmoothedParameter
+{
+public:
+    explicit SmoothedParameter(float value = 0.0f) : m_target(value), m_current(value) {}
+
+    void setTarget(float value) { m_target.store(value, std::memory_order_relaxed); }
+    float target() const { return m_target.load(std::memory_order_relaxed); }
+
+    // Значение на следующий блок (вызывать раз в блок из аудиопотока)
+    float next();
+    float current() const { return m_current; }
+    bool isSmoothing() const { return m_current != target(); }
+    void snap() { m_current = target(); }
+
+private:
+    std::atomic<float> m_target;
+    float m_current;
+};
+
+// Узел графа эффектов: обрабатывает стерео f32 на месте. Все буферы узел
+// выделяет в конструкторе, process() не выделяет память и не блокируется.
+class EffectNode
+{
+public:
+    static constexpr size_t kChannels = 2;
+    static constexpr size_t kBlockFrames = 64; // EffectChain режет буфер на блоки не длиннее этого
+
+    EffectNode(size_t parameterCount, float sampleRate);
+    virtual ~EffectNode() = default;
+
+    virtual void process(float* pFrames, size_t frameCount) = 0;
+    virtual void reset() = 0;
+
+    // Потокобезопасно: меняет цель, изменение доходит до звука плавно
+    void setParameter(size_t index, float value);
+    size_t parameterCount() const { return m_parameterCount; }
+
+protected:
+    SmoothedParameter& parameter(size_t index) { return m_parameters[index]; }
+
+    const float m_sampleRate;
+
+private:
+    const size_t m_parameterCount;
+    std::unique_ptr<SmoothedParameter[]> m_parameters;
+};
+
+// Биквадратный фильтр по RBJ Audio EQ Cookbook (транспонированная прямая форма II)
+class BiquadFilter : public EffectNode
+{
+public:
+    enum Type { HighPass, LowPass, LowShelf, Peaking, HighShelf };
+    enum Parameter { Frequency, GainDb, Q, ParameterCount };
+
+    BiquadFilter(Type type, float sampleRate, float frequency, float gainDb = 0.0f, float q = 0.7071f);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    void updateCoefficients(float frequency, float gainDb, float q);
+
+    const Type m_type;
+    float m_b0, m_b1, m_b2, m_a1, m_a2;
+    float m_z1[kChannels];
+    float m_z2[kChannels];
+};
+
+// Реверберация Freeverb: 8 гребенчатых и 4 всепропускающих фильтра на канал
+class ReverbEffect : public EffectNode
+{
+public:
+    enum Parameter { RoomSize, Damping, Wet, ParameterCount };
+
+    ReverbEffect(float sampleRate, float roomSize, float damping, float wet);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    static constexpr size_t kCombCount = 8;
+    static constexpr size_t kAllpassCount = 4;
+
+    struct Comb {
+        std::vector<float> buffer;
+        size_t index = 0;
+        float filterStore = 0.0f;
+    };
+    struct Allpass {
+        std::vector<float> buffer;
+        size_t index = 0;
+    };
+
+    Comb m_combs[kChannels][kCombCount];
+    Allpass m_allpasses[kChannels][kAllpassCount];
+    float m_lastWet;
+};
+
+// Понижение разрядности и частоты дискретизации
+class BitcrushEffect : public EffectNode
+{
+public:
+    enum Parameter { Bits, Downsample, Mix, ParameterCount };
+
+    BitcrushEffect(float sampleRate, float bits, float downsample, float mix);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    float m_held[kChannels];
+    size_t m_holdCounter;
+    float m_lastMix;
+};
+
+// «Робот»: кольцевая модуляция голоса синусом низкой частоты
+class RobotVoiceEffect : public EffectNode
+{
+public:
+    enum Parameter { Frequency, Mix, ParameterCount };
+
+    RobotVoiceEffect(float sampleRate, float frequency, float mix);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    double m_phase;
+    float m_lastMix;
+    float m_carrier[kBlockFrames];
+};
+
+// Шумовой гейт без упреждения (нулевая задержка): огибающая по пику обоих каналов,
+// открытие за 1 мс, гистерезис 6 дБ, удержание 120 мс, закрытие за 80 мс до -40 дБ
+class NoiseGateEffect : public EffectNode
+{
+public:
+    enum Parameter { ThresholdDb, ParameterCount };
+
+    NoiseGateEffect(float sampleRate, float thresholdDb);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    const float m_envelopeRelease;
+    const float m_attack;
+    const float m_release;
+    const size_t m_holdFrames;
+    float m_envelope;
+    float m_gain;
+    size_t m_holdCounter;
+    bool m_isOpen;
+};
+
+// Легкое спектральное шумоподавление. Оконное БПФ на 256 точек с шагом 32 кадра;
+// уровень шума в каждой полосе — минимум сглаженной мощности за последние ~1.6 с,
+// усиление — винеровское с решением по направлению (decision-directed), не ниже -ReductionDb.
+//
+// Окна асимметричные (Mauler & Martin): длинное анализирующее дает разрешение 256 точек,
+// а синтезирующее занимает только последние 2·kHopFrames отсчетов кадра, поэтому
+// задержка — kLatencyFrames (1.3 мс при 48 кГц), меньше любого рабочего периода.
+class NoiseSuppressor : public EffectNode
+{
+public:
+    enum Parameter { ReductionDb, ParameterCount };
+
+    static constexpr size_t kFftSize = 256;
+    static constexpr size_t kHopFrames = 32;
+    static constexpr size_t kLatencyFrames = 2 * kHopFrames;
+
+    NoiseSuppressor(float sampleRate, float reductionDb);
+
+    void process(float* pFrames, size_t frameCount) override;
+    void reset() override;
+
+private:
+    static constexpr size_t kMinimumWindows = 4; // Поиск минимума по 4 подокнам
+
+    struct Channel {
+        std::vector<float> input;    // Последние kFftSize входных отсчетов
+        std::vector<float> overlap;  // Сумма синтезированных кадров, 2·kHopFrames
+        std::vector<float> output;   // Готовый шаг, отдается по отсчету
+        std::vector<float> smoothedPower;
+        std::vector<float> windowMinimum; // Минимум текущего подокна
+        std::vector<float> pastMinimum;   // Минимумы прошлых подокон, kMinimumWindows на полосу
+        std::vector<float> cleanSnr;      // G²·γ прошлого кадра: основа decision-directed
+    };
+
+    void processFrame(Channel* pChannel, float floorGain);
+
+    RealFft m_fft;
+    const float m_powerSmoothing;
+    const float m_snrSmoothing;
+    const size_t m_windowFrames; // Кадров БПФ в подокне поиска минимума
+    std::vector<float> m_analysisWindow;
+    std::vector<float> m_synthesisWindow;
+    std::vector<float> m_frame;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    Channel m_channels[kChannels];
+    size_t m_hopPosition;
+    size_t m_windowPosition;
+    size_t m_pastIndex;
+    bool m_isPrimed;
+};
+
+// Последовательная цепочка узлов. Собирается в главном потоке целиком,
+// аудиопоток видит ее только после публикации через EffectChainSlot.
+class EffectChain
+{
+public:
+    void append(std::unique_ptr<EffectNode> node);
+    size_t nodeCount() const { return m_nodes.size(); }
+    EffectNode* node(size_t index) const { return m_nodes[index].get(); }
+
+    void process(float* pFrames, size_t frameCount);
+    void reset();
+
+private:
+    std::vector<std::unique_ptr<EffectNode>> m_nodes;
+};
+
+// Точка подключения цепочки (голос, шина микрофона, мастер).
+// Новая цепочка подменяется атомарно, старая освобождается в главном потоке
+// только после того, как аудиопоток гарантированно закончил с ней работать.
+class EffectChainSlot
+{
+public:
+    EffectChainSlot() = default;
+    ~EffectChainSlot();
+    EffectChainSlot(const EffectChainSlot&) = delete;
+    EffectChainSlot& operator=(const EffectChainSlot&) = delete;
+
+    // Аудиопоток
+    void process(float* pFrames, size_t frameCount);
+
+    // Главный поток
+    EffectChain* chain() const { return m_chain.load(); }
+    void publish(std::unique_ptr<EffectChain> chain); // nullptr отключает обработку
+    void collect(bool isAudioStopped);                // Освобождает отработавшие цепочки
+
+private:
+    struct Retired {
+        EffectChain* chain;
+        uint64_t processSerial;
+    };
+
+    std::atomic<EffectChain*> m_chain{nullptr};
+    std::atomic<uint64_t> m_processSerial{0};
+    std::vector<Retired> m_retired;
+};
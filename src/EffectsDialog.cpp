@@ -0,0 +1,118 @@
+#include "EffectsDialog.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QGroupBox>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+
+EffectsDialog::EffectsDialog(const QString &title, const AudioEngine::EffectSettings &settings, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle(title);
+
+    m_highPassGroup = createGroup(tr("High-pass filter"), settings.highPassEnabled);
+    m_highPassSpinBox = createSpinBox(20, 1000, 10, 0, tr(" Hz"), settings.highPassHz);
+    QFormLayout *highPassLayout = new QFormLayout(m_highPassGroup);
+    highPassLayout->addRow(tr("Cutoff:"), m_highPassSpinBox);
+
+    // Три полосы: полки 200 Гц и 4 кГц и перестраиваемый пик посередине
+    m_eqGroup = createGroup(tr("Equalizer"), settings.eqEnabled);
+    m_eqLowSpinBox = createSpinBox(-24, 24, 0.5, 1, tr(" dB"), settings.eqLowGainDb);
+    m_eqMidSpinBox = createSpinBox(-24, 24, 0.5, 1, tr(" dB"), settings.eqMidGainDb);
+    m_eqMidFrequencySpinBox = createSpinBox(200, 8000, 50, 0, tr(" Hz"), settings.eqMidHz);
+    m_eqHighSpinBox = createSpinBox(-24, 24, 0.5, 1, tr(" dB"), settings.eqHighGainDb);
+    QFormLayout *eqLayout = new QFormLayout(m_eqGroup);
+    eqLayout->addRow(tr("Low (200 Hz):"), m_eqLowSpinBox);
+    eqLayout->addRow(tr("Mid:"), m_eqMidSpinBox);
+    eqLayout->addRow(tr("Mid frequency:"), m_eqMidFrequencySpinBox);
+    eqLayout->addRow(tr("High (4 kHz):"), m_eqHighSpinBox);
+
+    m_bitcrushGroup = createGroup(tr("Bitcrusher"), settings.bitcrushEnabled);
+    m_bitcrushBitsSpinBox = createSpinBox(1, 16, 1, 0, tr(" bit"), settings.bitcrushBits);
+    m_bitcrushDownsampleSpinBox = createSpinBox(1, 32, 1, 0, tr("x"), settings.bitcrushDownsample);
+    m_bitcrushMixSpinBox = createSpinBox(0, 100, 5, 0, tr(" %"), settings.bitcrushMix * 100);
+    QFormLayout *bitcrushLayout = new QFormLayout(m_bitcrushGroup);
+    bitcrushLayout->addRow(tr("Bit depth:"), m_bitcrushBitsSpinBox);
+    bitcrushLayout->addRow(tr("Downsample:"), m_bitcrushDownsampleSpinBox);
+    bitcrushLayout->addRow(tr("Mix:"), m_bitcrushMixSpinBox);
+
+    m_robotGroup = createGroup(tr("Robot voice"), settings.robotEnabled);
+    m_robotFrequencySpinBox = createSpinBox(10, 500, 5, 0, tr(" Hz"), settings.robotHz);
+    m_robotMixSpinBox = createSpinBox(0, 100, 5, 0, tr(" %"), settings.robotMix * 100);
+    QFormLayout *robotLayout = new QFormLayout(m_robotGroup);
+    robotLayout->addRow(tr("Carrier:"), m_robotFrequencySpinBox);
+    robotLayout->addRow(tr("Mix:"), m_robotMixSpinBox);
+
+    m_reverbGroup = createGroup(tr("Reverb"), settings.reverbEnabled);
+    m_reverbRoomSpinBox = createSpinBox(0, 100, 5, 0, tr(" %"), settings.reverbRoomSize * 100);
+    m_reverbDampingSpinBox = createSpinBox(0, 100, 5, 0, tr(" %"), settings.reverbDamping * 100);
+    m_reverbWetSpinBox = createSpinBox(0, 100, 5, 0, tr(" %"), settings.reverbWet * 100);
+    QFormLayout *reverbLayout = new QFormLayout(m_reverbGroup);
+    reverbLayout->addRow(tr("Room size:"), m_reverbRoomSpinBox);
+    reverbLayout->addRow(tr("Damping:"), m_reverbDampingSpinBox);
+    reverbLayout->addRow(tr("Wet:"), m_reverbWetSpinBox);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    // Порядок групп совпадает с порядком узлов в цепочке
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_highPassGroup);
+    layout->addWidget(m_eqGroup);
+    layout->addWidget(m_bitcrushGroup);
+    layout->addWidget(m_robotGroup);
+    layout->addWidget(m_reverbGroup);
+    layout->addWidget(buttonBox);
+}
+
+AudioEngine::EffectSettings EffectsDialog::getSettings() const
+{
+    AudioEngine::EffectSettings settings;
+    settings.highPassEnabled = m_highPassGroup->isChecked();
+    settings.highPassHz = static_cast<float>(m_highPassSpinBox->value());
+
+    settings.eqEnabled = m_eqGroup->isChecked();
+    settings.eqLowGainDb = static_cast<float>(m_eqLowSpinBox->value());
+    settings.eqMidGainDb = static_cast<float>(m_eqMidSpinBox->value());
+    settings.eqMidHz = static_cast<float>(m_eqMidFrequencySpinBox->value());
+    settings.eqHighGainDb = static_cast<float>(m_eqHighSpinBox->value());
+
+    settings.bitcrushEnabled = m_bitcrushGroup->isChecked();
+    settings.bitcrushBits = static_cast<float>(m_bitcrushBitsSpinBox->value());
+    settings.bitcrushDownsample = static_cast<float>(m_bitcrushDownsampleSpinBox->value());
+    settings.bitcrushMix = static_cast<float>(m_bitcrushMixSpinBox->value() / 100.0);
+
+    settings.robotEnabled = m_robotGroup->isChecked();
+    settings.robotHz = static_cast<float>(m_robotFrequencySpinBox->value());
+    settings.robotMix = static_cast<float>(m_robotMixSpinBox->value() / 100.0);
+
+    settings.reverbEnabled = m_reverbGroup->isChecked();
+    settings.reverbRoomSize = static_cast<float>(m_reverbRoomSpinBox->value() / 100.0);
+    settings.reverbDamping = static_cast<float>(m_reverbDampingSpinBox->value() / 100.0);
+    settings.reverbWet = static_cast<float>(m_reverbWetSpinBox->value() / 100.0);
+    return settings;
+}
+
+QGroupBox* EffectsDialog::createGroup(const QString &title, bool checked)
+{
+    QGroupBox *group = new QGroupBox(title, this);
+    group->setCheckable(true);
+    group->setChecked(checked);
+    // Подключаемся после установки значения: остальные виджеты еще не созданы
+    connect(group, &QGroupBox::toggled, this, [this]() { emit settingsChanged(getSettings()); });
+    return group;
+}
+
+QDoubleSpinBox* EffectsDialog::createSpinBox(double minimum, double maximum, double step, int decimals,
+                                             const QString &suffix, double value)
+{
+    QDoubleSpinBox *spinBox = new QDoubleSpinBox(this);
+    spinBox->setRange(minimum, maximum);
+    spinBox->setSingleStep(step);
+    spinBox->setDecimals(decimals);
+    spinBox->setSuffix(suffix);
+    spinBox->setValue(value);
+    connect(spinBox, &QDoubleSpinBox::valueChanged, this, [this]() { emit settingsChanged(getSettings()); });
+    return spinBox;
+}
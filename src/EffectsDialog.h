@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QDialog>
+#include "AudioEngine.h"
+
+class QGroupBox;
+class QDoubleSpinBox;
+
+// Редактор цепочки эффектов трека или шины: срез низов, эквалайзер, bitcrush, робот, реверберация
+class EffectsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    EffectsDialog(const QString& title, const AudioEngine::EffectSettings& settings, QWidget *parent = nullptr);
+    AudioEngine::EffectSettings getSettings() const;
+
+signals:
+    // Любое изменение в диалоге — владелец может сразу применить его к движку для прослушивания
+    void settingsChanged(const AudioEngine::EffectSettings& settings);
+
+private:
+    QGroupBox* createGroup(const QString& title, bool checked);
+    QDoubleSpinBox* createSpinBox(double minimum, double maximum, double step, int decimals,
+                                  const QString& suffix, double value);
+
+    QGroupBox *m_highPassGroup;
+    QDoubleSpinBox *m_highPassSpinBox;
+
+    QGroupBox *m_eqGroup;
+    QDoubleSpinBox *m_eqLowSpinBox;
+    QDoubleSpinBox *m_eqMidSpinBox;
+    QDoubleSpinBox *m_eqMidFrequencySpinBox;
+    QDoubleSpinBox *m_eqHighSpinBox;
+
+    QGroupBox *m_bitcrushGroup;
+    QDoubleSpinBox *m_bitcrushBitsSpinBox;
+    QDoubleSpinBox *m_bitcrushDownsampleSpinBox;
+    QDoubleSpinBox *m_bitcrushMixSpinBox;
+
+    QGroupBox *m_robotGroup;
+    QDoubleSpinBox *m_robotFrequencySpinBox;
+    QDoubleSpinBox *m_robotMixSpinBox;
+
+    QGroupBox *m_reverbGroup;
+    QDoubleSpinBox *m_reverbRoomSpinBox;
+    QDoubleSpinBox *m_reverbDampingSpinBox;
+    QDoubleSpinBox *m_reverbWetSpinBox;
+};
@@ -0,0 +1,98 @@
+// src/EngineSettings.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EngineSettings.h"
+#include "AudioEngine.h"
+#include "Playlist.h"
+#include "MidiInput.h"
+#include <QDateTime>
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+
+namespace EngineSettings {
+
+bool apply(AudioEngine* engine)
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    const bool storeEnabled = settings.value("audio/sampleStoreEnabled", false).toBool();
+    const size_t budgetMB = settings.value("audio/sampleStoreBudgetMB", 256).toUInt();
+
+    engine->setContextOptions(settings.value("audio/backend").toString(),
+                              settings.value("audio/realtimePriority", false).toBool());
+    engine->setExclusiveMode(settings.value("audio/exclusiveMode", false).toBool());
+    engine->setParallelMixingEnabled(settings.value("audio/parallelMixing", false).toBool());
+    engine->setOutputDevice(settings.value("audio/outputDeviceId").toByteArray(),
+                            settings.value("audio/outputDeviceName").toString());
+    engine->setBufferSize(settings.value("audio/periodSizeInFrames", 0).toUInt(),
+                          settings.value("audio/periods", 0).toUInt());
+    engine->setMasterEffects(Playlist::parseEffects(settings.value("effects/master").toString()));
+    engine->setMicEffects(Playlist::parseEffects(settings.value("effects/mic").toString()));
+    engine->setMicPassthroughEnabled(settings.value("audio/micPassthrough", false).toBool());
+    engine->setMicNoiseSuppression(settings.value("audio/micNoiseSuppression", false).toBool(),
+                                   settings.value("audio/micSuppressionDb", 12).toFloat());
+    engine->setMicNoiseGate(settings.value("audio/micNoiseGate", false).toBool(),
+                            settings.value("audio/micGateThresholdDb", -45).toFloat());
+
+    engine->setPrimeBudget(settings.value("audio/primeBudgetMB", 64).toUInt() * size_t(1024 * 1024));
+    // Статистика запусков общая для окна и демона: оба играют одну библиотеку
+    engine->setUsageFile(settings.value("audio/rememberUsage", true).toBool()
+                             ? QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+                                   "/OpenSoundDeck/usage.dat"
+                             : QString());
+    engine->setReplaySeconds(settings.value("capture/replayMinutes", 2).toInt() * 60);
+    engine->setSampleStoreBudget(budgetMB * 1024 * 1024);
+    if (storeEnabled == engine->isSampleStoreEnabled()) {
+        return false;
+    }
+    engine->setSampleStoreEnabled(storeEnabled);
+    return storeEnabled;
+}
+
+void applyMidi(MidiInput* midiInput)
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    if (!settings.value("midi/enabled", false).toBool()) {
+        midiInput->stop();
+        return;
+    }
+
+    MidiInput::Mapping mapping;
+    mapping.channel = settings.value("midi/channel", 0).toInt();
+    mapping.firstNote = settings.value("midi/firstNote", 36).toInt();
+    mapping.firstController = settings.value("midi/firstController", -1).toInt();
+    mapping.velocityToGain = settings.value("midi/velocityToGain", true).toBool();
+    midiInput->start(settings.value("midi/source").toString(), mapping);
+}
+
+QString captureFilePath(const QString& prefix)
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    QString folder = settings.value("capture/folder").toString();
+    if (folder.isEmpty()) {
+        folder = QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/OpenSoundDeck";
+    }
+    QDir().mkpath(folder);
+    const QString suffix = settings.value("capture/format", "flac").toString() == "wav" ? "wav" : "flac";
+    return QDir(folder).filePath(
+        QString("%1 %2.%3").arg(prefix, QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss"), suffix));
+}
+
+} // namespace EngineSettings
@@ -0,0 +1,41 @@
+// src/EngineSettings.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+
+class AudioEngine;
+class MidiInput;
+
+// Настройки движка из QSettings (вкладка Audio и шины эффектов).
+// Общие для окна и для opensounddeckd, чтобы оба играли одинаково.
+namespace EngineSettings {
+
+// Возвращает true, если хранилище клипов только что включилось и его стоит прогреть
+bool apply(AudioEngine* engine);
+
+// Включает, перенастраивает или выключает вход MIDI (вкладка MIDI)
+void applyMidi(MidiInput* midiInput);
+
+// Новый файл записи в папке записей: "<prefix> yyyy-MM-dd hh-mm-ss.flac" (или .wav)
+QString captureFilePath(const QString& prefix);
+
+} // namespace EngineSettings
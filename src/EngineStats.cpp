@@ -0,0 +1,264 @@
+// src/EngineStats.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EngineStats.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+constexpr std::memory_order kRelaxed = std::memory_order_relaxed;
+
+// Пропуск больше полутора периодов означает, что устройство успело доиграть буфер до нашего колбэка
+constexpr qint64 kXrunIntervalPercent = 150;
+
+int histogramBucket(qint64 durationNs, qint64 budgetNs)
+{
+    const qint64 percent = durationNs * 100 / budgetNs;
+    if (percent < 100) {
+        return static_cast<int>(percent / 10);
+    }
+    return percent < 150 ? 10 : 11;
+}
+
+QJsonObject toJsonObject(const EngineStats::Snapshot& snapshot)
+{
+    QJsonArray histogram;
+    for (quint64 count : snapshot.histogram) {
+        histogram.append(static_cast<qint64>(count));
+    }
+    QJsonObject object;
+    object["timestamp"] = QDateTime::fromMSecsSinceEpoch(snapshot.timestampMs, Qt::UTC).toString(Qt::ISODateWithMs);
+    object["callbacks"] = static_cast<qint64>(snapshot.callbacks);
+    object["frames"] = static_cast<qint64>(snapshot.frames);
+    object["budget_ms"] = snapshot.budgetMillis;
+    object["callback_avg_ms"] = snapshot.averageCallbackMillis;
+    object["callback_max_ms"] = snapshot.maxCallbackMillis;
+    object["load_avg"] = snapshot.averageLoad;
+    object["load_peak"] = snapshot.peakLoad;
+    object["load_histogram"] = histogram;
+    object["over_budget"] = static_cast<qint64>(snapshot.overBudget);
+    object["xruns"] = static_cast<qint64>(snapshot.xruns);
+    object["active_voices"] = snapshot.activeVoices;
+    object["streamed_voices"] = snapshot.streamedVoices;
+    object["armed_clips"] = snapshot.armedClips;
+    object["armed_ready"] = snapshot.armedReady;
+    object["cache_hits"] = static_cast<qint64>(snapshot.cacheHits);
+    object["cache_misses"] = static_cast<qint64>(snapshot.cacheMisses);
+    object["cache_hit_rate"] = snapshot.cacheHitRate();
+    object["resident_bytes"] = static_cast<qint64>(snapshot.residentBytes);
+    object["budget_bytes"] = static_cast<qint64>(snapshot.budgetBytes);
+    object["stream_hits"] = static_cast<qint64>(snapshot.streamHits);
+    object["stream_misses"] = static_cast<qint64>(snapshot.streamMisses);
+    object["mic_denoise_load"] = snapshot.micSuppressionLoad;
+    object["mic_gate_load"] = snapshot.micGateLoad;
+    return object;
+}
+
+} // namespace
+
+double EngineStats::Snapshot::cacheHitRate() const
+{
+    const quint64 total = cacheHits + cacheMisses;
+    return total > 0 ? static_cast<double>(cacheHits) / total : 0.0;
+}
+
+EngineStats::EngineStats()
+    : m_isResetRequested(false),
+      m_callbacks(0),
+      m_frames(0),
+      m_totalDurationNs(0),
+      m_totalBudgetNs(0),
+      m_maxDurationNs(0),
+      m_lastBudgetNs(0),
+      m_peakLoadPermille(0),
+      m_overBudget(0),
+      m_xruns(0),
+      m_micSuppressionNs(0),
+      m_micGateNs(0),
+      m_activeVoices(0),
+      m_streamedVoices(0),
+      m_cacheHits(0),
+      m_cacheMisses(0)
+{
+    for (std::atomic<quint64>& bucket : m_histogram) {
+        bucket.store(0);
+    }
+}
+
+void EngineStats::recordCallback(qint64 durationNs, qint64 intervalNs, quint32 frameCount, quint32 sampleRate,
+                                 int activeVoices, int streamedVoices)
+{
+    if (frameCount == 0 || sampleRate == 0) {
+        return;
+    }
+    if (m_isResetRequested.exchange(false, kRelaxed)) {
+        m_callbacks.store(0, kRelaxed);
+        m_frames.store(0, kRelaxed);
+        m_totalDurationNs.store(0, kRelaxed);
+        m_totalBudgetNs.store(0, kRelaxed);
+        m_maxDurationNs.store(0, kRelaxed);
+        m_peakLoadPermille.store(0, kRelaxed);
+        for (std::atomic<quint64>& bucket : m_histogram) {
+            bucket.store(0, kRelaxed);
+        }
+        m_overBudget.store(0, kRelaxed);
+        m_xruns.store(0, kRelaxed);
+        m_micSuppressionNs.store(0, kRelaxed);
+        m_micGateNs.store(0, kRelaxed);
+    }
+
+    // Писатель один, поэтому load + store вместо fetch_add: на x86 это обычные mov без lock
+    const qint64 budgetNs = static_cast<qint64>(frameCount) * 1000000000LL / sampleRate;
+    m_callbacks.store(m_callbacks.load(kRelaxed) + 1, kRelaxed);
+    m_frames.store(m_frames.load(kRelaxed) + frameCount, kRelaxed);
+    m_totalDurationNs.store(m_totalDurationNs.load(kRelaxed) + durationNs, kRelaxed);
+    m_totalBudgetNs.store(m_totalBudgetNs.load(kRelaxed) + budgetNs, kRelaxed);
+    m_lastBudgetNs.store(budgetNs, kRelaxed);
+    if (durationNs > m_maxDurationNs.load(kRelaxed)) {
+        m_maxDurationNs.store(durationNs, kRelaxed);
+    }
+    const quint32 loadPermille = static_cast<quint32>(std::min<qint64>(durationNs * 1000 / budgetNs, UINT32_MAX));
+    if (loadPermille > m_peakLoadPermille.load(kRelaxed)) {
+        m_peakLoadPermille.store(loadPermille, kRelaxed);
+    }
+
+    std::atomic<quint64>& bucket = m_histogram[histogramBucket(durationNs, budgetNs)];
+    bucket.store(bucket.load(kRelaxed) + 1, kRelaxed);
+    if (durationNs > budgetNs) {
+        m_overBudget.store(m_overBudget.load(kRelaxed) + 1, kRelaxed);
+    }
+    if (intervalNs > 0 && intervalNs * 100 > budgetNs * kXrunIntervalPercent) {
+        m_xruns.store(m_xruns.load(kRelaxed) + 1, kRelaxed);
+    }
+    m_activeVoices.store(activeVoices, kRelaxed);
+    m_streamedVoices.store(streamedVoices, kRelaxed);
+}
+
+void EngineStats::recordMicCleanup(qint64 suppressionNs, qint64 gateNs)
+{
+    m_micSuppressionNs.store(m_micSuppressionNs.load(kRelaxed) + suppressionNs, kRelaxed);
+    m_micGateNs.store(m_micGateNs.load(kRelaxed) + gateNs, kRelaxed);
+}
+
+void EngineStats::recordTrigger(bool isResident)
+{
+    std::atomic<quint64>& counter = isResident ? m_cacheHits : m_cacheMisses;
+    counter.fetch_add(1, kRelaxed);
+}
+
+void EngineStats::requestReset()
+{
+    m_cacheHits.store(0, kRelaxed);
+    m_cacheMisses.store(0, kRelaxed);
+    m_isResetRequested.store(true, kRelaxed);
+}
+
+EngineStats::Snapshot EngineStats::snapshot() const
+{
+    // Поля читаются по отдельности: снимок может оказаться посередине колбэка,
+    // но расхождение в один колбэк для индикатора несущественно
+    Snapshot snapshot;
+    snapshot.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    snapshot.callbacks = m_callbacks.load(kRelaxed);
+    snapshot.frames = m_frames.load(kRelaxed);
+    snapshot.budgetMillis = m_lastBudgetNs.load(kRelaxed) / 1e6;
+    snapshot.maxCallbackMillis = m_maxDurationNs.load(kRelaxed) / 1e6;
+    const qint64 totalDurationNs = m_totalDurationNs.load(kRelaxed);
+    const qint64 totalBudgetNs = m_totalBudgetNs.load(kRelaxed);
+    if (snapshot.callbacks > 0) {
+        snapshot.averageCallbackMillis = totalDurationNs / 1e6 / snapshot.callbacks;
+    }
+    if (totalBudgetNs > 0) {
+        snapshot.averageLoad = static_cast<double>(totalDurationNs) / totalBudgetNs;
+        snapshot.micSuppressionLoad = static_cast<double>(m_micSuppressionNs.load(kRelaxed)) / totalBudgetNs;
+        snapshot.micGateLoad = static_cast<double>(m_micGateNs.load(kRelaxed)) / totalBudgetNs;
+    }
+    snapshot.peakLoad = m_peakLoadPermille.load(kRelaxed) / 1000.0;
+    for (int i = 0; i < kHistogramBuckets; ++i) {
+        snapshot.histogram[i] = m_histogram[i].load(kRelaxed);
+    }
+    snapshot.overBudget = m_overBudget.load(kRelaxed);
+    snapshot.xruns = m_xruns.load(kRelaxed);
+    snapshot.activeVoices = m_activeVoices.load(kRelaxed);
+    snapshot.streamedVoices = m_streamedVoices.load(kRelaxed);
+    snapshot.cacheHits = m_cacheHits.load(kRelaxed);
+    snapshot.cacheMisses = m_cacheMisses.load(kRelaxed);
+    return snapshot;
+}
+
+QByteArray EngineStats::toJson(const Snapshot& current, const QList<Snapshot>& history)
+{
+    QJsonArray historyArray;
+    for (const Snapshot& snapshot : history) {
+        historyArray.append(toJsonObject(snapshot));
+    }
+    QJsonObject root;
+    root["current"] = toJsonObject(current);
+    root["history"] = historyArray;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+QByteArray EngineStats::csvHeader()
+{
+    QByteArray header = "timestamp,callbacks,frames,budget_ms,callback_avg_ms,callback_max_ms,load_avg,load_peak,"
+                        "over_budget,xruns,active_voices,streamed_voices,armed_clips,armed_ready,"
+                        "cache_hits,cache_misses,cache_hit_rate,resident_bytes,budget_bytes,stream_hits,stream_misses,"
+                        "mic_denoise_load,mic_gate_load";
+    for (int i = 0; i < kHistogramBuckets; ++i) {
+        header += ",load_bucket_" + QByteArray::number(i);
+    }
+    return header + '\n';
+}
+
+QByteArray EngineStats::toCsvRow(const Snapshot& snapshot)
+{
+    QByteArray row = QDateTime::fromMSecsSinceEpoch(snapshot.timestampMs, Qt::UTC).toString(Qt::ISODateWithMs).toUtf8();
+    row += ',' + QByteArray::number(snapshot.callbacks);
+    row += ',' + QByteArray::number(snapshot.frames);
+    row += ',' + QByteArray::number(snapshot.budgetMillis, 'f', 3);
+    row += ',' + QByteArray::number(snapshot.averageCallbackMillis, 'f', 3);
+    row += ',' + QByteArray::number(snapshot.maxCallbackMillis, 'f', 3);
+    row += ',' + QByteArray::number(snapshot.averageLoad, 'f', 3);
+    row += ',' + QByteArray::number(snapshot.peakLoad, 'f', 3);
+    row += ',' + QByteArray::number(snapshot.overBudget);
+    row += ',' + QByteArray::number(snapshot.xruns);
+    row += ',' + QByteArray::number(snapshot.activeVoices);
+    row += ',' + QByteArray::number(snapshot.streamedVoices);
+    row += ',' + QByteArray::number(snapshot.armedClips);
+    row += ',' + QByteArray::number(snapshot.armedReady);
+    row += ',' + QByteArray::number(snapshot.cacheHits);
+    row += ',' + QByteArray::number(snapshot.cacheMisses);
+    row += ',' + QByteArray::number(snapshot.cacheHitRate(), 'f', 3);
+    row += ',' + QByteArray::number(snapshot.residentBytes);
+    row += ',' + QByteArray::number(snapshot.budgetBytes);
+    row += ',' + QByteArray::number(snapshot.streamHits);
+    row += ',' + QByteArray::number(snapshot.streamMisses);
+    row += ',' + QByteArray::number(snapshot.micSuppressionLoad, 'f', 4);
+    row += ',' + QByteArray::number(snapshot.micGateLoad, 'f', 4);
+    for (quint64 count : snapshot.histogram) {
+        row += ',' + QByteArray::number(count);
+    }
+    return row + '\n';
+}
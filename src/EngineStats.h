@@ -0,0 +1,103 @@
+// src/EngineStats.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+
+// Телеметрия движка. Колбэк пишет счетчики без блокировок и выделений памяти (один писатель,
+// relaxed-атомики), главный поток в любой момент снимает копию. Снимок можно сохранить
+// в JSON или CSV, чтобы сопоставить щелчки в эфире с нагрузкой.
+class EngineStats
+{
+public:
+    // Гистограмма длительности колбэка в долях бюджета (периода): десять корзин по 10%,
+    // затем 100-150% и больше 150%. Все, что выше 100%, — колбэк не уложился в период.
+    static constexpr int kHistogramBuckets = 12;
+
+    struct Snapshot {
+        qint64 timestampMs = 0;        // Время снимка, мс от эпохи UTC
+        quint64 callbacks = 0;
+        quint64 frames = 0;
+        double budgetMillis = 0.0;     // Период последнего колбэка
+        double averageCallbackMillis = 0.0;
+        double maxCallbackMillis = 0.0;
+        double averageLoad = 0.0;      // Суммарное время колбэков / суммарный бюджет
+        double peakLoad = 0.0;
+        quint64 histogram[kHistogramBuckets] = {};
+        quint64 overBudget = 0;        // Колбэк дольше периода
+        quint64 xruns = 0;             // Интервал между колбэками больше полутора периодов: выход недополучил данные
+        int activeVoices = 0;
+        int streamedVoices = 0;        // Играют с диска, а не из SampleStore
+        int armedClips = 0;            // Клипы активного банка
+        int armedReady = 0;            // Из них уже загружены в память
+        quint64 cacheHits = 0;         // Запуски из SampleStore
+        quint64 cacheMisses = 0;       // Запуски с открытием файла
+        quint64 residentBytes = 0;
+        quint64 budgetBytes = 0;
+        quint64 streamHits = 0;        // Чтения потоковых голосов из упреждающего буфера
+        quint64 streamMisses = 0;      // Блок не успел: голос колбэка молчал период
+        double micSuppressionLoad = 0.0; // Шумоподавление микрофона, доля суммарного бюджета
+        double micGateLoad = 0.0;        // Гейт микрофона, доля суммарного бюджета
+
+        double cacheHitRate() const;
+    };
+
+    EngineStats();
+
+    // Аудиопоток: один вызов на колбэк. intervalNs — от прошлого колбэка, 0 — первый после запуска
+    void recordCallback(qint64 durationNs, qint64 intervalNs, quint32 frameCount, quint32 sampleRate,
+                        int activeVoices, int streamedVoices);
+    // Аудиопоток: время очистки микрофона в этом колбэке, до recordCallback()
+    void recordMicCleanup(qint64 suppressionNs, qint64 gateNs);
+    // Главный поток: источник нового голоса
+    void recordTrigger(bool isResident);
+    // Счетчики колбэка обнуляет сам аудиопоток в следующем вызове, чтобы не было второго писателя
+    void requestReset();
+
+    // Поля SampleStore (armed*, *Bytes) и stream* заполняет AudioEngine::statsSnapshot()
+    Snapshot snapshot() const;
+
+    static QByteArray toJson(const Snapshot& current, const QList<Snapshot>& history);
+    static QByteArray csvHeader();
+    static QByteArray toCsvRow(const Snapshot& snapshot);
+
+private:
+    std::atomic<bool> m_isResetRequested;
+    std::atomic<quint64> m_callbacks;
+    std::atomic<quint64> m_frames;
+    std::atomic<qint64> m_totalDurationNs;
+    std::atomic<qint64> m_totalBudgetNs;
+    std::atomic<qint64> m_maxDurationNs;
+    std::atomic<qint64> m_lastBudgetNs;
+    std::atomic<quint32> m_peakLoadPermille;
+    std::atomic<quint64> m_histogram[kHistogramBuckets];
+    std::atomic<quint64> m_overBudget;
+    std::atomic<quint64> m_xruns;
+    std::atomic<qint64> m_micSuppressionNs;
+    std::atomic<qint64> m_micGateNs;
+    std::atomic<int> m_activeVoices;
+    std::atomic<int> m_streamedVoices;
+    std::atomic<quint64> m_cacheHits;
+    std::atomic<quint64> m_cacheMisses;
+};
@@ -0,0 +1,402 @@
+// src/FlacEncoder.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "FlacEncoder.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+constexpr int kMaxFixedOrder = 4;
+constexpr int kMaxPartitionOrder = 8;
+constexpr uint32_t kMaxRiceParameter = 30; // RICE2: 5 бит параметра, 31 — признак сырых данных
+
+uint8_t crc8(const uint8_t* pData, size_t size)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= pData[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t crc16(const uint8_t* pData, size_t size)
+{
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(pData[i]) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Остаток фиксированного предсказателя порядка order для отсчета i (i >= order)
+inline int64_t fixedResidual(const int32_t* s, uint32_t i, int order)
+{
+    switch (order) {
+    case 0: return s[i];
+    case 1: return static_cast<int64_t>(s[i]) - s[i - 1];
+    case 2: return static_cast<int64_t>(s[i]) - 2LL * s[i - 1] + s[i - 2];
+    case 3: return static_cast<int64_t>(s[i]) - 3LL * s[i - 1] + 3LL * s[i - 2] - s[i - 3];
+    default: return static_cast<int64_t>(s[i]) - 4LL * s[i - 1] + 6LL * s[i - 2] - 4LL * s[i - 3] + s[i - 4];
+    }
+}
+
+inline uint32_t zigzag(int64_t value)
+{
+    return static_cast<uint32_t>((value << 1) ^ (value >> 63));
+}
+
+// Параметр Райса с наименьшей длиной для части с суммой zigzag-значений sum
+uint32_t riceParameter(uint64_t sum, uint32_t count, uint64_t* pBits)
+{
+    uint32_t best = 0;
+    uint64_t bestBits = UINT64_MAX;
+    for (uint32_t k = 0; k <= kMaxRiceParameter; ++k) {
+        const uint64_t bits = static_cast<uint64_t>(count) * (k + 1) + (sum >> k);
+        if (bits < bestBits) {
+            bestBits = bits;
+            best = k;
+        }
+        if ((sum >> k) == 0) {
+            break;
+        }
+    }
+    *pBits = bestBits;
+    return best;
+}
+
+// Лучшее разбиение остатка на 2^order частей; pParameters получает параметр каждой части
+uint64_t bestPartitioning(const uint32_t* pValues, uint32_t blockFrames, int predictorOrder, int* pPartitionOrder,
+                          uint32_t* pParameters)
+{
+    uint64_t bestBits = UINT64_MAX;
+    uint32_t parameters[1 << kMaxPartitionOrder];
+    for (int order = 0; order <= kMaxPartitionOrder; ++order) {
+        const uint32_t partitions = 1u << order;
+        if (blockFrames % partitions != 0 || blockFrames / partitions <= static_cast<uint32_t>(predictorOrder)) {
+            break;
+        }
+        const uint32_t partitionFrames = blockFrames / partitions;
+        uint64_t bits = 0;
+        for (uint32_t partition = 0; partition < partitions; ++partition) {
+            const uint32_t begin = partition == 0 ? static_cast<uint32_t>(predictorOrder) : partition * partitionFrames;
+            const uint32_t end = (partition + 1) * partitionFrames;
+            uint64_t sum = 0;
+            for (uint32_t i = begin; i < end; ++i) {
+                sum += pValues[i];
+            }
+            uint64_t partitionBits = 0;
+            parameters[partition] = riceParameter(sum, end - begin, &partitionBits);
+            bits += 5 + partitionBits;
+        }
+        if (bits < bestBits) {
+            bestBits = bits;
+            *pPartitionOrder = order;
+            std::copy(parameters, parameters + partitions, pParameters);
+        }
+    }
+    return bestBits;
+}
+
+} // namespace
+
+class FlacEncoder::BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>* pOutput)
+        : m_pOutput(pOutput)
+    {
+    }
+
+    void write(uint64_t value, uint32_t bits)
+    {
+        while (bits > 0) {
+            const uint32_t take = std::min<uint32_t>(bits, 32);
+            bits -= take;
+            const uint64_t chunk = (value >> bits) & ((1ULL << take) - 1);
+            m_accumulator = (m_accumulator << take) | chunk;
+            m_count += take;
+            while (m_count >= 8) {
+                m_count -= 8;
+                m_pOutput->push_back(static_cast<uint8_t>(m_accumulator >> m_count));
+            }
+        }
+    }
+
+    void writeSigned(int64_t value, uint32_t bits)
+    {
+        write(static_cast<uint64_t>(value) & ((1ULL << bits) - 1), bits);
+    }
+
+    void writeRice(uint32_t value, uint32_t parameter)
+    {
+        uint32_t quotient = value >> parameter;
+        while (quotient >= 32) {
+            write(0, 32);
+            quotient -= 32;
+        }
+        write(1, quotient + 1); // quotient нулей и единица
+        write(value, parameter);
+    }
+
+    void alignToByte()
+    {
+        if (m_count > 0) {
+            write(0, 8 - m_count);
+        }
+    }
+
+private:
+    std::vector<uint8_t>* m_pOutput;
+    uint64_t m_accumulator = 0;
+    uint32_t m_count = 0;
+};
+
+FlacEncoder::FlacEncoder(uint32_t channels, uint32_t sampleRate)
+    : m_channels(std::clamp<uint32_t>(channels, 1, 8))
+    , m_sampleRate(sampleRate)
+{
+    m_pending.resize(static_cast<size_t>(kBlockFrames) * m_channels);
+    m_residual.resize(kBlockFrames);
+    m_side[0].resize(kBlockFrames);
+    m_side[1].resize(kBlockFrames);
+}
+
+std::vector<uint8_t> FlacEncoder::header() const
+{
+    std::vector<uint8_t> bytes = {'f', 'L', 'a', 'C'};
+    BitWriter writer(&bytes);
+    writer.write(1, 1);  // Последний блок метаданных
+    writer.write(0, 7);  // STREAMINFO
+    writer.write(34, 24);
+    writer.write(kBlockFrames, 16); // Последний блок файла может быть короче — по спецификации это допустимо
+    writer.write(kBlockFrames, 16);
+    writer.write(m_minFrameBytes, 24);
+    writer.write(m_maxFrameBytes, 24);
+    writer.write(m_sampleRate, 20);
+    writer.write(m_channels - 1, 3);
+    writer.write(kBitsPerSample - 1, 5);
+    writer.write(m_totalFrames, 36);
+    for (int i = 0; i < 16; ++i) {
+        writer.write(0, 8); // MD5 неизвестна
+    }
+    return bytes;
+}
+
+void FlacEncoder::write(const int16_t* pFrames, size_t frameCount, std::vector<uint8_t>* pOutput)
+{
+    while (frameCount > 0) {
+        const uint32_t take = static_cast<uint32_t>(std::min<size_t>(frameCount, kBlockFrames - m_pendingFrames));
+        for (uint32_t channel = 0; channel < m_channels; ++channel) {
+            int32_t* pChannel = m_pending.data() + static_cast<size_t>(channel) * kBlockFrames + m_pendingFrames;
+            for (uint32_t i = 0; i < take; ++i) {
+                pChannel[i] = pFrames[static_cast<size_t>(i) * m_channels + channel];
+            }
+        }
+        pFrames += static_cast<size_t>(take) * m_channels;
+        frameCount -= take;
+        m_pendingFrames += take;
+        if (m_pendingFrames == kBlockFrames) {
+            encodeBlock(kBlockFrames, pOutput);
+            m_pendingFrames = 0;
+        }
+    }
+}
+
+void FlacEncoder::finish(std::vector<uint8_t>* pOutput)
+{
+    if (m_pendingFrames > 0) {
+        // Каналы лежат с шагом kBlockFrames: короткий блок кодируется из тех же мест
+        encodeBlock(m_pendingFrames, pOutput);
+        m_pendingFrames = 0;
+    }
+}
+
+void FlacEncoder::encodeBlock(uint32_t blockFrames, std::vector<uint8_t>* pOutput)
+{
+    const size_t frameStart = pOutput->size();
+    const int32_t* pChannels[8];
+    for (uint32_t channel = 0; channel < m_channels; ++channel) {
+        pChannels[channel] = m_pending.data() + static_cast<size_t>(channel) * kBlockFrames;
+    }
+
+    // Стерео: кодируем ту пару из левого, правого, середины и разности, что короче
+    uint32_t assignment = m_channels - 1; // Независимые каналы
+    const int32_t* pSubframes[8] = {};
+    uint32_t subframeBits[8] = {};
+    for (uint32_t channel = 0; channel < m_channels; ++channel) {
+        pSubframes[channel] = pChannels[channel];
+        subframeBits[channel] = kBitsPerSample;
+    }
+    if (m_channels == 2) {
+        int32_t* pMid = m_side[0].data();
+        int32_t* pSide = m_side[1].data();
+        for (uint32_t i = 0; i < blockFrames; ++i) {
+            const int32_t left = pChannels[0][i];
+            const int32_t right = pChannels[1][i];
+            pMid[i] = (left + right) >> 1;
+            pSide[i] = left - right;
+        }
+        int order = 0;
+        const uint64_t leftBits = estimateSubframeBits(pChannels[0], blockFrames, kBitsPerSample, &order);
+        const uint64_t rightBits = estimateSubframeBits(pChannels[1], blockFrames, kBitsPerSample, &order);
+        const uint64_t midBits = estimateSubframeBits(pMid, blockFrames, kBitsPerSample, &order);
+        const uint64_t sideBits = estimateSubframeBits(pSide, blockFrames, kBitsPerSample + 1, &order);
+        const uint64_t options[4] = {leftBits + rightBits, leftBits + sideBits, sideBits + rightBits, midBits + sideBits};
+        const int best = static_cast<int>(std::min_element(options, options + 4) - options);
+        switch (best) {
+        case 1: // Левый + разность
+            assignment = 8;
+            pSubframes[1] = pSide;
+            subframeBits[1] = kBitsPerSample + 1;
+            break;
+        case 2: // Разность + правый
+            assignment = 9;
+            pSubframes[0] = pSide;
+            subframeBits[0] = kBitsPerSample + 1;
+            break;
+        case 3: // Середина + разность
+            assignment = 10;
+            pSubframes[0] = pMid;
+            pSubframes[1] = pSide;
+            subframeBits[1] = kBitsPerSample + 1;
+            break;
+        default:
+            break;
+        }
+    }
+
+    BitWriter writer(pOutput);
+    writer.write(0x3FFE, 14); // Синхрослово
+    writer.write(0, 1);
+    writer.write(0, 1);       // Фиксированный размер блока: в заголовке номер кадра
+    writer.write(7, 4);       // Размер блока - 1 — 16 бит после номера кадра
+    writer.write(m_sampleRate == 48000 ? 10 : m_sampleRate == 44100 ? 9 : 0, 4); // 0 — из STREAMINFO
+    writer.write(assignment, 4);
+    writer.write(4, 3);       // 16 бит
+    writer.write(0, 1);
+
+    // Номер кадра в «UTF-8» на 36 бит
+    const uint64_t number = m_frameNumber;
+    if (number < 0x80) {
+        writer.write(number, 8);
+    } else {
+        int extraBytes = 1;
+        while (extraBytes < 6 && number >= (1ULL << (5 * extraBytes + 6))) {
+            ++extraBytes;
+        }
+        const uint32_t leadBits = 6 - extraBytes; // Значащих бит в первом байте
+        writer.write(((0xFF00u >> (extraBytes + 1)) & 0xFF) | ((number >> (6 * extraBytes)) & ((1u << leadBits) - 1)), 8);
+        for (int i = extraBytes - 1; i >= 0; --i) {
+            writer.write(0x80 | ((number >> (6 * i)) & 0x3F), 8);
+        }
+    }
+    writer.write(blockFrames - 1, 16);
+    pOutput->push_back(crc8(pOutput->data() + frameStart, pOutput->size() - frameStart));
+
+    for (uint32_t channel = 0; channel < m_channels; ++channel) {
+        encodeSubframe(&writer, pSubframes[channel], blockFrames, subframeBits[channel]);
+    }
+    writer.alignToByte();
+    const uint16_t crc = crc16(pOutput->data() + frameStart, pOutput->size() - frameStart);
+    pOutput->push_back(static_cast<uint8_t>(crc >> 8));
+    pOutput->push_back(static_cast<uint8_t>(crc & 0xFF));
+
+    const uint32_t frameBytes = static_cast<uint32_t>(pOutput->size() - frameStart);
+    m_minFrameBytes = m_minFrameBytes == 0 ? frameBytes : std::min(m_minFrameBytes, frameBytes);
+    m_maxFrameBytes = std::max(m_maxFrameBytes, frameBytes);
+    m_totalFrames += blockFrames;
+    ++m_frameNumber;
+}
+
+uint64_t FlacEncoder::estimateSubframeBits(const int32_t* pSamples, uint32_t count, uint32_t bitsPerSample, int* pOrder)
+{
+    // Оценка без разбиения: один параметр Райса на весь остаток. Для выбора порядка
+    // и раскладки стерео этого хватает, точное разбиение считается уже при кодировании
+    uint64_t bestBits = static_cast<uint64_t>(count) * bitsPerSample;
+    *pOrder = -1; // Без сжатия
+    for (int order = 0; order <= std::min<int>(kMaxFixedOrder, static_cast<int>(count) - 1); ++order) {
+        uint64_t sum = 0;
+        for (uint32_t i = static_cast<uint32_t>(order); i < count; ++i) {
+            sum += zigzag(fixedResidual(pSamples, i, order));
+        }
+        uint64_t riceBits = 0;
+        riceParameter(sum, count - order, &riceBits);
+        const uint64_t bits = static_cast<uint64_t>(order) * bitsPerSample + 6 + 5 + riceBits;
+        if (bits < bestBits) {
+            bestBits = bits;
+            *pOrder = order;
+        }
+    }
+    return bestBits;
+}
+
+void FlacEncoder::encodeSubframe(BitWriter* pWriter, const int32_t* pSamples, uint32_t count, uint32_t bitsPerSample)
+{
+    // Тишина и постоянный сигнал — один отсчет на канал
+    if (std::all_of(pSamples + 1, pSamples + count, [pSamples](int32_t sample) { return sample == pSamples[0]; })) {
+        pWriter->write(0, 8); // CONSTANT
+        pWriter->writeSigned(pSamples[0], bitsPerSample);
+        return;
+    }
+
+    int order = -1;
+    estimateSubframeBits(pSamples, count, bitsPerSample, &order);
+    if (order < 0) {
+        pWriter->write(1 << 1, 8); // VERBATIM
+        for (uint32_t i = 0; i < count; ++i) {
+            pWriter->writeSigned(pSamples[i], bitsPerSample);
+        }
+        return;
+    }
+
+    uint32_t* pValues = reinterpret_cast<uint32_t*>(m_residual.data());
+    for (uint32_t i = static_cast<uint32_t>(order); i < count; ++i) {
+        pValues[i] = zigzag(fixedResidual(pSamples, i, order));
+    }
+    int partitionOrder = 0;
+    uint32_t parameters[1 << kMaxPartitionOrder];
+    bestPartitioning(pValues, count, order, &partitionOrder, parameters);
+    const uint32_t partitions = 1u << partitionOrder;
+    const bool isRice2 = std::any_of(parameters, parameters + partitions, [](uint32_t k) { return k > 14; });
+
+    pWriter->write((0x08 | order) << 1, 8); // FIXED порядка order
+    for (int i = 0; i < order; ++i) {
+        pWriter->writeSigned(pSamples[i], bitsPerSample);
+    }
+    pWriter->write(isRice2 ? 1 : 0, 2);
+    pWriter->write(static_cast<uint32_t>(partitionOrder), 4);
+    const uint32_t partitionFrames = count >> partitionOrder;
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        const uint32_t begin = partition == 0 ? static_cast<uint32_t>(order) : partition * partitionFrames;
+        const uint32_t end = (partition + 1) * partitionFrames;
+        pWriter->write(parameters[partition], isRice2 ? 5 : 4);
+        for (uint32_t i = begin; i < end; ++i) {
+            pWriter->writeRice(pValues[i], parameters[partition]);
+        }
+    }
+}
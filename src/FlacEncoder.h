@@ -0,0 +1,69 @@
+// src/FlacEncoder.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Кодер FLAC без сторонних библиотек для записи выхода: 16 бит, блоки по kBlockFrames
+// кадров, фиксированные предсказатели порядка 0-4 и код Райса с разбиением на части.
+// Стерео дополнительно пробует левый/правый/середина + разность и берет самый короткий
+// вариант. Сжимает хуже эталонного libFLAC с LPC, зато быстрее реального времени
+// в десятки раз и без выделений памяти после первого блока.
+//
+// Кодер не пишет файл сам: write() и finish() дописывают готовые кадры в буфер, а заголовок
+// (header(), всегда kHeaderBytes) владелец пишет в начало файла до кадров и переписывает
+// после finish(), когда известны длина и размеры кадров. MD5 не считается (нули — «неизвестно»).
+class FlacEncoder
+{
+public:
+    static constexpr uint32_t kBlockFrames = 4096;
+    static constexpr uint32_t kBitsPerSample = 16;
+    static constexpr size_t kHeaderBytes = 42; // "fLaC" + заголовок блока + STREAMINFO
+
+    FlacEncoder(uint32_t channels, uint32_t sampleRate);
+
+    std::vector<uint8_t> header() const;
+    // Кадры с чередованием каналов; неполный блок ждет следующего вызова или finish()
+    void write(const int16_t* pFrames, size_t frameCount, std::vector<uint8_t>* pOutput);
+    void finish(std::vector<uint8_t>* pOutput);
+    uint64_t totalFrames() const { return m_totalFrames; }
+
+private:
+    class BitWriter;
+
+    void encodeBlock(uint32_t blockFrames, std::vector<uint8_t>* pOutput);
+    void encodeSubframe(BitWriter* pWriter, const int32_t* pSamples, uint32_t count, uint32_t bitsPerSample);
+    static uint64_t estimateSubframeBits(const int32_t* pSamples, uint32_t count, uint32_t bitsPerSample, int* pOrder);
+
+    uint32_t m_channels;
+    uint32_t m_sampleRate;
+    std::vector<int32_t> m_pending;  // Накопленный блок, по каналам подряд
+    uint32_t m_pendingFrames = 0;
+    std::vector<int32_t> m_residual; // Рабочие буферы кадра
+    std::vector<int32_t> m_side[2];  // Середина и разность стерео
+    uint64_t m_totalFrames = 0;
+    uint64_t m_frameNumber = 0;
+    uint32_t m_minFrameBytes = 0;
+    uint32_t m_maxFrameBytes = 0;
+};
@@ -1,5 +1,5 @@
 #include "GlobalHotkeyManager.h"
-#include <QDebug>
+#include "Log.h"
 #include <QApplication>
 
 #ifdef Q_OS_WIN
@@ -66,24 +66,47 @@ bool GlobalHotkeyManager::registerHotkey(const QKeySequence& sequence, int track
     Qt::KeyboardModifiers modifiers = combo.keyboardModifiers();
     Qt::Key key = combo.key();
 
+    if (!registerNativeHotkey(key, modifiers, {trackRow, Qt::NoModifier})) {
+        OSD_LOG_WARNING(Ui, "Failed to register hotkey key=%s", qUtf8Printable(sequence.toString()));
+        return false;
+    }
+    m_registeredHotkeys.insert(sequence, trackRow);
+    OSD_LOG_DEBUG(Ui, "Registered hotkey key=%s", qUtf8Printable(sequence.toString()));
+
+    // Варианты с модификаторами не критичны: сочетание может быть занято другим приложением
+    for (Qt::KeyboardModifier variant : {Qt::ShiftModifier, Qt::ControlModifier, Qt::AltModifier}) {
+        if (m_modifierVariants.testFlag(variant) && !modifiers.testFlag(variant)) {
+            if (!registerNativeHotkey(key, modifiers | variant, {trackRow, variant})) {
+                OSD_LOG_WARNING(Ui, "Failed to register modifier variant for hotkey key=%s",
+                                qUtf8Printable(sequence.toString()));
+            }
+        }
+    }
+    return true;
+}
+
+void GlobalHotkeyManager::setModifierVariants(Qt::KeyboardModifiers modifiers)
+{
+    m_modifierVariants = modifiers & (Qt::ShiftModifier | Qt::ControlModifier | Qt::AltModifier);
+}
+
+bool GlobalHotkeyManager::registerNativeHotkey(Qt::Key key, Qt::KeyboardModifiers modifiers, const HotkeyBinding& binding)
+{
 #ifdef Q_OS_WIN
     quint32 nativeMod = nativeModifiers(modifiers);
     quint32 nativeK = nativeKey(key);
     int hotkeyId = m_nextNativeId++;
 
-    if (RegisterHotKey(NULL, hotkeyId, nativeMod, nativeK)) {
-        qDebug() << "Registered hotkey ID" << hotkeyId;
-        m_nativeKeyToRow.insert(hotkeyId, trackRow);
-        m_registeredHotkeys.insert(sequence, trackRow);
-        return true;
-    } else {
-        qWarning() << "Failed to register hotkey:" << sequence.toString();
+    if (!RegisterHotKey(NULL, hotkeyId, nativeMod, nativeK)) {
         return false;
     }
+    OSD_LOG_DEBUG(Ui, "Registered hotkey id=%d", hotkeyId);
+    m_nativeKeyToRow.insert(hotkeyId, binding);
+    return true;
 #elif defined(Q_OS_LINUX)
     QNativeInterface::QX11Application* x11App = qApp->nativeInterface<QNativeInterface::QX11Application>();
     if (!x11App) {
-        qWarning() << "Cannot register global hotkey: not running on X11.";
+        OSD_LOG_WARNING(Ui, "Cannot register global hotkey: not running on X11");
         return false;
     }
     Display* display = x11App->display();
@@ -101,11 +124,14 @@ bool GlobalHotkeyManager::registerHotkey(const QKeySequence& sequence, int track
     XGrabKey(display, keycode, modifiersX11 | Mod2Mask | LockMask, DefaultRootWindow(display), True, GrabModeAsync, GrabModeAsync);
 
     X11Hotkey hotkey = {keycode, modifiersX11};
-    m_nativeKeyToRow.insert(hotkey, trackRow);
-    m_registeredHotkeys.insert(sequence, trackRow);
-    qDebug() << "Registered hotkey:" << sequence.toString();
+    m_nativeKeyToRow.insert(hotkey, binding);
     return true;
 #elif defined(Q_OS_MACOS)
+    // Варианты с модификаторами на macOS пока не поддерживаются
+    if (binding.extraModifiers != Qt::NoModifier) {
+        return false;
+    }
+
     EventHotKeyRef hotKeyRef;
     EventTypeSpec eventType;
     eventType.eventClass = kEventClassKeyboard;
@@ -127,13 +153,15 @@ bool GlobalHotkeyManager::registerHotkey(const QKeySequence& sequence, int track
 
     OSStatus err = RegisterEventHotKey(keyId, keyModifiers, hotKeyID, GetApplicationEventTarget(), 0, &hotKeyRef);
     if (err == noErr) {
-        m_nativeKeyToRow.insert(hotKeyRef, trackRow);
-        m_registeredHotkeys.insert(sequence, trackRow);
+        m_nativeKeyToRow.insert(hotKeyRef, binding.trackRow);
         return true;
     }
     return false;
 #else
-    qWarning() << "Global hotkeys not supported on this platform.";
+    Q_UNUSED(key);
+    Q_UNUSED(modifiers);
+    Q_UNUSED(binding);
+    OSD_LOG_WARNING(Ui, "Global hotkeys not supported on this platform");
     return false;
 #endif
 }
@@ -143,11 +171,15 @@ void GlobalHotkeyManager::unregisterHotkey(int trackRow)
     QKeySequence sequence = m_registeredHotkeys.key(trackRow);
     if (sequence.isEmpty()) return;
 
+    // Снимаем основной хоткей вместе со всеми вариантами для этой строки
 #ifdef Q_OS_WIN
-    int hotkeyId = m_nativeKeyToRow.key(trackRow);
-    if (hotkeyId != 0) {
-        UnregisterHotKey(NULL, hotkeyId);
-        m_nativeKeyToRow.remove(hotkeyId);
+    for (auto it = m_nativeKeyToRow.begin(); it != m_nativeKeyToRow.end();) {
+        if (it.value().trackRow == trackRow) {
+            UnregisterHotKey(NULL, it.key());
+            it = m_nativeKeyToRow.erase(it);
+        } else {
+            ++it;
+        }
     }
 #elif defined(Q_OS_LINUX)
     QNativeInterface::QX11Application* x11App = qApp->nativeInterface<QNativeInterface::QX11Application>();
@@ -158,20 +190,18 @@ void GlobalHotkeyManager::unregisterHotkey(int trackRow)
     Display* display = x11App->display();
     if (!display) return;
 
-    // --- ИСПРАВЛЕНИЕ для Qt6 ---
-    QKeyCombination combo = sequence[0];
-    Qt::KeyboardModifiers modifiers = combo.keyboardModifiers();
-    Qt::Key key = combo.key();
-    uint keycode = XKeysymToKeycode(display, key);
-    uint modifiersX11 = nativeModifiersX11(modifiers);
-
-    XUngrabKey(display, keycode, modifiersX11, DefaultRootWindow(display));
-    XUngrabKey(display, keycode, modifiersX11 | Mod2Mask, DefaultRootWindow(display));
-    XUngrabKey(display, keycode, modifiersX11 | LockMask, DefaultRootWindow(display));
-    XUngrabKey(display, keycode, modifiersX11 | Mod2Mask | LockMask, DefaultRootWindow(display));
-
-    X11Hotkey hotkey = {keycode, modifiersX11};
-    m_nativeKeyToRow.remove(hotkey);
+    for (auto it = m_nativeKeyToRow.begin(); it != m_nativeKeyToRow.end();) {
+        if (it.value().trackRow != trackRow) {
+            ++it;
+            continue;
+        }
+        const X11Hotkey& hotkey = it.key();
+        XUngrabKey(display, hotkey.keycode, hotkey.modifiers, DefaultRootWindow(display));
+        XUngrabKey(display, hotkey.keycode, hotkey.modifiers | Mod2Mask, DefaultRootWindow(display));
+        XUngrabKey(display, hotkey.keycode, hotkey.modifiers | LockMask, DefaultRootWindow(display));
+        XUngrabKey(display, hotkey.keycode, hotkey.modifiers | Mod2Mask | LockMask, DefaultRootWindow(display));
+        it = m_nativeKeyToRow.erase(it);
+    }
 #elif defined(Q_OS_MACOS)
     void* hotKeyRef = m_nativeKeyToRow.key(trackRow);
     if (hotKeyRef) {
@@ -197,7 +227,8 @@ bool GlobalHotkeyManager::nativeEventFilter(const QByteArray &eventType, void *m
         if (msg->message == WM_HOTKEY) {
             int hotkeyId = msg->wParam;
             if (m_nativeKeyToRow.contains(hotkeyId)) {
-                emit hotkeyActivated(m_nativeKeyToRow.value(hotkeyId));
+                const HotkeyBinding binding = m_nativeKeyToRow.value(hotkeyId);
+                emit hotkeyActivated(binding.trackRow, binding.extraModifiers);
                 return true;
             }
         }
@@ -209,7 +240,8 @@ bool GlobalHotkeyManager::nativeEventFilter(const QByteArray &eventType, void *m
             xcb_key_press_event_t* keyEvent = (xcb_key_press_event_t*)event;
             X11Hotkey hotkey = {keyEvent->detail, keyEvent->state & ~Mod2Mask & ~LockMask};
             if (m_nativeKeyToRow.contains(hotkey)) {
-                emit hotkeyActivated(m_nativeKeyToRow.value(hotkey));
+                const HotkeyBinding binding = m_nativeKeyToRow.value(hotkey);
+                emit hotkeyActivated(binding.trackRow, binding.extraModifiers);
                 return true;
             }
         }
@@ -230,7 +262,7 @@ OSStatus HotKeyHandler(EventHandlerCallRef nextHandler, EventRef theEvent, void
     // Здесь нужно найти соответствующий hotKeyRef по hotKeyID.id
     // Это упрощение, в реальном коде потребуется более сложный маппинг.
     // Пока что будем считать, что мы можем найти trackRow.
-    // emit manager->hotkeyActivated(trackRow);
+    // emit manager->hotkeyActivated(trackRow, Qt::NoModifier);
 
     return CallNextEventHandler(nextHandler, theEvent);
 }
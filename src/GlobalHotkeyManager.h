@@ -31,24 +31,38 @@ public:
     void unregisterHotkey(int trackRow);
     void unregisterAll();
 
+    // Дополнительные модификаторы (Shift, Ctrl, Alt), с которыми хоткей тоже срабатывает.
+    // Каждый бит регистрирует отдельный вариант; действует для последующих registerHotkey().
+    void setModifierVariants(Qt::KeyboardModifiers modifiers);
+    Qt::KeyboardModifiers modifierVariants() const { return m_modifierVariants; }
+
 signals:
-    void hotkeyActivated(int trackRow);
+    // extraModifiers — модификатор варианта сверх назначенного сочетания (или NoModifier)
+    void hotkeyActivated(int trackRow, Qt::KeyboardModifiers extraModifiers);
 
 protected:
     // Эта функция будет перехватывать системные события
     bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *result) override;
 
 private:
+    struct HotkeyBinding {
+        int trackRow;
+        Qt::KeyboardModifiers extraModifiers;
+    };
+
+    bool registerNativeHotkey(Qt::Key key, Qt::KeyboardModifiers modifiers, const HotkeyBinding& binding);
+
     // Хранит соответствие между хоткеем и строкой трека
     QHash<QKeySequence, int> m_registeredHotkeys;
+    Qt::KeyboardModifiers m_modifierVariants = Qt::NoModifier;
 
     // Платформо-зависимые детали
 #ifdef Q_OS_WIN
     // Для Windows мы будем использовать числовые ID для хоткеев
-    QHash<int, int> m_nativeKeyToRow; // <Native ID, Track Row>
+    QHash<int, HotkeyBinding> m_nativeKeyToRow; // <Native ID, Track Row>
     int m_nextNativeId = 1;
 #elif defined(Q_OS_LINUX)
-    QHash<X11Hotkey, int> m_nativeKeyToRow;
+    QHash<X11Hotkey, HotkeyBinding> m_nativeKeyToRow;
 #elif defined(Q_OS_MACOS)
     // Для macOS будем использовать EventHotKeyRef
     QHash<void*, int> m_nativeKeyToRow; // <EventHotKeyRef, Track Row>
@@ -0,0 +1,190 @@
+// src/ImportPipeline.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "ImportPipeline.h"
+#include "Log.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+ImportPipeline::ImportPipeline(QObject* parent)
+    : QObject(parent)
+    , m_isRunning(false)
+    , m_isStopping(false)
+    , m_isCancelled(false)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_pThread = QThread::create([this]() { run(); });
+    m_pThread->start(QThread::LowPriority);
+}
+
+ImportPipeline::~ImportPipeline()
+{
+    m_isCancelled = true;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isStopping = true;
+        m_jobs.clear();
+    }
+    m_wake.wakeAll();
+    m_pool.clear();
+    m_pThread->wait();
+    delete m_pThread;
+}
+
+void ImportPipeline::start(const QStringList& paths, int target)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_jobs.append(Job{paths, target});
+        m_isRunning = true;
+    }
+    m_wake.wakeAll();
+}
+
+void ImportPipeline::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_isRunning) {
+        m_isCancelled = true;
+        m_jobs.clear();
+        m_pool.clear(); // Еще не начатые пробы волны не запускаются
+    }
+}
+
+bool ImportPipeline::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isRunning;
+}
+
+void ImportPipeline::run()
+{
+    int processed = 0;
+    int total = 0;
+    int imported = 0;
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_isStopping && m_jobs.isEmpty() && !m_isRunning) {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_isStopping) {
+                return;
+            }
+            if (m_isCancelled || m_jobs.isEmpty()) {
+                // Очередь кончилась или отменена: итог один на все пути, добавленные по ходу.
+                // Пути, пришедшие уже после отмены, — следующий импорт
+                const bool isCancelled = m_isCancelled.exchange(false);
+                m_isRunning = !m_jobs.isEmpty();
+                locker.unlock();
+                OSD_LOG_INFO(Library, "Import finished imported=%d skipped=%d cancelled=%d", imported,
+                             processed - imported, isCancelled ? 1 : 0);
+                emit finished(imported, processed - imported, isCancelled);
+                processed = 0;
+                total = 0;
+                imported = 0;
+                continue;
+            }
+            job = m_jobs.takeFirst();
+        }
+
+        const QStringList filePaths = enumerate(job.paths);
+        total += static_cast<int>(filePaths.size());
+        emit progress(processed, total);
+
+        for (qsizetype first = 0; first < filePaths.size() && !m_isCancelled; first += kBatchSize) {
+            const QStringList wave = filePaths.mid(first, kBatchSize);
+            QList<Item> items;
+            probeWave(wave, job.target, &items);
+            if (m_isCancelled) {
+                break; // Вставленное раньше остается, эта волна — нет
+            }
+            processed += static_cast<int>(wave.size());
+            imported += static_cast<int>(items.size());
+            if (!items.isEmpty()) {
+                emit batchReady(items);
+            }
+            emit progress(processed, total);
+        }
+    }
+}
+
+QStringList ImportPipeline::enumerate(const QStringList& paths)
+{
+    // Порядок — как в файловом менеджере: файлы по имени внутри каждой перетащенной папки
+    QStringList filePaths;
+    for (const QString& path : paths) {
+        const QFileInfo fileInfo(path);
+        if (fileInfo.isFile()) {
+            filePaths.append(fileInfo.absoluteFilePath());
+            continue;
+        }
+        if (!fileInfo.isDir()) {
+            continue;
+        }
+        QStringList found;
+        QDirIterator it(fileInfo.absoluteFilePath(), QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while (it.hasNext() && !m_isCancelled) {
+            found.append(it.next());
+        }
+        std::sort(found.begin(), found.end(), [](const QString& a, const QString& b) {
+            return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+        });
+        filePaths.append(found);
+    }
+    return filePaths;
+}
+
+void ImportPipeline::probeWave(const QStringList& filePaths, int target, QList<Item>* pItems)
+{
+    // Каждая проба пишет только в свою ячейку: после waitForDone() порядок обхода сохранен
+    QList<Item> results(filePaths.size());
+    for (qsizetype i = 0; i < filePaths.size(); ++i) {
+        Item* pSlot = &results[i];
+        const QString filePath = filePaths[i];
+        m_pool.start([this, pSlot, filePath]() {
+            if (m_isCancelled || !MediaProbe::isSupported(filePath)) {
+                return;
+            }
+            pSlot->info = MediaProbe::probe(filePath);
+            if (pSlot->info.isPlayable) {
+                pSlot->filePath = filePath;
+            }
+        });
+    }
+    m_pool.waitForDone();
+
+    pItems->reserve(results.size());
+    for (Item& result : results) {
+        if (!result.filePath.isEmpty()) {
+            result.target = target;
+            pItems->append(std::move(result));
+        }
+    }
+}
@@ -0,0 +1,90 @@
+// src/ImportPipeline.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "MediaProbe.h"
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+
+class QThread;
+
+// Массовый импорт файлов и папок (перетаскивание, диалог импорта) без работы в главном потоке.
+// Поток-координатор обходит папки рекурсивно, а пул отбирает файлы по заголовку
+// (MediaProbe::isSupportedHeader, расширение не важно) и параллельно читает длительность и теги.
+// Готовые файлы уходят в окно пачками в порядке обхода: окно вставляет пачку целиком,
+// не запуская для каждой строки ни проб, ни пересчета индексов.
+//
+// Сигналы испускаются из потока-координатора; получатель в главном потоке получает их
+// через очередь. start() во время работы дописывает пути в ту же очередь.
+class ImportPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kBatchSize = 256; // Файлов на одну пачку и одну волну проб
+
+    struct Item {
+        QString filePath;
+        int target = 0; // Значение из start(): окно передает туда номер банка
+        MediaProbe::MediaInfo info;
+    };
+
+    explicit ImportPipeline(QObject* parent = nullptr);
+    ~ImportPipeline();
+
+    void start(const QStringList& paths, int target);
+    void cancel(); // Не ждет: текущая волна проб дочитывается, ее результат отбрасывается
+    bool isRunning() const;
+
+signals:
+    void progress(int processed, int total); // total растет, пока идет обход папок
+    void batchReady(const QList<ImportPipeline::Item>& items);
+    void finished(int imported, int skipped, bool isCancelled);
+
+private:
+    struct Job {
+        QStringList paths;
+        int target = 0;
+    };
+
+    void run();
+    QStringList enumerate(const QStringList& paths);
+    void probeWave(const QStringList& filePaths, int target, QList<Item>* pItems);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Job> m_jobs;
+    bool m_isRunning;
+    bool m_isStopping;
+    std::atomic<bool> m_isCancelled;
+
+    QThreadPool m_pool; // Свой пул: пробы тысяч файлов не занимают глобальный пул движка
+    QThread* m_pThread;
+};
+
+Q_DECLARE_METATYPE(ImportPipeline::Item)
@@ -0,0 +1,330 @@
+// src/LibraryWatcher.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LibraryWatcher.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+#include "Log.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+constexpr int kQuietPeriodMs = 250;    // Пачка уходит после такой паузы в событиях
+constexpr int kMaxFlushDelayMs = 1000; // ...но при непрерывном потоке не позже этого
+
+#ifdef Q_OS_LINUX
+// IN_CREATE нужен только для новых папок: файл сообщаем по IN_CLOSE_WRITE, когда он дописан
+constexpr quint32 kWatchMask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                               IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+} // namespace
+
+LibraryWatcher::LibraryWatcher(QObject* parent)
+    : QObject(parent),
+      m_fd(-1),
+      m_notifier(nullptr),
+      m_isOverflowed(false)
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &LibraryWatcher::flush);
+}
+
+LibraryWatcher::~LibraryWatcher()
+{
+    stop();
+}
+
+bool LibraryWatcher::isAvailable()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LibraryWatcher::isAudioFile(const QString& filePath)
+{
+    static const QSet<QString> kSuffixes = {"mp3", "wav", "flac", "ogg"};
+    return kSuffixes.contains(QFileInfo(filePath).suffix().toLower());
+}
+
+bool LibraryWatcher::start(const QString& rootPath)
+{
+    stop();
+    const QString root = QFileInfo(rootPath).canonicalFilePath();
+    if (root.isEmpty() || !QFileInfo(root).isDir()) {
+        OSD_LOG_WARNING(Library, "Library folder does not exist path=\"%s\"", qUtf8Printable(rootPath));
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        OSD_LOG_WARNING(Library, "Failed to initialize inotify error=\"%s\"", strerror(errno));
+        return false;
+    }
+    m_rootPath = root;
+    watchTree(m_rootPath, nullptr);
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &LibraryWatcher::onEventsReady);
+    OSD_LOG_INFO(Library, "Watching library path=\"%s\" folders=%d", qUtf8Printable(m_rootPath),
+                 static_cast<int>(m_directories.size()));
+    return true;
+#else
+    OSD_LOG_WARNING(Library, "Library watching is only available on Linux (inotify)");
+    return false;
+#endif
+}
+
+void LibraryWatcher::stop()
+{
+    m_flushTimer->stop();
+    delete m_notifier;
+    m_notifier = nullptr;
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        close(m_fd); // Снимает все наблюдения разом
+        m_fd = -1;
+    }
+#endif
+    m_rootPath.clear();
+    m_directories.clear();
+    m_pendingMoves.clear();
+    m_added.clear();
+    m_removed.clear();
+    m_renamed.clear();
+    m_renamedBack.clear();
+    m_isOverflowed = false;
+    m_pendingAge.invalidate();
+}
+
+void LibraryWatcher::watchTree(const QString& directoryPath, QStringList* pFoundFiles)
+{
+#ifdef Q_OS_LINUX
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(directoryPath).constData(), kWatchMask);
+    if (wd < 0) {
+        // ENOSPC — исчерпан fs.inotify.max_user_watches
+        OSD_LOG_WARNING(Library, "Cannot watch path=\"%s\" error=\"%s\"", qUtf8Printable(directoryPath), strerror(errno));
+        return;
+    }
+    m_directories.insert(wd, directoryPath);
+
+    // Обходим только эту папку: вложенные обходятся рекурсией, символические ссылки не открываем
+    QDirIterator it(directoryPath, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Hidden);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (it.fileInfo().isDir()) {
+            watchTree(path, pFoundFiles);
+        } else if (pFoundFiles != nullptr && isAudioFile(path)) {
+            pFoundFiles->append(path);
+        }
+    }
+#else
+    Q_UNUSED(directoryPath);
+    Q_UNUSED(pFoundFiles);
+#endif
+}
+
+void LibraryWatcher::forgetTree(const QString& directoryPath)
+{
+#ifdef Q_OS_LINUX
+    const QString prefix = directoryPath + '/';
+    for (auto it = m_directories.begin(); it != m_directories.end();) {
+        if (it.value() == directoryPath || it.value().startsWith(prefix)) {
+            inotify_rm_watch(m_fd, it.key());
+            it = m_directories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#else
+    Q_UNUSED(directoryPath);
+#endif
+}
+
+void LibraryWatcher::onEventsReady()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN: очередь разобрана
+        }
+
+        for (const char* p = buffer; p < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                m_isOverflowed = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_directories.remove(event->wd); // Папка удалена или наблюдение снято
+                continue;
+            }
+            const QString directory = m_directories.value(event->wd);
+            if (directory.isEmpty() || event->len == 0) {
+                continue;
+            }
+
+            const QString path = directory + '/' + QFile::decodeName(event->name);
+            const bool isDirectory = event->mask & IN_ISDIR;
+            if (event->mask & IN_CREATE) {
+                if (isDirectory) {
+                    // Файлы могли появиться в папке раньше, чем мы поставили на нее наблюдение
+                    QStringList files;
+                    watchTree(path, &files);
+                    for (const QString& file : files) {
+                        queueAdded(file);
+                    }
+                }
+            } else if (event->mask & IN_CLOSE_WRITE) {
+                if (isAudioFile(path)) {
+                    queueAdded(path);
+                }
+            } else if (event->mask & IN_DELETE) {
+                queueRemoved(path);
+            } else if (event->mask & IN_MOVED_FROM) {
+                m_pendingMoves.insert(event->cookie, qMakePair(path, isDirectory));
+            } else if (event->mask & IN_MOVED_TO) {
+                const auto move = m_pendingMoves.constFind(event->cookie);
+                if (move != m_pendingMoves.constEnd()) {
+                    queueRenamed(move->first, path, isDirectory);
+                    m_pendingMoves.erase(move);
+                } else if (isDirectory) {
+                    // Папку принесли снаружи библиотеки: обходим только ее
+                    QStringList files;
+                    watchTree(path, &files);
+                    for (const QString& file : files) {
+                        queueAdded(file);
+                    }
+                } else if (isAudioFile(path)) {
+                    queueAdded(path);
+                }
+            }
+        }
+    }
+    scheduleFlush();
+#endif
+}
+
+void LibraryWatcher::queueAdded(const QString& path)
+{
+    m_removed.remove(path);
+    m_added.insert(path);
+}
+
+void LibraryWatcher::queueRemoved(const QString& path)
+{
+    m_added.remove(path);
+    m_removed.insert(path);
+}
+
+void LibraryWatcher::queueRenamed(const QString& fromPath, const QString& toPath, bool isDirectory)
+{
+    if (isDirectory) {
+        // Дескрипторы наблюдения переезжают вместе с папкой, меняются только пути
+        const QString prefix = fromPath + '/';
+        for (auto it = m_directories.begin(); it != m_directories.end(); ++it) {
+            if (it.value() == fromPath) {
+                it.value() = toPath;
+            } else if (it.value().startsWith(prefix)) {
+                it.value() = toPath + it.value().mid(fromPath.size());
+            }
+        }
+    } else if (m_added.remove(fromPath)) {
+        // Файл появился в этой же пачке (например, загрузчик пишет .part, потом переименовывает)
+        if (isAudioFile(toPath)) {
+            queueAdded(toPath);
+        }
+        return;
+    } else if (!isAudioFile(toPath)) {
+        queueRemoved(fromPath);
+        return;
+    } else if (!isAudioFile(fromPath)) {
+        queueAdded(toPath);
+        return;
+    }
+
+    const QString originalPath = m_renamedBack.take(fromPath);
+    const QString sourcePath = originalPath.isEmpty() ? fromPath : originalPath;
+    if (sourcePath == toPath) {
+        m_renamed.remove(sourcePath); // Переименовали обратно
+        return;
+    }
+    m_renamed.insert(sourcePath, toPath);
+    m_renamedBack.insert(toPath, sourcePath);
+}
+
+void LibraryWatcher::scheduleFlush()
+{
+    if (!m_pendingAge.isValid()) {
+        m_pendingAge.start();
+    }
+    m_flushTimer->start(m_pendingAge.elapsed() >= kMaxFlushDelayMs ? 0 : kQuietPeriodMs);
+}
+
+void LibraryWatcher::flush()
+{
+    // IN_MOVED_FROM без пары — файл или папку унесли за пределы библиотеки
+    for (auto it = m_pendingMoves.constBegin(); it != m_pendingMoves.constEnd(); ++it) {
+        if (it->second) {
+            forgetTree(it->first);
+        }
+        queueRemoved(it->first);
+    }
+    m_pendingMoves.clear();
+
+    Changes changes;
+    changes.added = m_added.values();
+    changes.added.sort(); // Порядок автодобавления совпадает с порядком имен
+    changes.removed = m_removed;
+    changes.renamed = m_renamed;
+    changes.isOverflowed = m_isOverflowed;
+
+    m_added.clear();
+    m_removed.clear();
+    m_renamed.clear();
+    m_renamedBack.clear();
+    m_isOverflowed = false;
+    m_pendingAge.invalidate();
+
+    if (changes.isOverflowed) {
+        OSD_LOG_WARNING(Library, "Library watcher queue overflowed, some changes were missed");
+    }
+    if (!changes.isEmpty()) {
+        emit changed(changes);
+    }
+}
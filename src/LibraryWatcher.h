@@ -0,0 +1,91 @@
+// src/LibraryWatcher.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+class QTimer;
+
+// Следит за папкой библиотеки через inotify (только Linux) и сообщает об изменениях пачками.
+// Дерево обходится один раз при старте, чтобы поставить наблюдение на каждую папку, дальше
+// обходятся только появившиеся папки. Шторм событий (распаковка архива на тысячу клипов)
+// копится и уходит одним сигналом, когда события затихнут, но не реже раза в секунду.
+class LibraryWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Changes {
+        QStringList added;               // Новые или перезаписанные аудиофайлы, уже закрытые на запись
+        QSet<QString> removed;           // Удаленные или вынесенные из библиотеки файлы и папки
+        QHash<QString, QString> renamed; // Старый путь -> новый, для файлов и папок
+        bool isOverflowed = false;       // Очередь ядра переполнилась — часть событий потеряна
+
+        bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && renamed.isEmpty() && !isOverflowed; }
+    };
+
+    explicit LibraryWatcher(QObject* parent = nullptr);
+    ~LibraryWatcher();
+
+    static bool isAvailable();
+    static bool isAudioFile(const QString& filePath);
+
+    bool start(const QString& rootPath);
+    void stop();
+    QString rootPath() const { return m_rootPath; }
+
+signals:
+    void changed(const LibraryWatcher::Changes& changes);
+
+private slots:
+    void onEventsReady();
+    void flush();
+
+private:
+    void watchTree(const QString& directoryPath, QStringList* pFoundFiles);
+    void forgetTree(const QString& directoryPath);
+    void queueAdded(const QString& path);
+    void queueRemoved(const QString& path);
+    void queueRenamed(const QString& fromPath, const QString& toPath, bool isDirectory);
+    void scheduleFlush();
+
+    QString m_rootPath;
+    int m_fd;
+    QSocketNotifier* m_notifier;
+    QHash<int, QString> m_directories;                    // Дескриптор наблюдения -> путь папки
+    QHash<quint32, QPair<QString, bool>> m_pendingMoves; // Cookie IN_MOVED_FROM -> путь и признак папки
+
+    // Накопленная пачка
+    QSet<QString> m_added;
+    QSet<QString> m_removed;
+    QHash<QString, QString> m_renamed;
+    QHash<QString, QString> m_renamedBack; // Новый путь -> исходный: цепочки a -> b -> c сводятся к a -> c
+    bool m_isOverflowed;
+    QTimer* m_flushTimer;
+    QElapsedTimer m_pendingAge;
+};
@@ -0,0 +1,313 @@
+// src/Log.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Log.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace Log {
+
+namespace detail {
+std::atomic<int> g_levels[CategoryCount] = {};
+std::atomic<quint64> g_dropped{0};
+thread_local bool t_isRealtimeThread = false;
+}
+
+namespace {
+
+// 4096 записей по 256 байт (1 МиБ): поток вывода просыпается раз в 20 мс, и за это время
+// в буфер помещается всплеск от загрузки плейлиста на несколько тысяч треков
+constexpr size_t kCapacity = 4096;
+constexpr size_t kTextSize = 232;
+constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+
+const char* const kCategoryNames[CategoryCount] = {
+    "general", "engine", "device", "store", "control", "midi", "library", "ui", "qt"
+};
+const char kLevelLetters[] = {'D', 'I', 'W', 'E'};
+
+// Ячейка кольца: sequence говорит, чья очередь — писателя с позицией pos (sequence == pos)
+// или читателя (sequence == pos + 1). Схема ограниченной MPMC-очереди Вьюкова, читатель один.
+struct Slot {
+    std::atomic<size_t> sequence;
+    qint64 timeMs;
+    quint32 threadId;
+    quint8 level;
+    quint8 category;
+    char text[kTextSize];
+};
+
+struct Ring {
+    Ring()
+    {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    Slot slots[kCapacity];
+    std::atomic<size_t> enqueuePosition{0};
+    size_t dequeuePosition = 0; // Только поток вывода
+};
+
+Ring g_ring;
+std::atomic<quint32> g_threadCounter{0};
+thread_local quint32 t_threadId = 0;
+
+std::thread g_drainThread;
+std::mutex g_drainMutex; // Только для сна потока вывода; писатели его не берут
+std::condition_variable g_drainCondition;
+bool g_isStopRequested = false;
+FILE* g_file = nullptr;
+QtMessageHandler g_previousHandler = nullptr;
+
+Level toLevel(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return Debug;
+    case QtInfoMsg:
+        return Info;
+    case QtWarningMsg:
+        return Warning;
+    default:
+        return Error;
+    }
+}
+
+void qtMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    if (type == QtFatalMsg) {
+        // Процесс сейчас завершится: пишем сразу, мимо очереди
+        stop();
+        if (g_previousHandler) {
+            g_previousHandler(type, context, message);
+        }
+        std::abort();
+    }
+    const Category category = context.category && qstrcmp(context.category, "default") != 0 ? QtMessages : General;
+    const Level level = toLevel(type);
+    if (isEnabled(level, category)) {
+        write(level, category, "%s", qUtf8Printable(message));
+    }
+}
+
+// Возвращает false, если очередь пуста
+bool printNext(QByteArray* pLine)
+{
+    Slot& slot = g_ring.slots[g_ring.dequeuePosition & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != g_ring.dequeuePosition + 1) {
+        return false;
+    }
+    *pLine = QDateTime::fromMSecsSinceEpoch(slot.timeMs).toString("HH:mm:ss.zzz").toLatin1();
+    *pLine += ' ';
+    *pLine += kLevelLetters[slot.level];
+    *pLine += ' ';
+    *pLine += kCategoryNames[slot.category];
+    *pLine += " [t" + QByteArray::number(slot.threadId) + "] ";
+    *pLine += slot.text;
+    *pLine += '\n';
+    slot.sequence.store(g_ring.dequeuePosition + kCapacity, std::memory_order_release);
+    ++g_ring.dequeuePosition;
+    return true;
+}
+
+void drain()
+{
+    static quint64 reportedDropped = 0;
+    QByteArray line;
+    QByteArray output;
+    while (printNext(&line)) {
+        output += line;
+    }
+    const quint64 dropped = detail::g_dropped.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped) {
+        output += "W log: " + QByteArray::number(dropped - reportedDropped) + " message(s) dropped\n";
+        reportedDropped = dropped;
+    }
+    if (output.isEmpty()) {
+        return;
+    }
+    std::fwrite(output.constData(), 1, output.size(), stderr);
+    std::fflush(stderr);
+    if (g_file) {
+        std::fwrite(output.constData(), 1, output.size(), g_file);
+        std::fflush(g_file);
+    }
+}
+
+void drainLoop()
+{
+    std::unique_lock<std::mutex> lock(g_drainMutex);
+    while (!g_isStopRequested) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        g_drainCondition.wait_for(lock, kDrainInterval, [] { return g_isStopRequested; });
+    }
+}
+
+} // namespace
+
+void start(const QString& filePath)
+{
+    if (g_drainThread.joinable()) {
+        return;
+    }
+    const QByteArray rules = qgetenv("OPENSOUNDDECK_LOG");
+    if (!rules.isEmpty()) {
+        applyRules(QString::fromUtf8(rules));
+    }
+    if (!filePath.isEmpty()) {
+        g_file = std::fopen(QFile::encodeName(filePath).constData(), "a");
+        if (!g_file) {
+            std::fprintf(stderr, "Cannot open log file %s\n", qUtf8Printable(filePath));
+        }
+    }
+    g_isStopRequested = false;
+    g_drainThread = std::thread(drainLoop);
+    g_previousHandler = qInstallMessageHandler(qtMessageHandler);
+}
+
+void stop()
+{
+    if (g_drainThread.joinable()) {
+        qInstallMessageHandler(g_previousHandler);
+        {
+            std::lock_guard<std::mutex> lock(g_drainMutex);
+            g_isStopRequested = true;
+        }
+        g_drainCondition.notify_one();
+        g_drainThread.join();
+    }
+    drain();
+    if (g_file) {
+        std::fclose(g_file);
+        g_file = nullptr;
+    }
+}
+
+void setLevel(Level level)
+{
+    for (std::atomic<int>& categoryLevel : detail::g_levels) {
+        categoryLevel.store(level, std::memory_order_relaxed);
+    }
+}
+
+void setLevel(Category category, Level level)
+{
+    detail::g_levels[category].store(level, std::memory_order_relaxed);
+}
+
+void applyRules(const QString& rules)
+{
+    static const char* const kLevelNames[] = {"debug", "info", "warning", "error"};
+    const auto parseLevel = [](const QString& name, Level* pLevel) {
+        for (int level = Debug; level <= Error; ++level) {
+            if (name.compare(QLatin1String(kLevelNames[level]), Qt::CaseInsensitive) == 0) {
+                *pLevel = static_cast<Level>(level);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (const QString& rule : rules.split(',', Qt::SkipEmptyParts)) {
+        const QString trimmed = rule.trimmed();
+        const int separator = trimmed.indexOf('=');
+        Level level = Debug;
+        if (separator < 0) {
+            if (parseLevel(trimmed, &level)) {
+                setLevel(level);
+            }
+            continue;
+        }
+        const QString name = trimmed.left(separator).trimmed();
+        if (!parseLevel(trimmed.mid(separator + 1).trimmed(), &level)) {
+            continue;
+        }
+        for (int category = 0; category < CategoryCount; ++category) {
+            if (name == QLatin1String("*") || name.compare(QLatin1String(kCategoryNames[category]), Qt::CaseInsensitive) == 0) {
+                setLevel(static_cast<Category>(category), level);
+            }
+        }
+    }
+}
+
+void markRealtimeThread()
+{
+    detail::t_isRealtimeThread = true;
+}
+
+quint64 droppedCount()
+{
+    return detail::g_dropped.load(std::memory_order_relaxed);
+}
+
+void write(Level level, Category category, const char* format, ...)
+{
+    if (detail::t_isRealtimeThread) { // Прямой вызов мимо isEnabled()
+        detail::g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (t_threadId == 0) {
+        t_threadId = g_threadCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Захват ячейки: CAS позиции записи. Полное кольцо — отбрасываем, а не ждем читателя
+    size_t position = g_ring.enqueuePosition.load(std::memory_order_relaxed);
+    Slot* pSlot = nullptr;
+    for (;;) {
+        pSlot = &g_ring.slots[position & (kCapacity - 1)];
+        const size_t sequence = pSlot->sequence.load(std::memory_order_acquire);
+        const qint64 difference = static_cast<qint64>(sequence) - static_cast<qint64>(position);
+        if (difference == 0) {
+            if (g_ring.enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            detail::g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = g_ring.enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    pSlot->timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    pSlot->threadId = t_threadId;
+    pSlot->level = static_cast<quint8>(level);
+    pSlot->category = static_cast<quint8>(category);
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(pSlot->text, kTextSize, format, args); // Длинное сообщение обрезается
+    va_end(args);
+    pSlot->sequence.store(position + 1, std::memory_order_release);
+}
+
+} // namespace Log
@@ -0,0 +1,124 @@
+// src/Log.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+
+// Журнал с категориями. Запись форматируется printf-ом прямо в ячейку кольцевого буфера
+// без блокировок и выделений памяти; в stderr и файл ее выводит отдельный поток.
+// Вызывающий поток никогда не ждет вывода: при переполнении буфера запись отбрасывается.
+//
+// Уровень ниже OPENSOUNDDECK_LOG_MIN_LEVEL вырезается при компиляции вместе с вычислением
+// аргументов. Во время работы уровень задается для каждой категории переменной окружения
+// OPENSOUNDDECK_LOG, например "info" или "device=debug,store=debug".
+//
+// Аудиопоток не пишет в журнал никогда: записи из него отбрасываются (см. markRealtimeThread).
+namespace Log {
+
+enum Level {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+enum Category {
+    General,
+    Engine,   // Голоса и деки
+    Device,   // Устройство вывода, контекст miniaudio
+    Store,    // SampleStore
+    Control,  // Сокет управления
+    Midi,
+    Library,  // Папка библиотеки и плейлисты
+    Ui,
+    QtMessages, // Сообщения самого Qt (qWarning() из его модулей)
+    CategoryCount
+};
+
+// Запускает поток вывода и перехватывает сообщения Qt. Пустой filePath — только stderr.
+void start(const QString& filePath = QString());
+// Выводит все, что осталось в буфере, и останавливает поток
+void stop();
+
+// start() и stop() на время жизни объекта: объявленный в main() первым, он переживает
+// окно и движок, и их последние сообщения тоже попадают в вывод
+class Session
+{
+public:
+    explicit Session(const QString& filePath = QString()) { start(filePath); }
+    ~Session() { stop(); }
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+};
+
+void setLevel(Level level);
+void setLevel(Category category, Level level);
+void applyRules(const QString& rules); // "info", "device=debug,store=warning"
+
+// Поток, записи из которого отбрасываются еще в isEnabled() (колбэк устройства). Вызывается из самого потока.
+void markRealtimeThread();
+quint64 droppedCount();
+
+void write(Level level, Category category, const char* format, ...) Q_ATTRIBUTE_FORMAT_PRINTF(3, 4);
+
+namespace detail {
+extern std::atomic<int> g_levels[CategoryCount];
+extern std::atomic<quint64> g_dropped;
+extern thread_local bool t_isRealtimeThread;
+}
+
+// Аудиопоток отсекается здесь, до вычисления аргументов записи: qUtf8Printable() и прочее
+// форматирование в колбэке не выполняются вовсе
+inline bool isEnabled(Level level, Category category)
+{
+    if (level < detail::g_levels[category].load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (detail::t_isRealtimeThread) {
+        detail::g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+} // namespace Log
+
+#ifndef OPENSOUNDDECK_LOG_MIN_LEVEL
+#define OPENSOUNDDECK_LOG_MIN_LEVEL 0
+#endif
+
+// Аргументы вычисляются, только если запись пройдет фильтр: qUtf8Printable() в выключенном
+// отладочном сообщении ничего не стоит
+#define OSD_LOG(level, category, ...)                                   \
+    do {                                                                \
+        if constexpr ((level) >= OPENSOUNDDECK_LOG_MIN_LEVEL) {         \
+            if (Log::isEnabled((level), (category))) {                  \
+                Log::write((level), (category), __VA_ARGS__);           \
+            }                                                           \
+        }                                                               \
+    } while (false)
+
+#define OSD_LOG_DEBUG(category, ...) OSD_LOG(Log::Debug, Log::category, __VA_ARGS__)
+#define OSD_LOG_INFO(category, ...) OSD_LOG(Log::Info, Log::category, __VA_ARGS__)
+#define OSD_LOG_WARNING(category, ...) OSD_LOG(Log::Warning, Log::category, __VA_ARGS__)
+#define OSD_LOG_ERROR(category, ...) OSD_LOG(Log::Error, Log::category, __VA_ARGS__)
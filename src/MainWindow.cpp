@@ -23,12 +23,21 @@
 #include "SettingsDialog.h"
 #include "GlobalHotkeyManager.h"
 #include "HotkeyCaptureDialog.h"
+#include "TrimDialog.h"
+#include "EffectsDialog.h"
+#include "DiagnosticsDialog.h"
+#include "Playlist.h"
+#include "EngineSettings.h"
+#include "MidiInput.h"
+#include "StartupTrace.h"
 
 #include <QApplication>
 #include <QTableWidget>
+#include <QTabWidget>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QStandardPaths>
-#include <QDebug>
+#include "Log.h"
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QStandardPaths>
@@ -45,30 +54,105 @@
 #include <QStatusBar>
 #include <QToolButton>
 #include <QLabel>
+#include <QProgressBar>
 #include <QMessageBox>
 #include <QSettings>
-#include <QMediaPlayer>
+#include <QThreadPool>
+#include <QPointer>
+#include <QTimer>
+#include <QLineEdit>
+#include <QDir>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// Роли данных ячейки "Tag": Qt::UserRole хранит путь к файлу
+const int RegionRole = Qt::UserRole + 1;
+const int ParamsRole = Qt::UserRole + 2;
+const int MissingRole = Qt::UserRole + 3; // Файл удален или унесен из библиотеки
+const int SearchIdRole = Qt::UserRole + 4; // Id записи в SearchIndex
+const int TagsRole = Qt::UserRole + 5;     // Исполнитель, название и альбом из тегов файла
+
+// Хоткей хранит банк и строку в одном числе: в банке заведомо меньше строк, чем шаг
+const int kHotkeyBankStride = 1 << 20;
+// Служебные хоткеи — за последним банком
+const int kSaveReplayHotkeyTarget = AudioEngine::kDeckCount * kHotkeyBankStride;
+
+// Сколько самых частых треков (UsageStore) держать с открытыми декодерами
+const int kPrimedFrequentSounds = 4;
+
+// Сколько треков показывать в меню Most Used
+const int kMostUsedItems = 10;
+
+// Сколько последних треков банка перемешивание не повторяет (но не больше половины банка)
+const int kShuffleHistory = 32;
+
+// Индекс хранит UTF-16 как есть: QString отдает свой буфер без копирования
+std::u16string_view toSearchText(const QString& text)
+{
+    return std::u16string_view(reinterpret_cast<const char16_t*>(text.utf16()), static_cast<size_t>(text.size()));
+}
+
+// Сам путь или ближайшая его папка из набора: изменение папки касается всех файлов в ней
+template <typename Container>
+QString findAffectedPath(const QString& filePath, const Container& paths)
+{
+    QString path = filePath;
+    while (!path.isEmpty()) {
+        if (paths.contains(path)) {
+            return path;
+        }
+        const int separator = path.lastIndexOf('/');
+        if (separator <= 0) {
+            break;
+        }
+        path.truncate(separator);
+    }
+    return QString();
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
     // --- 1. ИНИЦИАЛИЗАЦИЯ СЛУЖЕБНЫХ ОБЪЕКТОВ ---
+    // Настройки применяются до открытия контекста, чтобы он сразу открылся с нужным бэкендом.
+    // Контекст и устройство открываются в фоне, пока строится окно
     m_audioEngine = new AudioEngine(this);
-    if (!m_audioEngine->init()) {
-        // TODO: Handle audio engine initialization failure more gracefully
-        QMessageBox::critical(this, tr("Fatal Error"), tr("Failed to initialize audio engine. The application will now close."));
-        // В реальном приложении можно было бы запланировать закрытие, но для простоты пока оставим так
-    }
-    m_metaDataReader = new QMediaPlayer(this);
+    EngineSettings::apply(m_audioEngine);
+    m_audioEngine->beginInit();
+    StartupTrace::mark("audio init started");
+
     m_hotkeyManager = new GlobalHotkeyManager(this);
-    connect(m_hotkeyManager, &GlobalHotkeyManager::hotkeyActivated, this, [this](int row){
-        playTrackAtRow(row);
+    // Хоткей запускает трек своего банка, даже если на экране другой: деки играют одновременно
+    connect(m_hotkeyManager, &GlobalHotkeyManager::hotkeyActivated, this, [this](int target, Qt::KeyboardModifiers extraModifiers){
+        if (target == kSaveReplayHotkeyTarget) {
+            onSaveReplay();
+            return;
+        }
+        const int bank = target / kHotkeyBankStride;
+        const int row = target % kHotkeyBankStride;
+        playTrackAtRow(row, extraModifiers, 1.0f, 0, bank);
+        m_primeTimer->start(); // Запуск сдвинул статистику: набор частых треков мог смениться
     });
+    // Пэды: нота или CC выбирает трек активного банка, сила нажатия — громкость. Звук
+    // запускает сам поток MIDI (см. updateMidiTracks()), сюда приходит только отметка
+    m_midiInput = new MidiInput(m_audioEngine, this);
+    connect(m_midiInput, &MidiInput::trackTriggered, this, [this](int trackIndex, int deck){
+        markTrackStarted(trackIndex, deck);
+    });
+    m_libraryWatcher = new LibraryWatcher(this);
+    connect(m_libraryWatcher, &LibraryWatcher::changed, this, &MainWindow::onLibraryChanged);
+    m_importPipeline = new ImportPipeline(this);
+    connect(m_importPipeline, &ImportPipeline::progress, this, &MainWindow::onImportProgress);
+    connect(m_importPipeline, &ImportPipeline::batchReady, this, &MainWindow::onImportBatch);
+    connect(m_importPipeline, &ImportPipeline::finished, this, &MainWindow::onImportFinished);
+    StartupTrace::mark("hotkey manager created");
 
     // --- 2. СОЗДАНИЕ ДЕЙСТВИЙ (ACTIONS) ---
     // Меню File
     m_newAction = new QAction(tr("&New Playlist"), this);
-    m_isRepeatEnabled = false;
     m_openAction = new QAction(tr("&Open Playlist"), this);
     m_importAction = new QAction(tr("&Import Audio"), this);
     m_saveAction = new QAction(tr("&Save Playlist"), this);
@@ -88,6 +172,8 @@ MainWindow::MainWindow(QWidget *parent)
     m_settingsAction = new QAction(tr("&Settings..."), this);
     m_pasteAction = new QAction(tr("&Paste"), this);
     m_settingsAction->setShortcut(tr("Ctrl+P"));
+    m_findAction = new QAction(tr("&Find..."), this);
+    m_findAction->setShortcut(QKeySequence::Find);
 
     // Меню Help
     m_aboutAction = new QAction(tr("&About"), this);
@@ -99,8 +185,17 @@ MainWindow::MainWindow(QWidget *parent)
     m_playAction = new QAction(style()->standardIcon(QStyle::SP_MediaPlay), tr("Play"), this);
     m_pauseAction = new QAction(style()->standardIcon(QStyle::SP_MediaPause), tr("Pause"), this);
     m_stopAction = new QAction(style()->standardIcon(QStyle::SP_MediaStop), tr("Stop"), this);
+    m_stopAllAction = new QAction(tr("Stop All Banks"), this);
+    m_stopAllAction->setShortcut(tr("Ctrl+Shift+Space"));
     m_nextAction = new QAction(style()->standardIcon(QStyle::SP_MediaSkipForward), tr("Next"), this);
     m_prevAction = new QAction(style()->standardIcon(QStyle::SP_MediaSkipBackward), tr("Previous"), this);
+    m_masterEffectsAction = new QAction(tr("Master Effects..."), this);
+    m_micEffectsAction = new QAction(tr("Microphone Effects..."), this);
+    m_recordAction = new QAction(tr("&Record Output"), this);
+    m_recordAction->setCheckable(true);
+    m_recordAction->setShortcut(tr("Ctrl+R"));
+    m_saveReplayAction = new QAction(tr("Save &Replay"), this);
+    m_saveReplayAction->setShortcut(tr("Ctrl+Shift+R"));
 
     // Меню Window
     m_minimizeAction = new QAction(tr("Mi&nimize"), this);
@@ -108,12 +203,15 @@ MainWindow::MainWindow(QWidget *parent)
     m_keepOnTopAction = new QAction(tr("Keep Above Others"), this);
     m_keepOnTopAction->setCheckable(true);
     m_fullscreenAction->setCheckable(true);
+    m_diagnosticsAction = new QAction(tr("Engine &Diagnostics..."), this);
 
     // Устанавливаем начальное состояние кнопок
     m_playAction->setEnabled(true);
     m_pauseAction->setEnabled(false);
     m_stopAction->setEnabled(false);
 
+    StartupTrace::mark("actions created");
+
     // --- 3. СОЗДАНИЕ ВИДЖЕТОВ ИНТЕРФЕЙСА ---
     // Верхнее меню
     m_fileMenu = menuBar()->addMenu(tr("&File"));
@@ -130,14 +228,26 @@ MainWindow::MainWindow(QWidget *parent)
     m_headphonesMuteButton = new QToolButton(this);
     m_micMuteButton = new QToolButton(this);
 
-    // Центральная область
-    m_soundTableWidget = new QTableWidget();
+    // Центральная область: вкладки банков
+    m_bankTabWidget = new QTabWidget(this);
+    for (int bank = 0; bank < AudioEngine::kDeckCount; ++bank) {
+        m_bankTabWidget->addTab(createBankPage(bank), tr("Bank %1").arg(bank + 1));
+    }
+    m_soundTableWidget = m_banks.first().table;
+    m_searchLineEdit = new QLineEdit(this);
+    m_searchTimer = new QTimer(this);
+    m_primeTimer = new QTimer(this);
+    m_midiTracksTimer = new QTimer(this);
 
     // Строка состояния
     m_headphonesButton = new QToolButton(this);
     m_allButton = new QToolButton(this);
     m_repeatButton = new QToolButton(this);
+    m_queueButton = new QToolButton(this);
+    m_shuffleButton = new QToolButton(this);
     m_statusLabel = new QLabel(tr("Ready"), this);
+    m_importProgressBar = new QProgressBar(this);
+    m_importCancelButton = new QToolButton(this);
 
     // --- 4. НАСТРОЙКА ВИДЖЕТОВ И КОМПОНОВКА ---
     // Меню
@@ -154,19 +264,32 @@ MainWindow::MainWindow(QWidget *parent)
     m_editMenu->addAction(m_copyAction);
     m_editMenu->addAction(m_pasteAction);
     m_editMenu->addSeparator();
+    m_editMenu->addAction(m_findAction);
+    m_editMenu->addSeparator();
     m_editMenu->addAction(m_settingsAction);
     
     m_playMenu->addAction(m_playAction);
     m_playMenu->addAction(m_pauseAction);
     m_playMenu->addAction(m_stopAction);
+    m_playMenu->addAction(m_stopAllAction);
     m_playMenu->addSeparator();
     m_playMenu->addAction(m_prevAction);
     m_playMenu->addAction(m_nextAction);
+    m_playMenu->addSeparator();
+    m_mostUsedMenu = m_playMenu->addMenu(tr("Most &Used"));
+    m_playMenu->addSeparator();
+    m_playMenu->addAction(m_masterEffectsAction);
+    m_playMenu->addAction(m_micEffectsAction);
+    m_playMenu->addSeparator();
+    m_playMenu->addAction(m_recordAction);
+    m_playMenu->addAction(m_saveReplayAction);
 
     m_windowMenu->addAction(m_minimizeAction);
     m_windowMenu->addAction(m_fullscreenAction);
     m_windowMenu->addSeparator();
     m_windowMenu->addAction(m_keepOnTopAction);
+    m_windowMenu->addSeparator();
+    m_windowMenu->addAction(m_diagnosticsAction);
 
     m_helpMenu->addAction(m_aboutAction);
     m_helpMenu->addAction(m_offlineManualAction);
@@ -209,27 +332,38 @@ MainWindow::MainWindow(QWidget *parent)
     addToolBar(m_playbackToolBar);
     m_headphonesVolume = m_headphonesVolumeSlider->value(); // Сохраняем начальное значение
     m_micVolume = m_micVolumeSlider->value();
+    m_audioEngine->setMicVolume(m_micVolume / 100.0f);
 
     // Центральный виджет
     QWidget *centralWidget = new QWidget(this);
     setCentralWidget(centralWidget);
     QVBoxLayout *mainLayout = new QVBoxLayout(centralWidget);
-    mainLayout->addWidget(m_soundTableWidget);
+    mainLayout->addWidget(m_searchLineEdit);
+    mainLayout->addWidget(m_bankTabWidget);
+
+    // Строка поиска: фильтр по мере набора, Enter запускает лучшее совпадение, Esc сбрасывает
+    m_searchLineEdit->setPlaceholderText(tr("Search by name, tags or folder"));
+    m_searchLineEdit->setClearButtonEnabled(true);
+    QAction *clearSearchAction = new QAction(m_searchLineEdit);
+    clearSearchAction->setShortcut(Qt::Key_Escape);
+    clearSearchAction->setShortcutContext(Qt::WidgetShortcut);
+    m_searchLineEdit->addAction(clearSearchAction);
+    connect(clearSearchAction, &QAction::triggered, m_searchLineEdit, &QLineEdit::clear);
+    m_searchTimer->setSingleShot(true);
+    m_primeTimer->setSingleShot(true);
+    m_primeTimer->setInterval(100);
+    m_midiTracksTimer->setSingleShot(true);
+    m_midiTracksTimer->setInterval(0);
     
-    // Настройка таблицы
     setAcceptDrops(true); 
-    m_soundTableWidget->setAcceptDrops(true);
-    m_soundTableWidget->setColumnCount(4);
-    m_soundTableWidget->setHorizontalHeaderLabels({tr("Index"), tr("Tag"), tr("Duration"), tr("Hotkey")});
-    m_soundTableWidget->verticalHeader()->setVisible(false);
-    m_soundTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    m_soundTableWidget->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
-    m_soundTableWidget->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    m_soundTableWidget->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
-    m_soundTableWidget->setEditTriggers(QAbstractItemView::EditKeyPressed); // Разрешаем редактирование по F2
-    m_soundTableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_soundTableWidget->setSelectionMode(QAbstractItemView::SingleSelection);
-    m_soundTableWidget->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    // Переключение банков с клавиатуры: Ctrl+1..Ctrl+4
+    for (int bank = 0; bank < m_banks.size(); ++bank) {
+        QAction *bankAction = new QAction(this);
+        bankAction->setShortcut(QKeySequence(Qt::CTRL | static_cast<Qt::Key>(Qt::Key_1 + bank)));
+        connect(bankAction, &QAction::triggered, m_bankTabWidget, [this, bank](){ m_bankTabWidget->setCurrentIndex(bank); });
+        addAction(bankAction);
+    }
     
     // Строка состояния
     m_headphonesButton->setText("H");
@@ -243,16 +377,32 @@ MainWindow::MainWindow(QWidget *parent)
     m_repeatButton->setText(QString::fromUtf8("↻"));
     m_repeatButton->setCheckable(true);
     m_repeatButton->setToolTip(tr("Repeat playback"));
+    m_queueButton->setText(QString::fromUtf8("⇉"));
+    m_queueButton->setCheckable(true);
+    m_queueButton->setToolTip(tr("Continuous playback: the next track starts gaplessly"));
+    m_shuffleButton->setText(QString::fromUtf8("⤮"));
+    m_shuffleButton->setCheckable(true);
+    m_shuffleButton->setToolTip(tr("Shuffle continuous playback"));
 
     statusBar()->addWidget(m_headphonesButton);
     statusBar()->addWidget(m_allButton);
     statusBar()->addWidget(m_statusLabel);
+    m_importProgressBar->setFormat(tr("Importing %v / %m"));
+    m_importProgressBar->setMaximumWidth(220);
+    m_importProgressBar->hide();
+    m_importCancelButton->setText(QString::fromUtf8("✕"));
+    m_importCancelButton->setToolTip(tr("Cancel import"));
+    m_importCancelButton->hide();
+
+    statusBar()->addPermanentWidget(m_importProgressBar);
+    statusBar()->addPermanentWidget(m_importCancelButton);
+    statusBar()->addPermanentWidget(m_queueButton);
+    statusBar()->addPermanentWidget(m_shuffleButton);
     statusBar()->addPermanentWidget(m_repeatButton);
 
-    // --- 5. СОЕДИНЕНИЕ СИГНАЛОВ И СЛОТОВ ---
-    // Служебные
-    connect(m_metaDataReader, &QMediaPlayer::durationChanged, this, &MainWindow::onDurationChanged);
+    StartupTrace::mark("widgets built");
 
+    // --- 5. СОЕДИНЕНИЕ СИГНАЛОВ И СЛОТОВ ---
     // Меню
     connect(m_exitAction, &QAction::triggered, this, &MainWindow::onExitTriggered);
     connect(m_newAction, &QAction::triggered, this, &MainWindow::onNewTriggered);
@@ -261,26 +411,51 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_saveAction, &QAction::triggered, this, &MainWindow::onSaveTriggered);
     connect(m_saveAsAction, &QAction::triggered, this, &MainWindow::onSaveAsTriggered);
     connect(m_settingsAction, &QAction::triggered, this, &MainWindow::onSettingsClicked);
+    connect(m_findAction, &QAction::triggered, this, [this](){
+        m_searchLineEdit->setFocus(Qt::ShortcutFocusReason);
+        m_searchLineEdit->selectAll();
+    });
     connect(m_aboutAction, &QAction::triggered, this, &MainWindow::onAboutClicked);
     connect(m_offlineManualAction, &QAction::triggered, this, &MainWindow::onOfflineManualClicked);
     connect(m_aboutQtAction, &QAction::triggered, qApp, &QApplication::aboutQt);
+    connect(m_mostUsedMenu, &QMenu::aboutToShow, this, &MainWindow::updateMostUsedMenu);
 
     // Меню Window
     connect(m_minimizeAction, &QAction::triggered, this, &MainWindow::showMinimized);
     connect(m_keepOnTopAction, &QAction::toggled, this, &MainWindow::onKeepOnTopToggled);
+    connect(m_diagnosticsAction, &QAction::triggered, this, &MainWindow::onDiagnosticsClicked);
     connect(m_fullscreenAction, &QAction::toggled, this, [this](bool checked){ checked ? showFullScreen() : showNormal(); });
 
     // Audio
-    connect(m_audioEngine, &AudioEngine::durationReady, m_progressSlider, &QSlider::setMaximum);
+    connect(m_audioEngine, &AudioEngine::durationReady, this, [this](int deck, ma_uint64 durationMillis){
+        m_banks[deck].durationMillis = durationMillis;
+        if (deck == m_activeBank) {
+            m_progressSlider->setMaximum(static_cast<int>(durationMillis));
+        }
+    });
     connect(m_audioEngine, &AudioEngine::positionChanged, this, &MainWindow::onPositionChanged);
     connect(m_audioEngine, &AudioEngine::playbackFinished, this, &MainWindow::onPlaybackFinished);
+    connect(m_audioEngine, &AudioEngine::queueAdvanced, this, &MainWindow::onQueueAdvanced);
+    connect(m_audioEngine, &AudioEngine::cueReached, this, &MainWindow::onCueReached);
+    connect(m_audioEngine, &AudioEngine::recordingSaved, this, [this](const QString& filePath, bool isSaved){
+        // Без диалога: запись закрывается посреди эфира. Запись могла оборваться на ошибке диска
+        const QSignalBlocker blocker(m_recordAction);
+        m_recordAction->setChecked(m_audioEngine->isRecording());
+        m_statusLabel->setText(isSaved ? tr("Saved %1").arg(QDir::toNativeSeparators(filePath))
+                                       : tr("Failed to save %1").arg(QDir::toNativeSeparators(filePath)));
+    });
 
     // Панель инструментов
     connect(m_playAction, &QAction::triggered, this, &MainWindow::onPlayClicked);
     connect(m_pauseAction, &QAction::triggered, this, &MainWindow::onPauseClicked);
     connect(m_stopAction, &QAction::triggered, this, &MainWindow::onStopClicked);
+    connect(m_stopAllAction, &QAction::triggered, this, &MainWindow::onStopAllClicked);
     connect(m_nextAction, &QAction::triggered, this, &MainWindow::onNextClicked);
     connect(m_prevAction, &QAction::triggered, this, &MainWindow::onPrevClicked);
+    connect(m_masterEffectsAction, &QAction::triggered, this, &MainWindow::onMasterEffects);
+    connect(m_micEffectsAction, &QAction::triggered, this, &MainWindow::onMicEffects);
+    connect(m_recordAction, &QAction::toggled, this, &MainWindow::onRecordToggled);
+    connect(m_saveReplayAction, &QAction::triggered, this, &MainWindow::onSaveReplay);
     connect(m_progressSlider, &QSlider::sliderMoved, this, &MainWindow::onProgressSliderMoved);
     connect(m_headphonesVolumeSlider, &QSlider::valueChanged, this, &MainWindow::onHeadphonesVolumeChanged);
     connect(m_headphonesMuteButton, &QToolButton::clicked, this, &MainWindow::onHeadphonesMuteClicked);
@@ -291,21 +466,332 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_headphonesButton, &QToolButton::toggled, this, &MainWindow::onHeadphonesToggle);
     connect(m_allButton, &QToolButton::toggled, this, &MainWindow::onAllToggle);
     connect(m_repeatButton, &QToolButton::toggled, this, &MainWindow::onRepeatToggle);
-
-    // Таблица
-    connect(m_soundTableWidget, &QTableWidget::itemDoubleClicked, this, &MainWindow::onSoundTableDoubleClicked);
-    connect(m_soundTableWidget, &QTableWidget::itemChanged, this, &MainWindow::onSoundItemChanged);
-    connect(m_soundTableWidget, &QTableWidget::customContextMenuRequested, this, &MainWindow::onSoundTableContextMenuRequested);
+    connect(m_queueButton, &QToolButton::toggled, this, &MainWindow::onQueueToggle);
+    connect(m_shuffleButton, &QToolButton::toggled, this, &MainWindow::onShuffleToggle);
+    connect(m_importCancelButton, &QToolButton::clicked, m_importPipeline, &ImportPipeline::cancel);
+
+    // Банки
+    connect(m_bankTabWidget, &QTabWidget::currentChanged, this, &MainWindow::onBankChanged);
+
+    // Поиск
+    connect(m_searchLineEdit, &QLineEdit::textChanged, this, &MainWindow::applySearchFilter);
+    connect(m_searchLineEdit, &QLineEdit::returnPressed, this, [this](){
+        if (m_searchBestRow >= 0) {
+            playTrackAtRow(m_searchBestRow);
+        }
+    });
+    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::applySearchFilter);
+    connect(m_primeTimer, &QTimer::timeout, this, &MainWindow::primeLikelySounds);
+    connect(m_midiTracksTimer, &QTimer::timeout, this, &MainWindow::updateMidiTracks);
+    for (const Bank& bank : m_banks) {
+        QTableWidget *table = bank.table;
+        connect(table, &QTableWidget::currentCellChanged, this, [this, table](){
+            if (table == m_soundTableWidget) {
+                m_primeTimer->start();
+            }
+        });
+    }
 
     // --- 6. НАСТРОЙКИ ОКНА ---
     setWindowTitle("OpenSoundDeck v0.1 (dev)");
     setWindowIcon(QIcon(":/icons/app-icon.png"));
     resize(800, 600);
     setMinimumSize(500, 400);
+
+    if (!m_audioEngine->waitForInit()) {
+        // TODO: Handle audio engine initialization failure more gracefully
+        QMessageBox::critical(this, tr("Fatal Error"), tr("Failed to initialize audio engine. The application will now close."));
+        // В реальном приложении можно было бы запланировать закрытие, но для простоты пока оставим так
+    }
+    StartupTrace::mark("audio engine ready");
+
+    applyHotkeySettings();
+    applyMidiSettings();
+    StartupTrace::mark("hotkeys and MIDI applied");
+
+    // Плейлист и дерево библиотеки читаются уже после показа окна
+    QTimer::singleShot(0, this, &MainWindow::restoreLastPlaylist);
+    QTimer::singleShot(0, this, &MainWindow::applyLibrarySettings);
 }
 
 MainWindow::~MainWindow() {}
 
+QWidget* MainWindow::createBankPage(int bank)
+{
+    QWidget *page = new QWidget(this);
+    QTableWidget *table = new QTableWidget(page);
+    QSlider *volumeSlider = new QSlider(Qt::Horizontal, page);
+
+    table->setAcceptDrops(true);
+    table->setColumnCount(4);
+    table->setHorizontalHeaderLabels({tr("Index"), tr("Tag"), tr("Duration"), tr("Hotkey")});
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    table->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+    table->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
+    table->setEditTriggers(QAbstractItemView::EditKeyPressed); // Разрешаем редактирование по F2
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    // Громкость банка — отдельный множитель деки поверх громкости трека и мониторинга
+    const QString volumeKey = QString("banks/%1/volume").arg(bank + 1);
+    volumeSlider->setRange(0, 100);
+    volumeSlider->setValue(QSettings("pavel-kruhlei", "OpenSoundDeck").value(volumeKey, 100).toInt());
+    volumeSlider->setFixedWidth(120);
+    volumeSlider->setToolTip(tr("Bank volume"));
+    m_audioEngine->setDeckVolume(bank, volumeSlider->value() / 100.0f);
+    connect(volumeSlider, &QSlider::valueChanged, this, [this, bank, volumeKey](int value){
+        m_audioEngine->setDeckVolume(bank, value / 100.0f);
+        QSettings("pavel-kruhlei", "OpenSoundDeck").setValue(volumeKey, value);
+    });
+
+    QHBoxLayout *volumeLayout = new QHBoxLayout;
+    volumeLayout->addStretch();
+    volumeLayout->addWidget(new QLabel(tr("Bank volume:"), page));
+    volumeLayout->addWidget(volumeSlider);
+    QVBoxLayout *layout = new QVBoxLayout(page);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(volumeLayout);
+    layout->addWidget(table);
+
+    // Действия пользователя приходят только от таблицы активного банка
+    connect(table, &QTableWidget::itemDoubleClicked, this, &MainWindow::onSoundTableDoubleClicked);
+    connect(table, &QTableWidget::itemChanged, this, &MainWindow::onSoundItemChanged);
+    connect(table, &QTableWidget::customContextMenuRequested, this, &MainWindow::onSoundTableContextMenuRequested);
+    // Таблица нот потока MIDI повторяет строки активного банка
+    auto updateMidiTracksLater = [this, table]() {
+        if (table == m_soundTableWidget) {
+            m_midiTracksTimer->start();
+        }
+    };
+    connect(table->model(), &QAbstractItemModel::rowsInserted, this, updateMidiTracksLater);
+    connect(table->model(), &QAbstractItemModel::rowsRemoved, this, updateMidiTracksLater);
+    connect(table->model(), &QAbstractItemModel::dataChanged, this, updateMidiTracksLater);
+
+    m_banks.append(Bank{table, volumeSlider, false, 0});
+    return page;
+}
+
+void MainWindow::onBankChanged(int index)
+{
+    if (index < 0 || index >= m_banks.size()) {
+        return;
+    }
+    m_activeBank = index;
+    m_soundTableWidget = m_banks[index].table;
+
+    // Транспорт показывает деку нового банка
+    const AudioEngine::PlaybackState state = m_audioEngine->getPlaybackState(index);
+    updatePlaybackButtons(state == AudioEngine::Playing);
+    m_progressSlider->setMaximum(static_cast<int>(m_banks[index].durationMillis));
+    if (state == AudioEngine::Stopped) {
+        m_progressSlider->setValue(0);
+    }
+    const QSignalBlocker repeatBlocker(m_repeatButton);
+    m_repeatButton->setChecked(m_banks[index].isRepeatEnabled);
+    const QSignalBlocker queueBlocker(m_queueButton);
+    m_queueButton->setChecked(m_banks[index].isQueueEnabled);
+    const QSignalBlocker shuffleBlocker(m_shuffleButton);
+    m_shuffleButton->setChecked(m_banks[index].isShuffleEnabled);
+
+    m_isSearchViewStale = true; // Строки этого банка помнят видимость с прошлого показа
+    applySearchFilter();
+    armActiveBank();
+    m_primeTimer->start();
+    m_midiTracksTimer->start();
+}
+
+void MainWindow::armActiveBank()
+{
+    // Клипы активного банка закрепляются в памяти и догружаются в фоне: первый запуск
+    // после переключения не ждет декодирования файла
+    QStringList filePaths;
+    for (int row = 0; row < m_soundTableWidget->rowCount(); ++row) {
+        QTableWidgetItem *tagItem = m_soundTableWidget->item(row, 1);
+        if (tagItem && !tagItem->data(MissingRole).toBool()) {
+            filePaths.append(tagItem->data(Qt::UserRole).toString());
+        }
+    }
+    m_audioEngine->armSounds(filePaths);
+}
+
+void MainWindow::primeLikelySounds()
+{
+    // Порядок — приоритет: при малом бюджете готовятся только первые
+    QList<QPair<QString, AudioEngine::PlaybackRegion>> sounds;
+    auto appendRow = [&sounds](QTableWidget *table, int row) {
+        QTableWidgetItem *tagItem = row >= 0 ? table->item(row, 1) : nullptr;
+        if (tagItem && !tagItem->data(MissingRole).toBool()) {
+            sounds.append({tagItem->data(Qt::UserRole).toString(),
+                           tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>()});
+        }
+    };
+
+    const int currentRow = m_soundTableWidget->currentRow();
+    if (m_soundTableWidget->rowCount() > 0) {
+        appendRow(m_soundTableWidget, currentRow);
+        appendRow(m_soundTableWidget, adjacentRow(m_soundTableWidget, currentRow, 1));
+        appendRow(m_soundTableWidget, adjacentRow(m_soundTableWidget, qMax(currentRow, 0), -1));
+    }
+
+    // Самые частые треки любого банка по статистике запусков (хоткеи, пэды, двойной щелчок),
+    // в том числе прошлых сессий: их деки играют, даже когда банк не на экране
+    struct FrequentRow {
+        double score;
+        QTableWidget *table;
+        int row;
+    };
+    QList<FrequentRow> frequentRows;
+    for (const Bank& bank : m_banks) {
+        for (int row = 0; row < bank.table->rowCount(); ++row) {
+            QTableWidgetItem *tagItem = bank.table->item(row, 1);
+            const double score = tagItem ? m_audioEngine->usage().score(tagItem->data(Qt::UserRole).toString()) : 0.0;
+            if (score > 0.0) {
+                frequentRows.append({score, bank.table, row});
+            }
+        }
+    }
+    std::stable_sort(frequentRows.begin(), frequentRows.end(),
+                     [](const FrequentRow& a, const FrequentRow& b) { return a.score > b.score; });
+    for (int i = 0; i < qMin(frequentRows.size(), kPrimedFrequentSounds); ++i) {
+        appendRow(frequentRows[i].table, frequentRows[i].row);
+    }
+
+    m_audioEngine->primeSounds(sounds);
+}
+
+void MainWindow::updateMostUsedMenu()
+{
+    // Статистика помнит и файлы, которых в плейлисте уже нет: показываем только найденные
+    m_mostUsedMenu->clear();
+    const QStringList filePaths = m_audioEngine->usage().ranked(kMostUsedItems * 4);
+    for (const QString& filePath : filePaths) {
+        if (m_mostUsedMenu->actions().size() >= kMostUsedItems) {
+            break;
+        }
+        for (int bank = 0; bank < m_banks.size(); ++bank) {
+            QTableWidget *table = m_banks[bank].table;
+            int row = 0;
+            while (row < table->rowCount() &&
+                   (!table->item(row, 1) || table->item(row, 1)->data(Qt::UserRole).toString() != filePath)) {
+                ++row;
+            }
+            if (row == table->rowCount()) {
+                continue;
+            }
+            const quint32 triggers = m_audioEngine->usage().record(filePath).triggers;
+            QAction *action = m_mostUsedMenu->addAction(
+                tr("%1 — bank %2 (%n play(s))", "", static_cast<int>(triggers)).arg(table->item(row, 1)->text()).arg(bank + 1));
+            connect(action, &QAction::triggered, this, [this, bank, row]() {
+                m_bankTabWidget->setCurrentIndex(bank);
+                playTrackAtRow(row, Qt::NoModifier, 1.0f, 0, bank);
+            });
+            break;
+        }
+    }
+    if (m_mostUsedMenu->isEmpty()) {
+        m_mostUsedMenu->addAction(tr("No plays yet"))->setEnabled(false);
+    }
+}
+
+int MainWindow::adjacentRow(const QTableWidget* table, int row, int direction) const
+{
+    // Скрытые поиском строки пропускаются, список зациклен
+    const int rowCount = table->rowCount();
+    int adjacent = row;
+    for (int step = 0; step < rowCount; ++step) {
+        adjacent = (adjacent + direction + rowCount) % rowCount;
+        if (!table->isRowHidden(adjacent)) {
+            break;
+        }
+    }
+    return adjacent;
+}
+
+void MainWindow::queueNextTrack(int bank)
+{
+    // queuedPath меняется только вместе с очередью движка: начатый переход она не отдает
+    Bank& target = m_banks[bank];
+    if (!target.isQueueEnabled || m_audioEngine->getPlaybackState(bank) == AudioEngine::Stopped) {
+        m_audioEngine->clearQueue(bank);
+        return;
+    }
+
+    // По порядку банк играет до последней строки; перемешивание не кончается
+    const int currentRow = target.table->currentRow();
+    int row = -1;
+    if (target.isShuffleEnabled) {
+        row = shuffleRow(bank);
+    } else if (currentRow >= 0) {
+        row = adjacentRow(target.table, currentRow, 1);
+        if (row <= currentRow) {
+            row = -1;
+        }
+    }
+    QTableWidgetItem *tagItem = row >= 0 ? target.table->item(row, 1) : nullptr;
+    if (!tagItem || tagItem->data(MissingRole).toBool()) {
+        m_audioEngine->clearQueue(bank);
+        return;
+    }
+
+    const QString filePath = tagItem->data(Qt::UserRole).toString();
+    const ma_uint64 crossfadeMillis =
+        QSettings("pavel-kruhlei", "OpenSoundDeck").value("playback/queueCrossfadeMs", 0).toULongLong();
+    if (m_audioEngine->queueSound(filePath, tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>(),
+                                  tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>(), bank, crossfadeMillis)) {
+        target.queuedPath = filePath;
+    }
+}
+
+int MainWindow::shuffleRow(int bank) const
+{
+    const Bank& source = m_banks[bank];
+    QList<int> freshRows;
+    QList<int> otherRows;
+    int visibleCount = 0;
+    for (int row = 0; row < source.table->rowCount(); ++row) {
+        QTableWidgetItem *tagItem = source.table->item(row, 1);
+        if (source.table->isRowHidden(row) || !tagItem || tagItem->data(MissingRole).toBool()) {
+            continue;
+        }
+        ++visibleCount;
+        if (row != source.table->currentRow()) {
+            otherRows.append(row);
+        }
+    }
+
+    // Недавние треки исключаются, пока остается из чего выбирать: иначе — любой, кроме текущего
+    const int historySize = qMin(kShuffleHistory, visibleCount / 2);
+    const QStringList recent = source.recentPaths.mid(qMax(0, source.recentPaths.size() - historySize));
+    for (int row : otherRows) {
+        if (!recent.contains(source.table->item(row, 1)->data(Qt::UserRole).toString())) {
+            freshRows.append(row);
+        }
+    }
+    const QList<int>& candidates = freshRows.isEmpty() ? otherRows : freshRows;
+    if (candidates.isEmpty()) {
+        return -1;
+    }
+    return candidates[QRandomGenerator::global()->bounded(static_cast<int>(candidates.size()))];
+}
+
+void MainWindow::rememberPlayed(int bank, const QString& filePath)
+{
+    QStringList& recentPaths = m_banks[bank].recentPaths;
+    recentPaths.removeAll(filePath);
+    recentPaths.append(filePath);
+    if (recentPaths.size() > kShuffleHistory) {
+        recentPaths.removeFirst();
+    }
+}
+
+int MainWindow::hotkeyTarget(int bank, int row) const
+{
+    return bank * kHotkeyBankStride + row;
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 {
 
@@ -316,34 +802,54 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 
 void MainWindow::dropEvent(QDropEvent *event)
 {
+    // Папки обходятся рекурсивно; все, кроме вставки строк, идет в фоне
+    QStringList paths;
     for (const QUrl &url : event->mimeData()->urls()) {
         const QString filePath = url.toLocalFile();
         if (!filePath.isEmpty()) {
-            addSoundFile(filePath);
+            paths.append(filePath);
         }
     }
+    startImport(paths);
 }
 
-void MainWindow::addSoundFile(const QString& filePath)
+void MainWindow::addSoundFile(const QString& filePath, const AudioEngine::PlaybackRegion& region,
+                              const AudioEngine::VoiceParams& params)
 {
-    const int newRow = m_soundTableWidget->rowCount();
-    m_soundTableWidget->insertRow(newRow);
+    insertSoundRow(m_activeBank, filePath, region, params);
+    updateIndexes();
+}
+
+void MainWindow::insertSoundRow(int bank, const QString& filePath, const AudioEngine::PlaybackRegion& region,
+                                const AudioEngine::VoiceParams& params, const MediaProbe::MediaInfo* pInfo)
+{
+    QTableWidget *table = m_banks[bank].table;
+    const int newRow = table->rowCount();
+    table->insertRow(newRow);
 
     QFileInfo fileInfo(filePath);
     QTableWidgetItem *tagItem = new QTableWidgetItem(fileInfo.fileName());
     tagItem->setData(Qt::UserRole, filePath);
-    
+    tagItem->setData(RegionRole, QVariant::fromValue(region));
+    tagItem->setData(ParamsRole, QVariant::fromValue(params));
+
     QTableWidgetItem *durationItem = new QTableWidgetItem(tr("Loading..."));
     QTableWidgetItem *hotkeyItem = new QTableWidgetItem("None");
+    if (pInfo) {
+        applyMediaInfo(tagItem, durationItem, filePath, *pInfo);
+    }
+    updateSearchEntry(tagItem); // До setItem(): itemChanged еще не подключен к строке
 
-    m_soundTableWidget->setItem(newRow, 1, tagItem);
-    m_soundTableWidget->setItem(newRow, 2, durationItem);
-    m_soundTableWidget->setItem(newRow, 3, hotkeyItem);
-
-    m_metaDataReader->setSource(QUrl::fromLocalFile(filePath));
+    table->setItem(newRow, 1, tagItem);
+    table->setItem(newRow, 2, durationItem);
+    table->setItem(newRow, 3, hotkeyItem);
 
-    updateIndexes();
-    qDebug() << "Added sound:" << filePath;
+    // Пачку импорта в память не грузим по файлу: клипы активного банка закрепит armActiveBank()
+    if (!pInfo) {
+        probeMedia(filePath);
+        m_audioEngine->preloadSound(filePath);
+    }
+    OSD_LOG_DEBUG(Ui, "Added sound path=\"%s\"", qUtf8Printable(filePath));
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event)
@@ -355,9 +861,10 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
             const int currentRow = m_soundTableWidget->currentRow();
             
             if (currentRow >= 0) {
+                forgetSearchEntry(currentRow);
                 m_soundTableWidget->removeRow(currentRow);
                 updateIndexes();
-                qDebug() << "Removed sound at row" << currentRow << "with Delete key.";
+                OSD_LOG_DEBUG(Ui, "Removed sound row=%d", currentRow);
             }
         }
     } else {
@@ -367,19 +874,27 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 
 void MainWindow::updateIndexes()
 {
-    // Проходим по всем строкам таблицы
-    for (int i = 0; i < m_soundTableWidget->rowCount(); ++i) {
-        // Пытаемся получить ячейку в первой колонке (Index)
-        QTableWidgetItem *item = m_soundTableWidget->item(i, 0);
-        
-        // ЕСЛИ ЯЧЕЙКИ НЕТ (item == nullptr), ТО СОЗДАЕМ ЕЕ
-        if (!item) {
-            item = new QTableWidgetItem();
-            m_soundTableWidget->setItem(i, 0, item);
+    // Проходим по всем строкам таблиц всех банков
+    for (const Bank& bank : m_banks) {
+        for (int i = 0; i < bank.table->rowCount(); ++i) {
+            // Пытаемся получить ячейку в первой колонке (Index)
+            QTableWidgetItem *item = bank.table->item(i, 0);
+
+            // ЕСЛИ ЯЧЕЙКИ НЕТ (item == nullptr), ТО СОЗДАЕМ ЕЕ
+            if (!item) {
+                item = new QTableWidgetItem();
+                bank.table->setItem(i, 0, item);
+            }
+
+            // Устанавливаем правильный номер (i + 1)
+            item->setText(QString::number(i + 1));
         }
-        
-        // Устанавливаем правильный номер (i + 1)
-        item->setText(QString::number(i + 1));
+    }
+
+    // Новые строки тоже проходят через действующий фильтр; строки могли сдвинуться
+    m_isSearchViewStale = true;
+    if (!m_searchLineEdit->text().isEmpty()) {
+        applySearchFilter();
     }
 }
 
@@ -417,15 +932,24 @@ void MainWindow::onSoundTableDoubleClicked(QTableWidgetItem *item)
 
 void MainWindow::onSettingsClicked()
 {
-    SettingsDialog dialog(this);
+    SettingsDialog dialog(m_audioEngine, this);
+    connect(&dialog, &SettingsDialog::settingsApplied, this, &MainWindow::applyAudioSettings);
+    connect(&dialog, &SettingsDialog::settingsApplied, this, &MainWindow::applyHotkeySettings);
+    connect(&dialog, &SettingsDialog::settingsApplied, this, &MainWindow::applyMidiSettings);
+    connect(&dialog, &SettingsDialog::settingsApplied, this, &MainWindow::applyLibrarySettings);
     dialog.exec();
 }
 
 void MainWindow::onNewTriggered()
 {
     // TODO: Prompt to save if modified
-    m_soundTableWidget->setRowCount(0);
+    for (const Bank& bank : m_banks) {
+        bank.table->setRowCount(0);
+    }
+    clearSearchEntries();
+    armActiveBank();
     m_currentPlaylistPath.clear();
+    QSettings("pavel-kruhlei", "OpenSoundDeck").remove("playlist/last");
 }
 
 void MainWindow::onOpenTriggered()
@@ -441,24 +965,77 @@ void MainWindow::onOpenTriggered()
         return;
     }
 
-    QFile file(fileNames.first());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QMessageBox::warning(this, tr("Error"), tr("Could not open playlist file."));
-            return;
-        }
+    QList<PlaylistEntry> entries;
+    if (!Playlist::load(fileNames.first(), &entries)) {
+        QMessageBox::warning(this, tr("Error"), tr("Could not open playlist file."));
+        return;
+    }
 
-        m_soundTableWidget->setRowCount(0); // Очищаем таблицу
+    showPlaylist(fileNames.first(), entries);
+}
 
-        QTextStream in(&file);
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            if (!line.trimmed().isEmpty()) {
-                addSoundFile(line);
+void MainWindow::showPlaylist(const QString& fileName, const QList<PlaylistEntry>& entries)
+{
+    // Очищаем таблицы всех банков
+    for (const Bank& bank : m_banks) {
+        bank.table->setRowCount(0);
+    }
+    clearSearchEntries();
+    for (const PlaylistEntry &entry : entries) {
+        insertSoundRow(entry.bank, entry.filePath, entry.region, entry.params);
+    }
+    updateIndexes();
+    armActiveBank();
+    m_currentPlaylistPath = fileName;
+    QSettings("pavel-kruhlei", "OpenSoundDeck").setValue("playlist/last", fileName);
+    OSD_LOG_INFO(Library, "Playlist loaded path=\"%s\"", qUtf8Printable(m_currentPlaylistPath));
+}
+
+void MainWindow::restoreLastPlaylist()
+{
+    const QString fileName = QSettings("pavel-kruhlei", "OpenSoundDeck").value("playlist/last").toString();
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    // Файл может лежать на медленном или спящем диске: читаем его в пуле потоков,
+    // а таблицу заполняем в главном потоке, если окно еще живо
+    QPointer<MainWindow> window(this);
+    QThreadPool::globalInstance()->start([window, fileName]() {
+        QList<PlaylistEntry> entries;
+        const bool isLoaded = Playlist::load(fileName, &entries);
+        QMetaObject::invokeMethod(qApp, [window, fileName, entries, isLoaded]() {
+            // Пока файл читался, пользователь мог открыть или начать другой плейлист
+            if (!window || !window->m_currentPlaylistPath.isEmpty()) {
+                return;
             }
-        }
-        file.close();
-        m_currentPlaylistPath = fileNames.first();
-        qDebug() << "Playlist loaded from" << m_currentPlaylistPath;
+            for (const Bank& bank : window->m_banks) {
+                if (bank.table->rowCount() > 0) {
+                    return;
+                }
+            }
+            if (!isLoaded) {
+                OSD_LOG_WARNING(Library, "Could not restore the last playlist path=\"%s\"", qUtf8Printable(fileName));
+                return;
+            }
+            window->showPlaylist(fileName, entries);
+            StartupTrace::mark("last playlist restored");
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::probeMedia(const QString& filePath)
+{
+    // Длина MP3 без заголовка Xing считается проходом по всем кадрам — это работа для пула потоков
+    QPointer<MainWindow> window(this);
+    QThreadPool::globalInstance()->start([window, filePath]() {
+        const MediaProbe::MediaInfo info = MediaProbe::probe(filePath);
+        QMetaObject::invokeMethod(qApp, [window, filePath, info]() {
+            if (window) {
+                window->onMediaProbed(filePath, info);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::onSoundTableContextMenuRequested(const QPoint &pos)
@@ -477,8 +1054,8 @@ void MainWindow::onSoundTableContextMenuRequested(const QPoint &pos)
     QAction *moveDownAction = contextMenu.addAction(tr("Move Down"));
     QAction *duplicateAction = contextMenu.addAction(tr("Duplicate"));
     contextMenu.addSeparator();
-    QAction *trimAction = contextMenu.addAction(tr("Trim"));
-    trimAction->setEnabled(false); // Пока недоступно
+    QAction *trimAction = contextMenu.addAction(tr("Trim, Loop and Pitch..."));
+    QAction *effectsAction = contextMenu.addAction(tr("Effects..."));
     contextMenu.addSeparator();
     QAction *removeAction = contextMenu.addAction(tr("Remove from Playlist"));
 
@@ -497,6 +1074,8 @@ void MainWindow::onSoundTableContextMenuRequested(const QPoint &pos)
     connect(duplicateAction, &QAction::triggered, this, &MainWindow::onDuplicateTrack);
     connect(moveUpAction, &QAction::triggered, this, &MainWindow::onMoveTrackUp);
     connect(moveDownAction, &QAction::triggered, this, &MainWindow::onMoveTrackDown);
+    connect(trimAction, &QAction::triggered, this, &MainWindow::onTrimTrack);
+    connect(effectsAction, &QAction::triggered, this, &MainWindow::onTrackEffects);
 
     contextMenu.exec(m_soundTableWidget->viewport()->mapToGlobal(pos));
 }
@@ -516,8 +1095,9 @@ void MainWindow::onRenameTrack()
 void MainWindow::onRemoveTrack()
 {
     int currentRow = m_soundTableWidget->currentRow();
-    m_hotkeyManager->unregisterHotkey(currentRow);
+    m_hotkeyManager->unregisterHotkey(hotkeyTarget(m_activeBank, currentRow));
     if (currentRow >= 0) {
+        forgetSearchEntry(currentRow);
         m_soundTableWidget->removeRow(currentRow);
         updateIndexes();
     }
@@ -531,8 +1111,109 @@ void MainWindow::onDuplicateTrack()
     QTableWidgetItem *tagItem = m_soundTableWidget->item(currentRow, 1);
     if (tagItem) {
         QString filePath = tagItem->data(Qt::UserRole).toString();
-        addSoundFile(filePath);
+        addSoundFile(filePath, tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>(),
+                     tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>());
+    }
+}
+
+void MainWindow::onTrimTrack()
+{
+    const int currentRow = m_soundTableWidget->currentRow();
+    QTableWidgetItem *tagItem = currentRow >= 0 ? m_soundTableWidget->item(currentRow, 1) : nullptr;
+    if (!tagItem) {
+        return;
+    }
+
+    TrimDialog dialog(tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>(),
+                      tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>(), this);
+    if (dialog.exec() == QDialog::Accepted) {
+        tagItem->setData(RegionRole, QVariant::fromValue(dialog.getRegion()));
+        tagItem->setData(ParamsRole, QVariant::fromValue(dialog.getParams()));
+    }
+}
+
+void MainWindow::onTrackEffects()
+{
+    const int currentRow = m_soundTableWidget->currentRow();
+    QTableWidgetItem *tagItem = currentRow >= 0 ? m_soundTableWidget->item(currentRow, 1) : nullptr;
+    if (!tagItem) {
+        return;
+    }
+
+    AudioEngine::VoiceParams params = tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>();
+    EffectsDialog dialog(tr("Track Effects - %1").arg(tagItem->text()), params.effects, this);
+    if (dialog.exec() == QDialog::Accepted) {
+        params.effects = dialog.getSettings();
+        tagItem->setData(ParamsRole, QVariant::fromValue(params));
+    }
+}
+
+void MainWindow::onMasterEffects()
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    const AudioEngine::EffectSettings current = Playlist::parseEffects(settings.value("effects/master").toString());
+
+    // Изменения слышны сразу; отмена возвращает прежнюю цепочку
+    EffectsDialog dialog(tr("Master Effects"), current, this);
+    connect(&dialog, &EffectsDialog::settingsChanged, m_audioEngine, &AudioEngine::setMasterEffects);
+    if (dialog.exec() == QDialog::Accepted) {
+        settings.setValue("effects/master", Playlist::formatEffects(dialog.getSettings()));
+        m_audioEngine->setMasterEffects(dialog.getSettings());
+    } else {
+        m_audioEngine->setMasterEffects(current);
+    }
+}
+
+void MainWindow::onMicEffects()
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    const AudioEngine::EffectSettings current = Playlist::parseEffects(settings.value("effects/mic").toString());
+
+    EffectsDialog dialog(tr("Microphone Effects"), current, this);
+    connect(&dialog, &EffectsDialog::settingsChanged, m_audioEngine, &AudioEngine::setMicEffects);
+    if (dialog.exec() == QDialog::Accepted) {
+        settings.setValue("effects/mic", Playlist::formatEffects(dialog.getSettings()));
+        m_audioEngine->setMicEffects(dialog.getSettings());
+    } else {
+        m_audioEngine->setMicEffects(current);
+    }
+}
+
+void MainWindow::onRecordToggled(bool checked)
+{
+    if (!checked) {
+        m_audioEngine->stopRecording(); // Хвост дописывается в фоне, итог придет в recordingSaved
+        return;
+    }
+    const QString filePath = EngineSettings::captureFilePath("Recording");
+    if (!m_audioEngine->startRecording(filePath)) {
+        const QSignalBlocker blocker(m_recordAction);
+        m_recordAction->setChecked(m_audioEngine->isRecording());
+        m_statusLabel->setText(tr("Failed to start recording"));
+        return;
+    }
+    m_statusLabel->setText(tr("Recording to %1").arg(QDir::toNativeSeparators(filePath)));
+}
+
+void MainWindow::onSaveReplay()
+{
+    const QString filePath = EngineSettings::captureFilePath("Replay");
+    if (!m_audioEngine->saveReplay(filePath)) {
+        m_statusLabel->setText(tr("Replay buffer is off or empty"));
+        return;
     }
+    m_statusLabel->setText(tr("Saving replay..."));
+}
+
+void MainWindow::onDiagnosticsClicked()
+{
+    // Немодальное окно: панель остается открытой рядом с плейлистом во время эфира
+    if (!m_diagnosticsDialog) {
+        m_diagnosticsDialog = new DiagnosticsDialog(m_audioEngine, this);
+    }
+    m_diagnosticsDialog->show();
+    m_diagnosticsDialog->raise();
+    m_diagnosticsDialog->activateWindow();
 }
 
 void MainWindow::onMoveTrackUp()
@@ -589,10 +1270,12 @@ void MainWindow::onSoundItemChanged(QTableWidgetItem *item)
     if (file.rename(newFilePath)) {
         // Успешно переименовали файл, теперь обновим путь в данных ячейки
         item->setData(Qt::UserRole, newFilePath);
-        qDebug() << "Renamed" << oldFilePath << "to" << newFilePath;
+        updateSearchEntry(item);
+        OSD_LOG_DEBUG(Ui, "Renamed from=\"%s\" to=\"%s\"", qUtf8Printable(oldFilePath), qUtf8Printable(newFilePath));
     } else {
         // Ошибка переименования, вернем старое имя в ячейку
-        qWarning() << "Failed to rename" << oldFilePath << "to" << newFilePath;
+        OSD_LOG_WARNING(Ui, "Failed to rename from=\"%s\" to=\"%s\"", qUtf8Printable(oldFilePath),
+                        qUtf8Printable(newFilePath));
         QMessageBox::warning(this, tr("Rename Error"), tr("Could not rename the file on disk."));
         item->setText(oldFileInfo.fileName()); // Откат имени в таблице
     }
@@ -606,10 +1289,59 @@ void MainWindow::onImportTriggered()
         libraryPath,
         tr("Audio Files (*.mp3 *.wav *.flac *.ogg)"));
 
-    for (const QString &fileName : fileNames) {
-        if (!fileName.isEmpty()) {
-            addSoundFile(fileName);
-        }
+    startImport(fileNames);
+}
+
+void MainWindow::startImport(const QStringList& paths)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+    m_importPipeline->start(paths, m_activeBank);
+    OSD_LOG_INFO(Ui, "Import started paths=%d bank=%d", static_cast<int>(paths.size()), m_activeBank);
+}
+
+void MainWindow::onImportProgress(int processed, int total)
+{
+    m_importProgressBar->setMaximum(qMax(total, 1));
+    m_importProgressBar->setValue(processed);
+    m_importProgressBar->show();
+    m_importCancelButton->show();
+}
+
+void MainWindow::onImportBatch(const QList<ImportPipeline::Item>& items)
+{
+    // Строки пачки вставляются без перерисовки, номера пересчитываются один раз на пачку
+    QList<QTableWidget*> tables;
+    for (const Bank& bank : m_banks) {
+        tables.append(bank.table);
+        bank.table->setUpdatesEnabled(false);
+    }
+    for (const ImportPipeline::Item& item : items) {
+        insertSoundRow(item.target, item.filePath, AudioEngine::PlaybackRegion(), AudioEngine::VoiceParams(),
+                       &item.info);
+    }
+    updateIndexes();
+    for (QTableWidget* table : tables) {
+        table->setUpdatesEnabled(true);
+    }
+}
+
+void MainWindow::onImportFinished(int imported, int skipped, bool isCancelled)
+{
+    m_importProgressBar->hide();
+    m_importCancelButton->hide();
+    const QString message = tr("%n file(s) imported", "", imported);
+    if (isCancelled) {
+        m_statusLabel->setText(tr("Import cancelled: %1").arg(message));
+    } else if (skipped > 0) {
+        m_statusLabel->setText(tr("%1, %n unsupported skipped", "", skipped).arg(message));
+    } else {
+        m_statusLabel->setText(message);
+    }
+    if (imported > 0) {
+        armActiveBank();
+        m_primeTimer->start();
     }
 }
 
@@ -634,26 +1366,32 @@ void MainWindow::onSaveAsTriggered()
 
 void MainWindow::savePlaylist(const QString& fileName)
 {
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Error"), tr("Could not save playlist file."));
-        return;
-    }
-
-    QTextStream out(&file);
-    for (int i = 0; i < m_soundTableWidget->rowCount(); ++i) {
-        QTableWidgetItem *item = m_soundTableWidget->item(i, 1); // Колонка "Tag"
-        if (item) {
-            QString filePath = item->data(Qt::UserRole).toString();
-            if (!filePath.isEmpty()) {
-                out << filePath << "\n";
+    QList<PlaylistEntry> entries;
+    for (int bank = 0; bank < m_banks.size(); ++bank) {
+        QTableWidget *table = m_banks[bank].table;
+        for (int i = 0; i < table->rowCount(); ++i) {
+            QTableWidgetItem *item = table->item(i, 1); // Колонка "Tag"
+            if (item) {
+                PlaylistEntry entry;
+                entry.filePath = item->data(Qt::UserRole).toString();
+                entry.bank = bank;
+                entry.region = item->data(RegionRole).value<AudioEngine::PlaybackRegion>();
+                entry.params = item->data(ParamsRole).value<AudioEngine::VoiceParams>();
+                if (!entry.filePath.isEmpty()) {
+                    entries.append(entry);
+                }
             }
         }
     }
 
-    file.close();
+    if (!Playlist::save(fileName, entries)) {
+        QMessageBox::warning(this, tr("Error"), tr("Could not save playlist file."));
+        return;
+    }
+
     m_currentPlaylistPath = fileName;
-    qDebug() << "Playlist saved to" << m_currentPlaylistPath;
+    QSettings("pavel-kruhlei", "OpenSoundDeck").setValue("playlist/last", fileName);
+    OSD_LOG_INFO(Library, "Playlist saved path=\"%s\"", qUtf8Printable(m_currentPlaylistPath));
 }
 void MainWindow::onOfflineManualClicked()
 {
@@ -684,12 +1422,13 @@ void MainWindow::onKeepOnTopToggled(bool checked)
 
 void MainWindow::onPlayClicked()
 {
-    if (m_audioEngine->getPlaybackState() == AudioEngine::Paused) {
-        m_audioEngine->resume();
+    if (m_audioEngine->getPlaybackState(m_activeBank) == AudioEngine::Paused) {
+        m_audioEngine->resume(m_activeBank);
+        updatePlaybackButtons(m_audioEngine->getPlaybackState(m_activeBank) == AudioEngine::Playing);
     } else {
         const int currentRow = m_soundTableWidget->currentRow();
         if (currentRow < 0 || m_soundTableWidget->rowCount() == 0) {
-            qDebug() << "No sound selected to play.";
+            OSD_LOG_DEBUG(Ui, "No sound selected to play");
             return;
         }
 
@@ -699,86 +1438,163 @@ void MainWindow::onPlayClicked()
 
 void MainWindow::onPauseClicked()
 {
-    m_audioEngine->pause();
+    m_audioEngine->pause(m_activeBank);
     updatePlaybackButtons(false);
 }
 
 void MainWindow::onNextClicked()
 {
-    const int rowCount = m_soundTableWidget->rowCount();
-    if (rowCount == 0) {
+    if (m_soundTableWidget->rowCount() == 0) {
         return;
     }
 
-    int nextRow = m_soundTableWidget->currentRow() + 1;
-    if (nextRow >= rowCount) {
-        nextRow = 0; // Зацикливание на начало списка
-    }
-
-    playTrackAtRow(nextRow);
+    playTrackAtRow(adjacentRow(m_soundTableWidget, m_soundTableWidget->currentRow(), 1));
 }
 
 void MainWindow::onPrevClicked()
 {
-    const int rowCount = m_soundTableWidget->rowCount();
-    if (rowCount == 0) {
+    if (m_soundTableWidget->rowCount() == 0) {
         return;
     }
 
-    int prevRow = m_soundTableWidget->currentRow() - 1;
-    if (prevRow < 0) {
-        prevRow = rowCount - 1; // Зацикливание на конец списка
-    }
-
-    playTrackAtRow(prevRow);
+    playTrackAtRow(adjacentRow(m_soundTableWidget, qMax(m_soundTableWidget->currentRow(), 0), -1));
 }
 
-void MainWindow::playTrackAtRow(int row)
+void MainWindow::playTrackAtRow(int row, Qt::KeyboardModifiers extraModifiers, float gain, qint64 eventTimeNs, int bank)
 {
-    if (row < 0 || row >= m_soundTableWidget->rowCount()) {
-        qDebug() << "Invalid row index to play:" << row;
+    if (bank < 0) {
+        bank = m_activeBank;
+    }
+    if (bank >= m_banks.size() || row < 0 || row >= m_banks[bank].table->rowCount()) {
+        OSD_LOG_DEBUG(Ui, "Invalid row to play row=%d bank=%d", row, bank);
         return;
     }
+    QTableWidget *table = m_banks[bank].table;
 
-    QTableWidgetItem *tagItem = m_soundTableWidget->item(row, 1);
+    QTableWidgetItem *tagItem = table->item(row, 1);
     if (!tagItem) {
-        qDebug() << "Invalid tag item at row" << row;
+        OSD_LOG_DEBUG(Ui, "Invalid tag item row=%d", row);
         return;
     }
 
     const QString filePath = tagItem->data(Qt::UserRole).toString();
     if (filePath.isEmpty()) {
-        qDebug() << "No file path associated with row" << row;
+        OSD_LOG_DEBUG(Ui, "No file path associated row=%d", row);
         return;
     }
 
-    m_soundTableWidget->setCurrentCell(row, 0); // Выделяем новую строку
-    m_audioEngine->playSound(filePath);
-    updatePlaybackButtons(true);
+    // Вариант хоткея с модификатором сдвигает тон или темп относительно настроек трека
+    AudioEngine::VoiceParams params = tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>();
+    if (extraModifiers & Qt::ShiftModifier) {
+        params.pitchSemitones += m_shiftPitchSemitones;
+    }
+    if (extraModifiers & Qt::ControlModifier) {
+        params.tempo *= m_controlTempoFactor;
+    }
+    if (extraModifiers & Qt::AltModifier) {
+        params.pitchSemitones += m_altPitchSemitones;
+    }
+    params.gain *= gain;
+
+    m_audioEngine->playSound(filePath, tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>(), params,
+                             eventTimeNs, bank);
+    markTrackStarted(row, bank);
 }
 
-void MainWindow::onPlaybackFinished()
+void MainWindow::markTrackStarted(int row, int bank)
 {
-    if (m_isRepeatEnabled) {
-        // Если включен повтор, просто проигрываем текущий трек заново
-        playTrackAtRow(m_soundTableWidget->currentRow());
-    } else {
-        // Иначе, останавливаем воспроизведение
-        updatePlaybackButtons(false);
-        m_playAction->setEnabled(true); // Но кнопка Play должна быть доступна
-        m_progressSlider->setValue(0);
+    if (bank < 0 || bank >= m_banks.size() || row < 0 || row >= m_banks[bank].table->rowCount()) {
+        return;
+    }
+    QTableWidgetItem *tagItem = m_banks[bank].table->item(row, 1);
+    if (!tagItem) {
+        return;
     }
+    m_banks[bank].table->setCurrentCell(row, 0); // Выделяем новую строку
+    m_banks[bank].queuedPath.clear(); // Ручной запуск сбросил очередь деки
+    rememberPlayed(bank, tagItem->data(Qt::UserRole).toString());
+    queueNextTrack(bank);
+    if (bank == m_activeBank) {
+        updatePlaybackButtons(m_audioEngine->getPlaybackState(bank) == AudioEngine::Playing);
+    }
+}
+
+void MainWindow::updateMidiTracks()
+{
+    // Нота выбирает строку активного банка; строки без файла остаются пустыми, чтобы номера совпадали
+    QList<PlaylistEntry> tracks;
+    for (int row = 0; row < m_soundTableWidget->rowCount(); ++row) {
+        PlaylistEntry entry;
+        entry.bank = m_activeBank;
+        if (QTableWidgetItem *tagItem = m_soundTableWidget->item(row, 1)) {
+            entry.filePath = tagItem->data(Qt::UserRole).toString();
+            entry.region = tagItem->data(RegionRole).value<AudioEngine::PlaybackRegion>();
+            entry.params = tagItem->data(ParamsRole).value<AudioEngine::VoiceParams>();
+        }
+        tracks.append(entry);
+    }
+    m_midiInput->setTracks(tracks);
+}
+
+void MainWindow::onPlaybackFinished(int deck)
+{
+    // Повтор обрабатывается движком без остановки, сюда попадаем только по окончании трека
+    // или когда его заглушил трек той же группы на другом банке
+    m_banks[deck].queuedPath.clear();
+    if (deck != m_activeBank) {
+        return;
+    }
+    updatePlaybackButtons(false);
+    m_playAction->setEnabled(true); // Но кнопка Play должна быть доступна
+    m_progressSlider->setValue(0);
+}
+
+void MainWindow::onQueueAdvanced(int deck)
+{
+    // Дека уже играет следующий трек: выделяем его строку (ближайшую после текущей, если
+    // файл стоит в банке несколько раз) и ставим в очередь следующий
+    Bank& bank = m_banks[deck];
+    const int rowCount = bank.table->rowCount();
+    const int currentRow = qMax(bank.table->currentRow(), 0);
+    for (int step = 1; step <= rowCount; ++step) {
+        const int row = (currentRow + step) % rowCount;
+        QTableWidgetItem *tagItem = bank.table->item(row, 1);
+        if (tagItem && tagItem->data(Qt::UserRole).toString() == bank.queuedPath) {
+            bank.table->setCurrentCell(row, 0);
+            break;
+        }
+    }
+    if (!bank.queuedPath.isEmpty()) {
+        rememberPlayed(deck, bank.queuedPath);
+    }
+    OSD_LOG_DEBUG(Ui, "Queue advanced bank=%d path=\"%s\"", deck, qUtf8Printable(bank.queuedPath));
+    queueNextTrack(deck);
+}
+
+void MainWindow::onCueReached(int deck, int cueIndex)
+{
+    m_statusLabel->setText(tr("Bank %1: cue %2").arg(deck + 1).arg(cueIndex + 1));
 }
 
 void MainWindow::onStopClicked()
 {
-    m_audioEngine->stopAllSounds(); // <-- ИСПОЛЬЗУЕМ НАШ ДВИЖОК
+    m_audioEngine->stopDeck(m_activeBank);
     updatePlaybackButtons(false); // Обновляем UI немедленно
-    qDebug() << "Stop command sent to audio engine.";
+    m_progressSlider->setValue(0);
+}
+
+void MainWindow::onStopAllClicked()
+{
+    m_audioEngine->stopAllSounds();
+    updatePlaybackButtons(false);
+    m_progressSlider->setValue(0);
 }
 
-void MainWindow::onPositionChanged(ma_uint64 position)
+void MainWindow::onPositionChanged(int deck, ma_uint64 position)
 {
+    if (deck != m_activeBank) {
+        return;
+    }
     // Блокируем сигналы, чтобы избежать рекурсивного вызова onProgressSliderMoved
     m_progressSlider->blockSignals(true);
     m_progressSlider->setValue(position);
@@ -787,7 +1603,7 @@ void MainWindow::onPositionChanged(ma_uint64 position)
 
 void MainWindow::onProgressSliderMoved(int position)
 {
-    m_audioEngine->seek(position);
+    m_audioEngine->seek(position, m_activeBank);
 }
 
 void MainWindow::onHeadphonesVolumeChanged(int value)
@@ -805,8 +1621,7 @@ void MainWindow::onHeadphonesVolumeChanged(int value)
 
 void MainWindow::onMicVolumeChanged(int value)
 {
-    // TODO: Реализовать громкость для микса в AudioEngine
-    qDebug() << "Mic volume changed to:" << value;
+    m_audioEngine->setMicVolume(value / 100.0f);
     updateMicVolumeIcon(value);
 
     if (value > 0) {
@@ -854,30 +1669,77 @@ void MainWindow::updateMicVolumeIcon(int value)
     }
 }
 
-void MainWindow::onHeadphonesToggle(bool checked) { qDebug() << "Headphones output" << (checked ? "ENABLED" : "DISABLED"); }
-void MainWindow::onAllToggle(bool checked) { qDebug() << "All (mic) output" << (checked ? "ENABLED" : "DISABLED"); }
+void MainWindow::onHeadphonesToggle(bool checked) { OSD_LOG_DEBUG(Ui, "Headphones output enabled=%d", checked ? 1 : 0); }
+void MainWindow::onAllToggle(bool checked) { OSD_LOG_DEBUG(Ui, "All (mic) output enabled=%d", checked ? 1 : 0); }
 void MainWindow::onRepeatToggle(bool checked)
 {
-    m_isRepeatEnabled = checked;
-    qDebug() << "Repeat" << (checked ? "ON" : "OFF");
+    m_banks[m_activeBank].isRepeatEnabled = checked;
+    m_audioEngine->setRepeatEnabled(checked, m_activeBank);
+    OSD_LOG_DEBUG(Ui, "Repeat bank=%d enabled=%d", m_activeBank, checked ? 1 : 0);
+}
+
+void MainWindow::onQueueToggle(bool checked)
+{
+    m_banks[m_activeBank].isQueueEnabled = checked;
+    queueNextTrack(m_activeBank); // Играющий трек сразу получает продолжение или теряет его
+    OSD_LOG_DEBUG(Ui, "Continuous playback bank=%d enabled=%d", m_activeBank, checked ? 1 : 0);
 }
 
-void MainWindow::onDurationChanged(qint64 duration)
+void MainWindow::onShuffleToggle(bool checked)
 {
-    if (duration > 0) {
-        for (int i = m_soundTableWidget->rowCount() - 1; i >= 0; --i) {
-            QTableWidgetItem* item = m_soundTableWidget->item(i, 2); 
-            if (item && item->text() == tr("Loading...")) {
-                int seconds = duration / 1000;
-                int minutes = seconds / 60;
-                seconds %= 60;
-                const QString formattedDuration = QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
-                item->setText(formattedDuration);
-                qDebug() << "Duration found:" << formattedDuration;
-                break;
+    m_banks[m_activeBank].isShuffleEnabled = checked;
+    queueNextTrack(m_activeBank);
+    OSD_LOG_DEBUG(Ui, "Shuffle bank=%d enabled=%d", m_activeBank, checked ? 1 : 0);
+}
+
+void MainWindow::onMediaProbed(const QString& filePath, const MediaProbe::MediaInfo& info)
+{
+    // Один файл может стоять в нескольких строках и банках (дубликаты), а строки могли переместиться
+    for (const Bank& bank : m_banks) {
+        for (int i = 0; i < bank.table->rowCount(); ++i) {
+            QTableWidgetItem* tagItem = bank.table->item(i, 1);
+            QTableWidgetItem* durationItem = bank.table->item(i, 2);
+            if (tagItem && durationItem && tagItem->data(Qt::UserRole).toString() == filePath &&
+                durationItem->text() == tr("Loading...")) {
+                const QSignalBlocker blocker(bank.table);
+                applyMediaInfo(tagItem, durationItem, filePath, info);
+                if (!tagItem->data(TagsRole).toString().isEmpty()) {
+                    updateSearchEntry(tagItem);
+                }
             }
         }
     }
+    OSD_LOG_DEBUG(Ui, "Duration found duration_ms=%lld path=\"%s\"", static_cast<long long>(info.durationMillis),
+                  qUtf8Printable(filePath));
+}
+
+void MainWindow::applyMediaInfo(QTableWidgetItem* tagItem, QTableWidgetItem* durationItem, const QString& filePath,
+                                const MediaProbe::MediaInfo& info)
+{
+    QString formattedDuration = tr("Unknown");
+    if (info.durationMillis >= 0) {
+        const qint64 totalSeconds = info.durationMillis / 1000;
+        formattedDuration = QString("%1:%2").arg(totalSeconds / 60).arg(totalSeconds % 60, 2, 10, QChar('0'));
+    }
+    QStringList tags;
+    if (!info.artist.isEmpty()) {
+        tags.append(info.artist);
+    }
+    if (!info.title.isEmpty()) {
+        tags.append(info.title);
+    }
+    if (!info.album.isEmpty()) {
+        tags.append(info.album);
+    }
+
+    durationItem->setText(formattedDuration);
+    tagItem->setToolTip(tags.isEmpty() ? filePath : tags.join(QString::fromUtf8(" — ")) + "\n" + filePath);
+    if (!tags.isEmpty()) {
+        tagItem->setData(TagsRole, tags.join(' '));
+    }
+    if (!info.isPlayable) {
+        durationItem->setToolTip(tr("This format cannot be played"));
+    }
 }
 
 void MainWindow::updatePlaybackButtons(bool isPlaying)
@@ -899,11 +1761,11 @@ void MainWindow::onAssignHotkey()
         QKeySequence hotkey = dialog.getHotkey();
 
         // Сначала отменяем регистрацию старого хоткея для этой строки, если он был
-        m_hotkeyManager->unregisterHotkey(currentRow);
+        m_hotkeyManager->unregisterHotkey(hotkeyTarget(m_activeBank, currentRow));
 
         if (!hotkey.isEmpty()) {
             // Регистрируем новый хоткей
-            if (m_hotkeyManager->registerHotkey(hotkey, currentRow)) {
+            if (m_hotkeyManager->registerHotkey(hotkey, hotkeyTarget(m_activeBank, currentRow))) {
                 m_soundTableWidget->item(currentRow, 3)->setText(hotkey.toString(QKeySequence::NativeText));
             } else {
                 QMessageBox::warning(this, tr("Hotkey Error"), tr("Failed to register hotkey. It might be already in use by another application."));
@@ -913,9 +1775,301 @@ void MainWindow::onAssignHotkey()
     }
 }
 
+void MainWindow::applyAudioSettings()
+{
+    if (EngineSettings::apply(m_audioEngine)) {
+        // Прогреваем хранилище: сначала активный банк целиком, затем остальные треки плейлиста
+        armActiveBank();
+        for (const Bank& bank : m_banks) {
+            for (int i = 0; i < bank.table->rowCount(); ++i) {
+                QTableWidgetItem *tagItem = bank.table->item(i, 1);
+                if (tagItem) {
+                    m_audioEngine->preloadSound(tagItem->data(Qt::UserRole).toString());
+                }
+            }
+        }
+    }
+}
+
+void MainWindow::applyMidiSettings()
+{
+    EngineSettings::applyMidi(m_midiInput);
+}
+
+void MainWindow::applyLibrarySettings()
+{
+    const QString libraryPath = QFileInfo(getLibraryPath()).canonicalFilePath();
+    if (!libraryPath.isEmpty() && libraryPath == m_libraryWatcher->rootPath()) {
+        return;
+    }
+    m_libraryWatcher->start(getLibraryPath());
+}
+
+void MainWindow::onLibraryChanged(const LibraryWatcher::Changes& changes)
+{
+    const QSet<QString> addedPaths(changes.added.cbegin(), changes.added.cend());
+    QSet<QString> tablePaths;
+    bool isActiveBankChanged = false;
+
+    for (int bank = 0; bank < m_banks.size(); ++bank) {
+        QTableWidget *table = m_banks[bank].table;
+        // Меняем данные строк без сигналов: иначе onSoundItemChanged переименует файл на диске еще раз
+        const QSignalBlocker blocker(table);
+
+        for (int row = 0; row < table->rowCount(); ++row) {
+            QTableWidgetItem *tagItem = table->item(row, 1);
+            if (!tagItem) {
+                continue;
+            }
+            QString filePath = tagItem->data(Qt::UserRole).toString();
+            const QString originalPath = filePath;
+            const bool wasMissing = tagItem->data(MissingRole).toBool();
+
+            const QString renamedPath = findAffectedPath(filePath, changes.renamed);
+            if (!renamedPath.isEmpty()) {
+                m_audioEngine->forgetSound(filePath);
+                filePath = changes.renamed.value(renamedPath) + filePath.mid(renamedPath.size());
+                tagItem->setData(Qt::UserRole, filePath);
+                tagItem->setText(QFileInfo(filePath).fileName());
+                updateSearchEntry(tagItem);
+                m_audioEngine->preloadSound(filePath);
+            }
+
+            // После переполнения очереди событий проверяем файлы строк напрямую, а не дерево библиотеки
+            if (addedPaths.contains(filePath)) {
+                setTrackMissing(table, row, false);
+                reloadTrackFile(table, row); // Файл вернулся или перезаписан
+            } else if (changes.isOverflowed) {
+                setTrackMissing(table, row, !QFileInfo::exists(filePath));
+                if (wasMissing) {
+                    reloadTrackFile(table, row);
+                }
+            } else if (!findAffectedPath(filePath, changes.removed).isEmpty()) {
+                m_audioEngine->forgetSound(filePath);
+                setTrackMissing(table, row, true);
+            }
+            if (bank == m_activeBank &&
+                (filePath != originalPath || tagItem->data(MissingRole).toBool() != wasMissing)) {
+                isActiveBankChanged = true;
+            }
+            tablePaths.insert(filePath);
+        }
+    }
+
+    if (QSettings("pavel-kruhlei", "OpenSoundDeck").value("library/autoImport", false).toBool()) {
+        int importedCount = 0;
+        for (const QString& filePath : changes.added) {
+            if (!tablePaths.contains(filePath)) {
+                insertSoundRow(m_activeBank, filePath, AudioEngine::PlaybackRegion(), AudioEngine::VoiceParams());
+                ++importedCount;
+            }
+        }
+        if (importedCount > 0) {
+            updateIndexes();
+            isActiveBankChanged = true;
+            m_statusLabel->setText(tr("%n new file(s) added from the library", "", importedCount));
+        }
+    }
+
+    // Набор закрепленных клипов активного банка должен совпадать с его строками
+    if (isActiveBankChanged) {
+        armActiveBank();
+    }
+}
+
+void MainWindow::setTrackMissing(QTableWidget* table, int row, bool isMissing)
+{
+    QTableWidgetItem *tagItem = table->item(row, 1);
+    QTableWidgetItem *durationItem = table->item(row, 2);
+    if (!tagItem || !durationItem || tagItem->data(MissingRole).toBool() == isMissing) {
+        return;
+    }
+    tagItem->setData(MissingRole, isMissing);
+    tagItem->setForeground(isMissing ? palette().brush(QPalette::Disabled, QPalette::Text) : QBrush());
+    if (isMissing) {
+        durationItem->setText(tr("Missing"));
+    }
+}
+
+void MainWindow::reloadTrackFile(QTableWidget* table, int row)
+{
+    QTableWidgetItem *tagItem = table->item(row, 1);
+    QTableWidgetItem *durationItem = table->item(row, 2);
+    if (!tagItem || !durationItem || tagItem->data(MissingRole).toBool()) {
+        return;
+    }
+    // Содержимое могло измениться: заново читаем длительность и клип в памяти
+    const QString filePath = tagItem->data(Qt::UserRole).toString();
+    m_audioEngine->forgetSound(filePath);
+    m_audioEngine->preloadSound(filePath);
+    durationItem->setText(tr("Loading..."));
+    probeMedia(filePath);
+}
+
+void MainWindow::updateSearchEntry(QTableWidgetItem* tagItem)
+{
+    // Ищется имя файла, теги и папка внутри библиотеки. Общий для всех треков путь к библиотеке
+    // в индекс не попадает: его триграммы были бы у каждой записи и только замедляли поиск
+    const QFileInfo fileInfo(tagItem->data(Qt::UserRole).toString());
+    QString folder = QDir(getLibraryPath()).relativeFilePath(fileInfo.absolutePath());
+    if (folder.startsWith("..") || QDir::isAbsolutePath(folder)) {
+        folder = fileInfo.dir().dirName();
+    }
+    const QString text = QString("%1 %2 %3").arg(fileInfo.fileName(), tagItem->data(TagsRole).toString(), folder)
+                             .toCaseFolded();
+
+    const QVariant searchId = tagItem->data(SearchIdRole);
+    if (searchId.isValid()) {
+        m_searchIndex.update(searchId.toUInt(), toSearchText(text));
+    } else {
+        const SearchIndex::Id id = m_searchIndex.add(toSearchText(text));
+        tagItem->setData(SearchIdRole, id);
+        if (id >= m_searchItems.size()) {
+            m_searchItems.resize(id + 1, nullptr);
+        }
+        m_searchItems[id] = tagItem;
+        m_isSearchViewStale = true; // Новая строка видима, пока ее не пройдет фильтр
+    }
+    if (!m_searchLineEdit->text().isEmpty()) {
+        m_searchTimer->start(0);
+    }
+}
+
+void MainWindow::forgetSearchEntry(int row)
+{
+    QTableWidgetItem *tagItem = m_soundTableWidget->item(row, 1);
+    if (tagItem && tagItem->data(SearchIdRole).isValid()) {
+        const SearchIndex::Id id = tagItem->data(SearchIdRole).toUInt();
+        m_searchIndex.remove(id);
+        m_searchItems[id] = nullptr; // Ячейка удаляется вместе со строкой
+    }
+}
+
+void MainWindow::clearSearchEntries()
+{
+    m_searchIndex.clear();
+    m_searchItems.clear();
+    m_searchMatches.clear();
+    m_isSearchViewStale = true;
+}
+
+void MainWindow::applySearchFilter()
+{
+    m_searchTimer->stop();
+    const QString query = m_searchLineEdit->text().trimmed().toCaseFolded();
+    const std::vector<SearchIndex::Id> best = m_searchIndex.search(toSearchText(query), 1);
+    const bool isFiltering = m_searchIndex.isFiltering();
+    std::vector<SearchIndex::Id> matches;
+    m_searchIndex.collectMatches(&matches);
+
+    // Видимость меняется только у строк, которых она касается: перерисовка и пересчет
+    // геометрии таблицы стоят дороже самого поиска. Обычно это разница совпадений с прошлым
+    // проходом; все строки обходятся лишь после их изменения, смены банка и при включении
+    // или снятии фильтра
+    if (m_isSearchViewStale || isFiltering != m_isSearchFiltering) {
+        m_searchMatchCount = 0;
+        for (int row = 0; row < m_soundTableWidget->rowCount(); ++row) {
+            QTableWidgetItem *tagItem = m_soundTableWidget->item(row, 1);
+            if (!tagItem) {
+                continue;
+            }
+            const bool isHidden = !m_searchIndex.matches(tagItem->data(SearchIdRole).toUInt());
+            if (m_soundTableWidget->isRowHidden(row) != isHidden) {
+                m_soundTableWidget->setRowHidden(row, isHidden);
+            }
+            if (!isHidden) {
+                ++m_searchMatchCount;
+            }
+        }
+        m_isSearchViewStale = false;
+    } else if (isFiltering) {
+        std::vector<SearchIndex::Id> changed;
+        std::set_symmetric_difference(m_searchMatches.begin(), m_searchMatches.end(), matches.begin(), matches.end(),
+                                      std::back_inserter(changed));
+        for (SearchIndex::Id id : changed) {
+            // Индекс общий для всех банков, строки других банков догонит полный проход
+            QTableWidgetItem *tagItem = id < m_searchItems.size() ? m_searchItems[id] : nullptr;
+            if (!tagItem || tagItem->tableWidget() != m_soundTableWidget) {
+                continue;
+            }
+            const int row = tagItem->row();
+            const bool isHidden = !m_searchIndex.matches(id);
+            if (m_soundTableWidget->isRowHidden(row) != isHidden) {
+                m_soundTableWidget->setRowHidden(row, isHidden);
+                m_searchMatchCount += isHidden ? -1 : 1;
+            }
+        }
+    }
+    m_searchMatches.swap(matches);
+    m_isSearchFiltering = isFiltering;
+
+    m_searchBestRow = -1;
+    if (!best.empty() && best.front() < m_searchItems.size()) {
+        const QTableWidgetItem *tagItem = m_searchItems[best.front()];
+        if (tagItem && tagItem->tableWidget() == m_soundTableWidget) {
+            m_searchBestRow = tagItem->row();
+        }
+    }
+
+    if (query.isEmpty()) {
+        m_statusLabel->setText(tr("Ready"));
+        return;
+    }
+    if (m_searchBestRow >= 0) {
+        m_soundTableWidget->setCurrentCell(m_searchBestRow, 1);
+        m_soundTableWidget->scrollToItem(m_soundTableWidget->item(m_searchBestRow, 1));
+    }
+    m_statusLabel->setText(tr("%n match(es)", "", m_searchMatchCount));
+}
+
+void MainWindow::applyHotkeySettings()
+{
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
+    m_shiftPitchSemitones = settings.value("hotkeys/shiftPitchSemitones", 12.0).toFloat();
+    m_controlTempoFactor = settings.value("hotkeys/controlTempoPercent", 150).toInt() / 100.0f;
+    m_altPitchSemitones = settings.value("hotkeys/altPitchSemitones", -12.0).toFloat();
+
+    const QKeySequence replayHotkey =
+        QKeySequence::fromString(settings.value("capture/replayHotkey").toString(), QKeySequence::PortableText);
+    if (replayHotkey != m_replayHotkey) {
+        m_hotkeyManager->unregisterHotkey(kSaveReplayHotkeyTarget);
+        if (!replayHotkey.isEmpty() && !m_hotkeyManager->registerHotkey(replayHotkey, kSaveReplayHotkeyTarget)) {
+            OSD_LOG_WARNING(Ui, "Failed to register replay hotkey \"%s\"", qUtf8Printable(replayHotkey.toString()));
+        }
+        m_replayHotkey = replayHotkey;
+    }
+
+    const Qt::KeyboardModifiers variants = settings.value("hotkeys/modifierVariants", false).toBool()
+        ? (Qt::ShiftModifier | Qt::ControlModifier | Qt::AltModifier)
+        : Qt::NoModifier;
+    if (variants == m_hotkeyManager->modifierVariants()) {
+        return;
+    }
+
+    // Варианты захватываются при регистрации, поэтому перерегистрируем назначенные хоткеи
+    m_hotkeyManager->setModifierVariants(variants);
+    for (int bank = 0; bank < m_banks.size(); ++bank) {
+        QTableWidget *table = m_banks[bank].table;
+        for (int row = 0; row < table->rowCount(); ++row) {
+            QTableWidgetItem *hotkeyItem = table->item(row, 3);
+            const QKeySequence hotkey = hotkeyItem && hotkeyItem->text() != "None"
+                ? QKeySequence::fromString(hotkeyItem->text(), QKeySequence::NativeText)
+                : QKeySequence();
+            if (!hotkey.isEmpty()) {
+                m_hotkeyManager->unregisterHotkey(hotkeyTarget(bank, row));
+                m_hotkeyManager->registerHotkey(hotkey, hotkeyTarget(bank, row));
+            }
+        }
+    }
+    if (!m_replayHotkey.isEmpty()) {
+        m_hotkeyManager->unregisterHotkey(kSaveReplayHotkeyTarget);
+        m_hotkeyManager->registerHotkey(m_replayHotkey, kSaveReplayHotkeyTarget);
+    }
+}
+
 QString MainWindow::getLibraryPath() const
 {
-    QSettings settings("kkrugley", "OpenSoundDeck");
+    QSettings settings("pavel-kruhlei", "OpenSoundDeck");
     QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::MusicLocation);
     return settings.value("library/path", defaultPath).toString();
 }
\ No newline at end of file
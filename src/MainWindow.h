@@ -22,10 +22,18 @@
 
 #include <QMainWindow>
 #include <QKeyEvent>
+#include <QKeySequence>
 #include "AudioEngine.h"
+#include "Playlist.h"
+#include "MediaProbe.h"
+#include "LibraryWatcher.h"
+#include "ImportPipeline.h"
+#include "SearchIndex.h"
 
 class GlobalHotkeyManager;
+class DiagnosticsDialog;
 class QTableWidget;
+class QTabWidget;
 class QTableWidgetItem;
 class QToolBar;
 class QAction;
@@ -34,12 +42,15 @@ class QDropEvent;
 class QKeyEvent;
 class QSlider;
 class QMenu;
+class QTimer;
 class QMenuBar;
 class QStatusBar;
 class QToolButton;
 class QLabel;
-class QMediaPlayer;
+class QLineEdit;
+class QProgressBar;
 class SettingsDialog;
+class MidiInput;
 
 class MainWindow : public QMainWindow
 {
@@ -67,6 +78,13 @@ private slots:
     void onMoveTrackUp();
     void onMoveTrackDown();
     void onAssignHotkey();
+    void onTrimTrack();
+    void onTrackEffects();
+    void onMasterEffects();
+    void onMicEffects();
+    void onRecordToggled(bool checked);
+    void onSaveReplay();
+    void onDiagnosticsClicked();
     void onSaveTriggered();
     void onSaveAsTriggered();
     void onSettingsClicked();
@@ -78,14 +96,19 @@ private slots:
     void onHeadphonesToggle(bool checked);
     void onAllToggle(bool checked);
     void onRepeatToggle(bool checked);
-    void onDurationChanged(qint64 duration);
+    void onQueueToggle(bool checked);
+    void onShuffleToggle(bool checked);
     void onHeadphonesMuteClicked(bool checked);
     void onMicMuteClicked(bool checked);
     void onAboutClicked();
     void onKeepOnTopToggled(bool checked);
     void onOfflineManualClicked();
-    void onPlaybackFinished();
-    void onPositionChanged(ma_uint64 position);
+    void onStopAllClicked();
+    void onBankChanged(int index);
+    void onPlaybackFinished(int deck);
+    void onQueueAdvanced(int deck);
+    void onPositionChanged(int deck, ma_uint64 position);
+    void onCueReached(int deck, int cueIndex);
 
 
 protected:
@@ -95,14 +118,54 @@ protected:
 
 private:
     void updateIndexes();
-    void addSoundFile(const QString& filePath);
-    void playTrackAtRow(int row);
+    void addSoundFile(const QString& filePath, const AudioEngine::PlaybackRegion& region = AudioEngine::PlaybackRegion(),
+                      const AudioEngine::VoiceParams& params = AudioEngine::VoiceParams());
+    // Как addSoundFile(), но без перенумерации: для пачек, после которых вызывается updateIndexes().
+    // pInfo — длительность и теги, уже прочитанные в фоне: строка заполняется сразу, без пробы
+    void insertSoundRow(int bank, const QString& filePath, const AudioEngine::PlaybackRegion& region,
+                        const AudioEngine::VoiceParams& params, const MediaProbe::MediaInfo* pInfo = nullptr);
+    // Файлы и папки целиком — через ImportPipeline в активный банк
+    void startImport(const QStringList& paths);
+    void onImportProgress(int processed, int total);
+    void onImportBatch(const QList<ImportPipeline::Item>& items);
+    void onImportFinished(int imported, int skipped, bool isCancelled);
+    // bank -1 — активный банк; трек играет на деке своего банка
+    void playTrackAtRow(int row, Qt::KeyboardModifiers extraModifiers = Qt::NoModifier,
+                        float gain = 1.0f, qint64 eventTimeNs = 0, int bank = -1);
+    void markTrackStarted(int row, int bank); // Выделение строки и очередь банка после запуска
+    void updateMidiTracks();
+    QWidget* createBankPage(int bank);
+    void armActiveBank();
+    void primeLikelySounds();
+    void updateMostUsedMenu();
+    int adjacentRow(const QTableWidget* table, int row, int direction) const;
+    // Непрерывное воспроизведение: следующий трек банка заранее встает в очередь деки
+    void queueNextTrack(int bank);
+    int shuffleRow(int bank) const;
+    void rememberPlayed(int bank, const QString& filePath);
+    int hotkeyTarget(int bank, int row) const;
     void updatePlaybackButtons(bool isPlaying);
     void savePlaylist(const QString& fileName);
+    void showPlaylist(const QString& fileName, const QList<PlaylistEntry>& entries);
+    void restoreLastPlaylist();
+    void probeMedia(const QString& filePath);
+    void onMediaProbed(const QString& filePath, const MediaProbe::MediaInfo& info);
+    void applyMediaInfo(QTableWidgetItem* tagItem, QTableWidgetItem* durationItem, const QString& filePath,
+                        const MediaProbe::MediaInfo& info);
     QString getLibraryPath() const;
+    void applyAudioSettings();
+    void applyHotkeySettings();
+    void applyMidiSettings();
+    void applyLibrarySettings();
+    void onLibraryChanged(const LibraryWatcher::Changes& changes);
+    void setTrackMissing(QTableWidget* table, int row, bool isMissing);
+    void reloadTrackFile(QTableWidget* table, int row);
+    void updateSearchEntry(QTableWidgetItem* tagItem);
+    void forgetSearchEntry(int row);
+    void clearSearchEntries();
+    void applySearchFilter();
     void updateHeadphonesVolumeIcon(int value);
     void updateMicVolumeIcon(int value);
-    bool m_isRepeatEnabled;
 
     // System Menu
     QMenuBar *m_menuBar;
@@ -111,6 +174,7 @@ private:
     QMenu *m_playMenu;
     QMenu *m_windowMenu;
     QMenu *m_helpMenu;
+    QMenu *m_mostUsedMenu;
 
     // File Actions
     QAction *m_newAction;
@@ -125,25 +189,63 @@ private:
     QAction *m_copyAction;
     QAction *m_settingsAction;
     QAction *m_pasteAction;
+    QAction *m_findAction;
 
     // Play Actions
     QAction *m_nextAction;
     QAction *m_prevAction;
+    QAction *m_masterEffectsAction;
+    QAction *m_micEffectsAction;
+    QAction *m_recordAction;
+    QAction *m_saveReplayAction;
 
     // Window Actions
     QAction *m_minimizeAction;
     QAction *m_fullscreenAction;
     QAction *m_keepOnTopAction;
+    QAction *m_diagnosticsAction;
+    DiagnosticsDialog *m_diagnosticsDialog = nullptr; // Создается при первом открытии и дальше копит историю
 
     //
 
+    // Банки: у каждого своя таблица, дека движка и громкость. m_soundTableWidget — таблица
+    // активного банка, с ней работают транспорт, меню и поиск
+    struct Bank {
+        QTableWidget* table;
+        QSlider* volumeSlider;
+        bool isRepeatEnabled;
+        ma_uint64 durationMillis;
+        bool isQueueEnabled = false;
+        bool isShuffleEnabled = false;
+        QString queuedPath;        // Трек в очереди деки; строку ищем по пути — их могли переставить
+        QStringList recentPaths;   // Недавно сыгранные: перемешивание их не повторяет
+    };
+    QTabWidget *m_bankTabWidget;
+    QList<Bank> m_banks;
+    int m_activeBank = 0;
     QTableWidget *m_soundTableWidget;
+    QLineEdit *m_searchLineEdit;
+
+    // Поиск по имени, тегам и папке: строки не пересоздаются, а только скрываются
+    SearchIndex m_searchIndex;
+    QTimer *m_searchTimer; // Склеивает обновления индекса (длительности, переименования) в один проход
+    int m_searchBestRow = -1;
+    std::vector<QTableWidgetItem*> m_searchItems;  // Ячейка тегов по id записи индекса
+    std::vector<SearchIndex::Id> m_searchMatches;  // Совпадения прошлого прохода по возрастанию id
+    int m_searchMatchCount = 0;                    // Видимых строк активного банка
+    bool m_isSearchFiltering = false;
+    bool m_isSearchViewStale = true;               // Строки добавлены, удалены, сдвинуты или сменился банк
+
+    // Декодеры, открытые заранее: выделенная строка, соседи для Next/Prev и самые частые треки
+    QTimer *m_primeTimer; // Склеивает быстрое листание строк в одну подготовку
+    QTimer *m_midiTracksTimer; // Склеивает правки активного банка в одну таблицу для MidiInput
 
     // Sound Panel
     QToolBar *m_playbackToolBar;
     QAction *m_playAction;
     QAction *m_pauseAction;
     QAction *m_stopAction;
+    QAction *m_stopAllAction;
     QSlider *m_progressSlider;
     QSlider *m_headphonesVolumeSlider;
     QToolButton *m_headphonesMuteButton;
@@ -156,7 +258,11 @@ private:
     QToolButton *m_headphonesButton;
     QToolButton *m_allButton;
     QToolButton *m_repeatButton;
+    QToolButton *m_queueButton;
+    QToolButton *m_shuffleButton;
     QLabel *m_statusLabel;
+    QProgressBar *m_importProgressBar;
+    QToolButton *m_importCancelButton;
     // 
     
     // Help Actions
@@ -164,14 +270,22 @@ private:
     QAction *m_offlineManualAction;
     QAction *m_aboutQtAction;
 
-    QMediaPlayer *m_metaDataReader;
     AudioEngine *m_audioEngine;
 
     // Playlist
     QString m_currentPlaylistPath;
+    LibraryWatcher* m_libraryWatcher;
+    ImportPipeline* m_importPipeline;
 
     // Hotkeys
     GlobalHotkeyManager* m_hotkeyManager;
+    MidiInput* m_midiInput;
+    QKeySequence m_replayHotkey; // Зарегистрированный глобальный хоткей Save Replay
+
+    // Сдвиги для вариантов хоткеев с модификаторами
+    float m_shiftPitchSemitones = 12.0f;
+    float m_controlTempoFactor = 1.5f;
+    float m_altPitchSemitones = -12.0f;
 
     // Volume state
     int m_headphonesVolume;
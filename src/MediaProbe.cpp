@@ -0,0 +1,343 @@
+// src/MediaProbe.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MediaProbe.h"
+#include "miniaudio.h"
+#include <QFile>
+#include <QByteArray>
+#include <algorithm>
+
+namespace {
+
+// Теги лежат в начале файла; обложки и прочие большие кадры дальше этого не читаем
+constexpr qint64 kTagScanBytes = 256 * 1024;
+// Последняя страница Ogg (с итоговой granule position) не длиннее 64 КБ
+constexpr qint64 kOggTailBytes = 64 * 1024;
+
+quint32 readUInt16LE(const char* p)
+{
+    return static_cast<quint32>(static_cast<uchar>(p[0])) | static_cast<quint32>(static_cast<uchar>(p[1])) << 8;
+}
+
+quint32 readUInt32LE(const char* p)
+{
+    return readUInt16LE(p) | readUInt16LE(p + 2) << 16;
+}
+
+quint32 readUInt32BE(const char* p)
+{
+    return static_cast<quint32>(static_cast<uchar>(p[0])) << 24 | static_cast<quint32>(static_cast<uchar>(p[1])) << 16 |
+           static_cast<quint32>(static_cast<uchar>(p[2])) << 8 | static_cast<quint32>(static_cast<uchar>(p[3]));
+}
+
+// Размеры в ID3v2 — 7 бит на байт
+quint32 readSynchsafe(const char* p)
+{
+    return (static_cast<quint32>(p[0]) & 0x7f) << 21 | (static_cast<quint32>(p[1]) & 0x7f) << 14 |
+           (static_cast<quint32>(p[2]) & 0x7f) << 7 | (static_cast<quint32>(p[3]) & 0x7f);
+}
+
+void setTag(MediaProbe::MediaInfo* pInfo, const QString& key, QString value)
+{
+    // Строка может заканчиваться нулем или содержать несколько значений через ноль — берем первое
+    const int terminator = value.indexOf(QChar(0));
+    if (terminator >= 0) {
+        value.truncate(terminator);
+    }
+    value = value.trimmed();
+    if (value.isEmpty()) {
+        return;
+    }
+    QString* pField = key == "TITLE" ? &pInfo->title : key == "ARTIST" ? &pInfo->artist : key == "ALBUM" ? &pInfo->album : nullptr;
+    if (pField != nullptr && pField->isEmpty()) {
+        *pField = value;
+    }
+}
+
+QString decodeId3Text(const QByteArray& frame)
+{
+    if (frame.isEmpty()) {
+        return QString();
+    }
+    const char encoding = frame[0];
+    const QByteArray text = frame.mid(1);
+    if (encoding == 0) {
+        return QString::fromLatin1(text);
+    }
+    if (encoding == 3) {
+        return QString::fromUtf8(text);
+    }
+
+    // UTF-16 с BOM (1) или UTF-16BE без BOM (2)
+    bool isBigEndian = encoding == 2;
+    int start = 0;
+    if (text.size() >= 2 && static_cast<uchar>(text[0]) == 0xff && static_cast<uchar>(text[1]) == 0xfe) {
+        isBigEndian = false;
+        start = 2;
+    } else if (text.size() >= 2 && static_cast<uchar>(text[0]) == 0xfe && static_cast<uchar>(text[1]) == 0xff) {
+        isBigEndian = true;
+        start = 2;
+    }
+    QString result;
+    for (int i = start; i + 1 < text.size(); i += 2) {
+        const uchar first = static_cast<uchar>(text[i]);
+        const uchar second = static_cast<uchar>(text[i + 1]);
+        result.append(QChar(static_cast<char16_t>(isBigEndian ? (first << 8 | second) : (second << 8 | first))));
+    }
+    return result;
+}
+
+void readId3v2(const QByteArray& head, MediaProbe::MediaInfo* pInfo)
+{
+    if (head.size() < 10) {
+        return;
+    }
+    const int version = static_cast<uchar>(head[3]);
+    const uchar flags = static_cast<uchar>(head[5]);
+    // ID3v2.2 и теги с unsynchronisation встречаются редко — их пропускаем
+    if (version < 3 || version > 4 || (flags & 0x80)) {
+        return;
+    }
+
+    const char* data = head.constData();
+    const qint64 end = std::min<qint64>(10 + readSynchsafe(data + 6), head.size());
+    qint64 pos = 10;
+    if (flags & 0x40) { // Расширенный заголовок
+        if (pos + 4 > end) {
+            return;
+        }
+        pos += version == 4 ? readSynchsafe(data + pos) : readUInt32BE(data + pos) + 4;
+    }
+
+    while (pos + 10 <= end) {
+        if (data[pos] == 0) {
+            break; // Дальше заполнитель
+        }
+        const QByteArray id = head.mid(pos, 4);
+        const qint64 size = version == 4 ? readSynchsafe(data + pos + 4) : readUInt32BE(data + pos + 4);
+        pos += 10;
+        if (size > end - pos) {
+            break;
+        }
+        if (id == "TIT2") {
+            setTag(pInfo, "TITLE", decodeId3Text(head.mid(pos, size)));
+        } else if (id == "TPE1") {
+            setTag(pInfo, "ARTIST", decodeId3Text(head.mid(pos, size)));
+        } else if (id == "TALB") {
+            setTag(pInfo, "ALBUM", decodeId3Text(head.mid(pos, size)));
+        }
+        pos += size;
+    }
+}
+
+// Vorbis comment (FLAC, Ogg Vorbis, Opus): длина вендора, вендор, число полей, поля "KEY=value"
+void readVorbisComment(const char* data, qint64 size, MediaProbe::MediaInfo* pInfo)
+{
+    if (size < 8) {
+        return;
+    }
+    qint64 pos = 4 + static_cast<qint64>(readUInt32LE(data));
+    if (pos + 4 > size) {
+        return;
+    }
+    const quint32 count = readUInt32LE(data + pos);
+    pos += 4;
+    for (quint32 i = 0; i < count && pos + 4 <= size; ++i) {
+        const qint64 length = readUInt32LE(data + pos);
+        pos += 4;
+        if (length > size - pos) {
+            return;
+        }
+        const QString comment = QString::fromUtf8(data + pos, length);
+        pos += length;
+        const int separator = comment.indexOf('=');
+        if (separator > 0) {
+            setTag(pInfo, comment.left(separator).toUpper(), comment.mid(separator + 1));
+        }
+    }
+}
+
+void readFlac(const QByteArray& head, MediaProbe::MediaInfo* pInfo)
+{
+    qint64 pos = 4;
+    while (pos + 4 <= head.size()) {
+        const uchar header = static_cast<uchar>(head[pos]);
+        const qint64 length = static_cast<qint64>(readUInt32BE(head.constData() + pos)) & 0xffffff;
+        pos += 4;
+        if ((header & 0x7f) == 4 && length <= head.size() - pos) { // VORBIS_COMMENT
+            readVorbisComment(head.constData() + pos, length, pInfo);
+        }
+        if (header & 0x80) {
+            break; // Последний блок метаданных
+        }
+        pos += length;
+    }
+}
+
+// Ogg не декодируется движком, поэтому длительность считаем по granule position последней страницы
+void readOgg(QFile& file, const QByteArray& head, MediaProbe::MediaInfo* pInfo)
+{
+    quint32 granuleRate = 0;
+    qint64 preSkip = 0;
+    qsizetype index = head.indexOf("\x01vorbis");
+    if (index >= 0 && index + 16 <= head.size()) {
+        pInfo->channels = static_cast<uchar>(head[index + 11]);
+        pInfo->sampleRate = readUInt32LE(head.constData() + index + 12);
+        granuleRate = pInfo->sampleRate;
+    } else if ((index = head.indexOf("OpusHead")) >= 0 && index + 16 <= head.size()) {
+        pInfo->channels = static_cast<uchar>(head[index + 9]);
+        preSkip = readUInt16LE(head.constData() + index + 10);
+        pInfo->sampleRate = readUInt32LE(head.constData() + index + 12);
+        granuleRate = 48000; // Granule position в Opus всегда в отсчетах 48 кГц
+    }
+
+    // Пакет комментариев обычно помещается в одну страницу сразу за заголовком
+    index = head.indexOf("\x03vorbis");
+    if (index >= 0) {
+        readVorbisComment(head.constData() + index + 7, head.size() - index - 7, pInfo);
+    } else if ((index = head.indexOf("OpusTags")) >= 0) {
+        readVorbisComment(head.constData() + index + 8, head.size() - index - 8, pInfo);
+    }
+
+    if (pInfo->durationMillis >= 0 || granuleRate == 0 || !file.seek(std::max<qint64>(0, file.size() - kOggTailBytes))) {
+        return;
+    }
+    const QByteArray tail = file.read(kOggTailBytes);
+    const qsizetype lastPage = tail.lastIndexOf("OggS");
+    if (lastPage >= 0 && lastPage + 14 <= tail.size()) {
+        const qint64 granule = static_cast<qint64>(readUInt32LE(tail.constData() + lastPage + 6)) |
+                               static_cast<qint64>(readUInt32LE(tail.constData() + lastPage + 10)) << 32;
+        if (granule > preSkip) {
+            pInfo->durationMillis = (granule - preSkip) * 1000 / granuleRate;
+        }
+    }
+}
+
+// В WAV список INFO часто записан после данных, поэтому идем по чанкам файла, а не по началу
+void readRiffInfo(QFile& file, MediaProbe::MediaInfo* pInfo)
+{
+    qint64 pos = 12;
+    while (file.seek(pos)) {
+        const QByteArray header = file.read(12);
+        if (header.size() < 8) {
+            return;
+        }
+        const qint64 size = readUInt32LE(header.constData() + 4);
+        if (header.startsWith("LIST") && header.mid(8, 4) == "INFO" && size >= 4 && size <= kTagScanBytes) {
+            const QByteArray list = file.read(size - 4);
+            qint64 itemPos = 0;
+            while (itemPos + 8 <= list.size()) {
+                const QByteArray id = list.mid(itemPos, 4);
+                const qint64 itemSize = readUInt32LE(list.constData() + itemPos + 4);
+                itemPos += 8;
+                if (itemSize > list.size() - itemPos) {
+                    break;
+                }
+                const QString value = QString::fromUtf8(list.constData() + itemPos, itemSize);
+                if (id == "INAM") {
+                    setTag(pInfo, "TITLE", value);
+                } else if (id == "IART") {
+                    setTag(pInfo, "ARTIST", value);
+                } else if (id == "IPRD") {
+                    setTag(pInfo, "ALBUM", value);
+                }
+                itemPos += itemSize + (itemSize & 1);
+            }
+            return;
+        }
+        pos += 8 + size + (size & 1); // Чанки выровнены по двум байтам
+    }
+}
+
+} // namespace
+
+namespace MediaProbe {
+
+MediaInfo probe(const QString& filePath)
+{
+    MediaInfo info;
+
+    // Формат и частота 0 — родные параметры файла, без конвертера и ресемплера
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder) == MA_SUCCESS) {
+        info.isPlayable = true;
+        ma_format format;
+        ma_uint32 channels = 0;
+        ma_uint32 sampleRate = 0;
+        ma_uint64 lengthFrames = 0;
+        ma_decoder_get_data_format(&decoder, &format, &channels, &sampleRate, NULL, 0);
+        info.channels = channels;
+        info.sampleRate = sampleRate;
+        if (ma_decoder_get_length_in_pcm_frames(&decoder, &lengthFrames) == MA_SUCCESS && lengthFrames > 0 && sampleRate > 0) {
+            info.durationMillis = static_cast<qint64>(lengthFrames * 1000 / sampleRate);
+        }
+        ma_decoder_uninit(&decoder);
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return info;
+    }
+    const QByteArray head = file.read(kTagScanBytes);
+    if (head.startsWith("ID3")) {
+        readId3v2(head, &info);
+    } else if (head.startsWith("fLaC")) {
+        readFlac(head, &info);
+    } else if (head.startsWith("OggS")) {
+        readOgg(file, head, &info);
+    } else if (head.startsWith("RIFF") && head.mid(8, 4) == "WAVE") {
+        readRiffInfo(file, &info);
+    }
+    return info;
+}
+
+bool isSupportedHeader(const QByteArray& head)
+{
+    const int size = static_cast<int>(head.size());
+    const char* data = head.constData();
+    if ((head.startsWith("RIFF") || head.startsWith("RF64")) && size >= 12) {
+        return head.mid(8, 4) == "WAVE";
+    }
+    if (head.startsWith("fLaC") || head.startsWith("ID3")) {
+        return true;
+    }
+    if (head.startsWith("OggS") && size >= 27) {
+        // Первая страница несет заголовок кодека сразу за таблицей сегментов; Opus и прочее не играем
+        const int packet = 27 + static_cast<uchar>(data[26]);
+        return size >= packet + 7 && head.mid(packet, 7) == "\x01vorbis";
+    }
+    if (size >= 4) {
+        // MP3 без ID3: синхрослово кадра и допустимые слой, битрейт и частота
+        const uchar b1 = static_cast<uchar>(data[1]);
+        const uchar b2 = static_cast<uchar>(data[2]);
+        return static_cast<uchar>(data[0]) == 0xFF && (b1 & 0xE0) == 0xE0 && (b1 & 0x06) != 0 &&
+               (b2 & 0xF0) != 0xF0 && (b2 & 0x0C) != 0x0C;
+    }
+    return false;
+}
+
+bool isSupported(const QString& filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) && isSupportedHeader(file.read(kSniffBytes));
+}
+
+} // namespace MediaProbe
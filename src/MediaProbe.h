@@ -0,0 +1,50 @@
+// src/MediaProbe.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+// Длительность, формат и теги аудиофайла без Qt Multimedia: длительность берется у тех же
+// декодеров miniaudio, что играют файл, теги читаются напрямую из ID3v2, FLAC/Ogg Vorbis
+// comment и RIFF INFO. Блокирует на время чтения файла — вызывать вне главного потока.
+namespace MediaProbe {
+
+struct MediaInfo {
+    bool isPlayable = false;    // Движок умеет декодировать файл
+    qint64 durationMillis = -1; // -1 — длительность неизвестна
+    quint32 sampleRate = 0;
+    quint32 channels = 0;
+    QString title;
+    QString artist;
+    QString album;
+};
+
+MediaInfo probe(const QString& filePath);
+
+// Формат по первым байтам файла, а не по расширению: WAV/RF64, FLAC, Ogg Vorbis, MP3 (ID3v2
+// или заголовок MPEG-кадра). Читает не больше kSniffBytes — годится для отбора тысяч файлов
+constexpr qint64 kSniffBytes = 64;
+bool isSupportedHeader(const QByteArray& head);
+bool isSupported(const QString& filePath);
+
+} // namespace MediaProbe
@@ -0,0 +1,264 @@
+// src/MidiInput.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MidiInput.h"
+#include "AudioEngine.h"
+#include "Log.h"
+
+#ifdef Q_OS_LINUX
+#include <alsa/asoundlib.h>
+#include <poll.h>
+#include <algorithm>
+#include <vector>
+#endif
+
+#ifdef Q_OS_LINUX
+
+namespace {
+
+// Время очереди секвенсора в наносекундах
+qint64 toNanoseconds(const snd_seq_real_time_t& time)
+{
+    return static_cast<qint64>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+}
+
+// Обходит порты, из которых можно читать (источники MIDI), кроме системных и своих
+template <typename Callback>
+void forEachSource(snd_seq_t* seq, Callback callback)
+{
+    snd_seq_client_info_t* clientInfo;
+    snd_seq_port_info_t* portInfo;
+    snd_seq_client_info_alloca(&clientInfo);
+    snd_seq_port_info_alloca(&portInfo);
+
+    const int ownClient = snd_seq_client_id(seq);
+    snd_seq_client_info_set_client(clientInfo, -1);
+    while (snd_seq_query_next_client(seq, clientInfo) >= 0) {
+        const int client = snd_seq_client_info_get_client(clientInfo);
+        if (client == SND_SEQ_CLIENT_SYSTEM || client == ownClient) {
+            continue;
+        }
+        snd_seq_port_info_set_client(portInfo, client);
+        snd_seq_port_info_set_port(portInfo, -1);
+        while (snd_seq_query_next_port(seq, portInfo) >= 0) {
+            const unsigned int required = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+            const unsigned int capability = snd_seq_port_info_get_capability(portInfo);
+            if ((capability & required) != required || (capability & SND_SEQ_PORT_CAP_NO_EXPORT)) {
+                continue;
+            }
+            const QString name = QString("%1:%2").arg(QString::fromUtf8(snd_seq_client_info_get_name(clientInfo)),
+                                                      QString::fromUtf8(snd_seq_port_info_get_name(portInfo)));
+            callback(name, client, snd_seq_port_info_get_port(portInfo));
+        }
+    }
+}
+
+} // namespace
+
+#endif
+
+MidiInput::MidiInput(AudioEngine* engine, QObject* parent)
+    : QObject(parent),
+      m_engine(engine),
+      m_isStopRequested(false)
+#ifdef Q_OS_LINUX
+      , m_seq(nullptr),
+      m_port(-1),
+      m_queue(-1)
+#endif
+{
+}
+
+MidiInput::~MidiInput()
+{
+    stop();
+}
+
+bool MidiInput::isAvailable()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+QStringList MidiInput::availableSources()
+{
+    QStringList sources;
+#ifdef Q_OS_LINUX
+    snd_seq_t* seq = nullptr;
+    if (snd_seq_open(&seq, "default", SND_SEQ_OPEN_INPUT, 0) < 0) {
+        return sources;
+    }
+    forEachSource(seq, [&sources](const QString& name, int, int) { sources.append(name); });
+    snd_seq_close(seq);
+#endif
+    return sources;
+}
+
+bool MidiInput::start(const QString& source, const Mapping& mapping)
+{
+    stop();
+    m_mapping = mapping;
+
+#ifdef Q_OS_LINUX
+    if (snd_seq_open(&m_seq, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+        OSD_LOG_WARNING(Midi, "Failed to open the ALSA sequencer");
+        m_seq = nullptr;
+        return false;
+    }
+    snd_seq_set_client_name(m_seq, "OpenSoundDeck");
+    m_port = snd_seq_create_simple_port(m_seq, "Trigger In",
+                                        SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                        SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    m_queue = snd_seq_alloc_queue(m_seq);
+    if (m_port < 0 || m_queue < 0) {
+        OSD_LOG_WARNING(Midi, "Failed to create the MIDI input port");
+        snd_seq_close(m_seq);
+        m_seq = nullptr;
+        return false;
+    }
+
+    // Ядро ставит метку времени очереди в момент прихода события, а не когда поток проснулся:
+    // задержка планировщика потока не попадает в момент запуска звука
+    snd_seq_port_info_t* portInfo;
+    snd_seq_port_info_alloca(&portInfo);
+    snd_seq_get_port_info(m_seq, m_port, portInfo);
+    snd_seq_port_info_set_timestamping(portInfo, 1);
+    snd_seq_port_info_set_timestamp_real(portInfo, 1);
+    snd_seq_port_info_set_timestamp_queue(portInfo, m_queue);
+    snd_seq_set_port_info(m_seq, m_port, portInfo);
+    snd_seq_start_queue(m_seq, m_queue, nullptr);
+    snd_seq_drain_output(m_seq);
+
+    if (!source.isEmpty()) {
+        bool isConnected = false;
+        forEachSource(m_seq, [&](const QString& name, int client, int port) {
+            if (!isConnected && name == source) {
+                isConnected = snd_seq_connect_from(m_seq, m_port, client, port) >= 0;
+            }
+        });
+        if (!isConnected) {
+            OSD_LOG_WARNING(Midi, "MIDI source not found source=\"%s\"", qUtf8Printable(source));
+        }
+    }
+
+    m_isStopRequested.store(false);
+    m_thread = std::thread(&MidiInput::run, this);
+    OSD_LOG_INFO(Midi, "MIDI input started source=\"%s\"", qUtf8Printable(source));
+    return true;
+#else
+    Q_UNUSED(source);
+    OSD_LOG_WARNING(Midi, "MIDI input is only available on Linux (ALSA sequencer)");
+    return false;
+#endif
+}
+
+void MidiInput::stop()
+{
+    if (m_thread.joinable()) {
+        m_isStopRequested.store(true);
+        m_thread.join();
+    }
+#ifdef Q_OS_LINUX
+    if (m_seq != nullptr) {
+        snd_seq_close(m_seq); // Закрывает и порт, и очередь, и подписки
+        m_seq = nullptr;
+        m_port = -1;
+        m_queue = -1;
+    }
+#endif
+}
+
+void MidiInput::setTracks(const QList<PlaylistEntry>& tracks)
+{
+    QMutexLocker locker(&m_tracksMutex);
+    m_tracks = tracks;
+}
+
+void MidiInput::run()
+{
+#ifdef Q_OS_LINUX
+    const int descriptorCount = snd_seq_poll_descriptors_count(m_seq, POLLIN);
+    std::vector<pollfd> descriptors(descriptorCount);
+    snd_seq_poll_descriptors(m_seq, descriptors.data(), descriptorCount, POLLIN);
+
+    snd_seq_queue_status_t* queueStatus;
+    snd_seq_queue_status_malloc(&queueStatus);
+
+    while (!m_isStopRequested.load()) {
+        // Таймаут нужен только для проверки флага остановки
+        if (poll(descriptors.data(), descriptors.size(), 100) <= 0) {
+            continue;
+        }
+
+        // Пересчет времени очереди в steady_clock на каждую пачку событий:
+        // расхождение часов между пачками пренебрежимо мало
+        const qint64 now = AudioEngine::clockNanoseconds();
+        qint64 queueToSteady = 0;
+        if (snd_seq_get_queue_status(m_seq, m_queue, queueStatus) >= 0) {
+            queueToSteady = now - toNanoseconds(*snd_seq_queue_status_get_real_time(queueStatus));
+        }
+
+        snd_seq_event_t* event = nullptr;
+        while (snd_seq_event_input(m_seq, &event) >= 0 && event != nullptr) {
+            int channel = 0;
+            int trackIndex = -1;
+            int velocity = 0;
+            if (event->type == SND_SEQ_EVENT_NOTEON && event->data.note.velocity > 0) {
+                channel = event->data.note.channel + 1;
+                trackIndex = event->data.note.note - m_mapping.firstNote;
+                velocity = event->data.note.velocity;
+            } else if (event->type == SND_SEQ_EVENT_CONTROLLER && m_mapping.firstController >= 0 &&
+                       event->data.control.value > 0) {
+                // Кнопки контроллеров шлют CC со значением 127 при нажатии и 0 при отпускании
+                channel = event->data.control.channel + 1;
+                trackIndex = static_cast<int>(event->data.control.param) - m_mapping.firstController;
+                velocity = std::min(event->data.control.value, 127);
+            }
+            if (trackIndex < 0 || (m_mapping.channel != 0 && channel != m_mapping.channel)) {
+                continue;
+            }
+
+            qint64 eventTime = now;
+            if (queueToSteady != 0 && (event->flags & SND_SEQ_TIME_STAMP_MASK) == SND_SEQ_TIME_STAMP_REAL) {
+                eventTime = std::min(now, queueToSteady + toNanoseconds(event->time.time));
+            }
+            PlaylistEntry track;
+            {
+                QMutexLocker locker(&m_tracksMutex);
+                if (trackIndex < m_tracks.size()) {
+                    track = m_tracks[trackIndex];
+                }
+            }
+            if (track.filePath.isEmpty()) {
+                continue;
+            }
+            const float gain = m_mapping.velocityToGain ? velocity / 127.0f : 1.0f;
+            track.params.gain *= gain;
+            m_engine->triggerSound(track.filePath, track.region, track.params, eventTime, track.bank);
+            emit trackTriggered(trackIndex, track.bank, gain);
+        }
+    }
+
+    snd_seq_queue_status_free(queueStatus);
+#endif
+}
@@ -0,0 +1,88 @@
+// src/MidiInput.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <thread>
+#include "Playlist.h"
+
+#ifdef Q_OS_LINUX
+typedef struct _snd_seq snd_seq_t;
+#endif
+
+// Вход MIDI через секвенсор ALSA (только Linux). Создает порт «OpenSoundDeck:Trigger In»,
+// к которому можно подключить контроллер через aconnect или выбрать источник в настройках.
+// События читаются в отдельном потоке и получают метку времени ядра, по которой движок
+// ставит звук с точностью до семпла. Нота сопоставляется треку в том же потоке, и трек
+// запускается через AudioEngine::triggerSound(), минуя цикл событий главного потока:
+// зависание интерфейса не сдвигает звук.
+class MidiInput : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Сопоставление сообщений трекам (номер трека с 0)
+    struct Mapping {
+        int channel = 0;          // 0 — любой канал, иначе 1..16
+        int firstNote = 36;       // Нота, запускающая первый трек (C1 — первый пэд у большинства контроллеров)
+        int firstController = -1; // CC, запускающий первый трек; -1 — CC не используются
+        bool velocityToGain = true;
+    };
+
+    explicit MidiInput(AudioEngine* engine, QObject* parent = nullptr);
+    ~MidiInput();
+
+    static bool isAvailable();
+    static QStringList availableSources(); // "Клиент:Порт" всех источников MIDI в системе
+
+    // Пустой source — только открыть свой порт. Перезапускает поток, если он уже работал.
+    bool start(const QString& source, const Mapping& mapping);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+
+    // Треки по номерам нот; пустой filePath — нота ничего не запускает. Можно менять на ходу
+    void setTracks(const QList<PlaylistEntry>& tracks);
+
+signals:
+    // Испускается из потока MIDI, когда звук уже отправлен в движок: для отметок интерфейса
+    void trackTriggered(int trackIndex, int deck, float gain);
+
+private:
+    void run();
+
+    AudioEngine* m_engine;
+    Mapping m_mapping;
+    QMutex m_tracksMutex; // Таблицу меняет главный поток, читает поток MIDI
+    QList<PlaylistEntry> m_tracks;
+    std::thread m_thread;
+    std::atomic<bool> m_isStopRequested;
+#ifdef Q_OS_LINUX
+    snd_seq_t* m_seq;
+    int m_port;
+    int m_queue;
+#endif
+};
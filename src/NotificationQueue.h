@@ -0,0 +1,105 @@
+// src/NotificationQueue.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Сообщения аудиопотока главному: конец голоса, переход очереди, метка. Ограниченная
+// MPSC-очередь Вьюкова, как кольцо журнала: ячейки выделены заранее, поэтому колбэк и
+// рабочие ParallelMixer пишут без блокировок и выделений, а главный поток забирает
+// сообщения по таймеру. Переполнение не ждет читателя — сообщение отбрасывается и
+// учитывается в droppedCount().
+class NotificationQueue
+{
+public:
+    static constexpr size_t kCapacity = 512; // Степень двойки
+
+    enum Type : uint8_t {
+        PlaybackFinished,
+        QueueAdvanced,
+        CueReached
+    };
+
+    struct Notification {
+        Type type = PlaybackFinished;
+        int deck = 0;
+        int cueIndex = 0;
+    };
+
+    NotificationQueue()
+    {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    NotificationQueue(const NotificationQueue&) = delete;
+    NotificationQueue& operator=(const NotificationQueue&) = delete;
+
+    // Любой поток
+    bool push(const Notification& notification)
+    {
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[position & (kCapacity - 1)];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.notification = notification;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < position) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Только один читатель (главный поток)
+    bool pop(Notification* pNotification)
+    {
+        Slot& slot = m_slots[m_dequeuePosition & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1) {
+            return false;
+        }
+        *pNotification = slot.notification;
+        slot.sequence.store(m_dequeuePosition + kCapacity, std::memory_order_release);
+        ++m_dequeuePosition;
+        return true;
+    }
+
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Notification notification;
+    };
+
+    Slot m_slots[kCapacity];
+    std::atomic<size_t> m_enqueuePosition{0};
+    size_t m_dequeuePosition = 0;
+    std::atomic<uint64_t> m_dropped{0};
+};
@@ -0,0 +1,359 @@
+// src/OfflineRenderer.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "OfflineRenderer.h"
+#include "Log.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 kChannels = AudioEngine::kEngineChannels;
+
+// Аргументы через пробел; путь с пробелами берется в двойные кавычки (как в сокете управления)
+QStringList splitArguments(const QString& line)
+{
+    QStringList args;
+    QString current;
+    bool isQuoted = false;
+    bool hasToken = false;
+    for (QChar c : line) {
+        if (c == '"') {
+            isQuoted = !isQuoted;
+            hasToken = true;
+        } else if (!isQuoted && (c == ' ' || c == '\t')) {
+            if (hasToken) {
+                args.append(current);
+                current.clear();
+                hasToken = false;
+            }
+        } else {
+            current += c;
+            hasToken = true;
+        }
+    }
+    if (hasToken) {
+        args.append(current);
+    }
+    return args;
+}
+
+// Секунды сценария в кадры движка; округление, чтобы 0.1 с давало ровно 4800 кадров
+bool parseTime(const QString& text, ma_uint64* pFrame)
+{
+    bool ok = false;
+    const double seconds = text.toDouble(&ok);
+    if (!ok || seconds < 0.0 || !std::isfinite(seconds)) {
+        return false;
+    }
+    *pFrame = static_cast<ma_uint64>(std::llround(seconds * AudioEngine::kEngineSampleRate));
+    return true;
+}
+
+QString resolvePath(const QString& path, const QString& baseDirectory)
+{
+    return QFileInfo(path).isAbsolute() ? path : QDir(baseDirectory).filePath(path);
+}
+
+} // namespace
+
+bool OfflineRenderer::loadTimeline(const QString& fileName)
+{
+    m_tracks.clear();
+    m_masterEffects = AudioEngine::EffectSettings();
+    m_events.clear();
+    m_endFrame = -1;
+    m_errorString.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_errorString = QString("cannot open %1").arg(fileName);
+        return false;
+    }
+
+    const QString baseDirectory = QFileInfo(fileName).absolutePath();
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (!parseLine(line, lineNumber, baseDirectory)) {
+            return false;
+        }
+    }
+
+    // Устойчивая сортировка: события одного момента остаются в порядке файла
+    std::stable_sort(m_events.begin(), m_events.end(), [](const Event& a, const Event& b) { return a.frame < b.frame; });
+    return true;
+}
+
+bool OfflineRenderer::parseLine(const QString& line, int lineNumber, const QString& baseDirectory)
+{
+    const QStringList args = splitArguments(line);
+    const QString command = args.first().toLower();
+
+    if (command == "playlist") {
+        if (args.size() != 2) {
+            return fail(lineNumber, "usage: playlist <file.osdpl>");
+        }
+        if (!Playlist::load(resolvePath(args[1], baseDirectory), &m_tracks)) {
+            return fail(lineNumber, QString("cannot open playlist %1").arg(args[1]));
+        }
+        return true;
+    }
+    if (command == "master") {
+        // Формат эффектов не содержит пробелов, но разрешаем их внутри строки
+        m_masterEffects = Playlist::parseEffects(args.mid(1).join(QString()));
+        return true;
+    }
+
+    ma_uint64 frame = 0;
+    if (!parseTime(args.first(), &frame)) {
+        return fail(lineNumber, QString("expected a time in seconds or a directive, got \"%1\"").arg(args.first()));
+    }
+    if (args.size() < 2) {
+        return fail(lineNumber, "missing command");
+    }
+    return parseEvent(frame, args.mid(1), lineNumber, baseDirectory);
+}
+
+bool OfflineRenderer::parseEvent(ma_uint64 frame, const QStringList& args, int lineNumber, const QString& baseDirectory)
+{
+    const QString command = args.first().toLower();
+    Event event;
+    event.frame = frame;
+    event.line = lineNumber;
+
+    if (command == "end") {
+        if (m_endFrame >= 0) {
+            return fail(lineNumber, "end is given twice");
+        }
+        m_endFrame = static_cast<qint64>(frame);
+        return true;
+    }
+
+    if (command == "play") {
+        if (args.size() < 2) {
+            return fail(lineNumber, "usage: play <track number|file> [field=value...]");
+        }
+        bool isNumber = false;
+        const int trackNumber = args[1].toInt(&isNumber);
+        if (isNumber) {
+            if (trackNumber < 1 || trackNumber > m_tracks.size()) {
+                return fail(lineNumber, QString("no track %1 in the playlist").arg(trackNumber));
+            }
+            event.entry = m_tracks[trackNumber - 1];
+        } else {
+            event.entry.filePath = resolvePath(args[1], baseDirectory);
+        }
+        for (int i = 2; i < args.size(); ++i) {
+            if (!args[i].contains('=')) {
+                return fail(lineNumber, QString("expected field=value, got \"%1\"").arg(args[i]));
+            }
+            Playlist::parseField(args[i], &event.entry);
+        }
+        event.type = Event::Play;
+        event.deck = event.entry.bank;
+        m_events.append(event);
+        return true;
+    }
+
+    // Остальные команды: необязательное значение и необязательный bank=N
+    QStringList values;
+    bool hasDeck = false;
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i].startsWith("bank=")) {
+            bool ok = false;
+            event.deck = args[i].mid(5).toInt(&ok);
+            if (!ok || event.deck < 0 || event.deck >= AudioEngine::kDeckCount) {
+                return fail(lineNumber, QString("bank must be between 0 and %1").arg(AudioEngine::kDeckCount - 1));
+            }
+            hasDeck = true;
+        } else {
+            values.append(args[i]);
+        }
+    }
+
+    auto parseValue = [&](double minimum, double maximum) {
+        bool ok = values.size() == 1;
+        event.value = ok ? values.first().toDouble(&ok) : 0.0;
+        return ok && event.value >= minimum && event.value <= maximum;
+    };
+
+    if (command == "stop") {
+        event.type = hasDeck ? Event::Stop : Event::StopAll;
+    } else if (command == "pause") {
+        event.type = Event::Pause;
+    } else if (command == "resume") {
+        event.type = Event::Resume;
+    } else if (command == "seek") {
+        if (!parseValue(0.0, 1e12)) {
+            return fail(lineNumber, "usage: seek <milliseconds> [bank=N]");
+        }
+        event.type = Event::Seek;
+    } else if (command == "gain") {
+        if (!parseValue(0.0, AudioEngine::kMaxVoiceGain)) {
+            return fail(lineNumber, "usage: gain <0..2> [bank=N]");
+        }
+        event.type = Event::Gain;
+    } else if (command == "volume") {
+        if (!parseValue(0.0, 1.0)) {
+            return fail(lineNumber, "usage: volume <0..1> [bank=N]");
+        }
+        event.type = Event::Volume;
+    } else if (command == "repeat") {
+        if (values.size() != 1 || (values.first() != "on" && values.first() != "off")) {
+            return fail(lineNumber, "usage: repeat on|off [bank=N]");
+        }
+        event.type = Event::Repeat;
+        event.value = values.first() == "on" ? 1.0 : 0.0;
+    } else {
+        return fail(lineNumber, QString("unknown command \"%1\"").arg(command));
+    }
+    m_events.append(event);
+    return true;
+}
+
+bool OfflineRenderer::fail(int lineNumber, const QString& message)
+{
+    m_errorString = QString("line %1: %2").arg(lineNumber).arg(message);
+    return false;
+}
+
+bool OfflineRenderer::applyEvent(AudioEngine* engine, const Event& event, AudioEngine::VoiceParams* pDeckParams)
+{
+    switch (event.type) {
+    case Event::Play:
+        engine->playSound(event.entry.filePath, event.entry.region, event.entry.params, 0, event.deck);
+        if (engine->getPlaybackState(event.deck) != AudioEngine::Playing) {
+            return fail(event.line, QString("cannot play %1").arg(event.entry.filePath));
+        }
+        pDeckParams[event.deck] = event.entry.params;
+        break;
+    case Event::Stop:
+        engine->stopDeck(event.deck);
+        break;
+    case Event::StopAll:
+        engine->stopAllSounds();
+        break;
+    case Event::Pause:
+        engine->pause(event.deck);
+        break;
+    case Event::Resume:
+        engine->resume(event.deck);
+        break;
+    case Event::Seek:
+        engine->seek(static_cast<ma_uint64>(event.value), event.deck);
+        break;
+    case Event::Gain:
+        pDeckParams[event.deck].gain = static_cast<float>(event.value);
+        engine->setVoiceParams(pDeckParams[event.deck], event.deck);
+        break;
+    case Event::Volume:
+        engine->setDeckVolume(event.deck, static_cast<float>(event.value));
+        break;
+    case Event::Repeat:
+        engine->setRepeatEnabled(event.value != 0.0, event.deck);
+        break;
+    }
+    return true;
+}
+
+bool OfflineRenderer::render(const QString& outputPath, SampleFormat format)
+{
+    m_renderedFrames = 0;
+    m_errorString.clear();
+
+    // Каждый рендер — новый движок: состояние эффектов и растяжения не переходит между запусками
+    AudioEngine engine;
+    engine.initOffline();
+    engine.setMasterEffects(m_masterEffects);
+
+    ma_encoder encoder;
+    const ma_encoder_config encoderConfig = ma_encoder_config_init(
+        ma_encoding_format_wav, format == Int16 ? ma_format_s16 : ma_format_f32, kChannels, AudioEngine::kEngineSampleRate);
+    if (ma_encoder_init_file(outputPath.toStdString().c_str(), &encoderConfig, &encoder) != MA_SUCCESS) {
+        m_errorString = QString("cannot create %1").arg(outputPath);
+        return false;
+    }
+
+    std::vector<float> block(static_cast<size_t>(kBlockFrames) * kChannels);
+    std::vector<ma_int16> converted(format == Int16 ? block.size() : 0);
+    AudioEngine::VoiceParams deckParams[AudioEngine::kDeckCount];
+
+    const ma_uint64 lastEventFrame = m_events.isEmpty() ? 0 : m_events.last().frame;
+    const ma_uint64 limitFrame = m_endFrame >= 0 ? static_cast<ma_uint64>(m_endFrame)
+                                                 : lastEventFrame + kMaxTailSeconds * AudioEngine::kEngineSampleRate;
+    ma_uint64 frame = 0;
+    qsizetype nextEvent = 0;
+    bool isOk = true;
+    while (isOk) {
+        while (nextEvent < m_events.size() && m_events[nextEvent].frame <= frame && isOk) {
+            isOk = applyEvent(&engine, m_events[nextEvent++], deckParams);
+        }
+        if (!isOk) {
+            break;
+        }
+        // Без end сценарий кончается, когда событий больше нет и все деки доиграли
+        if (m_endFrame < 0 && nextEvent == m_events.size() && !engine.isAnyDeckPlaying()) {
+            break;
+        }
+        if (frame >= limitFrame) {
+            if (m_endFrame < 0) {
+                OSD_LOG_WARNING(Engine, "Offline render cut after %llu s of tail, add an end line to the timeline",
+                                static_cast<unsigned long long>(kMaxTailSeconds));
+            }
+            break;
+        }
+
+        // Блок кончается на следующем событии: оно сработает ровно на своем кадре
+        ma_uint64 frameCount = std::min<ma_uint64>(kBlockFrames, limitFrame - frame);
+        if (nextEvent < m_events.size()) {
+            frameCount = std::min(frameCount, m_events[nextEvent].frame - frame);
+        }
+        engine.renderOffline(block.data(), static_cast<ma_uint32>(frameCount));
+
+        ma_result result;
+        if (format == Int16) {
+            ma_pcm_f32_to_s16(converted.data(), block.data(), frameCount * kChannels, ma_dither_mode_none);
+            result = ma_encoder_write_pcm_frames(&encoder, converted.data(), frameCount, nullptr);
+        } else {
+            result = ma_encoder_write_pcm_frames(&encoder, block.data(), frameCount, nullptr);
+        }
+        if (result != MA_SUCCESS) {
+            m_errorString = QString("cannot write %1").arg(outputPath);
+            isOk = false;
+        }
+        frame += frameCount;
+    }
+
+    engine.stopAllSounds();
+    ma_encoder_uninit(&encoder);
+    m_renderedFrames = frame;
+    return isOk;
+}
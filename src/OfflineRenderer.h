@@ -0,0 +1,105 @@
+// src/OfflineRenderer.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include "AudioEngine.h"
+#include "Playlist.h"
+
+// Офлайн-рендер сценария в WAV: триггеры, громкость и перемотка из файла сценария проходят
+// через тот же микшер, что и колбэк устройства (AudioEngine::initOffline), но без устройства
+// и быстрее реального времени. Событие делит блок и срабатывает точно на своем семпле.
+//
+// Результат побитово повторяется на той же сборке: движок каждый раз новый, клипы читаются
+// потоковым декодером (без сжатия SampleStore), время событий считается в кадрах, а не по часам.
+//
+// Формат сценария (.osdtl): одна команда на строку, строка с «#» в начале — комментарий.
+//
+//   playlist show.osdpl
+//   master hp:80;reverb:0.6,0.4,0.25
+//   0.000  play 1
+//   0.250  play "sfx/horn.wav" bank=2 gain=0.8 loop=1
+//   1.500  seek 250 bank=2
+//   6.000  end
+//
+// Без времени: playlist — треки для play <номер> (путь относительно сценария),
+// master — эффекты мастер-шины в формате плейлиста. Строка события начинается со времени
+// в секундах; события одного момента выполняются в порядке файла. Команды:
+//   play <номер трека|файл> [поле=значение...] — поля трека как в .osdpl, дека из bank=
+//   seek <мс>, gain <0..2> (голос), volume <0..1> (дека), repeat on|off, pause, resume
+//   stop — все деки, если не указан bank=
+//   end — конец рендера; без него рендер идет, пока не доиграют все деки
+// У команд кроме play дека задается полем bank=N, по умолчанию 0.
+class OfflineRenderer
+{
+public:
+    enum SampleFormat {
+        Float32,
+        Int16 // Без дизеринга: шум дизеринга сделал бы файл неповторяемым
+    };
+
+    // Размер блока входит в условие повторяемости: растяжение и эффекты
+    // подхватывают новые параметры на границе блока
+    static constexpr ma_uint32 kBlockFrames = 512;
+    // Сценарий без end с бесконечной петлей обрезается через столько секунд после последнего события
+    static constexpr ma_uint64 kMaxTailSeconds = 600;
+
+    bool loadTimeline(const QString& fileName);
+    bool render(const QString& outputPath, SampleFormat format = Float32);
+
+    QString errorString() const { return m_errorString; }
+    ma_uint64 renderedFrames() const { return m_renderedFrames; }
+
+private:
+    struct Event {
+        enum Type {
+            Play,
+            Stop,
+            StopAll,
+            Pause,
+            Resume,
+            Seek,
+            Gain,
+            Volume,
+            Repeat
+        };
+        ma_uint64 frame = 0;
+        Type type = Play;
+        int deck = 0;
+        PlaylistEntry entry; // Только Play
+        double value = 0.0;
+        int line = 0;
+    };
+
+    bool parseLine(const QString& line, int lineNumber, const QString& baseDirectory);
+    bool parseEvent(ma_uint64 frame, const QStringList& args, int lineNumber, const QString& baseDirectory);
+    bool applyEvent(AudioEngine* engine, const Event& event, AudioEngine::VoiceParams* pDeckParams);
+    bool fail(int lineNumber, const QString& message);
+
+    QList<PlaylistEntry> m_tracks;
+    AudioEngine::EffectSettings m_masterEffects;
+    QList<Event> m_events;
+    qint64 m_endFrame = -1; // -1 — до тишины
+    QString m_errorString;
+    ma_uint64 m_renderedFrames = 0;
+};
@@ -0,0 +1,475 @@
+// src/OutputRecorder.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "OutputRecorder.h"
+#include "FlacEncoder.h"
+#include "Log.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+constexpr ma_uint32 kWriteChunkMillis = 500; // Сколько история отдает заданию за один захват мьютекса
+
+} // namespace
+
+// Файл записи: WAV через кодировщик miniaudio или FLAC через FlacEncoder
+class OutputRecorder::Sink
+{
+public:
+    Sink(ma_uint32 channels, ma_uint32 sampleRate)
+        : m_channels(channels)
+        , m_sampleRate(sampleRate)
+    {
+    }
+
+    ~Sink() { close(); }
+
+    bool open(const QString& filePath)
+    {
+        QDir().mkpath(QFileInfo(filePath).absolutePath());
+        if (QFileInfo(filePath).suffix().compare("flac", Qt::CaseInsensitive) == 0) {
+            m_flac = std::make_unique<FlacEncoder>(m_channels, m_sampleRate);
+            m_file.setFileName(filePath);
+            // Заголовок переписывается в close(), когда известны длина и размеры кадров
+            const std::vector<uint8_t> header = m_flac->header();
+            return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+                   m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<qint64>(header.size())) ==
+                       static_cast<qint64>(header.size());
+        }
+        const ma_encoder_config config =
+            ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, m_channels, m_sampleRate);
+        m_isWavOpen = ma_encoder_init_file(filePath.toStdString().c_str(), &config, &m_wav) == MA_SUCCESS;
+        return m_isWavOpen;
+    }
+
+    bool write(const qint16* pFrames, ma_uint64 frameCount)
+    {
+        if (m_flac) {
+            m_encoded.clear();
+            m_flac->write(pFrames, static_cast<size_t>(frameCount), &m_encoded);
+            return m_file.write(reinterpret_cast<const char*>(m_encoded.data()), static_cast<qint64>(m_encoded.size())) ==
+                   static_cast<qint64>(m_encoded.size());
+        }
+        ma_uint64 framesWritten = 0;
+        return m_isWavOpen && ma_encoder_write_pcm_frames(&m_wav, pFrames, frameCount, &framesWritten) == MA_SUCCESS &&
+               framesWritten == frameCount;
+    }
+
+    bool close()
+    {
+        bool isOk = true;
+        if (m_flac && m_file.isOpen()) {
+            m_encoded.clear();
+            m_flac->finish(&m_encoded);
+            const std::vector<uint8_t> header = m_flac->header();
+            isOk = m_file.write(reinterpret_cast<const char*>(m_encoded.data()), static_cast<qint64>(m_encoded.size())) ==
+                       static_cast<qint64>(m_encoded.size()) &&
+                   m_file.seek(0) &&
+                   m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<qint64>(header.size())) ==
+                       static_cast<qint64>(header.size()) &&
+                   m_file.flush();
+            m_file.close();
+        }
+        if (m_isWavOpen) {
+            ma_encoder_uninit(&m_wav); // Дописывает размеры в заголовок WAV
+            m_isWavOpen = false;
+        }
+        return isOk;
+    }
+
+private:
+    ma_uint32 m_channels;
+    ma_uint32 m_sampleRate;
+    std::unique_ptr<FlacEncoder> m_flac;
+    QFile m_file;
+    std::vector<uint8_t> m_encoded;
+    ma_encoder m_wav;
+    bool m_isWavOpen = false;
+};
+
+OutputRecorder::OutputRecorder(ma_uint32 channels, ma_uint32 sampleRate)
+    : m_channels(channels)
+    , m_sampleRate(sampleRate)
+    , m_isCapturing(false)
+    , m_droppedFrames(0)
+    , m_historyFrames(0)
+    , m_headFrame(0)
+    , m_validFromFrame(0)
+    , m_replaySeconds(0)
+    , m_lostFrames(0)
+    , m_isStopping(false)
+{
+    ma_pcm_rb_init(ma_format_f32, m_channels, kRingMillis * m_sampleRate / 1000, NULL, NULL, &m_ring);
+
+    // Сбор важнее записи: при нехватке процессора лучше отстанет диск, чем переполнится кольцо
+    m_pDrainThread = QThread::create([this]() { drainLoop(); });
+    m_pDrainThread->start(QThread::HighPriority);
+    m_pWriteThread = QThread::create([this]() { writeLoop(); });
+    m_pWriteThread->start(QThread::LowPriority);
+}
+
+OutputRecorder::~OutputRecorder()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isCapturing = false;
+        m_isStopping = true;
+    }
+    // Сначала сбор: все, что уже в кольце, попадает в историю и в идущую запись
+    m_drainWake.wakeAll();
+    m_pDrainThread->wait();
+    delete m_pDrainThread;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_liveJob) {
+            m_liveJob->endFrame = m_headFrame;
+            m_liveJob.reset();
+        }
+    }
+    m_writeWake.wakeAll();
+    m_pWriteThread->wait();
+    delete m_pWriteThread;
+    ma_pcm_rb_uninit(&m_ring);
+}
+
+void OutputRecorder::capture(const float* pFrames, ma_uint32 frameCount)
+{
+    if (!m_isCapturing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Кольцо может завернуться: тогда блок пишется в два приема
+    ma_uint32 framesDone = 0;
+    while (framesDone < frameCount) {
+        ma_uint32 framesToWrite = frameCount - framesDone;
+        void* pBuffer = nullptr;
+        if (ma_pcm_rb_acquire_write(&m_ring, &framesToWrite, &pBuffer) != MA_SUCCESS || framesToWrite == 0) {
+            break;
+        }
+        std::copy(pFrames + static_cast<size_t>(framesDone) * m_channels,
+                  pFrames + static_cast<size_t>(framesDone + framesToWrite) * m_channels, static_cast<float*>(pBuffer));
+        ma_pcm_rb_commit_write(&m_ring, framesToWrite);
+        framesDone += framesToWrite;
+    }
+    if (framesDone < frameCount) {
+        m_droppedFrames.fetch_add(frameCount - framesDone, std::memory_order_relaxed);
+    }
+}
+
+void OutputRecorder::setReplaySeconds(int seconds)
+{
+    seconds = std::clamp(seconds, 0, kMaxReplaySeconds);
+    QMutexLocker locker(&m_mutex);
+    if (seconds == m_replaySeconds) {
+        return;
+    }
+    m_replaySeconds = seconds;
+    resizeHistoryLocked();
+    updateCapturingLocked();
+    OSD_LOG_INFO(Engine, "Replay buffer seconds=%d memory_mb=%.1f", seconds,
+                 m_history.size() * sizeof(qint16) / (1024.0 * 1024.0));
+}
+
+int OutputRecorder::replaySeconds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_replaySeconds;
+}
+
+bool OutputRecorder::startRecording(const QString& filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_liveJob) {
+            return false;
+        }
+        if (m_history.empty()) {
+            // Без буфера повтора история — только запас записи
+            m_historyFrames = static_cast<quint64>(kWriteBehindSeconds) * m_sampleRate;
+            m_history.assign(static_cast<size_t>(m_historyFrames) * m_channels, 0);
+            m_validFromFrame = m_headFrame;
+        }
+        m_liveJob = std::make_shared<Job>();
+        m_liveJob->filePath = filePath;
+        m_liveJob->cursorFrame = m_headFrame;
+        m_liveJob->endFrame = UINT64_MAX;
+        m_liveJob->isLive = true;
+        m_jobs.append(m_liveJob);
+        updateCapturingLocked();
+    }
+    m_writeWake.wakeAll();
+    OSD_LOG_INFO(Engine, "Recording started path=\"%s\"", qUtf8Printable(filePath));
+    return true;
+}
+
+void OutputRecorder::stopRecording()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_liveJob) {
+            return;
+        }
+        m_liveJob->endFrame = m_headFrame; // Кадры, еще лежащие в кольце, в файл уже не войдут
+        m_liveJob.reset();
+        updateCapturingLocked();
+    }
+    m_writeWake.wakeAll();
+}
+
+bool OutputRecorder::isRecording() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_liveJob != nullptr;
+}
+
+bool OutputRecorder::saveReplay(const QString& filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const quint64 replayFrames = static_cast<quint64>(m_replaySeconds) * m_sampleRate;
+        const quint64 startFrame = std::max(oldestFrameLocked(), m_headFrame - std::min(m_headFrame, replayFrames));
+        if (m_replaySeconds == 0 || startFrame >= m_headFrame) {
+            return false;
+        }
+        auto job = std::make_shared<Job>();
+        job->filePath = filePath;
+        job->cursorFrame = startFrame;
+        job->endFrame = m_headFrame;
+        m_jobs.append(job);
+    }
+    m_writeWake.wakeAll();
+    OSD_LOG_INFO(Engine, "Saving replay path=\"%s\"", qUtf8Printable(filePath));
+    return true;
+}
+
+void OutputRecorder::setSavedCallback(SavedCallback callback)
+{
+    QMutexLocker locker(&m_mutex);
+    m_savedCallback = std::move(callback);
+}
+
+OutputRecorder::Stats OutputRecorder::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    stats.lostFrames = m_lostFrames;
+    stats.isRecording = m_liveJob != nullptr;
+    const quint64 replayFrames = std::min(m_headFrame - oldestFrameLocked(), static_cast<quint64>(m_replaySeconds) * m_sampleRate);
+    stats.replayMillis = static_cast<qint64>(replayFrames * 1000 / m_sampleRate);
+    return stats;
+}
+
+void OutputRecorder::resizeHistoryLocked()
+{
+    // Сохранение повтора читает кадры, собранные до него: новая история подождет его конца.
+    // Идущая запись не ждет — она теряет то, что не успела забрать из старой истории
+    const bool isReplaySaving = std::any_of(m_jobs.begin(), m_jobs.end(),
+                                            [](const std::shared_ptr<Job>& job) { return !job->isLive; });
+    const quint64 historyFrames = static_cast<quint64>(m_replaySeconds + kWriteBehindSeconds) * m_sampleRate;
+    const bool isNeeded = m_replaySeconds > 0 || m_liveJob != nullptr;
+    if (isReplaySaving || !isNeeded || historyFrames == m_historyFrames) {
+        return;
+    }
+    m_history.assign(static_cast<size_t>(historyFrames) * m_channels, 0);
+    m_history.shrink_to_fit();
+    m_historyFrames = historyFrames;
+    m_validFromFrame = m_headFrame;
+}
+
+void OutputRecorder::updateCapturingLocked()
+{
+    const bool isCapturing = !m_isStopping && (m_replaySeconds > 0 || m_liveJob != nullptr);
+    m_isCapturing = isCapturing;
+    if (!isCapturing && m_jobs.isEmpty() && m_historyFrames > 0) {
+        // История без записи и повтора не нужна; пока файл дописывается, она еще его запас
+        std::vector<qint16>().swap(m_history);
+        m_historyFrames = 0;
+        m_validFromFrame = m_headFrame;
+    }
+}
+
+quint64 OutputRecorder::oldestFrameLocked() const
+{
+    return std::max(m_validFromFrame, m_headFrame - std::min(m_headFrame, m_historyFrames));
+}
+
+void OutputRecorder::drainLoop()
+{
+    const ma_uint32 chunkFrames = kDrainMillis * m_sampleRate / 1000 * 4;
+    std::vector<qint16> converted(static_cast<size_t>(chunkFrames) * m_channels);
+    quint64 reportedDrops = 0;
+    for (;;) {
+        bool isStopping = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_isStopping) {
+                m_drainWake.wait(&m_mutex, kDrainMillis);
+            }
+            isStopping = m_isStopping;
+        }
+
+        for (;;) {
+            ma_uint32 frameCount = chunkFrames;
+            void* pBuffer = nullptr;
+            if (ma_pcm_rb_acquire_read(&m_ring, &frameCount, &pBuffer) != MA_SUCCESS || frameCount == 0) {
+                break;
+            }
+            ma_pcm_f32_to_s16(converted.data(), pBuffer, static_cast<ma_uint64>(frameCount) * m_channels,
+                              ma_dither_mode_none);
+            ma_pcm_rb_commit_read(&m_ring, frameCount);
+
+            QMutexLocker locker(&m_mutex);
+            if (m_historyFrames == 0) {
+                continue; // Сбор только что выключен: хвост кольца никому не нужен
+            }
+            for (ma_uint32 frame = 0; frame < frameCount;) {
+                const quint64 slot = (m_headFrame + frame) % m_historyFrames;
+                const ma_uint32 run = static_cast<ma_uint32>(std::min<quint64>(frameCount - frame, m_historyFrames - slot));
+                std::copy(converted.begin() + static_cast<qsizetype>(frame) * m_channels,
+                          converted.begin() + static_cast<qsizetype>(frame + run) * m_channels,
+                          m_history.begin() + static_cast<qsizetype>(slot * m_channels));
+                frame += run;
+            }
+            m_headFrame += frameCount;
+        }
+
+        const quint64 drops = m_droppedFrames.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            OSD_LOG_WARNING(Engine, "Capture ring overflowed dropped_frames=%llu",
+                            static_cast<unsigned long long>(drops - reportedDrops));
+            reportedDrops = drops;
+        }
+        if (isStopping) {
+            return;
+        }
+    }
+}
+
+void OutputRecorder::writeLoop()
+{
+    std::vector<qint16> buffer(static_cast<size_t>(kWriteChunkMillis * m_sampleRate / 1000) * m_channels);
+    for (;;) {
+        QList<std::shared_ptr<Job>> jobs;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_jobs.isEmpty()) {
+                if (m_isStopping) {
+                    return;
+                }
+                m_writeWake.wait(&m_mutex);
+                continue;
+            }
+            jobs = m_jobs;
+        }
+
+        // Задания пишутся по очереди кусками, пока не догонят историю
+        bool isWaiting = true;
+        for (const std::shared_ptr<Job>& job : jobs) {
+            const quint64 before = job->cursorFrame;
+            const bool isDone = writeJob(job.get(), &buffer);
+            isWaiting = isWaiting && !isDone && job->cursorFrame == before;
+            if (!isDone) {
+                continue;
+            }
+            const bool isSaved = !job->isFailed && job->sink && job->sink->close();
+            job->sink.reset();
+            SavedCallback callback;
+            {
+                QMutexLocker locker(&m_mutex);
+                m_jobs.removeOne(job);
+                if (job == m_liveJob) {
+                    m_liveJob.reset(); // Запись оборвалась на ошибке диска: isRecording() это покажет
+                }
+                resizeHistoryLocked(); // Размер, отложенный до конца сохранения повтора
+                updateCapturingLocked();
+                callback = m_savedCallback;
+            }
+            if (isSaved) {
+                OSD_LOG_INFO(Engine, "Capture saved path=\"%s\"", qUtf8Printable(job->filePath));
+            } else {
+                OSD_LOG_WARNING(Engine, "Failed to write capture path=\"%s\"", qUtf8Printable(job->filePath));
+            }
+            if (callback) {
+                callback(job->filePath, isSaved);
+            }
+        }
+        if (isWaiting) {
+            // Все догнали сбор: ждем следующей порции или остановки записи
+            QMutexLocker locker(&m_mutex);
+            m_writeWake.wait(&m_mutex, 4 * kDrainMillis);
+        }
+    }
+}
+
+bool OutputRecorder::writeJob(Job* pJob, std::vector<qint16>* pBuffer)
+{
+    if (pJob->isFailed) {
+        return true;
+    }
+    if (!pJob->sink) {
+        pJob->sink = std::make_unique<Sink>(m_channels, m_sampleRate);
+        if (!pJob->sink->open(pJob->filePath)) {
+            pJob->isFailed = true;
+            return true;
+        }
+    }
+
+    const quint64 chunkFrames = pBuffer->size() / m_channels;
+    quint64 frameCount = 0;
+    bool isDone = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        const quint64 oldestFrame = oldestFrameLocked();
+        if (pJob->cursorFrame < oldestFrame) {
+            m_lostFrames += oldestFrame - pJob->cursorFrame;
+            OSD_LOG_WARNING(Engine, "Capture writer fell behind lost_frames=%llu path=\"%s\"",
+                            static_cast<unsigned long long>(oldestFrame - pJob->cursorFrame),
+                            qUtf8Printable(pJob->filePath));
+            pJob->cursorFrame = oldestFrame;
+        }
+        const quint64 endFrame = std::min(pJob->endFrame, m_headFrame);
+        frameCount = std::min(chunkFrames, endFrame - std::min(endFrame, pJob->cursorFrame));
+        for (quint64 frame = 0; frame < frameCount;) {
+            const quint64 slot = (pJob->cursorFrame + frame) % m_historyFrames;
+            const quint64 run = std::min(frameCount - frame, m_historyFrames - slot);
+            std::copy(m_history.begin() + static_cast<qsizetype>(slot * m_channels),
+                      m_history.begin() + static_cast<qsizetype>((slot + run) * m_channels),
+                      pBuffer->begin() + static_cast<qsizetype>(frame * m_channels));
+            frame += run;
+        }
+        pJob->cursorFrame += frameCount;
+        // Конец задания известен, когда его endFrame уже собран; идущая запись ждет stopRecording()
+        isDone = pJob->endFrame <= m_headFrame && pJob->cursorFrame >= pJob->endFrame;
+    }
+
+    // Диск — вне мьютекса: сбор продолжается, пока файл пишется
+    if (frameCount > 0 && !pJob->sink->write(pBuffer->data(), frameCount)) {
+        pJob->isFailed = true;
+        return true;
+    }
+    return isDone;
+}
@@ -0,0 +1,127 @@
+// src/OutputRecorder.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "miniaudio.h"
+
+class QThread;
+
+// Запись выхода: ровно то, что ушло на устройство (деки и микрофон после мастер-шины).
+// Аудиопоток только копирует блок в кольцо без блокировок (ma_pcm_rb) и никогда не ждет:
+// если кольцо полно, хвост блока теряется и попадает в счетчик droppedFrames.
+//
+// Поток сбора каждые kDrainMillis переводит кольцо в 16 бит и дописывает в историю в памяти.
+// История — это и буфер повтора («последние N минут»), и запас записи: поток записи читает
+// файлы из нее, поэтому медленный диск задерживает только запись, а не сбор. Отстав больше
+// чем на kWriteBehindSeconds сверх буфера повтора, запись теряет кадры (lostFrames).
+//
+// Пока устройство остановлено (ни одна дека не играет, микрофон выключен), колбэка нет —
+// тишина не записывается и не занимает буфер повтора.
+class OutputRecorder
+{
+public:
+    static constexpr ma_uint32 kRingMillis = 4000; // Запас между аудиопотоком и потоком сбора
+    static constexpr ma_uint32 kDrainMillis = 20;
+    static constexpr int kWriteBehindSeconds = 30;
+    static constexpr int kMaxReplaySeconds = 30 * 60;
+
+    struct Stats {
+        quint64 droppedFrames = 0; // Не вошли в кольцо: поток сбора не успевал
+        quint64 lostFrames = 0;    // Ушли из истории раньше, чем попали в файл: диск не успевал
+        bool isRecording = false;
+        qint64 replayMillis = 0;   // Сколько уже накоплено для повтора
+    };
+
+    using SavedCallback = std::function<void(const QString& filePath, bool isSaved)>;
+
+    OutputRecorder(ma_uint32 channels, ma_uint32 sampleRate);
+    ~OutputRecorder(); // Дописывает и закрывает начатые файлы
+    OutputRecorder(const OutputRecorder&) = delete;
+    OutputRecorder& operator=(const OutputRecorder&) = delete;
+
+    // Аудиопоток. Ничего не делает, пока нет ни буфера повтора, ни записи
+    void capture(const float* pFrames, ma_uint32 frameCount);
+
+    // 0 — без буфера повтора. Смена размера очищает буфер, но не раньше, чем допишутся
+    // уже начатые сохранения повтора: до тех пор они читают прежнюю историю
+    void setReplaySeconds(int seconds);
+    int replaySeconds() const;
+
+    // Формат по расширению: .flac — FLAC (FlacEncoder), иначе WAV; оба 16 бит.
+    // Файлы открываются и пишутся в потоке записи, итог приходит в SavedCallback
+    bool startRecording(const QString& filePath); // false — запись уже идет
+    void stopRecording(); // Файл дописывается до этого момента и закрывается в фоне
+    bool isRecording() const;
+    bool saveReplay(const QString& filePath); // false — буфер повтора пуст
+    void setSavedCallback(SavedCallback callback); // Вызывается из потока записи
+
+    Stats stats() const;
+
+private:
+    class Sink;
+    struct Job {
+        QString filePath;
+        std::unique_ptr<Sink> sink;
+        quint64 cursorFrame = 0;
+        quint64 endFrame = 0; // Для идущей записи растет до stopRecording()
+        bool isLive = false;
+        bool isFailed = false;
+    };
+
+    void drainLoop();
+    void writeLoop();
+    bool writeJob(Job* pJob, std::vector<qint16>* pBuffer); // true — задание закончено
+    void resizeHistoryLocked(); // Под размер m_replaySeconds, если это никому не мешает
+    void updateCapturingLocked();
+    quint64 oldestFrameLocked() const;
+
+    ma_uint32 m_channels;
+    ma_uint32 m_sampleRate;
+    ma_pcm_rb m_ring;
+    std::atomic<bool> m_isCapturing;
+    std::atomic<quint64> m_droppedFrames;
+
+    mutable QMutex m_mutex; // История, задания и настройки; аудиопоток его не берет
+    QWaitCondition m_drainWake;
+    QWaitCondition m_writeWake;
+    std::vector<qint16> m_history; // Кольцо на m_historyFrames кадров с чередованием каналов
+    quint64 m_historyFrames;
+    quint64 m_headFrame;      // Собрано всего; кадр f лежит в ячейке f % m_historyFrames
+    quint64 m_validFromFrame; // История перевыделялась: раньше этого кадра в ней ничего нет
+    int m_replaySeconds;
+    QList<std::shared_ptr<Job>> m_jobs;
+    std::shared_ptr<Job> m_liveJob;
+    quint64 m_lostFrames;
+    SavedCallback m_savedCallback;
+    bool m_isStopping;
+
+    QThread* m_pDrainThread;
+    QThread* m_pWriteThread;
+};
@@ -0,0 +1,211 @@
+// src/ParallelMixer.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelMixer.h"
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+uint64_t packRange(uint32_t generation, uint32_t begin, uint32_t end)
+{
+    return (static_cast<uint64_t>(generation) << 32) | (begin << 16) | end;
+}
+
+uint32_t rangeGeneration(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+uint32_t rangeBegin(uint64_t range) { return static_cast<uint32_t>(range >> 16) & 0xFFFF; }
+uint32_t rangeEnd(uint64_t range) { return static_cast<uint32_t>(range) & 0xFFFF; }
+
+// Пауза в цикле ожидания: освобождает ресурсы ядра соседнему гиперпотоку
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+bool pinThread(std::thread& thread, int cpu, bool realtimePriority)
+{
+    bool isOk = true;
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    isOk = pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet) == 0;
+    if (realtimePriority) {
+        // На ступень ниже потока устройства: он ждет рабочих на барьере и не должен быть вытеснен ими
+        sched_param parameters = {};
+        parameters.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+        isOk = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &parameters) == 0 && isOk;
+    }
+#elif defined(_WIN32)
+    const HANDLE handle = static_cast<HANDLE>(thread.native_handle());
+    isOk = SetThreadAffinityMask(handle, DWORD_PTR(1) << cpu) != 0;
+    isOk = SetThreadPriority(handle, realtimePriority ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST) && isOk;
+#else
+    // macOS не дает закреплять потоки за ядрами
+    (void)thread;
+    (void)cpu;
+    (void)realtimePriority;
+#endif
+    return isOk;
+}
+
+} // namespace
+
+ParallelMixer::~ParallelMixer()
+{
+    stop();
+}
+
+bool ParallelMixer::start(int workerCount, bool realtimePriority)
+{
+    stop();
+    workerCount = std::clamp(workerCount, 0, kMaxWorkers);
+    const int cpuCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    m_queueCount = workerCount + 1;
+    const uint32_t generation = m_generation.load(std::memory_order_relaxed);
+    bool isPinned = true;
+    m_workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&ParallelMixer::workerLoop, this, i + 1, generation);
+        isPinned = pinThread(m_workers.back(), (i + 1) % cpuCount, realtimePriority) && isPinned;
+    }
+    return isPinned;
+}
+
+void ParallelMixer::stop()
+{
+    if (m_workers.empty()) {
+        return;
+    }
+    m_isStopping.store(true);
+    m_generation.fetch_add(1);
+    m_generation.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_queueCount = 1;
+    m_isStopping.store(false);
+}
+
+void ParallelMixer::run(int jobCount, JobFunction function, void* pContext)
+{
+    if (m_workers.empty() || jobCount <= 1) {
+        for (int job = 0; job < jobCount; ++job) {
+            function(pContext, job);
+        }
+        return;
+    }
+
+    // Поровну подряд идущих заданий каждому участнику; лишние участники начинают с кражи
+    const uint32_t generation = m_generation.load(std::memory_order_relaxed) + 1;
+    const int participants = std::min(m_queueCount, jobCount);
+    for (int queue = 0; queue < m_queueCount; ++queue) {
+        const uint32_t begin = queue < participants ? static_cast<uint32_t>(queue * jobCount / participants) : 0;
+        const uint32_t end = queue < participants ? static_cast<uint32_t>((queue + 1) * jobCount / participants) : 0;
+        m_queues[queue].range.store(packRange(generation, begin, end), std::memory_order_relaxed);
+    }
+    m_function.store(function, std::memory_order_relaxed);
+    m_pContext.store(pContext, std::memory_order_relaxed);
+    m_pending.store(jobCount, std::memory_order_relaxed);
+
+    // seq_cst в паре с m_sleepers: либо рабочий увидит новое поколение до сна, либо мы увидим, что он спит
+    m_generation.store(generation);
+    if (m_sleepers.load() > 0) {
+        m_generation.notify_all();
+    }
+
+    executeFrom(0, generation);
+    while (m_pending.load(std::memory_order_acquire) > 0) {
+        cpuRelax();
+    }
+}
+
+void ParallelMixer::workerLoop(int participant, uint32_t generation)
+{
+    uint32_t seen = generation;
+    for (;;) {
+        uint32_t current = m_generation.load(std::memory_order_acquire);
+        for (int i = 0; i < kSpinIterations && current == seen; ++i) {
+            cpuRelax();
+            current = m_generation.load(std::memory_order_acquire);
+        }
+        if (current == seen) {
+            m_sleepers.fetch_add(1);
+            m_generation.wait(seen);
+            m_sleepers.fetch_sub(1);
+            continue;
+        }
+        if (m_isStopping.load()) {
+            return;
+        }
+        seen = current;
+        executeFrom(participant, current);
+    }
+}
+
+void ParallelMixer::executeFrom(int participant, uint32_t generation)
+{
+    int job = 0;
+    // Сначала свои задания с начала очереди, затем чужие с конца — туда, где владелец будет последним
+    for (int offset = 0; offset < m_queueCount; ++offset) {
+        const int queue = (participant + offset) % m_queueCount;
+        const bool isOwn = offset == 0;
+        while (claim(queue, generation, isOwn, &job)) {
+            // Задание взято, значит поколение еще идет и функция относится к нему
+            m_function.load(std::memory_order_relaxed)(m_pContext.load(std::memory_order_relaxed), job);
+            m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+bool ParallelMixer::claim(int queue, uint32_t generation, bool fromFront, int* pJob)
+{
+    std::atomic<uint64_t>& range = m_queues[queue].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t begin = rangeBegin(current);
+        const uint32_t end = rangeEnd(current);
+        if (rangeGeneration(current) != generation || begin >= end) {
+            return false;
+        }
+        const uint64_t next = fromFront ? packRange(generation, begin + 1, end) : packRange(generation, begin, end - 1);
+        if (range.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            *pJob = static_cast<int>(fromFront ? begin : end - 1);
+            return true;
+        }
+    }
+}
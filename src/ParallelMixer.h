@@ -0,0 +1,90 @@
+// src/ParallelMixer.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Пул потоков для рендера независимых голосов внутри одного периода. Без Qt и без
+// блокировок: аудиопоток раскладывает задания по участникам, сам берет свою долю,
+// а закончившие участники воруют задания у остальных. run() возвращается, когда
+// выполнено последнее задание (атомарный счетчик — барьер периода).
+//
+// Задания участника идут подряд: один и тот же голос из периода в период попадает на
+// то же закрепленное ядро, и его состояние (растяжение, фильтры) остается в кэше.
+//
+// Рабочие потоки ждут период, крутясь на счетчике поколений, а после kSpinIterations
+// пустых проверок засыпают на std::atomic::wait — аудиопоток будит их, только если
+// кто-то действительно спит.
+class ParallelMixer
+{
+public:
+    using JobFunction = void (*)(void* pContext, int job);
+
+    static constexpr int kMaxWorkers = 15;
+    static constexpr int kSpinIterations = 4000;
+    static constexpr int kMaxJobs = 0xFFFF;
+
+    ParallelMixer() = default;
+    ~ParallelMixer();
+    ParallelMixer(const ParallelMixer&) = delete;
+    ParallelMixer& operator=(const ParallelMixer&) = delete;
+
+    // Запускает workerCount потоков, закрепленных за ядрами 1..workerCount. Вызывающий run()
+    // поток не закрепляется: ядро аудиопотоку устройства выбирает ОС, и рабочий может делить
+    // его с ним. Возвращает false, если не удалось закрепить поток или поднять приоритет:
+    // пул при этом работает, просто без этих гарантий.
+    bool start(int workerCount, bool realtimePriority);
+    void stop();
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+    // Аудиопоток. Выполняет function(pContext, 0..jobCount-1) и возвращается после последнего.
+    // Заданий не больше kMaxJobs.
+    // Без рабочих потоков все задания выполняются в вызывающем потоке по порядку.
+    void run(int jobCount, JobFunction function, void* pContext);
+
+private:
+    // Очередь участника — диапазон [begin, end) заданий (по 16 бит), упакованный вместе
+    // с 32-битным номером поколения в одно слово: владелец берет с начала, вор с конца, оба через CAS.
+    // Поколение не дает опоздавшему вору взять задание следующего периода со старой функцией.
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> range{0};
+    };
+
+    void workerLoop(int participant, uint32_t generation);
+    void executeFrom(int participant, uint32_t generation);
+    bool claim(int queue, uint32_t generation, bool fromFront, int* pJob);
+
+    std::vector<std::thread> m_workers;
+    Queue m_queues[kMaxWorkers + 1]; // Участник 0 — вызывающий run() поток
+    int m_queueCount = 1;            // Рабочие + вызывающий; меняется только при остановленном пуле
+
+    alignas(64) std::atomic<uint32_t> m_generation{0};
+    alignas(64) std::atomic<int> m_pending{0}; // Барьер: невыполненные задания периода
+    std::atomic<int> m_sleepers{0};
+    std::atomic<bool> m_isStopping{false};
+
+    // Пишутся аудиопотоком до публикации поколения, читаются после успешного claim()
+    std::atomic<JobFunction> m_function{nullptr};
+    std::atomic<void*> m_pContext{nullptr};
+};
@@ -0,0 +1,217 @@
+// src/Playlist.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Playlist.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include "Log.h"
+
+namespace {
+
+QString formatFields(const PlaylistEntry& entry)
+{
+    const AudioEngine::PlaybackRegion& region = entry.region;
+    QStringList fields;
+    if (entry.bank > 0) fields << QString("bank=%1").arg(entry.bank);
+    if (region.startMillis > 0) fields << QString("start=%1").arg(region.startMillis);
+    if (region.endMillis > 0) fields << QString("end=%1").arg(region.endMillis);
+    if (region.loop) fields << QString("loop=1");
+    if (region.loopStartMillis > 0) fields << QString("loopStart=%1").arg(region.loopStartMillis);
+    if (region.loopEndMillis > 0) fields << QString("loopEnd=%1").arg(region.loopEndMillis);
+    if (region.crossfadeMillis > 0) fields << QString("crossfade=%1").arg(region.crossfadeMillis);
+    if (!region.cueMillis.isEmpty()) {
+        QStringList cues;
+        for (ma_uint64 cue : region.cueMillis) {
+            cues << QString::number(cue);
+        }
+        fields << "cues=" + cues.join(',');
+    }
+    if (entry.params.tempo != 1.0f) fields << QString("tempo=%1").arg(entry.params.tempo);
+    if (entry.params.pitchSemitones != 0.0f) fields << QString("pitch=%1").arg(entry.params.pitchSemitones);
+    if (entry.params.gain != 1.0f) fields << QString("gain=%1").arg(entry.params.gain);
+    if (entry.params.chokeGroup != 0) fields << QString("choke=%1").arg(entry.params.chokeGroup);
+    if (!entry.params.effects.isDefault()) fields << "fx=" + Playlist::formatEffects(entry.params.effects);
+    return fields.join('\t');
+}
+
+} // namespace
+
+namespace Playlist {
+
+void parseField(const QString& field, PlaylistEntry* pEntry)
+{
+    AudioEngine::PlaybackRegion* pRegion = &pEntry->region;
+    const int separator = field.indexOf('=');
+    if (separator <= 0) {
+        return;
+    }
+    const QString key = field.left(separator);
+    const QString value = field.mid(separator + 1);
+
+    if (key == "start") {
+        pRegion->startMillis = value.toULongLong();
+    } else if (key == "end") {
+        pRegion->endMillis = value.toULongLong();
+    } else if (key == "loop") {
+        pRegion->loop = value == "1";
+    } else if (key == "loopStart") {
+        pRegion->loopStartMillis = value.toULongLong();
+    } else if (key == "loopEnd") {
+        pRegion->loopEndMillis = value.toULongLong();
+    } else if (key == "crossfade") {
+        pRegion->crossfadeMillis = value.toULongLong();
+    } else if (key == "cues") {
+        for (const QString& cue : value.split(',', Qt::SkipEmptyParts)) {
+            pRegion->cueMillis.append(cue.toULongLong());
+        }
+    } else if (key == "tempo") {
+        pEntry->params.tempo = value.toFloat();
+    } else if (key == "pitch") {
+        pEntry->params.pitchSemitones = value.toFloat();
+    } else if (key == "gain") {
+        pEntry->params.gain = value.toFloat();
+    } else if (key == "choke") {
+        pEntry->params.chokeGroup = qMax(value.toInt(), 0);
+    } else if (key == "bank") {
+        pEntry->bank = qBound(0, value.toInt(), AudioEngine::kDeckCount - 1);
+    } else if (key == "fx") {
+        pEntry->params.effects = Playlist::parseEffects(value);
+    } else {
+        OSD_LOG_DEBUG(Library, "Playlist: unknown track field key=%s", qUtf8Printable(key));
+    }
+}
+
+AudioEngine::EffectSettings parseEffects(const QString& text)
+{
+    AudioEngine::EffectSettings settings;
+    for (const QString& node : text.split(';', Qt::SkipEmptyParts)) {
+        const int separator = node.indexOf(':');
+        const QString name = separator < 0 ? node : node.left(separator);
+        const QStringList values = separator < 0 ? QStringList() : node.mid(separator + 1).split(',');
+        // Недостающие значения остаются по умолчанию
+        auto value = [&values](int index, float* pTarget) {
+            if (index < values.size()) {
+                bool ok = false;
+                const float parsed = values[index].toFloat(&ok);
+                if (ok) {
+                    *pTarget = parsed;
+                }
+            }
+        };
+
+        if (name == "hp") {
+            settings.highPassEnabled = true;
+            value(0, &settings.highPassHz);
+        } else if (name == "eq") {
+            settings.eqEnabled = true;
+            value(0, &settings.eqLowGainDb);
+            value(1, &settings.eqMidGainDb);
+            value(2, &settings.eqMidHz);
+            value(3, &settings.eqHighGainDb);
+        } else if (name == "crush") {
+            settings.bitcrushEnabled = true;
+            value(0, &settings.bitcrushBits);
+            value(1, &settings.bitcrushDownsample);
+            value(2, &settings.bitcrushMix);
+        } else if (name == "robot") {
+            settings.robotEnabled = true;
+            value(0, &settings.robotHz);
+            value(1, &settings.robotMix);
+        } else if (name == "reverb") {
+            settings.reverbEnabled = true;
+            value(0, &settings.reverbRoomSize);
+            value(1, &settings.reverbDamping);
+            value(2, &settings.reverbWet);
+        } else {
+            OSD_LOG_DEBUG(Library, "Playlist: unknown effect name=%s", qUtf8Printable(name));
+        }
+    }
+    return settings;
+}
+
+QString formatEffects(const AudioEngine::EffectSettings& settings)
+{
+    QStringList nodes;
+    if (settings.highPassEnabled) {
+        nodes << QString("hp:%1").arg(settings.highPassHz);
+    }
+    if (settings.eqEnabled) {
+        nodes << QString("eq:%1,%2,%3,%4").arg(settings.eqLowGainDb).arg(settings.eqMidGainDb)
+                     .arg(settings.eqMidHz).arg(settings.eqHighGainDb);
+    }
+    if (settings.bitcrushEnabled) {
+        nodes << QString("crush:%1,%2,%3").arg(settings.bitcrushBits).arg(settings.bitcrushDownsample)
+                     .arg(settings.bitcrushMix);
+    }
+    if (settings.robotEnabled) {
+        nodes << QString("robot:%1,%2").arg(settings.robotHz).arg(settings.robotMix);
+    }
+    if (settings.reverbEnabled) {
+        nodes << QString("reverb:%1,%2,%3").arg(settings.reverbRoomSize).arg(settings.reverbDamping)
+                     .arg(settings.reverbWet);
+    }
+    return nodes.join(';');
+}
+
+bool load(const QString& fileName, QList<PlaylistEntry>* pEntries)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+
+        const QStringList fields = line.split('\t');
+        PlaylistEntry entry;
+        entry.filePath = fields.first();
+        for (int i = 1; i < fields.size(); ++i) {
+            parseField(fields[i], &entry);
+        }
+        pEntries->append(entry);
+    }
+    return true;
+}
+
+bool save(const QString& fileName, const QList<PlaylistEntry>& entries)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    for (const PlaylistEntry& entry : entries) {
+        out << entry.filePath;
+        if (entry.bank > 0 || !entry.region.isDefault() || !entry.params.isDefault()) {
+            out << '\t' << formatFields(entry);
+        }
+        out << "\n";
+    }
+    return true;
+}
+
+} // namespace Playlist
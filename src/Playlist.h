@@ -0,0 +1,49 @@
+// src/Playlist.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include "AudioEngine.h"
+
+// Трек плейлиста .osdpl: путь к файлу, банк, область воспроизведения, темп, тон, громкость и эффекты
+struct PlaylistEntry {
+    QString filePath;
+    int bank = 0; // Банк и дека, на которой он играет: 0..AudioEngine::kDeckCount-1
+    AudioEngine::PlaybackRegion region;
+    AudioEngine::VoiceParams params;
+};
+
+// Формат .osdpl: одна строка на трек. Старые плейлисты содержат только путь;
+// настройки трека дописываются после пути через табуляцию в виде key=value.
+namespace Playlist {
+
+bool load(const QString& fileName, QList<PlaylistEntry>* pEntries);
+bool save(const QString& fileName, const QList<PlaylistEntry>& entries);
+// Одно поле трека key=value поверх уже заполненного; неизвестный ключ пропускается
+void parseField(const QString& field, PlaylistEntry* pEntry);
+
+// Цепочка эффектов одной строкой: включенные узлы через «;», параметры через «,»,
+// например "hp:80;reverb:0.6,0.4,0.25". Тот же формат хранится в настройках для шин.
+AudioEngine::EffectSettings parseEffects(const QString& text);
+QString formatEffects(const AudioEngine::EffectSettings& settings);
+
+} // namespace Playlist
@@ -0,0 +1,173 @@
+// src/RealFft.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RealFft.h"
+
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OSD_HAS_SSE
+#endif
+
+RealFft::RealFft(size_t size)
+    : m_size(size)
+{
+    assert(size >= 16 && size <= 4096 && (size & (size - 1)) == 0);
+    const size_t half = size / 2;
+
+    m_bitReverse.resize(half);
+    size_t bits = 0;
+    while ((size_t(1) << bits) < half) {
+        ++bits;
+    }
+    for (size_t i = 0; i < half; ++i) {
+        size_t reversed = 0;
+        for (size_t bit = 0; bit < bits; ++bit) {
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        }
+        m_bitReverse[i] = reversed;
+    }
+
+    // Прямое преобразование: поворот e^(-2πik/len), поэтому синусы хранятся с минусом
+    m_stageCos.resize(half - 1);
+    m_stageSin.resize(half - 1);
+    for (size_t stageHalf = 1; stageHalf < half; stageHalf *= 2) {
+        for (size_t k = 0; k < stageHalf; ++k) {
+            const double angle = std::numbers::pi * static_cast<double>(k) / static_cast<double>(stageHalf);
+            m_stageCos[stageHalf - 1 + k] = static_cast<float>(std::cos(angle));
+            m_stageSin[stageHalf - 1 + k] = static_cast<float>(-std::sin(angle));
+        }
+    }
+    m_splitCos.resize(half + 1);
+    m_splitSin.resize(half + 1);
+    for (size_t k = 0; k <= half; ++k) {
+        const double angle = 2.0 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(size);
+        m_splitCos[k] = static_cast<float>(std::cos(angle));
+        m_splitSin[k] = static_cast<float>(-std::sin(angle));
+    }
+
+    m_re.resize(half);
+    m_im.resize(half);
+}
+
+void RealFft::forward(const float* pInput, float* pRe, float* pIm)
+{
+    // Четные отсчеты — в действительную часть, нечетные — в мнимую
+    const size_t half = m_size / 2;
+    for (size_t n = 0; n < half; ++n) {
+        m_re[m_bitReverse[n]] = pInput[2 * n];
+        m_im[m_bitReverse[n]] = pInput[2 * n + 1];
+    }
+    transform();
+
+    // Спектры четных (E) и нечетных (O) отсчетов из одного комплексного: X[k] = E[k] + W^k·O[k]
+    for (size_t k = 0; k <= half; ++k) {
+        const size_t k0 = k < half ? k : 0;
+        const size_t k1 = k > 0 ? half - k : 0;
+        const float zRe = m_re[k0];
+        const float zIm = m_im[k0];
+        const float cRe = m_re[k1];
+        const float cIm = -m_im[k1];
+        const float evenRe = 0.5f * (zRe + cRe);
+        const float evenIm = 0.5f * (zIm + cIm);
+        const float oddRe = 0.5f * (zIm - cIm);
+        const float oddIm = -0.5f * (zRe - cRe);
+        const float wRe = m_splitCos[k];
+        const float wIm = m_splitSin[k];
+        pRe[k] = evenRe + wRe * oddRe - wIm * oddIm;
+        pIm[k] = evenIm + wRe * oddIm + wIm * oddRe;
+    }
+}
+
+void RealFft::inverse(const float* pRe, const float* pIm, float* pOutput)
+{
+    // Обратный путь: собираем комплексный спектр длины N/2 и обращаем его через сопряжение
+    const size_t half = m_size / 2;
+    for (size_t k = 0; k < half; ++k) {
+        const float xRe = pRe[k];
+        const float xIm = pIm[k];
+        const float cRe = pRe[half - k];
+        const float cIm = -pIm[half - k];
+        const float evenRe = 0.5f * (xRe + cRe);
+        const float evenIm = 0.5f * (xIm + cIm);
+        const float diffRe = 0.5f * (xRe - cRe);
+        const float diffIm = 0.5f * (xIm - cIm);
+        const float wRe = m_splitCos[k];
+        const float wIm = m_splitSin[k];
+        const float oddRe = wRe * diffRe + wIm * diffIm;
+        const float oddIm = wRe * diffIm - wIm * diffRe;
+        m_re[m_bitReverse[k]] = evenRe - oddIm;
+        m_im[m_bitReverse[k]] = -(evenIm + oddRe);
+    }
+    transform();
+
+    const float scale = 1.0f / static_cast<float>(half);
+    for (size_t n = 0; n < half; ++n) {
+        pOutput[2 * n] = m_re[n] * scale;
+        pOutput[2 * n + 1] = -m_im[n] * scale;
+    }
+}
+
+void RealFft::transform()
+{
+    const size_t length = m_size / 2;
+    float* pRe = m_re.data();
+    float* pIm = m_im.data();
+
+    for (size_t half = 1; half < length; half *= 2) {
+        const float* pCos = m_stageCos.data() + half - 1;
+        const float* pSin = m_stageSin.data() + half - 1;
+        for (size_t group = 0; group < length; group += 2 * half) {
+            float* aRe = pRe + group;
+            float* aIm = pIm + group;
+            float* bRe = aRe + half;
+            float* bIm = aIm + half;
+            size_t k = 0;
+#if defined(OSD_HAS_SSE)
+            // С четвертой ступени бабочки группы идут по 4: повороты и оба плеча лежат подряд
+            for (; k + 4 <= half; k += 4) {
+                const __m128 c = _mm_loadu_ps(pCos + k);
+                const __m128 s = _mm_loadu_ps(pSin + k);
+                const __m128 xRe = _mm_loadu_ps(bRe + k);
+                const __m128 xIm = _mm_loadu_ps(bIm + k);
+                const __m128 tRe = _mm_sub_ps(_mm_mul_ps(xRe, c), _mm_mul_ps(xIm, s));
+                const __m128 tIm = _mm_add_ps(_mm_mul_ps(xRe, s), _mm_mul_ps(xIm, c));
+                const __m128 yRe = _mm_loadu_ps(aRe + k);
+                const __m128 yIm = _mm_loadu_ps(aIm + k);
+                _mm_storeu_ps(bRe + k, _mm_sub_ps(yRe, tRe));
+                _mm_storeu_ps(bIm + k, _mm_sub_ps(yIm, tIm));
+                _mm_storeu_ps(aRe + k, _mm_add_ps(yRe, tRe));
+                _mm_storeu_ps(aIm + k, _mm_add_ps(yIm, tIm));
+            }
+#endif
+            for (; k < half; ++k) {
+                const float tRe = bRe[k] * pCos[k] - bIm[k] * pSin[k];
+                const float tIm = bRe[k] * pSin[k] + bIm[k] * pCos[k];
+                bRe[k] = aRe[k] - tRe;
+                bIm[k] = aIm[k] - tIm;
+                aRe[k] += tRe;
+                aIm[k] += tIm;
+            }
+        }
+    }
+}
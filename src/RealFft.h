@@ -0,0 +1,56 @@
+// src/RealFft.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// БПФ вещественного сигнала длины N (степень двойки, 16..4096) через комплексное БПФ
+// длины N/2. Данные хранятся раздельно (re[] и im[]), поэтому бабочки одной ступени —
+// плоские циклы по соседним элементам: на x86 они идут по 4 через SSE, на остальных
+// платформах их векторизует компилятор.
+//
+// Спектр — N/2 + 1 бинов от 0 до частоты Найквиста, без нормировки; inverse(forward(x)) == x.
+// Таблицы и рабочие буферы выделяются в конструкторе, преобразования память не выделяют.
+// Один объект — один поток.
+class RealFft
+{
+public:
+    explicit RealFft(size_t size);
+
+    size_t size() const { return m_size; }
+    size_t binCount() const { return m_size / 2 + 1; }
+
+    void forward(const float* pInput, float* pRe, float* pIm);
+    void inverse(const float* pRe, const float* pIm, float* pOutput);
+
+private:
+    void transform(); // Комплексное БПФ длины N/2 на месте, вход уже в бит-реверсном порядке
+
+    const size_t m_size;
+    std::vector<size_t> m_bitReverse;
+    std::vector<float> m_stageCos;  // Повороты ступеней подряд: ступень с половиной h — с индекса h - 1
+    std::vector<float> m_stageSin;
+    std::vector<float> m_splitCos;  // Повороты разделения на четные и нечетные отсчеты, N/2 + 1
+    std::vector<float> m_splitSin;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+};
@@ -0,0 +1,406 @@
+// src/SampleStore.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SampleStore.h"
+#include "Log.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Стандартные таблицы IMA ADPCM
+const int kStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+const int kIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+struct AdpcmState {
+    int predictor = 0;
+    int index = 0;
+};
+
+inline int clampIndex(int index)
+{
+    return std::clamp(index, 0, 88);
+}
+
+inline int clampSample(int sample)
+{
+    return std::clamp(sample, -32768, 32767);
+}
+
+// Один масштаб у кодера и декодера, как у miniaudio для s16: клип в памяти звучит с единичным
+// усилением относительно потокового чтения
+constexpr float kSampleScale = 32768.0f;
+
+inline int16_t toInt16(float sample)
+{
+    return static_cast<int16_t>(clampSample(static_cast<int>(sample * kSampleScale)));
+}
+
+// Обновляет состояние по полубайту; общая часть кодера и декодера
+inline void applyNibble(AdpcmState& state, uint8_t nibble)
+{
+    const int step = kStepTable[state.index];
+    int diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    state.predictor = clampSample((nibble & 8) ? state.predictor - diff : state.predictor + diff);
+    state.index = clampIndex(state.index + kIndexTable[nibble]);
+}
+
+inline uint8_t encodeSample(AdpcmState& state, int sample)
+{
+    int diff = sample - state.predictor;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int step = kStepTable[state.index];
+    if (diff >= step) { nibble |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 1; }
+
+    applyNibble(state, nibble);
+    return nibble;
+}
+
+} // namespace
+
+CompressedClip::CompressedClip(ma_uint32 channels, ma_uint32 sampleRate)
+    : m_frameCount(0),
+      m_channels(channels),
+      m_sampleRate(sampleRate)
+{
+}
+
+std::shared_ptr<CompressedClip> CompressedClip::fromDecoder(ma_decoder* pDecoder)
+{
+    if (pDecoder == nullptr || pDecoder->outputFormat != ma_format_f32 ||
+        pDecoder->outputChannels == 0 || pDecoder->outputChannels > kMaxChannels) {
+        return nullptr;
+    }
+
+    std::shared_ptr<CompressedClip> clip(new CompressedClip(pDecoder->outputChannels, pDecoder->outputSampleRate));
+    const ma_uint32 channels = clip->m_channels;
+    const size_t blockBytes = clip->blockBytes();
+
+    ma_uint64 lengthFrames = 0;
+    if (ma_decoder_get_length_in_pcm_frames(pDecoder, &lengthFrames) == MA_SUCCESS && lengthFrames > 0) {
+        clip->m_data.reserve(((lengthFrames + kBlockFrames - 1) / kBlockFrames) * blockBytes);
+    }
+
+    float frames[kBlockFrames * kMaxChannels];
+    AdpcmState states[kMaxChannels];
+
+    for (;;) {
+        ma_uint64 framesRead = 0;
+        ma_decoder_read_pcm_frames(pDecoder, frames, kBlockFrames, &framesRead);
+        if (framesRead == 0) {
+            break;
+        }
+        if (framesRead < kBlockFrames) {
+            std::memset(frames + framesRead * channels, 0, (kBlockFrames - framesRead) * channels * sizeof(float));
+        }
+
+        const size_t blockOffset = clip->m_data.size();
+        clip->m_data.resize(blockOffset + blockBytes, 0);
+        uint8_t* pBlock = clip->m_data.data() + blockOffset;
+
+        for (ma_uint32 ch = 0; ch < channels; ++ch) {
+            uint8_t* pChannel = pBlock + ch * (4 + kBlockFrames / 2);
+            AdpcmState& state = states[ch];
+
+            // Первый семпл блока хранится точно — это точка ресинхронизации
+            state.predictor = toInt16(frames[ch]);
+            const uint16_t predictorBits = static_cast<uint16_t>(static_cast<int16_t>(state.predictor));
+            pChannel[0] = static_cast<uint8_t>(predictorBits & 0xFF);
+            pChannel[1] = static_cast<uint8_t>(predictorBits >> 8);
+            pChannel[2] = static_cast<uint8_t>(state.index);
+            pChannel[3] = 0;
+
+            uint8_t* pNibbles = pChannel + 4;
+            for (ma_uint32 i = 1; i < kBlockFrames; ++i) {
+                const uint8_t nibble = encodeSample(state, toInt16(frames[i * channels + ch]));
+                pNibbles[i >> 1] |= (i & 1) ? static_cast<uint8_t>(nibble << 4) : nibble;
+            }
+        }
+
+        clip->m_frameCount += framesRead;
+        if (framesRead < kBlockFrames) {
+            break;
+        }
+    }
+
+    clip->m_data.shrink_to_fit();
+    return clip;
+}
+
+ma_uint32 CompressedClip::decodeBlock(ma_uint64 blockIndex, float* out) const
+{
+    if (blockIndex >= blockCount()) {
+        return 0;
+    }
+
+    const uint8_t* pBlock = m_data.data() + blockIndex * blockBytes();
+    const float scale = 1.0f / kSampleScale;
+
+    for (ma_uint32 ch = 0; ch < m_channels; ++ch) {
+        const uint8_t* pChannel = pBlock + ch * (4 + kBlockFrames / 2);
+        AdpcmState state;
+        state.predictor = static_cast<int16_t>(pChannel[0] | (pChannel[1] << 8));
+        state.index = clampIndex(pChannel[2]);
+
+        const uint8_t* pNibbles = pChannel + 4;
+        out[ch] = state.predictor * scale;
+        for (ma_uint32 i = 1; i < kBlockFrames; ++i) {
+            const uint8_t packed = pNibbles[i >> 1];
+            applyNibble(state, (i & 1) ? (packed >> 4) : (packed & 0x0F));
+            out[i * m_channels + ch] = state.predictor * scale;
+        }
+    }
+
+    const ma_uint64 firstFrame = blockIndex * kBlockFrames;
+    return static_cast<ma_uint32>(std::min<ma_uint64>(kBlockFrames, m_frameCount - firstFrame));
+}
+
+void ClipReader::reset(const CompressedClip* pClip)
+{
+    m_pClip = pClip;
+    m_cursor = 0;
+    m_cachedBlock = UINT64_MAX;
+    m_cachedFrames = 0;
+}
+
+void ClipReader::seek(ma_uint64 frame)
+{
+    if (m_pClip == nullptr) {
+        return;
+    }
+    m_cursor = std::min(frame, m_pClip->frameCount());
+}
+
+ma_uint64 ClipReader::read(float* pOut, ma_uint64 frameCount)
+{
+    if (m_pClip == nullptr) {
+        return 0;
+    }
+
+    const ma_uint32 channels = m_pClip->channels();
+    const ma_uint64 totalFrames = m_pClip->frameCount();
+    ma_uint64 framesDone = 0;
+
+    while (framesDone < frameCount && m_cursor < totalFrames) {
+        const ma_uint64 block = m_cursor / CompressedClip::kBlockFrames;
+        if (block != m_cachedBlock) {
+            // Декодируем блок "точно в срок" прямо в цикле микширования
+            m_cachedFrames = m_pClip->decodeBlock(block, m_block);
+            m_cachedBlock = block;
+        }
+
+        const ma_uint64 offset = m_cursor % CompressedClip::kBlockFrames;
+        const ma_uint64 count = std::min<ma_uint64>(m_cachedFrames - offset, frameCount - framesDone);
+        std::memcpy(pOut + framesDone * channels, m_block + offset * channels, count * channels * sizeof(float));
+
+        m_cursor += count;
+        framesDone += count;
+    }
+
+    return framesDone;
+}
+
+SampleStore::SampleStore(size_t budgetBytes)
+    : m_budgetBytes(budgetBytes),
+      m_residentBytes(0),
+      m_useCounter(0)
+{
+}
+
+std::shared_ptr<const CompressedClip> SampleStore::load(const QString& filePath, ma_uint32 channels, ma_uint32 sampleRate)
+{
+    if (std::shared_ptr<const CompressedClip> existing = find(filePath)) {
+        return existing;
+    }
+
+    ma_decoder decoder;
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, channels, sampleRate);
+    if (ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder) != MA_SUCCESS) {
+        OSD_LOG_WARNING(Store, "Failed to open path=\"%s\"", qUtf8Printable(filePath));
+        return nullptr;
+    }
+    std::shared_ptr<const CompressedClip> clip = CompressedClip::fromDecoder(&decoder);
+    ma_decoder_uninit(&decoder);
+
+    if (!clip) {
+        OSD_LOG_WARNING(Store, "Failed to encode path=\"%s\"", qUtf8Printable(filePath));
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(filePath);
+    if (it != m_entries.end()) {
+        // Пока мы кодировали, клип успел загрузить другой поток
+        it->lastUse = ++m_useCounter;
+        return it->clip;
+    }
+
+    m_entries.insert(filePath, Entry{clip, ++m_useCounter});
+    m_residentBytes += clip->memoryUsage();
+    OSD_LOG_DEBUG(Store, "Loaded path=\"%s\" kib=%zu resident_mib=%zu", qUtf8Printable(filePath),
+                  clip->memoryUsage() / 1024, m_residentBytes / (1024 * 1024));
+    evictLocked();
+    return clip;
+}
+
+std::shared_ptr<const CompressedClip> SampleStore::find(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(filePath);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    it->lastUse = ++m_useCounter;
+    return it->clip;
+}
+
+bool SampleStore::contains(const QString& filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(filePath);
+}
+
+void SampleStore::remove(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(filePath);
+    if (it != m_entries.end()) {
+        m_residentBytes -= it->clip->memoryUsage();
+        m_entries.erase(it);
+    }
+}
+
+void SampleStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_residentBytes = 0;
+}
+
+void SampleStore::setPinned(const QSet<QString>& filePaths)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pinned = filePaths;
+    evictLocked(); // Снятые с закрепления клипы снова могут быть вытеснены
+}
+
+void SampleStore::setPreferred(const QSet<QString>& filePaths)
+{
+    QMutexLocker locker(&m_mutex);
+    m_preferred = filePaths;
+    evictLocked();
+}
+
+int SampleStore::pinnedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pinned.size();
+}
+
+int SampleStore::pinnedResidentCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const QString& filePath : m_pinned) {
+        if (m_entries.contains(filePath)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void SampleStore::setBudget(size_t budgetBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budgetBytes = budgetBytes;
+    evictLocked();
+}
+
+size_t SampleStore::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budgetBytes;
+}
+
+size_t SampleStore::residentBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_residentBytes;
+}
+
+void SampleStore::evictLocked()
+{
+    // Голоса держат shared_ptr на свой клип, поэтому вытеснение
+    // никогда не освобождает память, которая сейчас играет.
+    while (m_residentBytes > m_budgetBytes && !m_entries.isEmpty()) {
+        size_t preferredBytes = 0;
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (m_preferred.contains(it.key())) {
+                preferredBytes += it->clip->memoryUsage();
+            }
+        }
+        const bool isPreferredProtected = preferredBytes <= m_budgetBytes / 2;
+
+        // Самый давний из незакрепленных; частые — только когда других не осталось
+        auto oldest = m_entries.end();
+        bool isOldestPreferred = true;
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (m_pinned.contains(it.key())) {
+                continue;
+            }
+            const bool isPreferred = isPreferredProtected && m_preferred.contains(it.key());
+            if (oldest == m_entries.end() || (isOldestPreferred && !isPreferred) ||
+                (isOldestPreferred == isPreferred && it->lastUse < oldest->lastUse)) {
+                oldest = it;
+                isOldestPreferred = isPreferred;
+            }
+        }
+        if (oldest == m_entries.end()) {
+            break; // Остались только закрепленные клипы
+        }
+        m_residentBytes -= oldest->clip->memoryUsage();
+        OSD_LOG_DEBUG(Store, "Evicted path=\"%s\"", qUtf8Printable(oldest.key()));
+        m_entries.erase(oldest);
+    }
+}
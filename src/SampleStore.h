@@ -0,0 +1,126 @@
+// src/SampleStore.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "miniaudio.h"
+
+// Клип, сжатый блочным IMA ADPCM (4 бита на семпл, ~7.8x меньше, чем f32).
+// Каждый блок начинается с заголовка состояния декодера для каждого канала,
+// поэтому любой блок можно декодировать независимо — это дает дешевую перемотку.
+class CompressedClip
+{
+public:
+    static constexpr ma_uint32 kBlockFrames = 256;
+    static constexpr ma_uint32 kMaxChannels = 2;
+
+    // Читает декодер до конца, кодируя блок за блоком (без полного буфера f32)
+    static std::shared_ptr<CompressedClip> fromDecoder(ma_decoder* pDecoder);
+
+    ma_uint64 frameCount() const { return m_frameCount; }
+    ma_uint32 channels() const { return m_channels; }
+    ma_uint32 sampleRate() const { return m_sampleRate; }
+    ma_uint64 blockCount() const { return (m_frameCount + kBlockFrames - 1) / kBlockFrames; }
+    size_t memoryUsage() const { return m_data.capacity() + sizeof(*this); }
+
+    // Декодирует блок целиком в out (kBlockFrames * channels, interleaved).
+    // Возвращает число валидных кадров в блоке.
+    ma_uint32 decodeBlock(ma_uint64 blockIndex, float* out) const;
+
+private:
+    CompressedClip(ma_uint32 channels, ma_uint32 sampleRate);
+
+    size_t blockBytes() const { return m_channels * (4 + kBlockFrames / 2); }
+
+    std::vector<uint8_t> m_data;
+    ma_uint64 m_frameCount;
+    ma_uint32 m_channels;
+    ma_uint32 m_sampleRate;
+};
+
+// Курсор чтения клипа для одного голоса. Не выделяет память,
+// поэтому безопасен для вызова из аудиопотока.
+class ClipReader
+{
+public:
+    void reset(const CompressedClip* pClip);
+    void seek(ma_uint64 frame);
+    ma_uint64 read(float* pOut, ma_uint64 frameCount);
+    ma_uint64 cursor() const { return m_cursor; }
+
+private:
+    const CompressedClip* m_pClip = nullptr;
+    ma_uint64 m_cursor = 0;
+    ma_uint64 m_cachedBlock = UINT64_MAX;
+    ma_uint32 m_cachedFrames = 0;
+    float m_block[CompressedClip::kBlockFrames * CompressedClip::kMaxChannels];
+};
+
+// Резидентное хранилище сжатых клипов с LRU-вытеснением по бюджету памяти.
+// Потокобезопасно: загрузка идет в фоне, поиск — из главного потока.
+class SampleStore
+{
+public:
+    explicit SampleStore(size_t budgetBytes);
+
+    // Блокирующая загрузка (вызывать из рабочего потока)
+    std::shared_ptr<const CompressedClip> load(const QString& filePath, ma_uint32 channels, ma_uint32 sampleRate);
+    std::shared_ptr<const CompressedClip> find(const QString& filePath);
+    bool contains(const QString& filePath) const;
+    void remove(const QString& filePath);
+    void clear();
+
+    // Закрепленные клипы (активный банк) не вытесняются, даже если давно не играли;
+    // бюджет тогда освобождается за счет остальных
+    void setPinned(const QSet<QString>& filePaths);
+    int pinnedCount() const;
+    int pinnedResidentCount() const; // Сколько закрепленных клипов уже загружено
+
+    // Часто используемые клипы (UsageStore) вытесняются после всех остальных, пока
+    // занимают не больше половины бюджета: иначе новый клип вытеснялся бы сразу после загрузки
+    void setPreferred(const QSet<QString>& filePaths);
+
+    void setBudget(size_t budgetBytes);
+    size_t budget() const;
+    size_t residentBytes() const;
+
+private:
+    void evictLocked();
+
+    struct Entry {
+        std::shared_ptr<const CompressedClip> clip;
+        quint64 lastUse;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QSet<QString> m_pinned;
+    QSet<QString> m_preferred;
+    size_t m_budgetBytes;
+    size_t m_residentBytes;
+    quint64 m_useCounter;
+};
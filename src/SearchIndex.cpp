@@ -0,0 +1,403 @@
+// src/SearchIndex.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SearchIndex.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Лучшие кандидаты по числу совпавших триграмм дополнительно проверяются на точную подстроку
+constexpr size_t kRerankFactor = 4;
+constexpr size_t kMaxQueryLength = 256;
+// Лучшие на одном уровне совпадений выбираются по гистограмме длин; длиннее — в одной корзине
+constexpr size_t kMaxHistogramLength = 1023;
+
+bool isSeparator(char16_t c)
+{
+    // Не-ASCII символы (кириллица и прочее) считаются буквами
+    return c < 128 && !((c >= u'a' && c <= u'z') || (c >= u'0' && c <= u'9') || (c >= u'A' && c <= u'Z'));
+}
+
+size_t bitCount(const std::vector<uint64_t>& mask)
+{
+    size_t count = 0;
+    for (uint64_t word : mask) {
+        count += static_cast<size_t>(std::popcount(word));
+    }
+    return count;
+}
+
+template <typename Function>
+void forEachBit(const std::vector<uint64_t>& mask, Function function)
+{
+    for (size_t word = 0; word < mask.size(); ++word) {
+        for (uint64_t bits = mask[word]; bits != 0; bits &= bits - 1) {
+            function(static_cast<SearchIndex::Id>(word * 64 + std::countr_zero(bits)));
+        }
+    }
+}
+
+} // namespace
+
+std::vector<SearchIndex::Trigram> SearchIndex::trigramsOf(std::u16string_view text, bool isQuery)
+{
+    std::vector<Trigram> trigrams;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && isSeparator(text[pos])) {
+            ++pos;
+        }
+        const size_t begin = pos;
+        while (pos < text.size() && !isSeparator(text[pos])) {
+            ++pos;
+        }
+        if (begin == pos) {
+            break;
+        }
+
+        // Последнее слово запроса может быть недопечатано — ищем его как начало слова
+        const bool isOpenEnded = isQuery && pos == text.size();
+        std::u16string word = u"  ";
+        word.append(text.substr(begin, pos - begin));
+        if (!isOpenEnded) {
+            word += u' ';
+        }
+        for (size_t i = 0; i + 3 <= word.size(); ++i) {
+            trigrams.push_back(static_cast<Trigram>(word[i]) << 32 | static_cast<Trigram>(word[i + 1]) << 16 | word[i + 2]);
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+SearchIndex::Id SearchIndex::add(std::u16string_view text)
+{
+    Id id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = static_cast<Id>(m_entries.size());
+        m_entries.emplace_back();
+        m_lengths.push_back(0);
+    }
+    Entry& entry = m_entries[id];
+    entry.text.assign(text);
+    entry.trigrams = trigramsOf(text, false);
+    entry.isAlive = true;
+    m_lengths[id] = static_cast<uint16_t>(std::min<size_t>(text.size(), 0xFFFF));
+    indexEntry(id);
+    return id;
+}
+
+void SearchIndex::update(Id id, std::u16string_view text)
+{
+    if (id >= m_entries.size() || !m_entries[id].isAlive) {
+        return;
+    }
+    unindexEntry(id);
+    m_entries[id].text.assign(text);
+    m_entries[id].trigrams = trigramsOf(text, false);
+    m_lengths[id] = static_cast<uint16_t>(std::min<size_t>(text.size(), 0xFFFF));
+    indexEntry(id);
+}
+
+void SearchIndex::remove(Id id)
+{
+    if (id >= m_entries.size() || !m_entries[id].isAlive) {
+        return;
+    }
+    unindexEntry(id);
+    m_entries[id] = Entry();
+    if (id / 64 < m_matches.size()) {
+        m_matches[id / 64] &= ~(uint64_t(1) << (id % 64)); // Может остаться от последнего поиска
+    }
+    m_freeIds.push_back(id);
+}
+
+void SearchIndex::clear()
+{
+    m_entries.clear();
+    m_freeIds.clear();
+    m_postings.clear();
+    m_lengths.clear();
+    m_matches.clear();
+    m_minHits = 0;
+}
+
+void SearchIndex::indexEntry(Id id)
+{
+    const size_t word = id / 64;
+    const uint64_t bit = uint64_t(1) << (id % 64);
+    for (Trigram trigram : m_entries[id].trigrams) {
+        Postings& postings = m_postings[trigram];
+        if (postings.isDense) {
+            if (postings.bits.size() <= word) {
+                postings.bits.resize(word + 1, 0);
+            }
+            postings.bits[word] |= bit;
+        } else {
+            // Новые id обычно больше всех в списке — вставка в конец
+            postings.ids.insert(std::lower_bound(postings.ids.begin(), postings.ids.end(), id), id);
+        }
+        ++postings.count;
+        updateDensity(&postings);
+    }
+}
+
+void SearchIndex::unindexEntry(Id id)
+{
+    // Маска — сброс бита, массив — двоичный поиск: список длиннее 1/kDenseDivisor всех id
+    // всегда маска, поэтому сдвиг хвоста массива ограничен
+    const size_t word = id / 64;
+    const uint64_t bit = uint64_t(1) << (id % 64);
+    for (Trigram trigram : m_entries[id].trigrams) {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end()) {
+            continue;
+        }
+        Postings& postings = it->second;
+        if (postings.isDense) {
+            if (word >= postings.bits.size() || (postings.bits[word] & bit) == 0) {
+                continue;
+            }
+            postings.bits[word] &= ~bit;
+        } else {
+            auto found = std::lower_bound(postings.ids.begin(), postings.ids.end(), id);
+            if (found == postings.ids.end() || *found != id) {
+                continue;
+            }
+            postings.ids.erase(found);
+        }
+        if (--postings.count == 0) {
+            m_postings.erase(it);
+        } else {
+            updateDensity(&postings);
+        }
+    }
+}
+
+void SearchIndex::updateDensity(Postings* pPostings) const
+{
+    const size_t idCount = m_entries.size();
+    if (!pPostings->isDense && pPostings->count * kDenseDivisor > idCount) {
+        pPostings->bits.assign(wordCount(), 0);
+        for (Id id : pPostings->ids) {
+            pPostings->bits[id / 64] |= uint64_t(1) << (id % 64);
+        }
+        pPostings->ids = std::vector<Id>();
+        pPostings->isDense = true;
+    } else if (pPostings->isDense && pPostings->count * kDenseDivisor * kSparseHysteresis < idCount) {
+        std::vector<Id> ids;
+        ids.reserve(pPostings->count);
+        forEachBit(pPostings->bits, [&ids](Id id) { ids.push_back(id); });
+        pPostings->ids = std::move(ids);
+        pPostings->bits = std::vector<uint64_t>();
+        pPostings->isDense = false;
+    }
+}
+
+void SearchIndex::addToCounters(const Postings& postings)
+{
+    // Сложение столбиком сразу для 64 треков: перенос уходит в старший срез, пока не обнулится
+    const auto add = [this](size_t word, uint64_t carry) {
+        uint64_t* pSlices = m_counters.data() + word * m_counterBits;
+        for (size_t b = 0; carry != 0 && b < m_counterBits; ++b) {
+            const uint64_t next = pSlices[b] & carry;
+            pSlices[b] ^= carry;
+            carry = next;
+        }
+    };
+    if (postings.isDense) {
+        const size_t wordCount = std::min(postings.bits.size(), m_counterWords);
+        for (size_t word = 0; word < wordCount; ++word) {
+            if (postings.bits[word] != 0) {
+                add(word, postings.bits[word]);
+            }
+        }
+    } else {
+        for (Id id : postings.ids) {
+            add(id / 64, uint64_t(1) << (id % 64));
+        }
+    }
+}
+
+void SearchIndex::selectAtLeast(uint32_t hits, std::vector<uint64_t>* pMask) const
+{
+    // Сравнение счетчиков с числом по срезам от старшего: больше или пока равно
+    pMask->resize(m_counterWords);
+    for (size_t word = 0; word < m_counterWords; ++word) {
+        const uint64_t* pSlices = m_counters.data() + word * m_counterBits;
+        uint64_t greater = 0;
+        uint64_t equal = ~uint64_t(0);
+        for (size_t b = m_counterBits; b-- > 0;) {
+            if ((hits >> b) & 1) {
+                equal &= pSlices[b];
+            } else {
+                greater |= equal & pSlices[b];
+                equal &= ~pSlices[b];
+            }
+        }
+        (*pMask)[word] = greater | equal;
+    }
+}
+
+uint32_t SearchIndex::hitsOf(Id id) const
+{
+    const uint64_t* pSlices = m_counters.data() + (id / 64) * m_counterBits;
+    uint32_t hits = 0;
+    for (size_t b = 0; b < m_counterBits; ++b) {
+        hits |= static_cast<uint32_t>((pSlices[b] >> (id % 64)) & 1) << b;
+    }
+    return hits;
+}
+
+std::vector<SearchIndex::Id> SearchIndex::search(std::u16string_view query, size_t maxRanked)
+{
+    m_minHits = 0;
+    m_matches.clear();
+
+    query = query.substr(0, kMaxQueryLength);
+    const std::vector<Trigram> queryTrigrams = trigramsOf(query, true);
+    if (queryTrigrams.empty()) {
+        return {};
+    }
+    m_minHits = static_cast<uint32_t>(std::max(1.0, std::ceil(queryTrigrams.size() * kMinOverlap)));
+
+    std::vector<const Postings*> lists;
+    for (Trigram trigram : queryTrigrams) {
+        const auto postings = m_postings.find(trigram);
+        if (postings != m_postings.end()) {
+            lists.push_back(&postings->second);
+        }
+    }
+    if (lists.size() < m_minHits) {
+        return {}; // Ни один трек не наберет нужного числа совпадений
+    }
+
+    // Счетчику хватает бит на число списков; срезы одного слова лежат рядом
+    m_counterWords = wordCount();
+    m_counterBits = static_cast<size_t>(std::bit_width(lists.size()));
+    m_counters.assign(m_counterWords * m_counterBits, 0);
+    for (const Postings* pPostings : lists) {
+        addToCounters(*pPostings);
+    }
+    selectAtLeast(m_minHits, &m_matches);
+    const size_t matchCount = bitCount(m_matches);
+    if (matchCount == 0) {
+        return {};
+    }
+
+    // Лучшие — больше совпавших триграмм, при равенстве короче текст (точнее). Сверху вниз
+    // ищется уровень, на котором набирается rerankCount кандидатов: все, кто выше, входят
+    // целиком, а на самом уровне берутся самые короткие по гистограмме длин
+    const size_t rerankCount = std::min(matchCount, std::max<size_t>(maxRanked, 1) * kRerankFactor);
+    uint32_t level = m_minHits;
+    size_t aboveCount = 0;
+    m_above.assign(m_counterWords, 0);
+    for (uint32_t hits = static_cast<uint32_t>(lists.size()); hits > m_minHits; --hits) {
+        selectAtLeast(hits, &m_level);
+        const size_t count = bitCount(m_level);
+        if (count >= rerankCount) {
+            level = hits;
+            break;
+        }
+        m_above.swap(m_level);
+        aboveCount = count;
+    }
+    if (level == m_minHits) {
+        m_level = m_matches;
+    }
+
+    // Ключ ранжирования упакован в одно число: совпадения, краткость, в младших битах — id
+    m_candidates.clear();
+    const auto pushCandidate = [this](Id id) {
+        const uint64_t shortness = 0xFFFF - m_lengths[id];
+        m_candidates.push_back(static_cast<uint64_t>(hitsOf(id)) << 48 | shortness << 32 | id);
+    };
+    forEachBit(m_above, pushCandidate);
+
+    m_lengthCounts.assign(kMaxHistogramLength + 1, 0);
+    for (size_t word = 0; word < m_counterWords; ++word) {
+        for (uint64_t bits = m_level[word] & ~m_above[word]; bits != 0; bits &= bits - 1) {
+            const Id id = static_cast<Id>(word * 64 + std::countr_zero(bits));
+            ++m_lengthCounts[std::min<size_t>(m_lengths[id], kMaxHistogramLength)];
+        }
+    }
+    const size_t needed = rerankCount - aboveCount;
+    size_t cutoff = 0;
+    for (size_t taken = 0; taken + m_lengthCounts[cutoff] < needed; ++cutoff) {
+        taken += m_lengthCounts[cutoff];
+    }
+    for (size_t word = 0; word < m_counterWords; ++word) {
+        for (uint64_t bits = m_level[word] & ~m_above[word]; bits != 0; bits &= bits - 1) {
+            const Id id = static_cast<Id>(word * 64 + std::countr_zero(bits));
+            if (std::min<size_t>(m_lengths[id], kMaxHistogramLength) <= cutoff) {
+                pushCandidate(id);
+            }
+        }
+    }
+    // Лишние — только из треков длины cutoff
+    if (rerankCount < m_candidates.size()) {
+        std::nth_element(m_candidates.begin(), m_candidates.begin() + rerankCount, m_candidates.end(),
+                         std::greater<uint64_t>());
+    }
+
+    // Небольшой набор лучших затем переупорядочивается с учетом точной подстроки запроса
+    std::vector<std::pair<int, Id>> ranked;
+    ranked.reserve(rerankCount);
+    for (size_t i = 0; i < rerankCount; ++i) {
+        const Id id = static_cast<Id>(m_candidates[i]);
+        const std::u16string& text = m_entries[id].text;
+        const size_t found = text.find(query);
+        int bonus = 0;
+        if (found != std::u16string::npos) {
+            bonus = (found == 0 || isSeparator(text[found - 1])) ? 2 : 1; // Начало слова ценнее середины
+        }
+        ranked.emplace_back(static_cast<int>(m_candidates[i] >> 48) * 4 + bonus, id);
+    }
+    std::sort(ranked.begin(), ranked.end(), [this](const auto& a, const auto& b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        return m_entries[a.second].text.size() < m_entries[b.second].text.size();
+    });
+
+    std::vector<Id> best;
+    for (size_t i = 0; i < ranked.size() && i < maxRanked; ++i) {
+        best.push_back(ranked[i].second);
+    }
+    return best;
+}
+
+bool SearchIndex::matches(Id id) const
+{
+    return m_minHits == 0 || (id / 64 < m_matches.size() && ((m_matches[id / 64] >> (id % 64)) & 1) != 0);
+}
+
+void SearchIndex::collectMatches(std::vector<Id>* pIds) const
+{
+    pIds->clear();
+    forEachBit(m_matches, [pIds](Id id) { pIds->push_back(id); });
+}
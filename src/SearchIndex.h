@@ -0,0 +1,112 @@
+// src/SearchIndex.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Нечеткий поиск по трекам: индекс триграмм над именем, тегами и путем.
+//
+// Текст делится на слова по пробелам и ASCII-знакам препинания, каждое слово дополняется
+// двумя пробелами спереди и одним сзади, так что "kick" дает "  k", " ki", "kic", "ick", "ck ".
+// Последнее слово запроса не дополняется сзади и ищется как начало слова, поэтому результаты
+// есть уже с первой буквы. Трек подходит, если содержит не меньше kMinOverlap триграмм
+// запроса (половину): одна опечатка или перестановка букв в слове не мешает найти его.
+//
+// Списки редких триграмм — отсортированные id, частых (" wa" из ".wav") — битовые маски
+// по всем id. Поиск складывает списки запроса в счетчики, разрезанные по битам (бит b
+// счетчиков 64 треков — одно слово), поэтому частая триграмма стоит прохода по словам
+// маски, а не по трекам. Добавление и удаление трека не ищут его в длинных списках.
+//
+// Id стабилен, пока трек в индексе (строки таблицы можно двигать); id удаленных
+// треков переиспользуются. Не потокобезопасен: search() пишет во внутренние счетчики.
+class SearchIndex
+{
+public:
+    using Id = uint32_t;
+    static constexpr double kMinOverlap = 0.5;
+
+    // Текст должен быть уже приведен к нижнему регистру (QString::toCaseFolded())
+    Id add(std::u16string_view text);
+    void update(Id id, std::u16string_view text);
+    void remove(Id id);
+    void clear();
+    size_t size() const { return m_entries.size() - m_freeIds.size(); }
+
+    // Возвращает до maxRanked лучших совпадений, лучшее первым. После вызова matches()
+    // отвечает для любого трека; пустой запрос совпадает со всеми.
+    std::vector<Id> search(std::u16string_view query, size_t maxRanked);
+    bool matches(Id id) const;
+    bool isFiltering() const { return m_minHits != 0; } // false — последний запрос был пустым
+    void collectMatches(std::vector<Id>* pIds) const;   // Подходящие id по возрастанию
+
+private:
+    using Trigram = uint64_t;
+
+    // Список маской, когда в нем больше 1/kDenseDivisor всех id: маска тогда не больше
+    // массива id. Обратно в массив — когда список стал в kSparseHysteresis раз реже
+    static constexpr size_t kDenseDivisor = 32;
+    static constexpr size_t kSparseHysteresis = 4;
+
+    struct Entry {
+        std::u16string text;
+        std::vector<Trigram> trigrams; // Отсортированы, без повторов
+        bool isAlive = false;
+    };
+
+    struct Postings {
+        std::vector<Id> ids;        // Отсортированы; пусто у маски
+        std::vector<uint64_t> bits; // Маска; может быть короче wordCount() — хвост нулевой
+        size_t count = 0;
+        bool isDense = false;
+    };
+
+    static std::vector<Trigram> trigramsOf(std::u16string_view text, bool isQuery);
+    size_t wordCount() const { return (m_entries.size() + 63) / 64; }
+    void indexEntry(Id id);
+    void unindexEntry(Id id);
+    void updateDensity(Postings* pPostings) const;
+
+    // Счетчики последнего поиска
+    void addToCounters(const Postings& postings);
+    void selectAtLeast(uint32_t hits, std::vector<uint64_t>* pMask) const; // Маска id со счетчиком >= hits
+    uint32_t hitsOf(Id id) const;
+
+    std::vector<Entry> m_entries;
+    std::vector<Id> m_freeIds;
+    std::unordered_map<Trigram, Postings> m_postings;
+    std::vector<uint16_t> m_lengths; // Длина текста по id: ранжированию не нужно ходить в m_entries
+
+    // Состояние последнего поиска; буферы не выделяются заново на каждое нажатие
+    std::vector<uint64_t> m_counters;   // m_counterBits срезов по wordCount() слов
+    size_t m_counterBits = 0;
+    size_t m_counterWords = 0;
+    std::vector<uint64_t> m_matches;    // Id с не меньше m_minHits совпавших триграмм
+    std::vector<uint64_t> m_above;      // Рабочие маски выбора лучших
+    std::vector<uint64_t> m_level;
+    std::vector<uint32_t> m_lengthCounts;
+    std::vector<uint64_t> m_candidates; // Ключи ранжирования
+    uint32_t m_minHits = 0;             // 0 — фильтра нет
+};
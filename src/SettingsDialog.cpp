@@ -18,6 +18,8 @@
  */
 
 #include "SettingsDialog.h"
+#include "AudioEngine.h"
+#include "MidiInput.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -26,13 +28,20 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QKeySequenceEdit>
+#include <QTimer>
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QSettings>
-#include <QDebug>
+#include "Log.h"
 
-SettingsDialog::SettingsDialog(QWidget *parent)
-    : QDialog(parent)
+SettingsDialog::SettingsDialog(AudioEngine *audioEngine, QWidget *parent)
+    : QDialog(parent),
+      m_audioEngine(audioEngine)
 {
     setWindowTitle(tr("Settings"));
     setMinimumSize(500, 300);
@@ -43,6 +52,7 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     m_tabWidget->addTab(createHotkeysTab(), tr("Hotkeys"));
     m_tabWidget->addTab(createInterfaceTab(), tr("Interface"));
     m_tabWidget->addTab(createDevicesTab(), tr("Devices"));
+    m_tabWidget->addTab(createMidiTab(), tr("MIDI"));
 
     m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel | QDialogButtonBox::Apply);
     connect(m_buttonBox, &QDialogButtonBox::accepted, this, &SettingsDialog::onAccepted);
@@ -63,13 +73,104 @@ void SettingsDialog::loadSettings()
     QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::MusicLocation);
     QString libraryPath = settings.value("library/path", defaultPath).toString();
     m_libraryPathLineEdit->setText(libraryPath);
+    m_autoImportCheckBox->setChecked(settings.value("library/autoImport", false).toBool());
+
+    m_sampleStoreCheckBox->setChecked(settings.value("audio/sampleStoreEnabled", false).toBool());
+    m_sampleStoreBudgetSpinBox->setValue(settings.value("audio/sampleStoreBudgetMB", 256).toInt());
+    m_sampleStoreBudgetSpinBox->setEnabled(m_sampleStoreCheckBox->isChecked());
+    m_primeBudgetSpinBox->setValue(settings.value("audio/primeBudgetMB", 64).toInt());
+    m_queueCrossfadeSpinBox->setValue(settings.value("playback/queueCrossfadeMs", 0).toInt());
+    m_rememberUsageCheckBox->setChecked(settings.value("audio/rememberUsage", true).toBool());
+
+    const int backendIndex = m_backendComboBox->findData(settings.value("audio/backend").toString());
+    m_backendComboBox->setCurrentIndex(qMax(0, backendIndex));
+    m_periodSizeSpinBox->setValue(settings.value("audio/periodSizeInFrames", 0).toInt());
+    m_periodsSpinBox->setValue(settings.value("audio/periods", 0).toInt());
+    m_realtimePriorityCheckBox->setChecked(settings.value("audio/realtimePriority", false).toBool());
+    m_exclusiveModeCheckBox->setChecked(settings.value("audio/exclusiveMode", false).toBool());
+    m_parallelMixingCheckBox->setChecked(settings.value("audio/parallelMixing", false).toBool());
+    m_micPassthroughCheckBox->setChecked(settings.value("audio/micPassthrough", false).toBool());
+    m_micSuppressionCheckBox->setChecked(settings.value("audio/micNoiseSuppression", false).toBool());
+    m_micSuppressionSpinBox->setValue(settings.value("audio/micSuppressionDb", 12).toInt());
+    m_micSuppressionSpinBox->setEnabled(m_micSuppressionCheckBox->isChecked());
+    m_micGateCheckBox->setChecked(settings.value("audio/micNoiseGate", false).toBool());
+    m_micGateSpinBox->setValue(settings.value("audio/micGateThresholdDb", -45).toInt());
+    m_micGateSpinBox->setEnabled(m_micGateCheckBox->isChecked());
+    m_replayMinutesSpinBox->setValue(settings.value("capture/replayMinutes", 2).toInt());
+    m_captureFormatComboBox->setCurrentIndex(qMax(0, m_captureFormatComboBox->findData(
+                                                         settings.value("capture/format", "flac").toString())));
+    m_capturePathLineEdit->setText(settings.value("capture/folder").toString());
+
+    m_modifierVariantsCheckBox->setChecked(settings.value("hotkeys/modifierVariants", false).toBool());
+    m_shiftPitchSpinBox->setValue(settings.value("hotkeys/shiftPitchSemitones", 12.0).toDouble());
+    m_controlTempoSpinBox->setValue(settings.value("hotkeys/controlTempoPercent", 150).toInt());
+    m_altPitchSpinBox->setValue(settings.value("hotkeys/altPitchSemitones", -12.0).toDouble());
+    m_shiftPitchSpinBox->setEnabled(m_modifierVariantsCheckBox->isChecked());
+    m_controlTempoSpinBox->setEnabled(m_modifierVariantsCheckBox->isChecked());
+    m_altPitchSpinBox->setEnabled(m_modifierVariantsCheckBox->isChecked());
+    m_replayHotkeyEdit->setKeySequence(
+        QKeySequence::fromString(settings.value("capture/replayHotkey").toString(), QKeySequence::PortableText));
+
+    m_midiEnabledCheckBox->setChecked(settings.value("midi/enabled", false).toBool());
+    m_midiChannelSpinBox->setValue(settings.value("midi/channel", 0).toInt());
+    m_midiFirstNoteSpinBox->setValue(settings.value("midi/firstNote", 36).toInt());
+    m_midiFirstControllerSpinBox->setValue(settings.value("midi/firstController", -1).toInt());
+    m_midiVelocityCheckBox->setChecked(settings.value("midi/velocityToGain", true).toBool());
+    m_midiSourceComboBox->clear();
+    m_midiSourceComboBox->addItem(QString(), settings.value("midi/source").toString());
+    onRefreshMidiSources();
+
+    // Подставляем сохраненное устройство как текущее, список построит onPlaybackDevicesListed()
+    const QByteArray outputDeviceId = settings.value("audio/outputDeviceId").toByteArray();
+    const QString outputDeviceName = settings.value("audio/outputDeviceName").toString();
+    m_outputDeviceComboBox->clear();
+    m_outputDeviceComboBox->addItem(outputDeviceId.isEmpty() ? tr("System Default") : outputDeviceName, outputDeviceId);
+    m_outputDeviceComboBox->setItemData(0, outputDeviceName, Qt::UserRole + 1);
+    onRefreshDevices();
 }
 
 void SettingsDialog::saveSettings()
 {
     QSettings settings("pavel-kruhlei", "OpenSoundDeck");
     settings.setValue("library/path", m_libraryPathLineEdit->text());
-    qDebug() << "Settings saved. Library path:" << m_libraryPathLineEdit->text();
+    settings.setValue("library/autoImport", m_autoImportCheckBox->isChecked());
+    settings.setValue("audio/sampleStoreEnabled", m_sampleStoreCheckBox->isChecked());
+    settings.setValue("audio/sampleStoreBudgetMB", m_sampleStoreBudgetSpinBox->value());
+    settings.setValue("audio/primeBudgetMB", m_primeBudgetSpinBox->value());
+    settings.setValue("playback/queueCrossfadeMs", m_queueCrossfadeSpinBox->value());
+    settings.setValue("audio/rememberUsage", m_rememberUsageCheckBox->isChecked());
+    settings.setValue("audio/backend", m_backendComboBox->currentData().toString());
+    settings.setValue("audio/periodSizeInFrames", m_periodSizeSpinBox->value());
+    settings.setValue("audio/periods", m_periodsSpinBox->value());
+    settings.setValue("audio/realtimePriority", m_realtimePriorityCheckBox->isChecked());
+    settings.setValue("audio/exclusiveMode", m_exclusiveModeCheckBox->isChecked());
+    settings.setValue("audio/parallelMixing", m_parallelMixingCheckBox->isChecked());
+    settings.setValue("audio/micPassthrough", m_micPassthroughCheckBox->isChecked());
+    settings.setValue("audio/micNoiseSuppression", m_micSuppressionCheckBox->isChecked());
+    settings.setValue("audio/micSuppressionDb", m_micSuppressionSpinBox->value());
+    settings.setValue("audio/micNoiseGate", m_micGateCheckBox->isChecked());
+    settings.setValue("audio/micGateThresholdDb", m_micGateSpinBox->value());
+    settings.setValue("capture/replayMinutes", m_replayMinutesSpinBox->value());
+    settings.setValue("capture/format", m_captureFormatComboBox->currentData().toString());
+    settings.setValue("capture/folder", m_capturePathLineEdit->text());
+
+    settings.setValue("hotkeys/modifierVariants", m_modifierVariantsCheckBox->isChecked());
+    settings.setValue("hotkeys/shiftPitchSemitones", m_shiftPitchSpinBox->value());
+    settings.setValue("hotkeys/controlTempoPercent", m_controlTempoSpinBox->value());
+    settings.setValue("hotkeys/altPitchSemitones", m_altPitchSpinBox->value());
+    settings.setValue("capture/replayHotkey", m_replayHotkeyEdit->keySequence().toString(QKeySequence::PortableText));
+
+    settings.setValue("midi/enabled", m_midiEnabledCheckBox->isChecked());
+    settings.setValue("midi/source", m_midiSourceComboBox->currentData().toString());
+    settings.setValue("midi/channel", m_midiChannelSpinBox->value());
+    settings.setValue("midi/firstNote", m_midiFirstNoteSpinBox->value());
+    settings.setValue("midi/firstController", m_midiFirstControllerSpinBox->value());
+    settings.setValue("midi/velocityToGain", m_midiVelocityCheckBox->isChecked());
+
+    settings.setValue("audio/outputDeviceId", m_outputDeviceComboBox->currentData().toByteArray());
+    settings.setValue("audio/outputDeviceName", m_outputDeviceComboBox->currentData(Qt::UserRole + 1).toString());
+    OSD_LOG_INFO(Ui, "Settings saved library=\"%s\"", qUtf8Printable(m_libraryPathLineEdit->text()));
+    emit settingsApplied();
 }
 
 void SettingsDialog::onAccepted()
@@ -88,6 +189,16 @@ void SettingsDialog::onBrowseLibraryPath()
     }
 }
 
+void SettingsDialog::onBrowseCapturePath()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Select Recordings Folder"),
+                                                    m_capturePathLineEdit->text(),
+                                                    QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    if (!dir.isEmpty()) {
+        m_capturePathLineEdit->setText(dir);
+    }
+}
+
 QWidget* SettingsDialog::createGeneralTab()
 {
     QWidget *generalWidget = new QWidget;
@@ -101,13 +212,335 @@ QWidget* SettingsDialog::createGeneralTab()
     pathLayout->addWidget(m_libraryPathLineEdit);
     pathLayout->addWidget(browseButton);
 
+    m_autoImportCheckBox = new QCheckBox(tr("Add new files from the library folder to the playlist"));
+    m_autoImportCheckBox->setToolTip(tr("Renamed, moved and deleted files are always tracked in the playlist. "
+                                        "This also appends audio files that appear in the library folder."));
+
     layout->addRow(tr("Sound Library Path:"), pathLayout);
+    layout->addRow(m_autoImportCheckBox);
 
     return generalWidget;
 }
 
+QWidget* SettingsDialog::createAudioTab()
+{
+    QWidget *audioWidget = new QWidget;
+    QFormLayout *layout = new QFormLayout(audioWidget);
+
+    m_sampleStoreCheckBox = new QCheckBox(tr("Keep clips in memory (compressed)"));
+    m_sampleStoreCheckBox->setToolTip(tr("Clips are stored as ADPCM in RAM: about 8 times smaller than decoded audio, "
+                                         "decoded on the fly during playback."));
+
+    m_sampleStoreBudgetSpinBox = new QSpinBox;
+    m_sampleStoreBudgetSpinBox->setRange(16, 16384);
+    m_sampleStoreBudgetSpinBox->setSingleStep(64);
+    m_sampleStoreBudgetSpinBox->setSuffix(tr(" MB"));
+    connect(m_sampleStoreCheckBox, &QCheckBox::toggled, m_sampleStoreBudgetSpinBox, &QSpinBox::setEnabled);
+
+    layout->addRow(m_sampleStoreCheckBox);
+    layout->addRow(tr("Memory budget:"), m_sampleStoreBudgetSpinBox);
+
+    m_primeBudgetSpinBox = new QSpinBox;
+    m_primeBudgetSpinBox->setRange(0, 1024);
+    m_primeBudgetSpinBox->setSingleStep(16);
+    m_primeBudgetSpinBox->setSpecialValueText(tr("Off"));
+    m_primeBudgetSpinBox->setSuffix(tr(" MB"));
+    m_primeBudgetSpinBox->setToolTip(tr("Decoders for the selected track, its neighbours and the most used hotkeys "
+                                        "are opened in the background with the first 250 ms decoded."));
+    layout->addRow(tr("Pre-open decoders:"), m_primeBudgetSpinBox);
+
+    m_queueCrossfadeSpinBox = new QSpinBox;
+    m_queueCrossfadeSpinBox->setRange(0, 10000);
+    m_queueCrossfadeSpinBox->setSingleStep(250);
+    m_queueCrossfadeSpinBox->setSpecialValueText(tr("Gapless"));
+    m_queueCrossfadeSpinBox->setSuffix(tr(" ms"));
+    m_queueCrossfadeSpinBox->setToolTip(tr("Overlap between tracks in continuous playback. "
+                                           "Limited to half of the shorter track."));
+    layout->addRow(tr("Queue crossfade:"), m_queueCrossfadeSpinBox);
+
+    m_rememberUsageCheckBox = new QCheckBox(tr("Remember which tracks are used most"));
+    m_rememberUsageCheckBox->setToolTip(tr("Trigger counts are kept in a local file between sessions. The most used "
+                                           "clips stay in memory longest and are pre-opened first."));
+    layout->addRow(m_rememberUsageCheckBox);
+
+    // --- Задержка ---
+    m_backendComboBox = new QComboBox;
+    m_backendComboBox->addItem(tr("Automatic"), QString());
+    for (const QString& backend : m_audioEngine->availableBackends()) {
+        m_backendComboBox->addItem(backend, backend);
+    }
+
+    m_periodSizeSpinBox = new QSpinBox;
+    m_periodSizeSpinBox->setRange(0, 8192);
+    m_periodSizeSpinBox->setSingleStep(32);
+    m_periodSizeSpinBox->setSpecialValueText(tr("Automatic"));
+    m_periodSizeSpinBox->setSuffix(tr(" frames"));
+    m_periodSizeSpinBox->setToolTip(tr("Frames per period at 48 kHz: 128 = 2.7 ms, 256 = 5.3 ms, 480 = 10 ms."));
+
+    m_periodsSpinBox = new QSpinBox;
+    m_periodsSpinBox->setRange(0, 8);
+    m_periodsSpinBox->setSpecialValueText(tr("Automatic"));
+
+    m_realtimePriorityCheckBox = new QCheckBox(tr("Real-time audio thread priority"));
+    m_realtimePriorityCheckBox->setToolTip(tr("Requests SCHED_FIFO on Linux. Falls back to normal priority without permission."));
+    m_exclusiveModeCheckBox = new QCheckBox(tr("Exclusive device access"));
+    m_exclusiveModeCheckBox->setToolTip(tr("Bypasses the system mixer where the backend supports it (WASAPI)."));
+    m_parallelMixingCheckBox = new QCheckBox(tr("Render decks on multiple cores"));
+    m_parallelMixingCheckBox->setToolTip(tr("Renders playing decks on pinned worker threads when they take a large share "
+                                            "of the period. Light loads stay on the audio thread."));
+
+    m_micPassthroughCheckBox = new QCheckBox(tr("Mix microphone into the output"));
+    m_micPassthroughCheckBox->setToolTip(tr("Opens the default capture device together with the output. The microphone "
+                                            "goes through the microphone effects and the mic volume slider."));
+
+    m_micSuppressionCheckBox = new QCheckBox(tr("Suppress microphone noise"));
+    m_micSuppressionCheckBox->setToolTip(tr("Removes steady background noise (fans, hum, hiss) before the microphone "
+                                            "effects. Adds 1.3 ms of latency to the microphone."));
+    m_micSuppressionSpinBox = new QSpinBox;
+    m_micSuppressionSpinBox->setRange(3, 30);
+    m_micSuppressionSpinBox->setSuffix(tr(" dB"));
+    m_micSuppressionSpinBox->setToolTip(tr("Maximum attenuation of noise. Higher values remove more noise but can make "
+                                           "the voice sound watery."));
+    connect(m_micSuppressionCheckBox, &QCheckBox::toggled, m_micSuppressionSpinBox, &QSpinBox::setEnabled);
+
+    m_micGateCheckBox = new QCheckBox(tr("Noise gate on the microphone"));
+    m_micGateCheckBox->setToolTip(tr("Mutes the microphone while its level stays below the threshold. Runs after "
+                                     "noise suppression and adds no latency."));
+    m_micGateSpinBox = new QSpinBox;
+    m_micGateSpinBox->setRange(-80, -10);
+    m_micGateSpinBox->setSuffix(tr(" dBFS"));
+    connect(m_micGateCheckBox, &QCheckBox::toggled, m_micGateSpinBox, &QSpinBox::setEnabled);
+
+    m_replayMinutesSpinBox = new QSpinBox;
+    m_replayMinutesSpinBox->setRange(0, 30);
+    m_replayMinutesSpinBox->setSpecialValueText(tr("Off"));
+    m_replayMinutesSpinBox->setSuffix(tr(" min"));
+    m_replayMinutesSpinBox->setToolTip(tr("Keeps the last minutes of the output in memory. Save Replay writes them "
+                                          "to a file without an ongoing recording."));
+
+    m_captureFormatComboBox = new QComboBox;
+    m_captureFormatComboBox->addItem(tr("FLAC (lossless, compressed)"), QStringLiteral("flac"));
+    m_captureFormatComboBox->addItem(tr("WAV (16-bit PCM)"), QStringLiteral("wav"));
+
+    m_capturePathLineEdit = new QLineEdit;
+    m_capturePathLineEdit->setPlaceholderText(QStandardPaths::writableLocation(QStandardPaths::MusicLocation) +
+                                              "/OpenSoundDeck");
+    QPushButton *captureBrowseButton = new QPushButton(tr("Browse..."));
+    connect(captureBrowseButton, &QPushButton::clicked, this, &SettingsDialog::onBrowseCapturePath);
+    QHBoxLayout *capturePathLayout = new QHBoxLayout;
+    capturePathLayout->addWidget(m_capturePathLineEdit);
+    capturePathLayout->addWidget(captureBrowseButton);
+
+    m_latencyLabel = new QLabel;
+    m_latencyLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    layout->addRow(tr("Backend:"), m_backendComboBox);
+    layout->addRow(tr("Period size:"), m_periodSizeSpinBox);
+    layout->addRow(tr("Periods:"), m_periodsSpinBox);
+    layout->addRow(m_realtimePriorityCheckBox);
+    layout->addRow(m_exclusiveModeCheckBox);
+    layout->addRow(m_parallelMixingCheckBox);
+    layout->addRow(m_micPassthroughCheckBox);
+    layout->addRow(m_micSuppressionCheckBox);
+    layout->addRow(tr("Noise reduction:"), m_micSuppressionSpinBox);
+    layout->addRow(m_micGateCheckBox);
+    layout->addRow(tr("Gate threshold:"), m_micGateSpinBox);
+    layout->addRow(tr("Replay buffer:"), m_replayMinutesSpinBox);
+    layout->addRow(tr("Recording format:"), m_captureFormatComboBox);
+    layout->addRow(tr("Recordings folder:"), capturePathLayout);
+    layout->addRow(tr("Measured latency:"), m_latencyLabel);
+
+    // Живой индикатор: показывает эффект изменений после нажатия Apply
+    m_latencyTimer = new QTimer(this);
+    m_latencyTimer->setInterval(250);
+    connect(m_latencyTimer, &QTimer::timeout, this, &SettingsDialog::onUpdateLatencyReadout);
+    m_latencyTimer->start();
+    onUpdateLatencyReadout();
+
+    return audioWidget;
+}
+
+void SettingsDialog::onUpdateLatencyReadout()
+{
+    const AudioEngine::LatencyInfo info = m_audioEngine->latencyInfo();
+    if (info.bufferMillis <= 0) {
+        m_latencyLabel->setText(tr("Device is not open. Play a sound to measure."));
+        return;
+    }
+
+    QString text = tr("Buffer %1 ms (period %2 ms), callback every %3 ms")
+                       .arg(info.bufferMillis, 0, 'f', 1)
+                       .arg(info.periodMillis, 0, 'f', 1)
+                       .arg(info.callbackIntervalMillis, 0, 'f', 1);
+    if (info.outputLatencyMillis > 0) {
+        text += tr("\nLast trigger to output: %1 ms").arg(info.outputLatencyMillis, 0, 'f', 1);
+    }
+    m_latencyLabel->setText(text);
+}
+
+QWidget* SettingsDialog::createDevicesTab()
+{
+    QWidget *devicesWidget = new QWidget;
+    QFormLayout *layout = new QFormLayout(devicesWidget);
+
+    m_outputDeviceComboBox = new QComboBox;
+    m_outputDeviceComboBox->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    QPushButton *refreshButton = new QPushButton(tr("Refresh"));
+    connect(refreshButton, &QPushButton::clicked, this, &SettingsDialog::onRefreshDevices);
+    connect(m_audioEngine, &AudioEngine::playbackDevicesListed, this, &SettingsDialog::onPlaybackDevicesListed);
+
+    QHBoxLayout *deviceLayout = new QHBoxLayout;
+    deviceLayout->addWidget(m_outputDeviceComboBox);
+    deviceLayout->addWidget(refreshButton);
+
+    m_activeDeviceLabel = new QLabel;
+    connect(m_audioEngine, &AudioEngine::outputDeviceChanged, m_activeDeviceLabel, &QLabel::setText);
+
+    layout->addRow(tr("Output device:"), deviceLayout);
+    layout->addRow(tr("Active device:"), m_activeDeviceLabel);
+
+    return devicesWidget;
+}
+
+void SettingsDialog::onRefreshDevices()
+{
+    // Перечисление может занять секунды (Bluetooth, сетевые бэкенды) — список заполнит
+    // onPlaybackDevicesListed(), а пока в нем остается прежний выбор
+    m_audioEngine->requestPlaybackDevices();
+
+    const QString activeDevice = m_audioEngine->currentDeviceName();
+    m_activeDeviceLabel->setText(activeDevice.isEmpty() ? tr("Not opened yet") : activeDevice);
+}
+
+void SettingsDialog::onPlaybackDevicesListed(const QList<AudioEngine::DeviceInfo>& devices)
+{
+    const QByteArray currentId = m_outputDeviceComboBox->currentData().toByteArray();
+    const QString currentName = m_outputDeviceComboBox->currentData(Qt::UserRole + 1).toString();
+
+    m_outputDeviceComboBox->clear();
+    m_outputDeviceComboBox->addItem(tr("System Default"), QByteArray());
+    for (const AudioEngine::DeviceInfo& device : devices) {
+        m_outputDeviceComboBox->addItem(device.isDefault ? tr("%1 (default)").arg(device.name) : device.name, device.id);
+        m_outputDeviceComboBox->setItemData(m_outputDeviceComboBox->count() - 1, device.name, Qt::UserRole + 1);
+    }
+
+    int index = m_outputDeviceComboBox->findData(currentId);
+    if (index < 0 && !currentId.isEmpty()) {
+        // Выбранное устройство сейчас не подключено — показываем его, чтобы не потерять выбор
+        m_outputDeviceComboBox->addItem(tr("%1 (disconnected)").arg(currentName), currentId);
+        index = m_outputDeviceComboBox->count() - 1;
+        m_outputDeviceComboBox->setItemData(index, currentName, Qt::UserRole + 1);
+    }
+    m_outputDeviceComboBox->setCurrentIndex(qMax(0, index));
+}
+
+QWidget* SettingsDialog::createMidiTab()
+{
+    QWidget *midiWidget = new QWidget;
+    QFormLayout *layout = new QFormLayout(midiWidget);
+
+    m_midiEnabledCheckBox = new QCheckBox(tr("Trigger tracks from MIDI"));
+    m_midiEnabledCheckBox->setToolTip(tr("Creates the ALSA sequencer port \"OpenSoundDeck:Trigger In\". "
+                                         "Any controller can also be connected to it with aconnect."));
+
+    m_midiSourceComboBox = new QComboBox;
+    m_midiSourceComboBox->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    QPushButton *refreshButton = new QPushButton(tr("Refresh"));
+    connect(refreshButton, &QPushButton::clicked, this, &SettingsDialog::onRefreshMidiSources);
+    QHBoxLayout *sourceLayout = new QHBoxLayout;
+    sourceLayout->addWidget(m_midiSourceComboBox);
+    sourceLayout->addWidget(refreshButton);
+
+    m_midiChannelSpinBox = new QSpinBox;
+    m_midiChannelSpinBox->setRange(0, 16);
+    m_midiChannelSpinBox->setSpecialValueText(tr("Any"));
+
+    m_midiFirstNoteSpinBox = new QSpinBox;
+    m_midiFirstNoteSpinBox->setRange(0, 127);
+    m_midiFirstNoteSpinBox->setToolTip(tr("This note plays the first track, the next note the second one, and so on. "
+                                          "36 (C1) is the first pad on most controllers."));
+
+    m_midiFirstControllerSpinBox = new QSpinBox;
+    m_midiFirstControllerSpinBox->setRange(-1, 127);
+    m_midiFirstControllerSpinBox->setSpecialValueText(tr("Off"));
+    m_midiFirstControllerSpinBox->setToolTip(tr("For controllers whose buttons send CC messages instead of notes."));
+
+    m_midiVelocityCheckBox = new QCheckBox(tr("Velocity sets the track volume"));
+
+    layout->addRow(m_midiEnabledCheckBox);
+    layout->addRow(tr("Source:"), sourceLayout);
+    layout->addRow(tr("Channel:"), m_midiChannelSpinBox);
+    layout->addRow(tr("First note:"), m_midiFirstNoteSpinBox);
+    layout->addRow(tr("First controller:"), m_midiFirstControllerSpinBox);
+    layout->addRow(m_midiVelocityCheckBox);
+
+    if (!MidiInput::isAvailable()) {
+        midiWidget->setEnabled(false);
+        layout->addRow(new QLabel(tr("MIDI input requires the ALSA sequencer (Linux).")));
+    }
+    return midiWidget;
+}
+
+void SettingsDialog::onRefreshMidiSources()
+{
+    const QString currentSource = m_midiSourceComboBox->currentData().toString();
+
+    m_midiSourceComboBox->clear();
+    m_midiSourceComboBox->addItem(tr("None (connect with aconnect)"), QString());
+    for (const QString& source : MidiInput::availableSources()) {
+        m_midiSourceComboBox->addItem(source, source);
+    }
+
+    int index = m_midiSourceComboBox->findData(currentSource);
+    if (index < 0 && !currentSource.isEmpty()) {
+        // Контроллер сейчас не подключен — сохраняем выбор, подключимся при следующем старте
+        m_midiSourceComboBox->addItem(tr("%1 (disconnected)").arg(currentSource), currentSource);
+        index = m_midiSourceComboBox->count() - 1;
+    }
+    m_midiSourceComboBox->setCurrentIndex(qMax(0, index));
+}
+
 // --- Placeholder Tabs ---
-QWidget* SettingsDialog::createAudioTab()     { return new QLabel(tr("Audio settings will be here.")); }
-QWidget* SettingsDialog::createHotkeysTab()   { return new QLabel(tr("Hotkey settings will be here.")); }
+QWidget* SettingsDialog::createHotkeysTab()
+{
+    QWidget *hotkeysWidget = new QWidget;
+    QFormLayout *layout = new QFormLayout(hotkeysWidget);
+
+    m_modifierVariantsCheckBox = new QCheckBox(tr("Trigger pitch and tempo variants with modifiers"));
+    m_modifierVariantsCheckBox->setToolTip(tr("Also registers Shift, Ctrl and Alt + each assigned hotkey. "
+                                              "Offsets apply on top of the track's own pitch and tempo."));
+
+    auto createPitchSpinBox = [] {
+        QDoubleSpinBox *spinBox = new QDoubleSpinBox;
+        spinBox->setRange(-24.0, 24.0);
+        spinBox->setDecimals(1);
+        spinBox->setSingleStep(0.5);
+        spinBox->setSuffix(tr(" st"));
+        return spinBox;
+    };
+    m_shiftPitchSpinBox = createPitchSpinBox();
+    m_altPitchSpinBox = createPitchSpinBox();
+
+    m_controlTempoSpinBox = new QSpinBox;
+    m_controlTempoSpinBox->setRange(50, 200);
+    m_controlTempoSpinBox->setSingleStep(5);
+    m_controlTempoSpinBox->setSuffix(tr(" %"));
+
+    for (QWidget *widget : {static_cast<QWidget*>(m_shiftPitchSpinBox), static_cast<QWidget*>(m_controlTempoSpinBox),
+                            static_cast<QWidget*>(m_altPitchSpinBox)}) {
+        connect(m_modifierVariantsCheckBox, &QCheckBox::toggled, widget, &QWidget::setEnabled);
+    }
+
+    layout->addRow(m_modifierVariantsCheckBox);
+    layout->addRow(tr("Shift + hotkey, pitch:"), m_shiftPitchSpinBox);
+    layout->addRow(tr("Ctrl + hotkey, tempo:"), m_controlTempoSpinBox);
+    layout->addRow(tr("Alt + hotkey, pitch:"), m_altPitchSpinBox);
+
+    // Глобальный, как хоткеи треков: повтор сохраняется и из другого окна
+    m_replayHotkeyEdit = new QKeySequenceEdit;
+    layout->addRow(tr("Save replay:"), m_replayHotkeyEdit);
+
+    return hotkeysWidget;
+}
+
 QWidget* SettingsDialog::createInterfaceTab() { return new QLabel(tr("Interface settings will be here.")); }
-QWidget* SettingsDialog::createDevicesTab()   { return new QLabel(tr("Device settings will be here.")); }
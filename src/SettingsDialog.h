@@ -20,21 +20,38 @@
 #pragma once
 
 #include <QDialog>
+#include "AudioEngine.h"
 
 class QTabWidget;
 class QLineEdit;
 class QPushButton;
 class QDialogButtonBox;
+class QCheckBox;
+class QSpinBox;
+class QDoubleSpinBox;
+class QComboBox;
+class QLabel;
+class QKeySequenceEdit;
+class QTimer;
 
 class SettingsDialog : public QDialog
 {
     Q_OBJECT
 
 public:
-    explicit SettingsDialog(QWidget *parent = nullptr);
+    explicit SettingsDialog(AudioEngine *audioEngine, QWidget *parent = nullptr);
+
+signals:
+    // Настройки сохранены (OK или Apply) — владелец применяет их к движку сразу
+    void settingsApplied();
 
 private slots:
     void onBrowseLibraryPath();
+    void onBrowseCapturePath();
+    void onRefreshDevices();
+    void onPlaybackDevicesListed(const QList<AudioEngine::DeviceInfo>& devices);
+    void onRefreshMidiSources();
+    void onUpdateLatencyReadout();
     void onAccepted();
 
 private:
@@ -46,10 +63,55 @@ private:
     QWidget* createHotkeysTab();
     QWidget* createInterfaceTab();
     QWidget* createDevicesTab();
+    QWidget* createMidiTab();
 
+    AudioEngine* m_audioEngine;
     QTabWidget* m_tabWidget;
     QDialogButtonBox* m_buttonBox;
 
     // General Tab widgets
     QLineEdit* m_libraryPathLineEdit;
+    QCheckBox* m_autoImportCheckBox;
+
+    // Audio Tab widgets
+    QCheckBox* m_sampleStoreCheckBox;
+    QSpinBox* m_sampleStoreBudgetSpinBox;
+    QSpinBox* m_primeBudgetSpinBox;
+    QSpinBox* m_queueCrossfadeSpinBox;
+    QCheckBox* m_rememberUsageCheckBox;
+    QComboBox* m_backendComboBox;
+    QSpinBox* m_periodSizeSpinBox;
+    QSpinBox* m_periodsSpinBox;
+    QCheckBox* m_realtimePriorityCheckBox;
+    QCheckBox* m_exclusiveModeCheckBox;
+    QCheckBox* m_parallelMixingCheckBox;
+    QCheckBox* m_micPassthroughCheckBox;
+    QCheckBox* m_micSuppressionCheckBox;
+    QSpinBox* m_micSuppressionSpinBox;
+    QCheckBox* m_micGateCheckBox;
+    QSpinBox* m_micGateSpinBox;
+    QSpinBox* m_replayMinutesSpinBox;
+    QComboBox* m_captureFormatComboBox;
+    QLineEdit* m_capturePathLineEdit;
+    QLabel* m_latencyLabel;
+    QTimer* m_latencyTimer;
+
+    // Hotkeys Tab widgets
+    QCheckBox* m_modifierVariantsCheckBox;
+    QDoubleSpinBox* m_shiftPitchSpinBox;
+    QSpinBox* m_controlTempoSpinBox;
+    QDoubleSpinBox* m_altPitchSpinBox;
+    QKeySequenceEdit* m_replayHotkeyEdit;
+
+    // MIDI Tab widgets
+    QCheckBox* m_midiEnabledCheckBox;
+    QComboBox* m_midiSourceComboBox;
+    QSpinBox* m_midiChannelSpinBox;
+    QSpinBox* m_midiFirstNoteSpinBox;
+    QSpinBox* m_midiFirstControllerSpinBox;
+    QCheckBox* m_midiVelocityCheckBox;
+
+    // Devices Tab widgets
+    QComboBox* m_outputDeviceComboBox;
+    QLabel* m_activeDeviceLabel;
 };
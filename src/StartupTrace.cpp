@@ -0,0 +1,48 @@
+// src/StartupTrace.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StartupTrace.h"
+#include "Log.h"
+#include <QElapsedTimer>
+
+namespace StartupTrace {
+
+namespace {
+QElapsedTimer g_timer;
+qint64 g_lastMarkNs = 0;
+}
+
+void begin()
+{
+    g_timer.start();
+    g_lastMarkNs = 0;
+}
+
+void mark(const char* phase)
+{
+    if (!g_timer.isValid()) {
+        return;
+    }
+    const qint64 now = g_timer.nsecsElapsed();
+    OSD_LOG_INFO(General, "Startup: %s +%.1f ms (total %.1f ms)", phase, (now - g_lastMarkNs) / 1e6, now / 1e6);
+    g_lastMarkNs = now;
+}
+
+} // namespace StartupTrace
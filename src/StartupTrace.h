@@ -0,0 +1,30 @@
+// src/StartupTrace.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Замер фаз запуска: время от начала main() до каждой отметки и от предыдущей отметки.
+// Пишет в журнал (категория general) строки вида "Startup: window shown +12.4 ms (total 96.1 ms)".
+namespace StartupTrace {
+
+void begin();
+void mark(const char* phase);
+
+} // namespace StartupTrace
@@ -0,0 +1,801 @@
+// src/StreamScheduler.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StreamScheduler.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <string>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+constexpr int64_t kEmpty = -1;
+constexpr int64_t kLoading = -2;
+constexpr size_t kBufferAlignment = 4096;
+constexpr double kDefaultBytesPerSecond = 44100.0 * 4; // 16 бит стерео без сжатия — худший случай
+
+uint8_t* allocateBlock()
+{
+    return static_cast<uint8_t*>(::operator new(StreamScheduler::kBlockBytes, std::align_val_t(kBufferAlignment)));
+}
+
+#if defined(_WIN32)
+using FileHandle = HANDLE;
+const FileHandle kInvalidFile = INVALID_HANDLE_VALUE;
+
+FileHandle openFile(const char* pFilePath, const wchar_t* pWideFilePath)
+{
+    std::wstring widePath;
+    if (pWideFilePath == nullptr) {
+        const int length = MultiByteToWideChar(CP_UTF8, 0, pFilePath, -1, nullptr, 0);
+        widePath.resize(length > 0 ? length : 1);
+        MultiByteToWideChar(CP_UTF8, 0, pFilePath, -1, widePath.data(), length);
+        pWideFilePath = widePath.c_str();
+    }
+    return CreateFileW(pWideFilePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+}
+
+int64_t fileSize(FileHandle file)
+{
+    LARGE_INTEGER size = {};
+    return GetFileSizeEx(file, &size) ? size.QuadPart : -1;
+}
+
+int64_t readAt(FileHandle file, void* pOutput, size_t bytes, int64_t offset)
+{
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD bytesRead = 0;
+    if (!ReadFile(file, pOutput, static_cast<DWORD>(bytes), &bytesRead, &overlapped)) {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return bytesRead;
+}
+
+void closeFile(FileHandle file)
+{
+    CloseHandle(file);
+}
+#else
+using FileHandle = int;
+const FileHandle kInvalidFile = -1;
+
+FileHandle openFile(const char* pFilePath, const wchar_t* pWideFilePath)
+{
+    if (pFilePath == nullptr || pWideFilePath != nullptr) {
+        return kInvalidFile; // Широкие пути — только Windows
+    }
+    const int file = ::open(pFilePath, O_RDONLY | O_CLOEXEC);
+#if defined(__linux__)
+    if (file >= 0) {
+        posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+    return file;
+}
+
+int64_t fileSize(FileHandle file)
+{
+    struct stat info = {};
+    return fstat(file, &info) == 0 ? static_cast<int64_t>(info.st_size) : -1;
+}
+
+int64_t readAt(FileHandle file, void* pOutput, size_t bytes, int64_t offset)
+{
+    size_t done = 0;
+    while (done < bytes) {
+        const ssize_t result = ::pread(file, static_cast<char*>(pOutput) + done, bytes - done, offset + done);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            return done > 0 ? static_cast<int64_t>(done) : -1;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return static_cast<int64_t>(done);
+}
+
+void closeFile(FileHandle file)
+{
+    ::close(file);
+}
+#endif
+
+} // namespace
+
+struct StreamScheduler::Stream {
+    // Блок файла в памяти. block и length читает поток декодера без блокировок: блок, который
+    // переписывают во время копирования, распознается повторной проверкой block (как seqlock)
+    struct Slot {
+        std::atomic<int64_t> block{kEmpty};
+        std::atomic<uint32_t> length{0};
+        uint8_t* pData = nullptr;
+        int64_t loadingBlock = kEmpty; // Под m_mutex: какой блок сейчас читается в слот
+    };
+
+    FileHandle file = kInvalidFile;
+    int64_t size = 0;
+    int64_t position = 0; // Только поток декодера
+    std::atomic<int64_t> readBlock{0};
+    std::atomic<double> bytesPerSecond{kDefaultBytesPerSecond};
+    std::atomic<bool> isPlaying{false};
+    std::atomic<bool> isRealtime{false}; // Декодер читает колбэк: промах не ждет диска
+    int64_t pinnedBlock = kEmpty;        // Под m_mutex: начало петли, см. pinPosition()
+    Slot slots[kBlocksPerStream];
+
+    // Под m_mutex
+    int inFlight = 0;
+    bool isClosed = false; // Декодер закрыл файл, пока блоки еще читались: удалит последнее чтение
+
+    ~Stream()
+    {
+        for (Slot& slot : slots) {
+            ::operator delete(slot.pData, std::align_val_t(kBufferAlignment));
+        }
+        if (file != kInvalidFile) {
+            closeFile(file);
+        }
+    }
+
+    int64_t blockCount() const { return (size + kBlockBytes - 1) / kBlockBytes; }
+    uint32_t blockLength(int64_t block) const
+    {
+        return static_cast<uint32_t>(std::min<int64_t>(kBlockBytes, size - block * static_cast<int64_t>(kBlockBytes)));
+    }
+
+    // Без блокировок: блок уже прочитан в слот
+    bool hasLoadedBlock(int64_t block) const
+    {
+        return std::any_of(std::begin(slots), std::end(slots),
+                           [block](const Slot& slot) { return slot.block.load(std::memory_order_acquire) == block; });
+    }
+
+    // Под m_mutex: блок в слоте или читается
+    bool hasBlock(int64_t block) const
+    {
+        return std::any_of(std::begin(slots), std::end(slots), [block](const Slot& slot) {
+            return slot.loadingBlock == block || slot.block.load(std::memory_order_relaxed) == block;
+        });
+    }
+
+    // Под m_mutex
+    bool isPinned(int64_t block) const { return pinnedBlock != kEmpty && block >= pinnedBlock && block < pinnedBlock + 2; }
+
+    // Под m_mutex: слот пустой или с блоком вне окна и вне закрепленных; -1, если все заняты
+    int freeSlot(int64_t first, int window) const
+    {
+        for (int i = 0; i < kBlocksPerStream; ++i) {
+            const int64_t block = slots[i].block.load(std::memory_order_relaxed);
+            if (slots[i].loadingBlock == kEmpty &&
+                (block == kEmpty || ((block < first || block >= first + window) && !isPinned(block)))) {
+                return i;
+            }
+        }
+        return -1;
+    }
+};
+
+StreamScheduler::StreamScheduler(Backend preferred)
+    : m_backend(ThreadPool)
+{
+    m_vfs.callbacks.onOpen = onOpen;
+    m_vfs.callbacks.onOpenW = onOpenW;
+    m_vfs.callbacks.onClose = onClose;
+    m_vfs.callbacks.onRead = onRead;
+    m_vfs.callbacks.onWrite = onWrite;
+    m_vfs.callbacks.onSeek = onSeek;
+    m_vfs.callbacks.onTell = onTell;
+    m_vfs.callbacks.onInfo = onInfo;
+    m_vfs.pScheduler = this;
+
+#if defined(__linux__)
+    if (preferred == IoUring && initRing()) {
+        m_backend = IoUring;
+        m_threads.emplace_back(&StreamScheduler::ringLoop, this);
+        return;
+    }
+#else
+    (void)preferred;
+#endif
+    for (int i = 0; i < kPoolThreads; ++i) {
+        m_threads.emplace_back(&StreamScheduler::poolLoop, this);
+    }
+}
+
+StreamScheduler::~StreamScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    wake();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    // Все чтения завершены; незакрытые файлы — только если декодеры пережили планировщик
+    for (Stream* pStream : m_streams) {
+        delete pStream;
+    }
+
+#if defined(__linux__)
+    if (m_ringFd >= 0) {
+        munmap(m_pSqes, m_sqesBytes);
+        munmap(m_pSqRing, m_sqRingBytes);
+        ::close(m_ringFd);
+    }
+#endif
+}
+
+void StreamScheduler::startPlayback(ma_vfs_file file, double bytesPerSecond, bool isRealtime)
+{
+    Stream* pStream = static_cast<Stream*>(file);
+    if (pStream == nullptr) {
+        return;
+    }
+    if (bytesPerSecond > 0.0) {
+        pStream->bytesPerSecond.store(bytesPerSecond, std::memory_order_relaxed);
+    }
+    // Декодер мог прочитать длину или метаданные в конце файла: окно снова от текущей позиции.
+    // Блок позиции и следующий читаем здесь: первый колбэк голоса начнет без промаха
+    const int64_t first = pStream->position / static_cast<int64_t>(kBlockBytes);
+    pStream->readBlock.store(first, std::memory_order_release);
+    for (int64_t block = first; block < std::min<int64_t>(first + 2, pStream->blockCount()); ++block) {
+        loadBlock(pStream, block);
+    }
+    int64_t pinnedBlock = kEmpty;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pinnedBlock = pStream->pinnedBlock;
+    }
+    for (int64_t block = pinnedBlock; pinnedBlock != kEmpty && block < std::min<int64_t>(pinnedBlock + 2, pStream->blockCount()); ++block) {
+        loadBlock(pStream, block);
+    }
+    pStream->isRealtime.store(isRealtime, std::memory_order_relaxed);
+    pStream->isPlaying.store(true, std::memory_order_release);
+    wake();
+}
+
+void StreamScheduler::pinPosition(ma_vfs_file file)
+{
+    Stream* pStream = static_cast<Stream*>(file);
+    if (pStream == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pStream->pinnedBlock = pStream->position / static_cast<int64_t>(kBlockBytes);
+}
+
+bool StreamScheduler::isReady(ma_vfs_file file)
+{
+    const Stream* pStream = static_cast<const Stream*>(file);
+    if (pStream == nullptr || !pStream->isRealtime.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    // Одно чтение декодера много меньше блока, поэтому хватает блока позиции и следующего
+    const int64_t block = pStream->position / static_cast<int64_t>(kBlockBytes);
+    const int64_t last = std::min<int64_t>(block + 2, pStream->blockCount());
+    for (int64_t next = block; next < last; ++next) {
+        if (!pStream->hasLoadedBlock(next)) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            m_isDemandPending.store(true, std::memory_order_release);
+            return false;
+        }
+    }
+    return true;
+}
+
+StreamScheduler::Stats StreamScheduler::stats() const
+{
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.bytesAhead = m_bytesAhead.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.openStreams = static_cast<int>(m_streams.size());
+    return stats;
+}
+
+StreamScheduler::Stream* StreamScheduler::open(const char* pFilePath, const wchar_t* pWideFilePath)
+{
+    const FileHandle file = openFile(pFilePath, pWideFilePath);
+    if (file == kInvalidFile) {
+        return nullptr;
+    }
+    Stream* pStream = new Stream;
+    pStream->file = file;
+    pStream->size = fileSize(file);
+    if (pStream->size < 0) {
+        delete pStream;
+        return nullptr;
+    }
+
+    // Первый блок читаем сразу: заголовок разбирается из памяти, и голос стартует без промаха.
+    // Остальные буферы слотов выделяются при первом чтении в них
+    if (pStream->size > 0) {
+        pStream->slots[0].pData = allocateBlock();
+        const int64_t bytesRead = readAt(file, pStream->slots[0].pData, pStream->blockLength(0), 0);
+        if (bytesRead > 0) {
+            pStream->slots[0].length.store(static_cast<uint32_t>(bytesRead), std::memory_order_relaxed);
+            pStream->slots[0].block.store(0, std::memory_order_release);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams.push_back(pStream);
+    }
+    wake();
+    return pStream;
+}
+
+void StreamScheduler::close(Stream* pStream)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_streams.erase(std::remove(m_streams.begin(), m_streams.end(), pStream), m_streams.end());
+        if (pStream->inFlight > 0) {
+            pStream->isClosed = true;
+            return;
+        }
+    }
+    delete pStream;
+}
+
+size_t StreamScheduler::read(Stream* pStream, void* pOutput, size_t bytes)
+{
+    uint8_t* pBytes = static_cast<uint8_t*>(pOutput);
+    const bool isPlaying = pStream->isPlaying.load(std::memory_order_relaxed);
+    size_t done = 0;
+
+    while (done < bytes && pStream->position < pStream->size) {
+        const int64_t block = pStream->position / static_cast<int64_t>(kBlockBytes);
+        const size_t offset = static_cast<size_t>(pStream->position % static_cast<int64_t>(kBlockBytes));
+        const size_t wanted = static_cast<size_t>(std::min<int64_t>(bytes - done, pStream->size - pStream->position));
+
+        size_t copied = 0;
+        for (Stream::Slot& slot : pStream->slots) {
+            if (slot.block.load(std::memory_order_acquire) != block) {
+                continue;
+            }
+            const uint32_t length = slot.length.load(std::memory_order_relaxed);
+            if (offset < length) {
+                copied = std::min<size_t>(wanted, length - offset);
+                std::memcpy(pBytes + done, slot.pData + offset, copied);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.block.load(std::memory_order_relaxed) != block) {
+                    copied = 0; // Слот заняли под другой блок, пока мы копировали
+                }
+            }
+            break;
+        }
+
+        if (copied > 0) {
+            if (isPlaying) {
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (pStream->isRealtime.load(std::memory_order_relaxed)) {
+            // Промах в колбэке мимо isReady() — перемотка внутри декодера или чтение длиннее
+            // блока: диск не ждем, декодер получит короткое чтение
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            break;
+        } else {
+            // Промах в обычном потоке: читаем сами до конца блока, как читал бы ma_decoder_init_file()
+            const int64_t bytesRead = readAt(pStream->file, pBytes + done, std::min(wanted, kBlockBytes - offset),
+                                             pStream->position);
+            if (bytesRead <= 0) {
+                break;
+            }
+            copied = static_cast<size_t>(bytesRead);
+            if (isPlaying) {
+                m_misses.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        done += copied;
+        pStream->position += static_cast<int64_t>(copied);
+    }
+
+    moveWindow(pStream); // Новый блок — окно сдвинулось, освободился слот
+    return done;
+}
+
+void StreamScheduler::moveWindow(Stream* pStream)
+{
+    const int64_t readBlock = pStream->position / static_cast<int64_t>(kBlockBytes);
+    if (readBlock == pStream->readBlock.load(std::memory_order_relaxed)) {
+        return;
+    }
+    pStream->readBlock.store(readBlock, std::memory_order_release);
+    if (pStream->isRealtime.load(std::memory_order_relaxed)) {
+        m_isDemandPending.store(true, std::memory_order_release);
+    } else {
+        wake();
+    }
+}
+
+void StreamScheduler::wake()
+{
+    m_demand.fetch_add(1, std::memory_order_release);
+    m_demand.notify_all();
+}
+
+void StreamScheduler::waitForDemand(uint32_t demand, bool isPolling)
+{
+    if (!isPolling) {
+        m_demand.wait(demand);
+        return;
+    }
+    // Пока играют потоки колбэка, ждем его флаг опросом. Раз в kPollLimit список потоков
+    // пересматривается: последний из них мог закрыться
+    for (auto waited = std::chrono::milliseconds::zero(); waited < kPollLimit; waited += kPollInterval) {
+        std::this_thread::sleep_for(kPollInterval);
+        if (m_isDemandPending.exchange(false, std::memory_order_acquire) ||
+            m_demand.load(std::memory_order_acquire) != demand) {
+            return;
+        }
+    }
+}
+
+void StreamScheduler::loadBlock(Stream* pStream, int64_t block)
+{
+    Request request;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const int slot = pStream->hasBlock(block) ? -1 : pStream->freeSlot(pStream->readBlock.load(), kBlocksPerStream);
+        if (slot < 0) {
+            return; // Уже в памяти или читается потоком ввода
+        }
+        claimSlot(pStream, slot, block, &request);
+    }
+    const int64_t bytesRead = readAt(pStream->file, pStream->slots[request.slot].pData, pStream->blockLength(block),
+                                     block * static_cast<int64_t>(kBlockBytes));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    completeRequest(request, bytesRead);
+}
+
+bool StreamScheduler::hasRealtimeStreams() const
+{
+    return std::any_of(m_streams.begin(), m_streams.end(), [](const Stream* pStream) {
+        return pStream->isRealtime.load(std::memory_order_relaxed);
+    });
+}
+
+bool StreamScheduler::takeRequest(Request* pRequest)
+{
+    Stream* pBest = nullptr;
+    int64_t bestBlock = 0;
+    int bestSlot = 0;
+    double bestSeconds = std::numeric_limits<double>::infinity();
+
+    for (Stream* pStream : m_streams) {
+        // Открытый, но не запущенный декодер (подготовленный заранее) держит короткое окно
+        const int window = pStream->isPlaying.load(std::memory_order_relaxed) ? kBlocksPerStream : kIdleBlocksPerStream;
+        const int64_t first = pStream->readBlock.load(std::memory_order_acquire);
+        const int64_t last = std::min<int64_t>(first + window, pStream->blockCount());
+
+        // Первый недостающий блок: закрепленный (его вытеснило чтение до pinPosition()), затем окна
+        int64_t missing = kEmpty;
+        const int64_t pinnedLast = std::min<int64_t>(pStream->pinnedBlock + 2, pStream->blockCount());
+        for (int64_t block = pStream->pinnedBlock; block != kEmpty && block < pinnedLast && missing == kEmpty; ++block) {
+            missing = pStream->hasBlock(block) ? kEmpty : block;
+        }
+        for (int64_t block = first; block < last && missing == kEmpty; ++block) {
+            missing = pStream->hasBlock(block) ? kEmpty : block;
+        }
+        if (missing == kEmpty) {
+            continue;
+        }
+        const int freeSlot = pStream->freeSlot(first, window);
+        if (freeSlot < 0) {
+            continue; // Все слоты заняты чтениями, начатыми до перемотки
+        }
+
+        // Срочность — сколько секунд звука у потока есть до этого блока
+        const double seconds = static_cast<double>(std::max<int64_t>(missing - first, 0) * static_cast<int64_t>(kBlockBytes)) /
+                               pStream->bytesPerSecond.load(std::memory_order_relaxed);
+        if (seconds < bestSeconds) {
+            pBest = pStream;
+            bestBlock = missing;
+            bestSlot = freeSlot;
+            bestSeconds = seconds;
+        }
+    }
+    if (pBest == nullptr) {
+        return false;
+    }
+    claimSlot(pBest, bestSlot, bestBlock, pRequest);
+    return true;
+}
+
+void StreamScheduler::claimSlot(Stream* pStream, int slot, int64_t block, Request* pRequest)
+{
+    Stream::Slot& target = pStream->slots[slot];
+    if (target.pData == nullptr) {
+        target.pData = allocateBlock(); // Читатель смотрит в pData, только увидев в слоте свой блок
+    }
+    target.block.store(kLoading, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    target.loadingBlock = block;
+    ++pStream->inFlight;
+    pRequest->pStream = pStream;
+    pRequest->slot = slot;
+    pRequest->block = block;
+}
+
+void StreamScheduler::completeRequest(const Request& request, int64_t bytesRead)
+{
+    Stream* pStream = request.pStream;
+    Stream::Slot& slot = pStream->slots[request.slot];
+    slot.loadingBlock = kEmpty;
+    if (bytesRead > 0) {
+        slot.length.store(static_cast<uint32_t>(bytesRead), std::memory_order_relaxed);
+        slot.block.store(request.block, std::memory_order_release);
+        m_bytesAhead.fetch_add(static_cast<uint64_t>(bytesRead), std::memory_order_relaxed);
+    } else {
+        slot.block.store(kEmpty, std::memory_order_release); // Ошибку чтения увидит промах декодера
+    }
+    if (--pStream->inFlight == 0 && pStream->isClosed) {
+        delete pStream;
+    }
+}
+
+void StreamScheduler::poolLoop()
+{
+    for (;;) {
+        const uint32_t demand = m_demand.load(std::memory_order_acquire);
+        Request request;
+        FileHandle file = kInvalidFile;
+        uint32_t length = 0;
+        bool isPolling = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_isStopping) {
+                return;
+            }
+            if (takeRequest(&request)) {
+                file = request.pStream->file;
+                length = request.pStream->blockLength(request.block);
+            }
+            isPolling = hasRealtimeStreams();
+        }
+        if (file == kInvalidFile) {
+            waitForDemand(demand, isPolling);
+            continue;
+        }
+
+        const int64_t bytesRead = readAt(file, request.pStream->slots[request.slot].pData, length,
+                                         request.block * static_cast<int64_t>(kBlockBytes));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        completeRequest(request, bytesRead);
+    }
+}
+
+#if defined(__linux__)
+
+// io_uring без liburing: три отображения колец и два системных вызова
+bool StreamScheduler::initRing()
+{
+    io_uring_params parameters = {};
+    const int ringFd = static_cast<int>(syscall(__NR_io_uring_setup, kQueueDepth, &parameters));
+    if (ringFd < 0) {
+        return false;
+    }
+    // Таймаут ожидания (EXT_ARG, ядро 5.11+) нужен, чтобы срочный запрос не ждал медленный;
+    // на этих ядрах есть и IORING_OP_READ
+    if (!(parameters.features & IORING_FEAT_EXT_ARG) || !(parameters.features & IORING_FEAT_SINGLE_MMAP)) {
+        ::close(ringFd);
+        return false;
+    }
+
+    m_sqRingBytes = std::max<size_t>(parameters.sq_off.array + parameters.sq_entries * sizeof(uint32_t),
+                                     parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe));
+    m_sqesBytes = parameters.sq_entries * sizeof(io_uring_sqe);
+    m_pSqRing = mmap(nullptr, m_sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (m_pSqRing == MAP_FAILED) {
+        ::close(ringFd);
+        return false;
+    }
+    m_pSqes = mmap(nullptr, m_sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (m_pSqes == MAP_FAILED) {
+        munmap(m_pSqRing, m_sqRingBytes);
+        ::close(ringFd);
+        return false;
+    }
+
+    uint8_t* pSq = static_cast<uint8_t*>(m_pSqRing);
+    m_pSqTail = reinterpret_cast<uint32_t*>(pSq + parameters.sq_off.tail);
+    m_pSqMask = reinterpret_cast<uint32_t*>(pSq + parameters.sq_off.ring_mask);
+    m_pSqArray = reinterpret_cast<uint32_t*>(pSq + parameters.sq_off.array);
+    m_pCqHead = reinterpret_cast<uint32_t*>(pSq + parameters.cq_off.head);
+    m_pCqTail = reinterpret_cast<uint32_t*>(pSq + parameters.cq_off.tail);
+    m_pCqMask = reinterpret_cast<uint32_t*>(pSq + parameters.cq_off.ring_mask);
+    m_pCqes = pSq + parameters.cq_off.cqes;
+    m_ringFd = ringFd;
+    return true;
+}
+
+void StreamScheduler::ringLoop()
+{
+    Request requests[kQueueDepth];
+    bool isUsed[kQueueDepth] = {};
+    int inFlight = 0;
+    unsigned unsubmitted = 0;
+    io_uring_sqe* pSqes = static_cast<io_uring_sqe*>(m_pSqes);
+    const io_uring_cqe* pCqes = static_cast<const io_uring_cqe*>(m_pCqes);
+
+    for (;;) {
+        const uint32_t demand = m_demand.load(std::memory_order_acquire);
+        bool isPolling = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_isStopping && inFlight == 0) {
+                return;
+            }
+            isPolling = hasRealtimeStreams();
+            // Очередь заполняется по срочности; ядро выполняет запросы параллельно
+            for (int index = 0; index < kQueueDepth && !m_isStopping; ++index) {
+                if (isUsed[index]) {
+                    continue;
+                }
+                if (!takeRequest(&requests[index])) {
+                    break;
+                }
+                const Request& request = requests[index];
+                const uint32_t tail = *m_pSqTail;
+                const uint32_t sqIndex = tail & *m_pSqMask;
+                io_uring_sqe* pSqe = &pSqes[sqIndex];
+                std::memset(pSqe, 0, sizeof(*pSqe));
+                pSqe->opcode = IORING_OP_READ;
+                pSqe->fd = request.pStream->file;
+                pSqe->addr = reinterpret_cast<uint64_t>(request.pStream->slots[request.slot].pData);
+                pSqe->len = request.pStream->blockLength(request.block);
+                pSqe->off = static_cast<uint64_t>(request.block) * kBlockBytes;
+                pSqe->user_data = static_cast<uint64_t>(index);
+                m_pSqArray[sqIndex] = sqIndex;
+                std::atomic_ref<uint32_t>(*m_pSqTail).store(tail + 1, std::memory_order_release);
+                isUsed[index] = true;
+                ++inFlight;
+                ++unsubmitted;
+            }
+        }
+        if (inFlight == 0) {
+            waitForDemand(demand, isPolling);
+            continue;
+        }
+
+        // Ждем хотя бы одно завершение, но не дольше 2 мс: за это время мог появиться более срочный блок
+        __kernel_timespec timeout = {0, 2000000};
+        io_uring_getevents_arg argument = {};
+        argument.ts = reinterpret_cast<uint64_t>(&timeout);
+        const long submitted = syscall(__NR_io_uring_enter, m_ringFd, unsubmitted, 1,
+                                       IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument, sizeof(argument));
+        if (submitted > 0) {
+            unsubmitted -= static_cast<unsigned>(std::min<long>(submitted, unsubmitted));
+        }
+
+        std::atomic_ref<uint32_t> cqTail(*m_pCqTail);
+        std::atomic_ref<uint32_t> cqHead(*m_pCqHead);
+        uint32_t head = cqHead.load(std::memory_order_relaxed);
+        const uint32_t tail = cqTail.load(std::memory_order_acquire);
+        if (head == tail) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = pCqes[head & *m_pCqMask];
+            const int index = static_cast<int>(cqe.user_data);
+            completeRequest(requests[index], cqe.res);
+            isUsed[index] = false;
+            --inFlight;
+        }
+        cqHead.store(head, std::memory_order_release);
+    }
+}
+
+#endif
+
+ma_result StreamScheduler::onOpen(ma_vfs* pVFS, const char* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile)
+{
+    if (pFile == nullptr || pFilePath == nullptr || (openMode & MA_OPEN_MODE_WRITE) != 0) {
+        return MA_INVALID_ARGS;
+    }
+    *pFile = reinterpret_cast<Vfs*>(pVFS)->pScheduler->open(pFilePath, nullptr);
+    return *pFile != nullptr ? MA_SUCCESS : MA_DOES_NOT_EXIST;
+}
+
+ma_result StreamScheduler::onOpenW(ma_vfs* pVFS, const wchar_t* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile)
+{
+    if (pFile == nullptr || pFilePath == nullptr || (openMode & MA_OPEN_MODE_WRITE) != 0) {
+        return MA_INVALID_ARGS;
+    }
+    *pFile = reinterpret_cast<Vfs*>(pVFS)->pScheduler->open(nullptr, pFilePath);
+    return *pFile != nullptr ? MA_SUCCESS : MA_DOES_NOT_EXIST;
+}
+
+ma_result StreamScheduler::onClose(ma_vfs* pVFS, ma_vfs_file file)
+{
+    reinterpret_cast<Vfs*>(pVFS)->pScheduler->close(static_cast<Stream*>(file));
+    return MA_SUCCESS;
+}
+
+ma_result StreamScheduler::onRead(ma_vfs* pVFS, ma_vfs_file file, void* pDst, size_t sizeInBytes, size_t* pBytesRead)
+{
+    const size_t bytesRead = reinterpret_cast<Vfs*>(pVFS)->pScheduler->read(static_cast<Stream*>(file), pDst, sizeInBytes);
+    if (pBytesRead != nullptr) {
+        *pBytesRead = bytesRead;
+    }
+    return bytesRead == 0 && sizeInBytes > 0 ? MA_AT_END : MA_SUCCESS;
+}
+
+ma_result StreamScheduler::onWrite(ma_vfs*, ma_vfs_file, const void*, size_t, size_t*)
+{
+    return MA_NOT_IMPLEMENTED;
+}
+
+ma_result StreamScheduler::onSeek(ma_vfs* pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin)
+{
+    Stream* pStream = static_cast<Stream*>(file);
+    const int64_t base = origin == ma_seek_origin_current ? pStream->position
+                       : origin == ma_seek_origin_end ? pStream->size
+                       : 0;
+    if (base + offset < 0) {
+        return MA_INVALID_ARGS;
+    }
+    pStream->position = base + offset;
+
+    // Окно переезжает вместе с позицией: перемотка или переход петли
+    reinterpret_cast<Vfs*>(pVFS)->pScheduler->moveWindow(pStream);
+    return MA_SUCCESS;
+}
+
+ma_result StreamScheduler::onTell(ma_vfs*, ma_vfs_file file, ma_int64* pCursor)
+{
+    *pCursor = static_cast<Stream*>(file)->position;
+    return MA_SUCCESS;
+}
+
+ma_result StreamScheduler::onInfo(ma_vfs*, ma_vfs_file file, ma_file_info* pInfo)
+{
+    pInfo->sizeInBytes = static_cast<ma_uint64>(static_cast<Stream*>(file)->size);
+    return MA_SUCCESS;
+}
@@ -0,0 +1,167 @@
+// src/StreamScheduler.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "miniaudio.h"
+
+// Упреждающее чтение файлов для потоковых голосов. Декодер читает файл через vfs()
+// и получает байты из блоков, которые заранее прочитали потоки ввода-вывода; аудиопоток
+// не ждет их никогда. Если блок не успели прочитать, голос колбэка молчит, пока блок
+// не появится (см. isReady()), — это промах, он виден в телеметрии. Декодер в обычном
+// потоке (открытие, подготовка, офлайн-рендер) при промахе читает файл сам.
+//
+// Аудиопоток не делает системных вызовов: о сдвинутом окне он сообщает флагом, который
+// потоки ввода проверяют раз в kPollInterval, пока играет хоть один поток реального времени.
+//
+// Чтение идет крупными выровненными блоками по kBlockBytes, у каждого потока окно
+// в kBlocksPerStream блоков впереди позиции. Следующим читается блок потока, которому
+// осталось меньше всего секунд звука до опустошения окна: десятки одновременных
+// подложек с медленного диска или сетевой папки делят его по срочности, а не по очереди.
+//
+// На Linux запросы идут через io_uring (одна очередь, до kQueueDepth запросов в полете),
+// иначе и на старых ядрах — через пул потоков с pread.
+class StreamScheduler
+{
+public:
+    enum Backend {
+        IoUring,
+        ThreadPool
+    };
+
+    static constexpr size_t kBlockBytes = 256 * 1024;
+    static constexpr int kBlocksPerStream = 8;
+    static constexpr int kIdleBlocksPerStream = 2; // Окно до startPlayback(): декодер открыт заранее
+    static constexpr int kQueueDepth = 32;
+    static constexpr int kPoolThreads = 4;
+    static constexpr std::chrono::milliseconds kPollInterval{5};
+    static constexpr std::chrono::milliseconds kPollLimit{100}; // Пересмотр списка потоков при опросе
+
+    struct Stats {
+        uint64_t hits = 0;       // Чтения декодера из готовых блоков
+        uint64_t misses = 0;     // Блок не успел: колбэк молчал или обычный поток читал с диска сам
+        uint64_t bytesAhead = 0; // Прочитано упреждающе
+        int openStreams = 0;
+    };
+
+    explicit StreamScheduler(Backend preferred = IoUring);
+    ~StreamScheduler();
+    StreamScheduler(const StreamScheduler&) = delete;
+    StreamScheduler& operator=(const StreamScheduler&) = delete;
+
+    Backend backend() const { return m_backend; }
+    const char* backendName() const { return m_backend == IoUring ? "io_uring" : "thread pool"; }
+
+    // Для ma_decoder_init_vfs(). Файлы открывает и закрывает любой поток (ma_decoder_init /
+    // ma_decoder_uninit), read/seek/tell — поток, владеющий декодером. Декодер можно передать
+    // другому потоку через мьютекс или очередь, как делает DecoderPrimer.
+    ma_vfs* vfs() { return &m_vfs.callbacks; }
+
+    // Декодер открыт и стоит на начале звука: поток начинает считать промахи и получает скорость
+    // расхода (байт в секунду звука), по которой считается его срочность. Первые блоки окна
+    // читаются сразу, в вызывающем потоке. isRealtime — дальше декодер читает колбэк: промах
+    // не ждет диска
+    void startPlayback(ma_vfs_file file, double bytesPerSecond, bool isRealtime);
+    // Блок позиции декодера и следующий остаются в памяти все воспроизведение, вне окна:
+    // сюда колбэк перематывает на каждом круге петли. Вызывать до startPlayback()
+    void pinPosition(ma_vfs_file file);
+    // Колбэк перед чтением декодера: блок позиции и следующий уже в памяти. false — промах,
+    // голосу звучать тишиной до следующего колбэка. Для обычных потоков всегда true
+    bool isReady(ma_vfs_file file);
+
+    Stats stats() const;
+
+private:
+    struct Stream;
+    struct Request {
+        Stream* pStream = nullptr;
+        int slot = 0;
+        int64_t block = 0;
+    };
+    struct Vfs {
+        ma_vfs_callbacks callbacks;
+        StreamScheduler* pScheduler;
+    };
+
+    Stream* open(const char* pFilePath, const wchar_t* pWideFilePath);
+    void close(Stream* pStream);
+    size_t read(Stream* pStream, void* pOutput, size_t bytes);
+    void moveWindow(Stream* pStream); // Окно — за позицией декодера
+    void wake();                      // Не из колбэка: системный вызов
+    void waitForDemand(uint32_t demand, bool isPolling);
+    void loadBlock(Stream* pStream, int64_t block);
+
+    // Под m_mutex: выбирает самый срочный недостающий блок и занимает под него слот
+    bool takeRequest(Request* pRequest);
+    void claimSlot(Stream* pStream, int slot, int64_t block, Request* pRequest);
+    bool hasRealtimeStreams() const;
+    void completeRequest(const Request& request, int64_t bytesRead);
+    void poolLoop();
+
+#if defined(__linux__)
+    bool initRing();
+    void ringLoop();
+    int m_ringFd = -1;
+    void* m_pSqRing = nullptr; // Одно отображение на оба кольца (IORING_FEAT_SINGLE_MMAP)
+    void* m_pSqes = nullptr;
+    size_t m_sqRingBytes = 0;
+    size_t m_sqesBytes = 0;
+    uint32_t* m_pSqTail = nullptr;
+    uint32_t* m_pSqMask = nullptr;
+    uint32_t* m_pSqArray = nullptr;
+    uint32_t* m_pCqHead = nullptr;
+    uint32_t* m_pCqTail = nullptr;
+    uint32_t* m_pCqMask = nullptr;
+    void* m_pCqes = nullptr;
+#endif
+
+    static ma_result onOpen(ma_vfs* pVFS, const char* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile);
+    static ma_result onOpenW(ma_vfs* pVFS, const wchar_t* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile);
+    static ma_result onClose(ma_vfs* pVFS, ma_vfs_file file);
+    static ma_result onRead(ma_vfs* pVFS, ma_vfs_file file, void* pDst, size_t sizeInBytes, size_t* pBytesRead);
+    static ma_result onWrite(ma_vfs* pVFS, ma_vfs_file file, const void* pSrc, size_t sizeInBytes, size_t* pBytesWritten);
+    static ma_result onSeek(ma_vfs* pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin);
+    static ma_result onTell(ma_vfs* pVFS, ma_vfs_file file, ma_int64* pCursor);
+    static ma_result onInfo(ma_vfs* pVFS, ma_vfs_file file, ma_file_info* pInfo);
+
+    Vfs m_vfs;
+    Backend m_backend;
+    std::vector<std::thread> m_threads;
+
+    // Список потоков и слоты в полете меняются под мьютексом; аудиопоток его не берет
+    mutable std::mutex m_mutex;
+    std::vector<Stream*> m_streams;
+    bool m_isStopping = false;
+
+    // Счетчик спроса: открытие, запуск, остановка — потоки ввода просыпаются сразу.
+    // Флаг — тот же спрос от аудиопотока, его потоки ввода опрашивают
+    std::atomic<uint32_t> m_demand{0};
+    std::atomic<bool> m_isDemandPending{false};
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_bytesAhead{0};
+};
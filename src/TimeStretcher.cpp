@@ -0,0 +1,335 @@
+// src/TimeStretcher.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TimeStretcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kSequenceFrames = 1920; // 40 мс
+constexpr size_t kOverlapFrames = 384;   // 8 мс
+constexpr size_t kSeekFrames = 720;      // 15 мс
+constexpr size_t kCoarseStep = 4;        // Шаг грубого поиска
+constexpr size_t kFineRadius = kCoarseStep - 1;
+
+}
+
+TimeStretcher::TimeStretcher()
+    : m_sequenceFrames(kSequenceFrames),
+      m_overlapFrames(kOverlapFrames),
+      m_seekFrames(kSeekFrames),
+      m_tempo(1.0f),
+      m_pitchSemitones(0.0f),
+      m_stretchRatio(1.0),
+      m_pitchRatio(1.0),
+      m_inputFrames(0),
+      m_realInputFrames(0),
+      m_pendingSkip(0),
+      m_skipRemainder(0.0),
+      m_isSourceFinished(false),
+      m_hasOverlap(false),
+      m_overlapCursor(0),
+      m_continuationFrame(0),
+      m_stretchedFrames(0),
+      m_resamplePosition(0.0)
+{
+    m_input.resize((m_seekFrames + m_sequenceFrames) * kChannels);
+    m_overlap.resize(m_overlapFrames * kChannels);
+    m_overlapMono.resize(m_overlapFrames);
+    m_inputMono.resize(m_seekFrames + m_overlapFrames);
+    // Остаток после передискретизации плюс одна новая последовательность
+    m_stretched.resize(2 * m_sequenceFrames * kChannels);
+}
+
+void TimeStretcher::setParameters(float tempo, float pitchSemitones)
+{
+    m_tempo = std::clamp(tempo, kMinTempo, kMaxTempo);
+    m_pitchSemitones = std::clamp(pitchSemitones, -kMaxPitchSemitones, kMaxPitchSemitones);
+    m_pitchRatio = std::exp2(m_pitchSemitones / 12.0);
+    // WSOLA растягивает на pitchRatio больше, передискретизация сжимает обратно
+    m_stretchRatio = m_tempo / m_pitchRatio;
+}
+
+void TimeStretcher::reset()
+{
+    m_inputFrames = 0;
+    m_realInputFrames = 0;
+    m_pendingSkip = 0;
+    m_skipRemainder = 0.0;
+    m_isSourceFinished = false;
+    m_hasOverlap = false;
+    m_overlapCursor = 0;
+    m_continuationFrame = 0;
+    m_stretchedFrames = 0;
+    m_resamplePosition = 0.0;
+}
+
+size_t TimeStretcher::render(float* pOut, size_t frameCount, ReadFunction read, void* pUserData)
+{
+    size_t produced = 0;
+    while (produced < frameCount) {
+        produced += resample(pOut + produced * kChannels, frameCount - produced);
+        if (produced < frameCount && !processSequence(read, pUserData)) {
+            break;
+        }
+    }
+    return produced;
+}
+
+size_t TimeStretcher::resample(float* pOut, size_t frameCount)
+{
+    // Линейная интерполяция; при pitchRatio == 1 это точная копия
+    size_t produced = 0;
+    size_t index = static_cast<size_t>(m_resamplePosition);
+    while (produced < frameCount && index + 1 < m_stretchedFrames) {
+        const float frac = static_cast<float>(m_resamplePosition - static_cast<double>(index));
+        const float* a = &m_stretched[index * kChannels];
+        const float* b = a + kChannels;
+        for (size_t c = 0; c < kChannels; ++c) {
+            pOut[produced * kChannels + c] = a[c] + (b[c] - a[c]) * frac;
+        }
+        ++produced;
+        m_resamplePosition += m_pitchRatio;
+        index = static_cast<size_t>(m_resamplePosition);
+    }
+
+    const size_t consumed = std::min(index, m_stretchedFrames);
+    if (consumed > 0) {
+        std::memmove(m_stretched.data(), m_stretched.data() + consumed * kChannels,
+                     (m_stretchedFrames - consumed) * kChannels * sizeof(float));
+        m_stretchedFrames -= consumed;
+        m_resamplePosition -= static_cast<double>(consumed);
+    }
+    return produced;
+}
+
+size_t TimeStretcher::drain(float* pOut, size_t frameCount, ReadFunction read, void* pUserData)
+{
+    // Порядок тот же, в каком эти кадры прозвучали бы: готовый выход WSOLA, хвост последней
+    // последовательности, затем вход за хвостом. Дробная позиция передискретизации отбрасывается
+    size_t produced = 0;
+    const size_t index = static_cast<size_t>(m_resamplePosition);
+    if (index < m_stretchedFrames) {
+        const size_t count = std::min(frameCount, m_stretchedFrames - index);
+        std::memcpy(pOut, &m_stretched[index * kChannels], count * kChannels * sizeof(float));
+        produced += count;
+        m_resamplePosition = static_cast<double>(index + count);
+    }
+
+    if (m_hasOverlap && produced < frameCount) {
+        const size_t count = std::min(frameCount - produced, m_overlapFrames - m_overlapCursor);
+        std::memcpy(pOut + produced * kChannels, &m_overlap[m_overlapCursor * kChannels],
+                    count * kChannels * sizeof(float));
+        produced += count;
+        m_overlapCursor += count;
+        if (m_overlapCursor == m_overlapFrames) {
+            // Вход до конца хвоста уже прозвучал в последовательностях
+            m_hasOverlap = false;
+            if (m_continuationFrame > 0) {
+                dropInput(static_cast<size_t>(m_continuationFrame));
+            }
+            m_continuationFrame = 0;
+        }
+    }
+
+    if (!m_hasOverlap && produced < frameCount && m_realInputFrames > 0) {
+        const size_t count = std::min(frameCount - produced, m_realInputFrames);
+        std::memcpy(pOut + produced * kChannels, m_input.data(), count * kChannels * sizeof(float));
+        produced += count;
+        dropInput(count);
+    }
+
+    if (produced < frameCount) {
+        skipPending(read, pUserData);
+        reset();
+    }
+    return produced;
+}
+
+size_t TimeStretcher::bufferedFrames() const
+{
+    double frames = std::max(0.0, static_cast<double>(m_stretchedFrames) - m_resamplePosition) / m_pitchRatio;
+    if (m_hasOverlap) {
+        frames += static_cast<double>(m_overlapFrames - m_overlapCursor) / m_pitchRatio;
+    }
+    const size_t behind = static_cast<size_t>(std::max<std::ptrdiff_t>(m_continuationFrame, 0));
+    if (m_realInputFrames > behind) {
+        frames += static_cast<double>(m_realInputFrames - behind) / m_tempo;
+    }
+    return static_cast<size_t>(frames);
+}
+
+void TimeStretcher::skipPending(ReadFunction read, void* pUserData)
+{
+    // Пропуск, не поместившийся в накопленный вход, дочитывается и отбрасывается
+    while (m_pendingSkip > 0 && !m_isSourceFinished) {
+        const size_t chunk = std::min(m_pendingSkip, m_input.size() / kChannels);
+        const size_t got = read(pUserData, m_input.data(), chunk);
+        m_pendingSkip -= got;
+        if (got < chunk) {
+            m_isSourceFinished = true;
+        }
+    }
+}
+
+bool TimeStretcher::fillInput(ReadFunction read, void* pUserData)
+{
+    skipPending(read, pUserData);
+
+    const size_t needed = m_seekFrames + m_sequenceFrames;
+    if (m_inputFrames < needed) {
+        size_t got = 0;
+        if (!m_isSourceFinished) {
+            got = read(pUserData, m_input.data() + m_inputFrames * kChannels, needed - m_inputFrames);
+            if (got < needed - m_inputFrames) {
+                m_isSourceFinished = true;
+            }
+            m_realInputFrames += got;
+        }
+        // После конца источника хвост дополняется тишиной
+        std::fill(m_input.begin() + (m_inputFrames + got) * kChannels, m_input.end(), 0.0f);
+        m_inputFrames = needed;
+    }
+    return m_realInputFrames > 0;
+}
+
+bool TimeStretcher::processSequence(ReadFunction read, void* pUserData)
+{
+    if (!fillInput(read, pUserData)) {
+        return false;
+    }
+    // Переполнение выходного буфера означает, что передискретизация не забирает данные
+    const size_t sequenceOutput = m_sequenceFrames - m_overlapFrames;
+    if ((m_stretchedFrames + sequenceOutput) * kChannels > m_stretched.size()) {
+        return false;
+    }
+
+    size_t offset = 0;
+    if (m_hasOverlap) {
+        // Моно-копия окна поиска: каждое смещение читает ее вместо пары каналов
+        for (size_t i = 0; i < m_seekFrames + m_overlapFrames; ++i) {
+            m_inputMono[i] = m_input[i * kChannels] + m_input[i * kChannels + 1];
+        }
+        offset = seekBestOverlap();
+    }
+    const float* pSequence = &m_input[offset * kChannels];
+
+    // Перекрытие с хвостом предыдущей последовательности
+    float* pDest = &m_stretched[m_stretchedFrames * kChannels];
+    if (m_hasOverlap) {
+        const float step = 1.0f / static_cast<float>(m_overlapFrames);
+        for (size_t i = 0; i < m_overlapFrames; ++i) {
+            const float fadeIn = static_cast<float>(i) * step;
+            for (size_t c = 0; c < kChannels; ++c) {
+                const size_t s = i * kChannels + c;
+                pDest[s] = m_overlap[s] + (pSequence[s] - m_overlap[s]) * fadeIn;
+            }
+        }
+    } else {
+        std::memcpy(pDest, pSequence, m_overlapFrames * kChannels * sizeof(float));
+    }
+    std::memcpy(pDest + m_overlapFrames * kChannels,
+                pSequence + m_overlapFrames * kChannels,
+                (sequenceOutput - m_overlapFrames) * kChannels * sizeof(float));
+    m_stretchedFrames += sequenceOutput;
+
+    // Хвост последовательности станет перекрытием для следующей
+    const float* pTail = pSequence + sequenceOutput * kChannels;
+    std::memcpy(m_overlap.data(), pTail, m_overlapFrames * kChannels * sizeof(float));
+    for (size_t i = 0; i < m_overlapFrames; ++i) {
+        m_overlapMono[i] = pTail[i * kChannels] + pTail[i * kChannels + 1];
+    }
+    m_hasOverlap = true;
+    m_continuationFrame = static_cast<std::ptrdiff_t>(offset + m_sequenceFrames);
+
+    m_skipRemainder += m_stretchRatio * static_cast<double>(sequenceOutput);
+    const size_t skip = static_cast<size_t>(m_skipRemainder);
+    m_skipRemainder -= static_cast<double>(skip);
+    dropInput(skip);
+    return true;
+}
+
+void TimeStretcher::dropInput(size_t frameCount)
+{
+    m_continuationFrame -= static_cast<std::ptrdiff_t>(frameCount);
+    m_realInputFrames -= std::min(frameCount, m_realInputFrames);
+    if (frameCount >= m_inputFrames) {
+        m_pendingSkip += frameCount - m_inputFrames;
+        m_inputFrames = 0;
+        return;
+    }
+    std::memmove(m_input.data(), m_input.data() + frameCount * kChannels,
+                 (m_inputFrames - frameCount) * kChannels * sizeof(float));
+    m_inputFrames -= frameCount;
+}
+
+size_t TimeStretcher::seekBestOverlap() const
+{
+    // Грубый проход с прореживанием, затем уточнение вокруг лучшего смещения
+    size_t bestOffset = 0;
+    float bestScore = -1.0e30f;
+    for (size_t offset = 0; offset < m_seekFrames; offset += kCoarseStep) {
+        const float score = correlation(offset, 2);
+        if (score > bestScore) {
+            bestScore = score;
+            bestOffset = offset;
+        }
+    }
+
+    const size_t first = bestOffset > kFineRadius ? bestOffset - kFineRadius : 0;
+    const size_t last = std::min(bestOffset + kFineRadius, m_seekFrames - 1);
+    bestScore = -1.0e30f;
+    size_t refined = bestOffset;
+    for (size_t offset = first; offset <= last; ++offset) {
+        const float score = correlation(offset, 1);
+        if (score > bestScore) {
+            bestScore = score;
+            refined = offset;
+        }
+    }
+    return refined;
+}
+
+float TimeStretcher::correlation(size_t offset, size_t step) const
+{
+    // Четыре независимые суммы разрывают цепочку зависимостей сложения
+    const float* pCandidate = &m_inputMono[offset];
+    float cross[4] = {};
+    float energy[4] = {};
+    const size_t stride = 4 * step;
+    size_t i = 0;
+    for (; i + stride <= m_overlapFrames; i += stride) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            const size_t k = i + lane * step;
+            cross[lane] += m_overlapMono[k] * pCandidate[k];
+            energy[lane] += pCandidate[k] * pCandidate[k];
+        }
+    }
+    for (; i < m_overlapFrames; i += step) {
+        cross[0] += m_overlapMono[i] * pCandidate[i];
+        energy[0] += pCandidate[i] * pCandidate[i];
+    }
+    const float crossSum = (cross[0] + cross[1]) + (cross[2] + cross[3]);
+    const float energySum = (energy[0] + energy[1]) + (energy[2] + energy[3]);
+    return crossSum / std::sqrt(energySum + 1.0e-9f);
+}
@@ -0,0 +1,101 @@
+// src/TimeStretcher.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Изменение темпа и высоты тона для одного голоса (стерео f32, 48 кГц).
+// Темп меняет WSOLA: последовательности по 40 мс склеиваются в точке наибольшей
+// корреляции в окне поиска 15 мс. Высоту тона дает растяжение на коэффициент
+// высоты с последующей линейной передискретизацией обратно.
+//
+// Все буферы выделяются в конструкторе, render() не выделяет память,
+// а стоимость на кадр ограничена пределами параметров.
+class TimeStretcher
+{
+public:
+    static constexpr size_t kChannels = 2;
+    static constexpr float kMinTempo = 0.5f;
+    static constexpr float kMaxTempo = 2.0f;
+    static constexpr float kMaxPitchSemitones = 12.0f;
+
+    // Источник кадров: возвращает число прочитанных кадров, меньше запрошенного — конец
+    using ReadFunction = size_t (*)(void* pUserData, float* pOut, size_t frameCount);
+
+    TimeStretcher();
+
+    void setParameters(float tempo, float pitchSemitones);
+    float tempo() const { return m_tempo; }
+    float pitchSemitones() const { return m_pitchSemitones; }
+    bool isActive() const { return m_tempo != 1.0f || m_pitchSemitones != 0.0f; }
+
+    // Сбрасывает накопленные буферы (после перемотки источника)
+    void reset();
+
+    // Заполняет pOut, вытягивая данные из источника. Меньше frameCount — источник исчерпан.
+    size_t render(float* pOut, size_t frameCount, ReadFunction read, void* pUserData);
+
+    // После возврата к исходным темпу и тону: отдает без обработки то, что уже прочитано из
+    // источника, и сбрасывает буферы. Меньше frameCount — дальше источник читается напрямую
+    size_t drain(float* pOut, size_t frameCount, ReadFunction read, void* pUserData);
+
+    // Сколько кадров выхода дадут данные, уже прочитанные из источника (оценка по темпу)
+    size_t bufferedFrames() const;
+
+private:
+    size_t resample(float* pOut, size_t frameCount);
+    bool processSequence(ReadFunction read, void* pUserData);
+    bool fillInput(ReadFunction read, void* pUserData);
+    void skipPending(ReadFunction read, void* pUserData);
+    size_t seekBestOverlap() const;
+    float correlation(size_t offset, size_t step) const;
+    void appendStretched(const float* pFrames, size_t frameCount);
+    void dropInput(size_t frameCount);
+
+    // Параметры WSOLA в кадрах при 48 кГц
+    const size_t m_sequenceFrames;
+    const size_t m_overlapFrames;
+    const size_t m_seekFrames;
+
+    float m_tempo;
+    float m_pitchSemitones;
+    double m_stretchRatio; // Входных кадров на один кадр после WSOLA
+    double m_pitchRatio;   // Шаг передискретизации
+
+    std::vector<float> m_input;
+    std::vector<float> m_inputMono; // Окно поиска, сведенное в моно
+    size_t m_inputFrames;
+    size_t m_realInputFrames; // Без дополненной тишины после конца источника
+    size_t m_pendingSkip;     // Пропуск, превысивший накопленный вход
+    double m_skipRemainder;
+    bool m_isSourceFinished;
+
+    std::vector<float> m_overlap;     // Хвост предыдущей последовательности
+    std::vector<float> m_overlapMono;
+    bool m_hasOverlap;
+    size_t m_overlapCursor;           // Отданная drain() часть хвоста
+    std::ptrdiff_t m_continuationFrame; // Кадр m_input сразу за хвостом; меньше нуля — источник за ним пропущен
+
+    std::vector<float> m_stretched;   // Выход WSOLA, ждущий передискретизации
+    size_t m_stretchedFrames;
+    double m_resamplePosition;
+};
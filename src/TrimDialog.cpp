@@ -0,0 +1,124 @@
+#include "TrimDialog.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QDialogButtonBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QStringList>
+
+TrimDialog::TrimDialog(const AudioEngine::PlaybackRegion &region, const AudioEngine::VoiceParams &params,
+                       QWidget *parent)
+    : QDialog(parent),
+      m_params(params)
+{
+    setWindowTitle(tr("Trim, Loop and Pitch"));
+
+    m_startSpinBox = createMillisSpinBox(region.startMillis, QString());
+    m_endSpinBox = createMillisSpinBox(region.endMillis, tr("End of file"));
+    m_loopCheckBox = new QCheckBox(tr("Loop"), this);
+    m_loopCheckBox->setChecked(region.loop);
+    m_loopStartSpinBox = createMillisSpinBox(region.loopStartMillis, tr("Trim start"));
+    m_loopEndSpinBox = createMillisSpinBox(region.loopEndMillis, tr("Trim end"));
+    m_crossfadeSpinBox = createMillisSpinBox(region.crossfadeMillis, tr("None"));
+    m_crossfadeSpinBox->setMaximum(10000);
+
+    QStringList cues;
+    for (ma_uint64 cue : region.cueMillis) {
+        cues << QString::number(cue);
+    }
+    m_cuesLineEdit = new QLineEdit(cues.join(", "), this);
+    m_cuesLineEdit->setPlaceholderText(tr("e.g. 1500, 4200"));
+    m_cuesLineEdit->setToolTip(tr("Cue marker positions in milliseconds, separated by commas."));
+
+    // Темп в процентах от исходного, тон — в полутонах; высота и длительность меняются независимо
+    m_tempoSpinBox = new QSpinBox(this);
+    m_tempoSpinBox->setRange(static_cast<int>(TimeStretcher::kMinTempo * 100), static_cast<int>(TimeStretcher::kMaxTempo * 100));
+    m_tempoSpinBox->setSingleStep(5);
+    m_tempoSpinBox->setSuffix(tr(" %"));
+    m_tempoSpinBox->setValue(qRound(params.tempo * 100));
+
+    m_pitchSpinBox = new QDoubleSpinBox(this);
+    m_pitchSpinBox->setRange(-TimeStretcher::kMaxPitchSemitones, TimeStretcher::kMaxPitchSemitones);
+    m_pitchSpinBox->setDecimals(1);
+    m_pitchSpinBox->setSingleStep(0.5);
+    m_pitchSpinBox->setSuffix(tr(" st"));
+    m_pitchSpinBox->setValue(params.pitchSemitones);
+
+    // Как открытый и закрытый хай-хэт: запуск трека глушит треки той же группы на других банках
+    m_chokeGroupSpinBox = new QSpinBox(this);
+    m_chokeGroupSpinBox->setRange(0, 16);
+    m_chokeGroupSpinBox->setSpecialValueText(tr("None"));
+    m_chokeGroupSpinBox->setValue(params.chokeGroup);
+    m_chokeGroupSpinBox->setToolTip(tr("Starting this track cuts tracks of the same group playing on other banks."));
+
+    // Параметры петли имеют смысл только при включенной петле
+    for (QWidget *widget : {static_cast<QWidget*>(m_loopStartSpinBox), static_cast<QWidget*>(m_loopEndSpinBox),
+                            static_cast<QWidget*>(m_crossfadeSpinBox)}) {
+        widget->setEnabled(region.loop);
+        connect(m_loopCheckBox, &QCheckBox::toggled, widget, &QWidget::setEnabled);
+    }
+
+    QFormLayout *formLayout = new QFormLayout;
+    formLayout->addRow(tr("Start:"), m_startSpinBox);
+    formLayout->addRow(tr("End:"), m_endSpinBox);
+    formLayout->addRow(m_loopCheckBox);
+    formLayout->addRow(tr("Loop start:"), m_loopStartSpinBox);
+    formLayout->addRow(tr("Loop end:"), m_loopEndSpinBox);
+    formLayout->addRow(tr("Loop crossfade:"), m_crossfadeSpinBox);
+    formLayout->addRow(tr("Cue markers (ms):"), m_cuesLineEdit);
+    formLayout->addRow(tr("Tempo:"), m_tempoSpinBox);
+    formLayout->addRow(tr("Pitch:"), m_pitchSpinBox);
+    formLayout->addRow(tr("Choke group:"), m_chokeGroupSpinBox);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(formLayout);
+    layout->addWidget(buttonBox);
+}
+
+AudioEngine::PlaybackRegion TrimDialog::getRegion() const
+{
+    AudioEngine::PlaybackRegion region;
+    region.startMillis = m_startSpinBox->value();
+    region.endMillis = m_endSpinBox->value();
+    region.loop = m_loopCheckBox->isChecked();
+    if (region.loop) {
+        region.loopStartMillis = m_loopStartSpinBox->value();
+        region.loopEndMillis = m_loopEndSpinBox->value();
+        region.crossfadeMillis = m_crossfadeSpinBox->value();
+    }
+
+    for (const QString &cue : m_cuesLineEdit->text().split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const ma_uint64 cueMillis = cue.trimmed().toULongLong(&ok);
+        if (ok) {
+            region.cueMillis.append(cueMillis);
+        }
+    }
+    return region;
+}
+
+AudioEngine::VoiceParams TrimDialog::getParams() const
+{
+    AudioEngine::VoiceParams params = m_params;
+    params.tempo = m_tempoSpinBox->value() / 100.0f;
+    params.pitchSemitones = static_cast<float>(m_pitchSpinBox->value());
+    params.chokeGroup = m_chokeGroupSpinBox->value();
+    return params;
+}
+
+QSpinBox* TrimDialog::createMillisSpinBox(ma_uint64 value, const QString &specialText)
+{
+    QSpinBox *spinBox = new QSpinBox(this);
+    spinBox->setRange(0, 24 * 60 * 60 * 1000);
+    spinBox->setSingleStep(10);
+    spinBox->setSuffix(tr(" ms"));
+    spinBox->setSpecialValueText(specialText);
+    spinBox->setValue(static_cast<int>(value));
+    return spinBox;
+}
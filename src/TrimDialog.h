@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QDialog>
+#include "AudioEngine.h"
+
+class QSpinBox;
+class QCheckBox;
+class QLineEdit;
+class QDoubleSpinBox;
+
+// Редактор воспроизведения трека: обрезка, петля, склейка, метки, темп и тон
+class TrimDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    TrimDialog(const AudioEngine::PlaybackRegion& region, const AudioEngine::VoiceParams& params,
+               QWidget *parent = nullptr);
+    AudioEngine::PlaybackRegion getRegion() const;
+    AudioEngine::VoiceParams getParams() const;
+
+private:
+    QSpinBox* createMillisSpinBox(ma_uint64 value, const QString& specialText);
+
+    AudioEngine::VoiceParams m_params; // Эффекты трека редактируются в другом диалоге и сохраняются как есть
+
+    QSpinBox *m_startSpinBox;
+    QSpinBox *m_endSpinBox;
+    QCheckBox *m_loopCheckBox;
+    QSpinBox *m_loopStartSpinBox;
+    QSpinBox *m_loopEndSpinBox;
+    QSpinBox *m_crossfadeSpinBox;
+    QLineEdit *m_cuesLineEdit;
+    QSpinBox *m_tempoSpinBox;
+    QDoubleSpinBox *m_pitchSpinBox;
+    QSpinBox *m_chokeGroupSpinBox;
+};
@@ -0,0 +1,251 @@
+// src/UsageStore.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "UsageStore.h"
+#include "Log.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const quint32 kFileMagic = 0x4F534455; // "OSDU"
+const quint16 kFileVersion = 1;
+const qint64 kMillisPerDay = 24LL * 60 * 60 * 1000;
+
+// Верхние границы частей сессии в минутах; последняя часть открыта
+const qint64 kPhaseEndMinutes[UsageStore::kPhaseCount - 1] = {10, 30, 60, 120};
+
+} // namespace
+
+UsageStore::UsageStore()
+    : m_isDirty(false)
+{
+    m_session.start();
+}
+
+bool UsageStore::load(const QString& filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (filePath == m_filePath) {
+            return true; // Тот же файл: статистика сессии уже в памяти
+        }
+    }
+    save();
+    if (filePath.isEmpty()) {
+        // Запоминание выключено: собранное за сессию остается, но больше не пишется
+        QMutexLocker locker(&m_mutex);
+        m_filePath.clear();
+        return true;
+    }
+
+    QHash<QString, Record> records;
+    QFile file(filePath);
+    bool isLoaded = !file.exists();
+    if (!isLoaded && file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+        quint32 magic = 0;
+        quint16 version = 0;
+        quint32 count = 0;
+        stream >> magic >> version >> count;
+        if (magic == kFileMagic && version == kFileVersion) {
+            records.reserve(static_cast<qsizetype>(std::min<quint32>(count, kMaxRecords)));
+            for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                QString path;
+                Record record;
+                stream >> path >> record.triggers >> record.lastTriggerMs >> record.weight >> record.weightTimeMs;
+                for (quint32& phaseTriggers : record.phaseTriggers) {
+                    stream >> phaseTriggers;
+                }
+                records.insert(path, record);
+            }
+            isLoaded = stream.status() == QDataStream::Ok;
+        }
+    }
+    if (!isLoaded) {
+        // Битый или чужой файл не мешает работе: статистика начнется заново
+        OSD_LOG_WARNING(Engine, "Failed to read usage file path=\"%s\"", qUtf8Printable(filePath));
+        records.clear();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_records = records;
+    m_filePath = filePath;
+    m_isDirty = false;
+    OSD_LOG_INFO(Engine, "Usage statistics loaded tracks=%d path=\"%s\"", static_cast<int>(m_records.size()),
+                 qUtf8Printable(filePath));
+    return isLoaded;
+}
+
+bool UsageStore::save()
+{
+    QMutexLocker saveLocker(&m_saveMutex);
+    QHash<QString, Record> records;
+    QString filePath;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_isDirty || m_filePath.isEmpty()) {
+            return true;
+        }
+        records = m_records; // Неявно разделяемая копия: дальше главный поток правит свою
+        filePath = m_filePath;
+        m_isDirty = false;
+    }
+
+    // Сверх лимита в файл идут только самые горячие треки
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    std::vector<std::pair<double, QHash<QString, Record>::const_iterator>> order;
+    order.reserve(static_cast<size_t>(records.size()));
+    for (auto it = records.cbegin(); it != records.cend(); ++it) {
+        order.emplace_back(decayedWeight(it.value(), nowMs), it);
+    }
+    if (order.size() > static_cast<size_t>(kMaxRecords)) {
+        std::nth_element(order.begin(), order.begin() + kMaxRecords, order.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        order.resize(kMaxRecords);
+    }
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (file.open(QIODevice::WriteOnly)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << kFileMagic << kFileVersion << static_cast<quint32>(order.size());
+        for (const auto& entry : order) {
+            const Record& record = entry.second.value();
+            stream << entry.second.key() << record.triggers << record.lastTriggerMs << record.weight << record.weightTimeMs;
+            for (quint32 phaseTriggers : record.phaseTriggers) {
+                stream << phaseTriggers;
+            }
+        }
+        if (stream.status() == QDataStream::Ok && file.commit()) {
+            OSD_LOG_DEBUG(Engine, "Usage statistics saved tracks=%zu", order.size());
+            return true;
+        }
+    }
+
+    OSD_LOG_WARNING(Engine, "Failed to write usage file path=\"%s\"", qUtf8Printable(filePath));
+    QMutexLocker locker(&m_mutex);
+    m_isDirty = true; // Повторим со следующей пачкой
+    return false;
+}
+
+bool UsageStore::isDirty() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isDirty;
+}
+
+void UsageStore::recordTrigger(const QString& filePath)
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const int phase = currentPhase();
+
+    QMutexLocker locker(&m_mutex);
+    Record& record = m_records[filePath];
+    record.weight = decayedWeight(record, nowMs) + 1.0;
+    record.weightTimeMs = nowMs;
+    record.lastTriggerMs = nowMs;
+    ++record.triggers;
+    ++record.phaseTriggers[phase];
+    m_isDirty = true;
+}
+
+double UsageStore::score(const QString& filePath) const
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const int phase = currentPhase();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_records.constFind(filePath);
+    return it != m_records.cend() ? scoreLocked(it.value(), nowMs, phase) : 0.0;
+}
+
+UsageStore::Record UsageStore::record(const QString& filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_records.value(filePath);
+}
+
+QStringList UsageStore::ranked(int count) const
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const int phase = currentPhase();
+
+    std::vector<std::pair<double, QString>> order;
+    {
+        QMutexLocker locker(&m_mutex);
+        order.reserve(static_cast<size_t>(m_records.size()));
+        for (auto it = m_records.cbegin(); it != m_records.cend(); ++it) {
+            order.emplace_back(scoreLocked(it.value(), nowMs, phase), it.key());
+        }
+    }
+    const size_t resultSize = std::min(order.size(), static_cast<size_t>(std::max(count, 0)));
+    std::partial_sort(order.begin(), order.begin() + resultSize, order.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    QStringList filePaths;
+    filePaths.reserve(static_cast<qsizetype>(resultSize));
+    for (size_t i = 0; i < resultSize; ++i) {
+        filePaths.append(order[i].second);
+    }
+    return filePaths;
+}
+
+int UsageStore::recordCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_records.size());
+}
+
+int UsageStore::currentPhase() const
+{
+    const qint64 minutes = m_session.elapsed() / (60 * 1000);
+    int phase = 0;
+    while (phase < kPhaseCount - 1 && minutes >= kPhaseEndMinutes[phase]) {
+        ++phase;
+    }
+    return phase;
+}
+
+double UsageStore::scoreLocked(const Record& record, qint64 nowMs, int phase) const
+{
+    if (record.triggers == 0) {
+        return 0.0;
+    }
+    // Доля запусков в этой части сессии дает множитель от 0.5 до 1.5
+    const double phaseShare = static_cast<double>(record.phaseTriggers[phase]) / record.triggers;
+    return decayedWeight(record, nowMs) * (0.5 + phaseShare);
+}
+
+double UsageStore::decayedWeight(const Record& record, qint64 nowMs)
+{
+    const double days = static_cast<double>(std::max<qint64>(nowMs - record.weightTimeMs, 0)) / kMillisPerDay;
+    return record.weight * std::exp2(-days / kHalfLifeDays);
+}
@@ -0,0 +1,82 @@
+// src/UsageStore.h
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+// Статистика запусков треков между сессиями: сколько раз, когда последний раз и в какой
+// части сессии (минуты от запуска программы). По ней движок решает, какие клипы держать
+// в памяти, а окно — какие декодеры открывать заранее.
+//
+// recordTrigger() только правит запись в хэше; файл переписывается целиком в save(),
+// которую владелец вызывает пачкой (раз в минуту из пула потоков и при выходе).
+// Все методы потокобезопасны.
+class UsageStore
+{
+public:
+    static constexpr int kPhaseCount = 5;       // 0-10, 10-30, 30-60, 60-120 и больше 120 минут сессии
+    static constexpr double kHalfLifeDays = 14; // Вес запуска падает вдвое за две недели
+    static constexpr int kMaxRecords = 4096;    // Сверх этого при записи отбрасываются самые холодные
+
+    struct Record {
+        quint32 triggers = 0;
+        qint64 lastTriggerMs = 0;  // Мс от эпохи UTC
+        double weight = 0.0;       // Запуски с затуханием, приведенные к weightTimeMs
+        qint64 weightTimeMs = 0;
+        quint32 phaseTriggers[kPhaseCount] = {};
+    };
+
+    UsageStore();
+    UsageStore(const UsageStore&) = delete;
+    UsageStore& operator=(const UsageStore&) = delete;
+
+    // Пустой путь — статистика только на эту сессию. Прежний файл перед сменой сохраняется,
+    // повторный вызов с тем же путем ничего не делает
+    bool load(const QString& filePath);
+    bool save(); // Блокирующая запись, только если были изменения
+    bool isDirty() const;
+
+    void recordTrigger(const QString& filePath);
+
+    // Вес запусков на сейчас с поправкой на часть сессии: трек, который обычно звучит
+    // в начале эфира, в начале и поднимается выше. 0 — трек не запускали
+    double score(const QString& filePath) const;
+    Record record(const QString& filePath) const;
+    QStringList ranked(int count) const; // По убыванию score()
+    int recordCount() const;
+
+private:
+    int currentPhase() const;
+    double scoreLocked(const Record& record, qint64 nowMs, int phase) const;
+    static double decayedWeight(const Record& record, qint64 nowMs);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Record> m_records;
+    QString m_filePath;
+    bool m_isDirty;
+    QElapsedTimer m_session;
+
+    QMutex m_saveMutex; // Запись из пула и последняя запись при выходе не пересекаются
+};
@@ -19,30 +19,36 @@
  */
 
 #include "MainWindow.h"
+#include "StartupTrace.h"
+#include "Log.h"
 
 #include <QApplication>
 #include <QLoggingCategory>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::begin();
+
     // --- НАСТРОЙКА ЛОГИРОВАНИЯ ---
 
-    // Устанавливаем правило:
-    // 1. "*.debug=false" - ВЫКЛЮЧАЕМ все отладочные сообщения по умолчанию.
-    // 2. "\n" - разделитель правил.
-    // 3. "default.debug=true" - ВКЛЮЧАЕМ отладочные сообщения только
-    //    для дефолтной категории, которую использует qDebug().
+    // Отладочные сообщения модулей Qt выключены, наши категории фильтрует Log
+    // (переменная окружения OPENSOUNDDECK_LOG). Вывод идет из отдельного потока,
+    // поэтому запись в журнал не задерживает интерфейс.
     QLoggingCategory::setFilterRules("*.debug=false\ndefault.debug=true");
-
-    // Формат вывода оставляем прежним, он удобен.
-    qSetMessagePattern("%{type}: %{message}");
+    Log::Session logSession;
 
     // --- КОНЕЦ НАСТРОЙКИ ---
 
     QApplication app(argc, argv);
+    StartupTrace::mark("QApplication created");
 
     MainWindow window;
+    StartupTrace::mark("main window constructed");
     window.show();
+    StartupTrace::mark("window shown");
+    // Первая итерация цикла событий — окно отрисовано и принимает ввод
+    QTimer::singleShot(0, []() { StartupTrace::mark("event loop running"); });
 
     return app.exec();
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+// src/opensounddeckd.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Движок без окна: играет треки плейлиста по командам из локального сокета.
+// Настройки звука берутся те же, что у приложения (вкладка Audio).
+
+#include "AudioEngine.h"
+#include "ControlServer.h"
+#include "EngineSettings.h"
+#include "Log.h"
+#include "MidiInput.h"
+#include "OfflineRenderer.h"
+#include "Playlist.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QLoggingCategory>
+
+namespace {
+
+// Офлайн-рендер: настройки устройства и мастер-шины приложения не участвуют,
+// все нужное для повторяемого результата записано в самом сценарии
+int renderTimeline(const QString& timelinePath, QString outputPath, const QString& sampleFormat)
+{
+    if (sampleFormat != "f32" && sampleFormat != "s16") {
+        OSD_LOG_ERROR(General, "Unknown sample format format=%s", qUtf8Printable(sampleFormat));
+        return 1;
+    }
+    if (outputPath.isEmpty()) {
+        const QFileInfo timelineInfo(timelinePath);
+        outputPath = timelineInfo.dir().filePath(timelineInfo.completeBaseName() + ".wav");
+    }
+
+    OfflineRenderer renderer;
+    if (!renderer.loadTimeline(timelinePath)) {
+        OSD_LOG_ERROR(General, "Timeline error path=\"%s\": %s", qUtf8Printable(timelinePath),
+                      qUtf8Printable(renderer.errorString()));
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool isOk = renderer.render(outputPath, sampleFormat == "s16" ? OfflineRenderer::Int16 : OfflineRenderer::Float32);
+    const double renderedSeconds = static_cast<double>(renderer.renderedFrames()) / AudioEngine::kEngineSampleRate;
+    if (!isOk) {
+        OSD_LOG_ERROR(General, "Render failed path=\"%s\": %s", qUtf8Printable(outputPath),
+                      qUtf8Printable(renderer.errorString()));
+        return 1;
+    }
+    OSD_LOG_INFO(General, "Rendered path=\"%s\" seconds=%.3f elapsed_ms=%lld", qUtf8Printable(outputPath),
+                 renderedSeconds, static_cast<long long>(timer.elapsed()));
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QLoggingCategory::setFilterRules("*.debug=false\ndefault.debug=true");
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("opensounddeckd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("OpenSoundDeck headless engine controlled over a local socket.");
+    parser.addHelpOption();
+    QCommandLineOption socketOption("socket", "Control socket path.", "path", ControlServer::defaultSocketPath());
+    QCommandLineOption playlistOption("playlist", "Playlist (.osdpl) with the tracks to serve.", "file");
+    QCommandLineOption quietOption("quiet", "Log warnings only.");
+    QCommandLineOption logFileOption("log-file", "Also append the log to this file.", "file");
+    parser.addOption(socketOption);
+    parser.addOption(playlistOption);
+    parser.addOption(quietOption);
+    QCommandLineOption renderOption("render", "Render a timeline (.osdtl) to a WAV file without a device and exit.", "timeline");
+    QCommandLineOption outputOption("output", "WAV file for --render (default: next to the timeline).", "file");
+    QCommandLineOption sampleFormatOption("sample-format", "Sample format for --render: f32 or s16.", "format", "f32");
+    parser.addOption(logFileOption);
+    parser.addOption(renderOption);
+    parser.addOption(outputOption);
+    parser.addOption(sampleFormatOption);
+    parser.process(app);
+
+    if (parser.isSet(quietOption)) {
+        Log::setLevel(Log::Warning);
+    }
+    // Переменная окружения OPENSOUNDDECK_LOG уточняет уровни поверх --quiet
+    Log::Session logSession(parser.value(logFileOption));
+
+    if (parser.isSet(renderOption)) {
+        return renderTimeline(parser.value(renderOption), parser.value(outputOption), parser.value(sampleFormatOption));
+    }
+
+    // Настройки до init(): контекст сразу открывается с выбранным бэкендом, а не дважды
+    AudioEngine engine;
+    EngineSettings::apply(&engine);
+    if (!engine.init()) {
+        OSD_LOG_ERROR(General, "Failed to initialize the audio engine");
+        return 1;
+    }
+
+    QList<PlaylistEntry> tracks;
+    if (parser.isSet(playlistOption) && !Playlist::load(parser.value(playlistOption), &tracks)) {
+        OSD_LOG_ERROR(General, "Could not open playlist path=\"%s\"", qUtf8Printable(parser.value(playlistOption)));
+        return 1;
+    }
+    // Клипы из памяти стартуют без открытия файла — это самый короткий путь до первого семпла
+    for (const PlaylistEntry& track : tracks) {
+        engine.preloadSound(track.filePath);
+    }
+
+    ControlServer server(&engine);
+    server.setTracks(tracks);
+    if (!server.listen(parser.value(socketOption))) {
+        return 1;
+    }
+    OSD_LOG_INFO(Control, "Serving tracks=%d", static_cast<int>(tracks.size()));
+
+    MidiInput midiInput(&engine);
+    midiInput.setTracks(tracks);
+    QObject::connect(&midiInput, &MidiInput::trackTriggered, &server, &ControlServer::onTrackTriggered);
+    EngineSettings::applyMidi(&midiInput);
+
+    return app.exec();
+}
@@ -0,0 +1,126 @@
+// tests/ControlServerTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Протокол сокета управления: сервер и клиент в одном потоке, движок в офлайн-режиме.
+
+#include "AudioEngine.h"
+#include "ControlServer.h"
+#include "Playlist.h"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QLocalSocket>
+#include <QTemporaryDir>
+#include <QtTest>
+
+namespace {
+
+QString fixture(const char* name)
+{
+    return QString(OPENSOUNDDECK_TEST_DIR "/fixtures/") + name;
+}
+
+} // namespace
+
+class ControlServerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void overlongLineIsRejectedWhole();
+    void triggerAnswersTrackNumber();
+    void triggerAnswersPath();
+
+private:
+    QList<QByteArray> exchange(const QByteArray& request, int responseCount);
+
+    QTemporaryDir m_directory;
+    AudioEngine m_engine;
+    ControlServer* m_pServer = nullptr;
+};
+
+void ControlServerTest::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+    m_engine.initOffline();
+    m_pServer = new ControlServer(&m_engine, this);
+    QVERIFY(m_pServer->listen(m_directory.filePath("control.sock")));
+
+    PlaylistEntry entry;
+    entry.filePath = fixture("sine440_48k_f32.wav");
+    entry.bank = 1;
+    m_pServer->setTracks({entry});
+}
+
+// Сервер отвечает из того же цикла событий, поэтому клиент ждет ответов, прокручивая его
+QList<QByteArray> ControlServerTest::exchange(const QByteArray& request, int responseCount)
+{
+    QLocalSocket socket;
+    socket.connectToServer(m_pServer->socketPath());
+    if (!socket.waitForConnected(1000)) {
+        return {};
+    }
+    socket.write(request);
+    socket.flush();
+
+    QList<QByteArray> responses;
+    const QDeadlineTimer deadline(5000);
+    while (responses.size() < responseCount && !deadline.hasExpired()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        socket.waitForReadyRead(10);
+        while (socket.canReadLine()) {
+            responses.append(socket.readLine().trimmed());
+        }
+    }
+    return responses;
+}
+
+void ControlServerTest::overlongLineIsRejectedWhole()
+{
+    // Строка длиннее 4096 байт с переводом строки — одна ошибка, а не две команды из ее кусков
+    const QByteArray request = "PING " + QByteArray(5000, 'x') + "\nPING\n";
+    const QList<QByteArray> responses = exchange(request, 2);
+    QCOMPARE(responses.size(), 2);
+    QCOMPARE(responses[0], QByteArray("ERR line too long"));
+    QCOMPARE(responses[1], QByteArray("OK"));
+}
+
+void ControlServerTest::triggerAnswersTrackNumber()
+{
+    const QList<QByteArray> responses = exchange("TRIGGER 1 0.5\n", 1);
+    QCOMPARE(responses.size(), 1);
+    QCOMPARE(responses[0], QByteArray("OK 1"));
+    QCOMPARE(m_engine.getPlaybackState(1), AudioEngine::Playing); // Дека банка трека
+    m_engine.stopAllSounds();
+}
+
+void ControlServerTest::triggerAnswersPath()
+{
+    const QByteArray path = fixture("ramp_48k.wav").toUtf8();
+    const QList<QByteArray> responses = exchange("TRIGGER \"" + path + "\"\n", 1);
+    QCOMPARE(responses.size(), 1);
+    QCOMPARE(responses[0], "OK " + path);
+    QCOMPARE(m_engine.getPlaybackState(0), AudioEngine::Playing);
+    m_engine.stopAllSounds();
+}
+
+QTEST_GUILESS_MAIN(ControlServerTest)
+#include "ControlServerTest.moc"
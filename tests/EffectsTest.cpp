@@ -0,0 +1,97 @@
+// tests/EffectsTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Узлы эффектов без движка. Шумоподавление с подавлением 0 дБ (усиление всех полос 1)
+// должно вернуть вход, задержанный ровно на kLatencyFrames: окна анализа и синтеза
+// складываются в единицу, а задержка не зависит от того, как нарезан буфер.
+
+#include "Effects.h"
+
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace {
+
+constexpr float kSampleRate = 48000.0f;
+constexpr size_t kChannels = EffectNode::kChannels;
+
+// Тон и псевдослучайный шум, в каналах разные: полосы заняты по всему спектру
+std::vector<float> makeInput(size_t frameCount)
+{
+    std::vector<float> frames(frameCount * kChannels);
+    uint32_t seed = 1;
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        for (size_t channel = 0; channel < kChannels; ++channel) {
+            seed = seed * 1664525u + 1013904223u;
+            const float noise = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24) - 0.5f;
+            const float tone = std::sin(2.0f * std::numbers::pi_v<float> * (440.0f + 250.0f * channel) * frame / kSampleRate);
+            frames[frame * kChannels + channel] = 0.5f * tone + 0.2f * noise;
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+class EffectsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void suppressorAtUnityGainIsDelay_data();
+    void suppressorAtUnityGainIsDelay();
+};
+
+void EffectsTest::suppressorAtUnityGainIsDelay_data()
+{
+    QTest::addColumn<int>("chunkFrames");
+    QTest::newRow("one frame") << 1;
+    QTest::newRow("odd chunks") << 37;
+    QTest::newRow("block") << int(EffectNode::kBlockFrames);
+}
+
+void EffectsTest::suppressorAtUnityGainIsDelay()
+{
+    QFETCH(int, chunkFrames);
+    constexpr size_t kFrameCount = 48000;
+    constexpr size_t kLatency = NoiseSuppressor::kLatencyFrames;
+
+    const std::vector<float> input = makeInput(kFrameCount);
+    std::vector<float> output = input;
+    NoiseSuppressor suppressor(kSampleRate, 0.0f);
+    for (size_t offset = 0; offset < kFrameCount; offset += static_cast<size_t>(chunkFrames)) {
+        const size_t count = std::min(static_cast<size_t>(chunkFrames), kFrameCount - offset);
+        suppressor.process(output.data() + offset * kChannels, count);
+    }
+
+    // До задержки — тишина, дальше вход. Точность — погрешность БПФ в float, далеко ниже 16-битного шага
+    float maxError = 0.0f;
+    for (size_t i = 0; i < output.size(); ++i) {
+        const float expected = i < kLatency * kChannels ? 0.0f : input[i - kLatency * kChannels];
+        maxError = std::max(maxError, std::abs(output[i] - expected));
+    }
+    QVERIFY2(maxError < 1.0e-5f, qPrintable(QString("max error %1").arg(maxError)));
+}
+
+QTEST_GUILESS_MAIN(EffectsTest)
+#include "EffectsTest.moc"
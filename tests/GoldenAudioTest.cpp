@@ -0,0 +1,543 @@
+// tests/GoldenAudioTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Эталонные тесты микшера и декодеров: фикстуры из tests/fixtures играют через офлайн-режим
+// движка (тот же mixBlock, что у колбэка). Где результат известен точно — рампа, номер кадра
+// в каждом семпле, громкость степенями двойки — сравнение побитовое; ресемплинг и склейка
+// проверяются по спектру и гладкости; сведение по tests/golden/mix.osdtl воспроизводимо
+// (сравнение с эталоном mix.wav — в GoldenMixTest).
+
+#include "AudioEngine.h"
+#include "OfflineRenderer.h"
+#include "SampleStore.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 kChannels = AudioEngine::kEngineChannels;
+constexpr ma_uint32 kSampleRate = AudioEngine::kEngineSampleRate;
+
+QString fixture(const char* name)
+{
+    return QString(OPENSOUNDDECK_TEST_DIR "/fixtures/") + name;
+}
+
+QString golden(const char* name)
+{
+    return QString(OPENSOUNDDECK_TEST_DIR "/golden/") + name;
+}
+
+// Рендер блоками того же размера, что у OfflineRenderer
+std::vector<float> render(AudioEngine* engine, ma_uint32 frameCount)
+{
+    std::vector<float> frames(static_cast<size_t>(frameCount) * kChannels);
+    for (ma_uint32 offset = 0; offset < frameCount; offset += OfflineRenderer::kBlockFrames) {
+        const ma_uint32 count = std::min(OfflineRenderer::kBlockFrames, frameCount - offset);
+        engine->renderOffline(frames.data() + static_cast<size_t>(offset) * kChannels, count);
+    }
+    return frames;
+}
+
+// Рампа хранит в семпле номер кадра исходника (см. generate_fixtures.py)
+int rampFrameAt(const std::vector<float>& frames, size_t frame, ma_uint32 channel = 0)
+{
+    return static_cast<int>(frames[frame * kChannels + channel] * 32768.0f);
+}
+
+int rampValue(ma_uint64 sourceFrame)
+{
+    return static_cast<int>(sourceFrame % 32768);
+}
+
+std::vector<float> decodeFile(const QString& filePath)
+{
+    std::vector<float> frames;
+    ma_decoder decoder;
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, kChannels, kSampleRate);
+    if (ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder) != MA_SUCCESS) {
+        return frames;
+    }
+    float buffer[1024 * kChannels];
+    ma_uint64 framesRead = 0;
+    while (ma_decoder_read_pcm_frames(&decoder, buffer, 1024, &framesRead) == MA_SUCCESS && framesRead > 0) {
+        frames.insert(frames.end(), buffer, buffer + framesRead * kChannels);
+    }
+    ma_decoder_uninit(&decoder);
+    return frames;
+}
+
+std::vector<float> scaled(std::vector<float> frames, float factor)
+{
+    for (float& sample : frames) {
+        sample *= factor;
+    }
+    return frames;
+}
+
+float maxStep(const std::vector<float>& frames)
+{
+    float step = 0.0f;
+    for (size_t i = kChannels; i < frames.size(); i += kChannels) {
+        step = std::max(step, std::abs(frames[i] - frames[i - kChannels]));
+    }
+    return step;
+}
+
+} // namespace
+
+class GoldenAudioTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decodersAgree();
+    void residentClipIsUnityGain();
+    void seekIsSampleAccurate();
+    void loopSeamIsSampleAccurate();
+    void loopCrossfadeHasNoStep();
+    void primedStartMatchesColdStart_data();
+    void primedStartMatchesColdStart();
+    void retriggerReplacesVoice();
+    void chokeGroupStealsVoice();
+    void queueHandoverIsGapless();
+    void queueCrossfadeBlendsTailAndHead();
+    void resamplingPreservesTone();
+    void volumePathIsExact();
+    void parallelMixIsBitIdentical();
+    void timelineIsReproducible();
+    void sixteenEnginesOfFourDecksFitBudget();
+};
+
+void GoldenAudioTest::decodersAgree()
+{
+    // Одна и та же рампа в WAV и FLAC: оба декодера без потерь, результат должен совпасть побитово
+    const std::vector<float> wav = decodeFile(fixture("ramp_48k.wav"));
+    const std::vector<float> flac = decodeFile(fixture("ramp_48k.flac"));
+    QCOMPARE(wav.size(), static_cast<size_t>(48000 * kChannels));
+    QVERIFY(wav == flac);
+    for (size_t frame = 0; frame < 48000; frame += 997) {
+        QCOMPARE(rampFrameAt(wav, frame), rampValue(frame));
+        QCOMPARE(rampFrameAt(wav, frame, 1), rampValue(frame)); // Моно раскладывается на оба канала
+    }
+}
+
+void GoldenAudioTest::residentClipIsUnityGain()
+{
+    // Первый семпл блока ADPCM хранится точно: у рампы он должен вернуться тем же числом,
+    // иначе клип в памяти тише потокового чтения
+    ma_decoder decoder;
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, kChannels, kSampleRate);
+    QCOMPARE(ma_decoder_init_file(fixture("ramp_48k.wav").toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    const std::shared_ptr<CompressedClip> clip = CompressedClip::fromDecoder(&decoder);
+    ma_decoder_uninit(&decoder);
+    QVERIFY(clip != nullptr);
+    QCOMPARE(clip->frameCount(), static_cast<ma_uint64>(48000));
+
+    std::vector<float> block(CompressedClip::kBlockFrames * kChannels);
+    for (ma_uint64 blockIndex = 0; blockIndex < clip->blockCount(); ++blockIndex) {
+        clip->decodeBlock(blockIndex, block.data());
+        QCOMPARE(rampFrameAt(block, 0), rampValue(blockIndex * CompressedClip::kBlockFrames));
+        QCOMPARE(rampFrameAt(block, 0, 1), rampValue(blockIndex * CompressedClip::kBlockFrames));
+    }
+}
+
+void GoldenAudioTest::seekIsSampleAccurate()
+{
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("ramp_48k.wav"));
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Playing);
+
+    const std::vector<float> head = render(&engine, 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        QCOMPARE(rampFrameAt(head, i), rampValue(i));
+    }
+
+    // Перемотка срабатывает на границе следующего блока и ставит голос ровно на кадр
+    for (ma_uint64 millis : {500, 123, 0, 999}) {
+        engine.seek(millis);
+        const std::vector<float> frames = render(&engine, 40);
+        const ma_uint64 target = millis * kSampleRate / 1000;
+        for (size_t i = 0; i < 40; ++i) {
+            QCOMPARE(rampFrameAt(frames, i), rampValue(target + i));
+        }
+    }
+}
+
+void GoldenAudioTest::loopSeamIsSampleAccurate()
+{
+    AudioEngine engine;
+    engine.initOffline();
+    AudioEngine::PlaybackRegion region;
+    region.loop = true;
+    region.loopStartMillis = 100;
+    region.loopEndMillis = 200;
+    engine.playSound(fixture("ramp_48k.flac"), region);
+
+    // 0..9599, затем 4800..9599 по кругу: ни пропущенного, ни повторенного кадра на стыке
+    const std::vector<float> frames = render(&engine, 48000);
+    for (ma_uint64 i = 0; i < 48000; ++i) {
+        const ma_uint64 sourceFrame = i < 9600 ? i : 4800 + (i - 9600) % 4800;
+        QCOMPARE(rampFrameAt(frames, i), rampValue(sourceFrame));
+    }
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Playing);
+}
+
+void GoldenAudioTest::loopCrossfadeHasNoStep()
+{
+    // Петля 4320 кадров — не целое число периодов 440 Гц: без склейки на стыке скачок
+    AudioEngine::PlaybackRegion region;
+    region.loop = true;
+    region.loopStartMillis = 100;
+    region.loopEndMillis = 190;
+
+    AudioEngine hardEngine;
+    hardEngine.initOffline();
+    hardEngine.playSound(fixture("sine440_48k_f32.wav"), region);
+    QVERIFY(maxStep(render(&hardEngine, 24000)) > 0.2f);
+
+    // Естественный шаг синуса 0.5 * 2π * 440 / 48000 ≈ 0.029; склейка должна оставаться рядом с ним
+    region.crossfadeMillis = 10;
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("sine440_48k_f32.wav"), region);
+    const float step = maxStep(render(&engine, 24000));
+    QVERIFY2(step < 0.04f, qPrintable(QString("max step %1").arg(step)));
+}
+
+void GoldenAudioTest::primedStartMatchesColdStart_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<qulonglong>("startMillis");
+    QTest::newRow("wav") << "ramp_48k.wav" << qulonglong(0);
+    QTest::newRow("flac from region start") << "ramp_48k.flac" << qulonglong(100);
+}
+
+void GoldenAudioTest::primedStartMatchesColdStart()
+{
+    // Голос с заранее декодированного начала: голова, переход на декодер после нее и перемотки
+    // внутрь головы и за нее — кадр в кадр как у голоса, открытого при запуске
+    QFETCH(QString, fileName);
+    QFETCH(qulonglong, startMillis);
+    AudioEngine::PlaybackRegion region;
+    region.startMillis = startMillis;
+
+    auto playAndRender = [&](AudioEngine* engine) {
+        engine->playSound(fixture(fileName.toUtf8().constData()), region);
+        std::vector<float> frames = render(engine, kSampleRate / 2);
+        for (ma_uint64 millis : {startMillis + 50, startMillis + 400, startMillis}) {
+            engine->seek(millis);
+            const std::vector<float> tail = render(engine, kSampleRate / 4);
+            frames.insert(frames.end(), tail.begin(), tail.end());
+        }
+        return frames;
+    };
+
+    AudioEngine primedEngine;
+    primedEngine.initOffline();
+    primedEngine.primeSounds({qMakePair(fixture(fileName.toUtf8().constData()), region)});
+    QTRY_COMPARE(primedEngine.primedSoundCount(), 1);
+    const std::vector<float> primed = playAndRender(&primedEngine);
+    QCOMPARE(primedEngine.primedSoundCount(), 0); // Запуск забрал готовый декодер
+
+    AudioEngine coldEngine;
+    coldEngine.initOffline();
+    const std::vector<float> cold = playAndRender(&coldEngine);
+
+    QCOMPARE(primed.size(), cold.size());
+    QCOMPARE(rampFrameAt(cold, 0), rampValue(startMillis * kSampleRate / 1000));
+    QVERIFY(primed == cold);
+}
+
+void GoldenAudioTest::retriggerReplacesVoice()
+{
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("ramp_48k.wav"));
+    render(&engine, 1000);
+
+    // Новый звук на той же деке заменяет прежний голос с первого же кадра, без подмешивания
+    AudioEngine::PlaybackRegion region;
+    region.startMillis = 500;
+    engine.playSound(fixture("ramp_48k.wav"), region);
+    const std::vector<float> frames = render(&engine, 1024);
+    for (size_t i = 0; i < 1024; ++i) {
+        QCOMPARE(rampFrameAt(frames, i), rampValue(24000 + i));
+    }
+}
+
+void GoldenAudioTest::chokeGroupStealsVoice()
+{
+    AudioEngine::VoiceParams params;
+    params.chokeGroup = 1;
+
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("ramp_48k.wav"), AudioEngine::PlaybackRegion(), params, 0, 0);
+    render(&engine, 1000);
+    engine.playSound(fixture("sine440_48k_f32.wav"), AudioEngine::PlaybackRegion(), params, 0, 1);
+
+    // Эталон — тот же синус на пустом движке
+    AudioEngine reference;
+    reference.initOffline();
+    reference.playSound(fixture("sine440_48k_f32.wav"), AudioEngine::PlaybackRegion(), params, 0, 1);
+
+    // Заглушенный голос затихает за один блок и снимается с деки; дальше звучит только новый
+    const std::vector<float> fadeBlock = render(&engine, OfflineRenderer::kBlockFrames);
+    const std::vector<float> referenceFadeBlock = render(&reference, OfflineRenderer::kBlockFrames);
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Stopped);
+    QCOMPARE(engine.getPlaybackState(1), AudioEngine::Playing);
+    const size_t last = (OfflineRenderer::kBlockFrames - 1) * kChannels;
+    QCOMPARE(fadeBlock[last], referenceFadeBlock[last]); // Последний кадр затухания — ноль
+
+    QVERIFY(render(&engine, 4096) == render(&reference, 4096));
+}
+
+void GoldenAudioTest::queueHandoverIsGapless()
+{
+    // 0..99 мс рампы, затем очередь с 500 мс: стык посреди блока, без паузы и без повтора кадра
+    AudioEngine::PlaybackRegion region;
+    region.endMillis = 100;
+    AudioEngine::PlaybackRegion queuedRegion;
+    queuedRegion.startMillis = 500;
+
+    AudioEngine engine;
+    engine.initOffline();
+    QSignalSpy advancedSpy(&engine, &AudioEngine::queueAdvanced);
+    engine.playSound(fixture("ramp_48k.wav"), region);
+    QVERIFY(engine.queueSound(fixture("ramp_48k.wav"), queuedRegion));
+
+    const std::vector<float> frames = render(&engine, 9600);
+    for (ma_uint64 i = 0; i < 9600; ++i) {
+        QCOMPARE(rampFrameAt(frames, i), rampValue(i < 4800 ? i : 24000 + i - 4800));
+    }
+    QCOMPARE(advancedSpy.count(), 1);
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Playing);
+}
+
+void GoldenAudioTest::queueCrossfadeBlendsTailAndHead()
+{
+    // Склейка 10 мс: очередь вступает за 480 кадров до конца текущего голоса, веса — косинус
+    // и его зеркало. До и после склейки звучит ровно один из голосов
+    AudioEngine::PlaybackRegion region;
+    region.endMillis = 100;
+    AudioEngine::PlaybackRegion queuedRegion;
+    queuedRegion.startMillis = 500;
+    constexpr ma_uint64 kFadeFrames = 480;
+    constexpr ma_uint64 kFadeStart = 4800 - kFadeFrames;
+
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("ramp_48k.wav"), region);
+    QVERIFY(engine.queueSound(fixture("ramp_48k.wav"), queuedRegion, AudioEngine::VoiceParams(), 0, 10));
+
+    const std::vector<float> frames = render(&engine, 9600);
+    for (ma_uint64 i = 0; i < 9600; ++i) {
+        if (i < kFadeStart) {
+            QCOMPARE(rampFrameAt(frames, i), rampValue(i));
+        } else if (i >= 4800) {
+            QCOMPARE(rampFrameAt(frames, i), rampValue(24000 + i - kFadeStart));
+        } else {
+            const ma_uint64 k = i - kFadeStart;
+            const double tailGain = std::cos((k + 0.5) / kFadeFrames * std::numbers::pi / 2.0);
+            const double headGain = std::cos((kFadeFrames - 1 - k + 0.5) / kFadeFrames * std::numbers::pi / 2.0);
+            const double expected = (rampValue(i) * tailGain + rampValue(24000 + k) * headGain) / 32768.0;
+            QVERIFY2(std::abs(frames[i * kChannels] - expected) < 1e-5,
+                     qPrintable(QString("frame %1: %2 != %3").arg(i).arg(frames[i * kChannels]).arg(expected)));
+        }
+    }
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Playing);
+}
+
+void GoldenAudioTest::resamplingPreservesTone()
+{
+    // 1 кГц, 44.1 кГц, -6 дБ: после ресемплинга в 48 кГц тон, амплитуда и длина сохраняются
+    AudioEngine engine;
+    engine.initOffline();
+    engine.playSound(fixture("sine1k_44k1.wav"));
+    const std::vector<float> frames = render(&engine, 24000);
+
+    // Первые 10 мс пропускаем (разгон фильтра ресемплера), анализируем 400 периодов
+    constexpr size_t kOffset = 480;
+    constexpr size_t kCount = 19200;
+    double energy = 0.0;
+    double cosine = 0.0;
+    double sine = 0.0;
+    for (size_t i = 0; i < kCount; ++i) {
+        const double x = frames[(kOffset + i) * kChannels];
+        const double phase = 2.0 * std::numbers::pi * 1000.0 * i / kSampleRate;
+        energy += x * x;
+        cosine += x * std::cos(phase);
+        sine += x * std::sin(phase);
+    }
+    const double toneEnergy = 2.0 * (cosine * cosine + sine * sine) / kCount;
+    const double amplitude = std::sqrt(2.0 * energy / kCount);
+    QVERIFY2(toneEnergy / energy > 0.999, qPrintable(QString("tone share %1").arg(toneEnergy / energy)));
+    QVERIFY2(std::abs(20.0 * std::log10(amplitude / 0.5)) < 0.1, qPrintable(QString("amplitude %1").arg(amplitude)));
+
+    // 22050 кадров исходника — ровно 24000 кадров на выходе; голос доигрывает в следующем блоке
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Playing);
+    render(&engine, OfflineRenderer::kBlockFrames);
+    QCOMPARE(engine.getPlaybackState(0), AudioEngine::Stopped);
+}
+
+void GoldenAudioTest::volumePathIsExact()
+{
+    AudioEngine reference;
+    reference.initOffline();
+    reference.playSound(fixture("sine440_48k_f32.wav"));
+
+    AudioEngine::VoiceParams params;
+    params.gain = 0.5f;
+    AudioEngine engine;
+    engine.initOffline();
+    engine.setDeckVolume(0, 0.5f);
+    engine.playSound(fixture("sine440_48k_f32.wav"), AudioEngine::PlaybackRegion(), params);
+
+    // Множители — степени двойки, поэтому сравнение точное: голос 0.5 * дека 0.5
+    QVERIFY(render(&engine, 4096) == scaled(render(&reference, 4096), 0.25f));
+
+    // Громкость голоса меняется на лету с границы блока; мониторинг умножается поверх
+    params.gain = AudioEngine::kMaxVoiceGain;
+    engine.setVoiceParams(params);
+    engine.setMonitoringVolume(0.5f);
+    QVERIFY(render(&engine, 4096) == scaled(render(&reference, 4096), 0.5f));
+}
+
+void GoldenAudioTest::parallelMixIsBitIdentical()
+{
+    // Четыре деки с растяжением, тоном и эквалайзером: офлайн-движок с включенным пулом рендерит
+    // каждый блок на рабочих потоках, и сумма должна совпасть с однопоточной до бита
+    if (std::thread::hardware_concurrency() < 2) {
+        QSKIP("Parallel mixing needs more than one core");
+    }
+    auto renderDecks = [](bool isParallel) {
+        AudioEngine engine;
+        engine.initOffline();
+        engine.setParallelMixingEnabled(isParallel);
+        AudioEngine::PlaybackRegion region;
+        region.loop = true;
+        for (int deck = 0; deck < AudioEngine::kDeckCount; ++deck) {
+            AudioEngine::VoiceParams params;
+            params.tempo = 1.0f + 0.1f * deck;
+            params.pitchSemitones = deck == 3 ? -5.0f : 0.0f;
+            params.gain = 0.5f + 0.25f * deck;
+            params.effects.eqEnabled = deck % 2 == 0;
+            params.effects.eqMidGainDb = 4.0f;
+            engine.playSound(fixture(deck % 2 == 0 ? "sine440_48k_f32.wav" : "sine1k_44k1.wav"), region, params, 0,
+                             deck);
+        }
+        return render(&engine, kSampleRate);
+    };
+
+    const std::vector<float> serial = renderDecks(false);
+    const std::vector<float> parallel = renderDecks(true);
+    QCOMPARE(parallel.size(), serial.size());
+    QVERIFY(std::any_of(serial.begin(), serial.end(), [](float sample) { return sample != 0.0f; }));
+    QVERIFY(std::memcmp(parallel.data(), serial.data(), serial.size() * sizeof(float)) == 0);
+}
+
+void GoldenAudioTest::timelineIsReproducible()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    OfflineRenderer renderer;
+    QVERIFY2(renderer.loadTimeline(golden("mix.osdtl")), qPrintable(renderer.errorString()));
+
+    const QString firstPath = directory.filePath("first.wav");
+    const QString secondPath = directory.filePath("second.wav");
+    QVERIFY2(renderer.render(firstPath), qPrintable(renderer.errorString()));
+    QCOMPARE(renderer.renderedFrames(), static_cast<ma_uint64>(57600));
+    QVERIFY2(renderer.render(secondPath), qPrintable(renderer.errorString()));
+
+    QFile first(firstPath);
+    QFile second(secondPath);
+    QVERIFY(first.open(QIODevice::ReadOnly) && second.open(QIODevice::ReadOnly));
+    QVERIFY(first.readAll() == second.readAll());
+}
+
+void GoldenAudioTest::sixteenEnginesOfFourDecksFitBudget()
+{
+    // Не худший случай одного движка (у него всего четыре деки), а нагрузка: шестнадцать движков
+    // по четыре деки сводятся за один период подряд на одном ядре. Каждая дека с эквалайзером,
+    // в каждом движке одна растянута. Ловит кратное замедление микшера, а не проценты.
+    constexpr int kEngines = 16;
+    constexpr ma_uint32 kPeriodFrames = 256;
+    constexpr int kPeriods = 400;
+    constexpr qint64 kBudgetNs = static_cast<qint64>(kPeriodFrames) * 1000000000LL / kSampleRate;
+    // Запас на сборку без оптимизации (на MixBenchmark она медленнее release примерно в шесть раз)
+    // и на загруженную машину CI; release укладывается примерно в пятую часть периода
+    constexpr qint64 kSlack = 8;
+
+    AudioEngine::PlaybackRegion region;
+    region.loop = true;
+    std::vector<std::unique_ptr<AudioEngine>> engines;
+    for (int i = 0; i < kEngines; ++i) {
+        engines.push_back(std::make_unique<AudioEngine>());
+        engines.back()->initOffline();
+        for (int deck = 0; deck < AudioEngine::kDeckCount; ++deck) {
+            AudioEngine::VoiceParams params;
+            params.effects.eqEnabled = true;
+            params.effects.eqMidGainDb = 3.0f;
+            params.tempo = deck == 0 ? 1.25f : 1.0f;
+            engines.back()->playSound(fixture(deck % 2 == 0 ? "sine440_48k_f32.wav" : "sine1k_44k1.wav"),
+                                      region, params, 0, deck);
+        }
+    }
+
+    std::vector<float> block(kPeriodFrames * kChannels);
+    std::vector<qint64> durations;
+    QElapsedTimer timer;
+    for (int period = 0; period < kPeriods; ++period) {
+        timer.start();
+        for (const std::unique_ptr<AudioEngine>& engine : engines) {
+            engine->renderOffline(block.data(), kPeriodFrames);
+        }
+        durations.push_back(timer.nsecsElapsed());
+    }
+    for (const std::unique_ptr<AudioEngine>& engine : engines) {
+        for (int deck = 0; deck < AudioEngine::kDeckCount; ++deck) {
+            QCOMPARE(engine->getPlaybackState(deck), AudioEngine::Playing);
+        }
+    }
+
+    // Медиана, а не максимум: разовый вытесненный период на общей машине — не регрессия
+    std::sort(durations.begin(), durations.end());
+    const qint64 medianNs = durations[durations.size() / 2];
+    qInfo("%d engines x %d decks: median %.3f ms, p99 %.3f ms, period %.3f ms, limit %.3f ms", kEngines,
+          AudioEngine::kDeckCount, medianNs / 1e6, durations[durations.size() * 99 / 100] / 1e6, kBudgetNs / 1e6,
+          kBudgetNs * kSlack / 1e6);
+    QVERIFY2(medianNs < kBudgetNs * kSlack,
+             qPrintable(QString("median %1 ms over the %2 ms limit").arg(medianNs / 1e6).arg(kBudgetNs * kSlack / 1e6)));
+}
+
+QTEST_GUILESS_MAIN(GoldenAudioTest)
+#include "GoldenAudioTest.moc"
@@ -0,0 +1,106 @@
+// tests/GoldenMixTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Полное сведение tests/golden/mix.osdtl против эталона tests/golden/mix.wav. Отдельно от
+// GoldenAudioTest: эталон создается целью update_golden и коммитится, а ctest запускает
+// этот тест, только если эталон есть на момент конфигурации (см. CMakeLists.txt).
+
+#include "AudioEngine.h"
+#include "OfflineRenderer.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 kChannels = AudioEngine::kEngineChannels;
+constexpr ma_uint32 kSampleRate = AudioEngine::kEngineSampleRate;
+
+QString golden(const char* name)
+{
+    return QString(OPENSOUNDDECK_TEST_DIR "/golden/") + name;
+}
+
+std::vector<float> decodeFile(const QString& filePath)
+{
+    std::vector<float> frames;
+    ma_decoder decoder;
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, kChannels, kSampleRate);
+    if (ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder) != MA_SUCCESS) {
+        return frames;
+    }
+    float buffer[1024 * kChannels];
+    ma_uint64 framesRead = 0;
+    while (ma_decoder_read_pcm_frames(&decoder, buffer, 1024, &framesRead) == MA_SUCCESS && framesRead > 0) {
+        frames.insert(frames.end(), buffer, buffer + framesRead * kChannels);
+    }
+    ma_decoder_uninit(&decoder);
+    return frames;
+}
+
+} // namespace
+
+class GoldenMixTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void timelineMatchesGolden();
+};
+
+void GoldenMixTest::timelineMatchesGolden()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    OfflineRenderer renderer;
+    QVERIFY2(renderer.loadTimeline(golden("mix.osdtl")), qPrintable(renderer.errorString()));
+    const QString outputPath = directory.filePath("mix.wav");
+    QVERIFY2(renderer.render(outputPath), qPrintable(renderer.errorString()));
+
+    // Эталон пересоздается вручную после намеренного изменения звучания: переменная задает,
+    // куда записать сведение (цель update_golden пишет в tests/golden/mix.wav)
+    const QString updatePath = qEnvironmentVariable("OPENSOUNDDECK_UPDATE_GOLDEN");
+    if (!updatePath.isEmpty()) {
+        QFile::remove(updatePath);
+        QVERIFY2(QFile::copy(outputPath, updatePath), qPrintable(QString("cannot write %1").arg(updatePath)));
+        QSKIP(qPrintable(QString("Reference written to %1").arg(updatePath)));
+    }
+    const QString referencePath = golden("mix.wav");
+    if (!QFile::exists(referencePath)) {
+        QFAIL("No tests/golden/mix.wav, regenerate it with the update_golden target");
+    }
+
+    // Допуск на разные компиляторы и FMA: на той же сборке расхождение нулевое
+    const std::vector<float> expected = decodeFile(referencePath);
+    const std::vector<float> actual = decodeFile(outputPath);
+    QCOMPARE(actual.size(), expected.size());
+    float maxError = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        maxError = std::max(maxError, std::abs(actual[i] - expected[i]));
+    }
+    QVERIFY2(maxError <= 1e-4f, qPrintable(QString("max error %1").arg(maxError)));
+}
+
+QTEST_GUILESS_MAIN(GoldenMixTest)
+#include "GoldenMixTest.moc"
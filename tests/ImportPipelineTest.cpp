@@ -0,0 +1,131 @@
+// tests/ImportPipelineTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Отбор файлов при импорте идет по заголовку, а не по расширению: переименованный
+// не-звук отбрасывается, звук с чужим расширением импортируется.
+
+#include "ImportPipeline.h"
+#include "MediaProbe.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+namespace {
+
+QString fixture(const char* name)
+{
+    return QString(OPENSOUNDDECK_TEST_DIR "/fixtures/") + name;
+}
+
+// Первая страница Ogg с одним сегментом: за таблицей сегментов сразу заголовок кодека
+QByteArray oggPage(const QByteArray& packet)
+{
+    QByteArray page("OggS");
+    page.append(22, '\0');
+    page.append('\x01');
+    page.append(static_cast<char>(packet.size()));
+    page.append(packet);
+    return page;
+}
+
+bool writeFile(const QString& filePath, const QByteArray& data)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+} // namespace
+
+class ImportPipelineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void headerSniffing_data();
+    void headerSniffing();
+    void renamedFilesAreJudgedByHeader();
+};
+
+void ImportPipelineTest::headerSniffing_data()
+{
+    QTest::addColumn<QByteArray>("head");
+    QTest::addColumn<bool>("isSupported");
+
+    QTest::newRow("wav") << QByteArray("RIFF\x24\x00\x00\x00WAVEfmt ", 16) << true;
+    QTest::newRow("rf64") << QByteArray("RF64\xFF\xFF\xFF\xFFWAVEds64", 16) << true;
+    QTest::newRow("flac") << QByteArray("fLaC\x00\x00\x00\x22", 8) << true;
+    QTest::newRow("id3") << QByteArray("ID3\x04\x00\x00", 6) << true;
+    QTest::newRow("mp3 frame") << QByteArray("\xFF\xFB\x90\x64", 4) << true;
+    QTest::newRow("ogg vorbis") << oggPage(QByteArray("\x01vorbis\x00\x00\x00\x00", 11)) << true;
+
+    QTest::newRow("avi in riff") << QByteArray("RIFF\x24\x00\x00\x00" "AVI LIST", 16) << false;
+    QTest::newRow("ogg opus") << oggPage("OpusHead\x01\x02") << false;
+    QTest::newRow("png") << QByteArray("\x89PNG\r\n\x1A\n\x00\x00\x00\x0DIHDR", 16) << false;
+    QTest::newRow("pdf") << QByteArray("%PDF-1.7\n%\xE2\xE3") << false;
+    QTest::newRow("text") << QByteArray("track list\n1. jingle\n") << false;
+    QTest::newRow("mpeg sync, bad bitrate") << QByteArray("\xFF\xFB\xF0\x64", 4) << false;
+    QTest::newRow("short") << QByteArray("RIF") << false;
+    QTest::newRow("empty") << QByteArray() << false;
+}
+
+void ImportPipelineTest::headerSniffing()
+{
+    QFETCH(QByteArray, head);
+    QFETCH(bool, isSupported);
+    QCOMPARE(MediaProbe::isSupportedHeader(head), isSupported);
+}
+
+void ImportPipelineTest::renamedFilesAreJudgedByHeader()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(QFile::copy(fixture("ramp_48k.wav"), directory.filePath("a ramp.dat")));
+    QVERIFY(writeFile(directory.filePath("b notes.wav"), "track list\n1. jingle\n2. bed\n"));
+    QVERIFY(writeFile(directory.filePath("c cover.flac"), QByteArray("\x89PNG\r\n\x1A\n\x00\x00\x00\x0DIHDR", 16)));
+    QVERIFY(writeFile(directory.filePath("d empty.mp3"), QByteArray()));
+    QVERIFY(QFile::copy(fixture("ramp_48k.flac"), directory.filePath("e ramp.flac")));
+
+    ImportPipeline pipeline;
+    QList<ImportPipeline::Item> items;
+    int imported = -1;
+    int skipped = -1;
+    connect(&pipeline, &ImportPipeline::batchReady, this,
+            [&items](const QList<ImportPipeline::Item>& batch) { items.append(batch); });
+    connect(&pipeline, &ImportPipeline::finished, this, [&imported, &skipped](int importedCount, int skippedCount, bool) {
+        imported = importedCount;
+        skipped = skippedCount;
+    });
+    pipeline.start({directory.path()}, 3);
+
+    QTRY_COMPARE(imported, 2);
+    QCOMPARE(skipped, 3);
+    QCOMPARE(items.size(), 2);
+    QCOMPARE(items[0].filePath, directory.filePath("a ramp.dat"));
+    QCOMPARE(items[1].filePath, directory.filePath("e ramp.flac"));
+    for (const ImportPipeline::Item& item : items) {
+        QCOMPARE(item.target, 3);
+        QVERIFY(item.info.isPlayable);
+        QCOMPARE(item.info.durationMillis, qint64(1000));
+    }
+}
+
+QTEST_GUILESS_MAIN(ImportPipelineTest)
+#include "ImportPipelineTest.moc"
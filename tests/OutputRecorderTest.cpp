@@ -0,0 +1,223 @@
+// tests/OutputRecorderTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Запись выхода: FLAC из FlacEncoder декодируется miniaudio обратно бит в бит, а сохранение
+// повтора, начатое до смены длины буфера, пишет то, что было в буфере на момент сохранения.
+
+#include "FlacEncoder.h"
+#include "OutputRecorder.h"
+
+#include <QMutex>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 kSampleRate = 48000;
+
+enum Signal {
+    Silence,
+    Ramp,
+    Noise,
+    FullScale,
+    SameChannels
+};
+
+std::vector<int16_t> makeSignal(Signal signal, uint32_t channels, size_t frameCount)
+{
+    std::vector<int16_t> samples(frameCount * channels);
+    uint32_t seed = 12345;
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        for (uint32_t channel = 0; channel < channels; ++channel) {
+            seed = seed * 1664525u + 1013904223u;
+            int16_t sample = 0;
+            switch (signal) {
+            case Silence:
+                break;
+            case Ramp:
+                sample = static_cast<int16_t>(frame * 7 + channel * 1000);
+                break;
+            case Noise:
+                sample = static_cast<int16_t>(seed >> 16);
+                break;
+            case FullScale:
+                sample = (frame / 3 + channel) % 2 == 0 ? INT16_MAX : INT16_MIN;
+                break;
+            case SameChannels:
+                sample = static_cast<int16_t>(frame * 31);
+                break;
+            }
+            samples[frame * channels + channel] = sample;
+        }
+    }
+    return samples;
+}
+
+// Как пишет OutputRecorder: заголовок, кадры кусками разной длины, затем заголовок заново
+std::vector<uint8_t> encodeFlac(const std::vector<int16_t>& samples, uint32_t channels)
+{
+    FlacEncoder encoder(channels, kSampleRate);
+    std::vector<uint8_t> file = encoder.header();
+    const size_t frameCount = samples.size() / channels;
+    size_t chunk = 1;
+    for (size_t frame = 0; frame < frameCount; frame += chunk, chunk = chunk * 3 + 1) {
+        chunk = std::min(chunk, frameCount - frame);
+        encoder.write(samples.data() + frame * channels, chunk, &file);
+    }
+    encoder.finish(&file);
+    const std::vector<uint8_t> header = encoder.header();
+    std::copy(header.begin(), header.end(), file.begin());
+    return file;
+}
+
+std::vector<int16_t> decodeS16(ma_decoder* pDecoder, uint32_t channels)
+{
+    std::vector<int16_t> samples;
+    int16_t buffer[1024 * 2];
+    const ma_uint64 chunkFrames = 1024 * 2 / channels;
+    ma_uint64 framesRead = 0;
+    while (ma_decoder_read_pcm_frames(pDecoder, buffer, chunkFrames, &framesRead) == MA_SUCCESS && framesRead > 0) {
+        samples.insert(samples.end(), buffer, buffer + framesRead * channels);
+    }
+    return samples;
+}
+
+} // namespace
+
+class OutputRecorderTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void flacDecodesBitExact_data();
+    void flacDecodesBitExact();
+    void replaySurvivesLengthChange_data();
+    void replaySurvivesLengthChange();
+};
+
+void OutputRecorderTest::flacDecodesBitExact_data()
+{
+    QTest::addColumn<int>("signal");
+    QTest::addColumn<uint>("channels");
+    QTest::addColumn<qulonglong>("frameCount");
+
+    // Длины: один кадр, неполный блок, ровно блок и несколько блоков с хвостом
+    const qulonglong block = FlacEncoder::kBlockFrames;
+    QTest::newRow("silence") << int(Silence) << 2u << block * 2;
+    QTest::newRow("ramp") << int(Ramp) << 2u << block * 3 + 17;
+    QTest::newRow("noise") << int(Noise) << 2u << block * 2 + 1;
+    QTest::newRow("full scale") << int(FullScale) << 2u << block;
+    QTest::newRow("same channels") << int(SameChannels) << 2u << block + 100;
+    QTest::newRow("mono noise") << int(Noise) << 1u << block - 1;
+    QTest::newRow("one frame") << int(Ramp) << 2u << qulonglong(1);
+}
+
+void OutputRecorderTest::flacDecodesBitExact()
+{
+    QFETCH(int, signal);
+    QFETCH(uint, channels);
+    QFETCH(qulonglong, frameCount);
+
+    const std::vector<int16_t> samples = makeSignal(static_cast<Signal>(signal), channels, frameCount);
+    const std::vector<uint8_t> file = encodeFlac(samples, channels);
+    QVERIFY(file.size() > FlacEncoder::kHeaderBytes);
+
+    ma_decoder decoder;
+    const ma_decoder_config config = ma_decoder_config_init(ma_format_s16, channels, kSampleRate);
+    QCOMPARE(ma_decoder_init_memory(file.data(), file.size(), &config, &decoder), MA_SUCCESS);
+    ma_uint64 lengthFrames = 0;
+    QCOMPARE(ma_decoder_get_length_in_pcm_frames(&decoder, &lengthFrames), MA_SUCCESS);
+    const std::vector<int16_t> decoded = decodeS16(&decoder, channels);
+    ma_decoder_uninit(&decoder);
+
+    QCOMPARE(lengthFrames, static_cast<ma_uint64>(frameCount)); // Длина из переписанного STREAMINFO
+    QCOMPARE(decoded.size(), samples.size());
+    QVERIFY(decoded == samples);
+}
+
+void OutputRecorderTest::replaySurvivesLengthChange_data()
+{
+    QTest::addColumn<int>("newSeconds");
+    QTest::addColumn<QString>("fileName");
+    QTest::newRow("longer, wav") << 20 << "replay.wav";
+    QTest::newRow("off, wav") << 0 << "replay.wav";
+    QTest::newRow("shorter, flac") << 5 << "replay.flac";
+}
+
+void OutputRecorderTest::replaySurvivesLengthChange()
+{
+    // Длину буфера меняют сразу после «Сохранить повтор»: файл все равно получает
+    // накопленные кадры, а новый размер вступает после сохранения
+    QFETCH(int, newSeconds);
+    QFETCH(QString, fileName);
+    constexpr ma_uint32 kChannels = 2;
+    constexpr ma_uint32 kPeriodFrames = 480;
+    constexpr ma_uint32 kFrameCount = kSampleRate * 2;
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString filePath = directory.filePath(fileName);
+
+    QMutex mutex;
+    QList<QPair<QString, bool>> saved;
+    OutputRecorder recorder(kChannels, kSampleRate);
+    recorder.setSavedCallback([&mutex, &saved](const QString& path, bool isSaved) {
+        QMutexLocker locker(&mutex);
+        saved.append(qMakePair(path, isSaved));
+    });
+    recorder.setReplaySeconds(10);
+
+    std::vector<float> frames(static_cast<size_t>(kFrameCount) * kChannels);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        frames[i] = static_cast<float>(static_cast<int>(i % 2001) - 1000) / 1024.0f;
+    }
+    for (ma_uint32 offset = 0; offset < kFrameCount; offset += kPeriodFrames) {
+        recorder.capture(frames.data() + static_cast<size_t>(offset) * kChannels, kPeriodFrames);
+    }
+    QTRY_COMPARE(recorder.stats().replayMillis, qint64(2000));
+
+    QVERIFY(recorder.saveReplay(filePath));
+    recorder.setReplaySeconds(newSeconds);
+    QCOMPARE(recorder.replaySeconds(), newSeconds);
+
+    auto savedCount = [&mutex, &saved]() {
+        QMutexLocker locker(&mutex);
+        return saved.size();
+    };
+    QTRY_COMPARE(savedCount(), qsizetype(1));
+    QCOMPARE(saved[0].first, filePath);
+    QVERIFY(saved[0].second);
+    QCOMPARE(recorder.stats().replayMillis, qint64(0)); // Новый размер применен после сохранения
+
+    std::vector<int16_t> expected(frames.size());
+    ma_pcm_f32_to_s16(expected.data(), frames.data(), frames.size(), ma_dither_mode_none);
+    ma_decoder decoder;
+    const ma_decoder_config config = ma_decoder_config_init(ma_format_s16, kChannels, kSampleRate);
+    QCOMPARE(ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    const std::vector<int16_t> decoded = decodeS16(&decoder, kChannels);
+    ma_decoder_uninit(&decoder);
+    QCOMPARE(decoded.size(), expected.size());
+    QVERIFY(decoded == expected);
+}
+
+QTEST_GUILESS_MAIN(OutputRecorderTest)
+#include "OutputRecorderTest.moc"
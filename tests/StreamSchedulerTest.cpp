@@ -0,0 +1,254 @@
+// tests/StreamSchedulerTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Декодер поверх планировщика чтения должен выдавать те же кадры, что ma_decoder_init_file:
+// файл в несколько окон, чтение подряд, перемотки и режим колбэка, который не ждет диск.
+
+#include "StreamScheduler.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr ma_uint32 kChannels = 2;
+constexpr ma_uint32 kSampleRate = 48000;
+constexpr ma_uint64 kFileFrames = kSampleRate * 20; // ~3,8 МБ — больше окна в kBlocksPerStream блоков
+constexpr ma_uint64 kChunkFrames = 1024;
+
+// Каждый кадр различим: левый канал — номер кадра, правый — его перестановка
+bool writeTestFile(const QString& filePath)
+{
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, kChannels, kSampleRate);
+    ma_encoder encoder;
+    if (ma_encoder_init_file(filePath.toStdString().c_str(), &config, &encoder) != MA_SUCCESS) {
+        return false;
+    }
+    std::vector<ma_int16> frames(kFileFrames * kChannels);
+    for (ma_uint64 i = 0; i < kFileFrames; ++i) {
+        frames[i * kChannels] = static_cast<ma_int16>(i);
+        frames[i * kChannels + 1] = static_cast<ma_int16>(i * 7919);
+    }
+    ma_uint64 framesWritten = 0;
+    const ma_result result = ma_encoder_write_pcm_frames(&encoder, frames.data(), kFileFrames, &framesWritten);
+    ma_encoder_uninit(&encoder);
+    return result == MA_SUCCESS && framesWritten == kFileFrames;
+}
+
+ma_decoder_config decoderConfig()
+{
+    return ma_decoder_config_init(ma_format_f32, kChannels, kSampleRate);
+}
+
+// Кадры с позиции декодера до конца файла
+std::vector<float> readToEnd(ma_decoder* pDecoder)
+{
+    std::vector<float> frames;
+    float buffer[kChunkFrames * kChannels];
+    ma_uint64 framesRead = 0;
+    while (ma_decoder_read_pcm_frames(pDecoder, buffer, kChunkFrames, &framesRead) == MA_SUCCESS && framesRead > 0) {
+        frames.insert(frames.end(), buffer, buffer + framesRead * kChannels);
+    }
+    return frames;
+}
+
+std::vector<float> decodeFile(const QString& filePath, ma_uint64 startFrame)
+{
+    ma_decoder decoder;
+    const ma_decoder_config config = decoderConfig();
+    if (ma_decoder_init_file(filePath.toStdString().c_str(), &config, &decoder) != MA_SUCCESS) {
+        return {};
+    }
+    ma_decoder_seek_to_pcm_frame(&decoder, startFrame);
+    std::vector<float> frames = readToEnd(&decoder);
+    ma_decoder_uninit(&decoder);
+    return frames;
+}
+
+double bytesPerSecond()
+{
+    return static_cast<double>(kSampleRate * kChannels * sizeof(ma_int16));
+}
+
+} // namespace
+
+class StreamSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void decodeMatchesFile_data();
+    void decodeMatchesFile();
+    void seekMatchesFile_data();
+    void seekMatchesFile();
+    void realtimeDecodeMatchesFile();
+    void pinnedBlockStaysLoaded();
+
+private:
+    QTemporaryDir m_directory;
+    QString m_filePath;
+};
+
+void StreamSchedulerTest::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+    m_filePath = m_directory.filePath("stream.wav");
+    QVERIFY(writeTestFile(m_filePath));
+}
+
+void StreamSchedulerTest::decodeMatchesFile_data()
+{
+    QTest::addColumn<int>("backend");
+    QTest::newRow("io_uring") << static_cast<int>(StreamScheduler::IoUring);
+    QTest::newRow("thread pool") << static_cast<int>(StreamScheduler::ThreadPool);
+}
+
+void StreamSchedulerTest::decodeMatchesFile()
+{
+    QFETCH(int, backend);
+    StreamScheduler scheduler(static_cast<StreamScheduler::Backend>(backend));
+
+    ma_decoder decoder;
+    const ma_decoder_config config = decoderConfig();
+    QCOMPARE(ma_decoder_init_vfs(scheduler.vfs(), m_filePath.toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    scheduler.startPlayback(decoder.data.vfs.file, bytesPerSecond(), false);
+    const std::vector<float> streamed = readToEnd(&decoder);
+    ma_decoder_uninit(&decoder);
+
+    const std::vector<float> reference = decodeFile(m_filePath, 0);
+    QCOMPARE(reference.size(), static_cast<size_t>(kFileFrames * kChannels));
+    QVERIFY(streamed == reference);
+}
+
+void StreamSchedulerTest::seekMatchesFile_data()
+{
+    QTest::addColumn<qulonglong>("seekFrame");
+    QTest::newRow("inside window") << qulonglong(kSampleRate / 2);
+    QTest::newRow("past window") << qulonglong(kFileFrames / 2 + 3);
+    QTest::newRow("back to start") << qulonglong(0);
+    QTest::newRow("last block") << qulonglong(kFileFrames - 100);
+}
+
+void StreamSchedulerTest::seekMatchesFile()
+{
+    QFETCH(qulonglong, seekFrame);
+    StreamScheduler scheduler;
+
+    ma_decoder decoder;
+    const ma_decoder_config config = decoderConfig();
+    QCOMPARE(ma_decoder_init_vfs(scheduler.vfs(), m_filePath.toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    scheduler.startPlayback(decoder.data.vfs.file, bytesPerSecond(), false);
+
+    // Сначала уходим в середину файла, чтобы окно было не там, куда перематываем
+    float buffer[kChunkFrames * kChannels];
+    QCOMPARE(ma_decoder_seek_to_pcm_frame(&decoder, kFileFrames / 3), MA_SUCCESS);
+    QCOMPARE(ma_decoder_read_pcm_frames(&decoder, buffer, kChunkFrames, nullptr), MA_SUCCESS);
+
+    QCOMPARE(ma_decoder_seek_to_pcm_frame(&decoder, seekFrame), MA_SUCCESS);
+    const std::vector<float> streamed = readToEnd(&decoder);
+    ma_decoder_uninit(&decoder);
+
+    QVERIFY(streamed == decodeFile(m_filePath, seekFrame));
+}
+
+void StreamSchedulerTest::realtimeDecodeMatchesFile()
+{
+    // Как читает колбэк: перед каждым куском isReady(), при промахе — ждать следующего
+    // «колбэка», а не читать с диска. Кадры те же, промахи видны в статистике
+    StreamScheduler scheduler;
+
+    ma_decoder decoder;
+    const ma_decoder_config config = decoderConfig();
+    QCOMPARE(ma_decoder_init_vfs(scheduler.vfs(), m_filePath.toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    const ma_vfs_file file = decoder.data.vfs.file;
+    scheduler.startPlayback(file, bytesPerSecond(), true);
+    QVERIFY(scheduler.isReady(file));
+
+    std::vector<float> streamed;
+    float buffer[kChunkFrames * kChannels];
+    QElapsedTimer timer;
+    timer.start();
+    while (streamed.size() < kFileFrames * kChannels && timer.elapsed() < 30000) {
+        if (!scheduler.isReady(file)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        ma_uint64 framesRead = 0;
+        ma_decoder_read_pcm_frames(&decoder, buffer, kChunkFrames, &framesRead);
+        streamed.insert(streamed.end(), buffer, buffer + framesRead * kChannels);
+    }
+    const uint64_t misses = scheduler.stats().misses;
+    ma_decoder_uninit(&decoder);
+
+    QVERIFY(streamed == decodeFile(m_filePath, 0));
+    qDebug("misses=%llu", static_cast<unsigned long long>(misses));
+}
+
+void StreamSchedulerTest::pinnedBlockStaysLoaded()
+{
+    // Петля колбэка: после конца области декодер перематывается на ее начало — закрепленный
+    // блок должен оставаться в памяти, хотя окно давно ушло дальше
+    StreamScheduler scheduler;
+
+    ma_decoder decoder;
+    const ma_decoder_config config = decoderConfig();
+    QCOMPARE(ma_decoder_init_vfs(scheduler.vfs(), m_filePath.toStdString().c_str(), &config, &decoder), MA_SUCCESS);
+    const ma_vfs_file file = decoder.data.vfs.file;
+    const ma_uint64 loopStartFrame = kSampleRate;
+    QCOMPARE(ma_decoder_seek_to_pcm_frame(&decoder, loopStartFrame), MA_SUCCESS);
+    scheduler.pinPosition(file);
+    QCOMPARE(ma_decoder_seek_to_pcm_frame(&decoder, 0), MA_SUCCESS);
+    scheduler.startPlayback(file, bytesPerSecond(), true);
+
+    float buffer[kChunkFrames * kChannels];
+    ma_uint64 framesDone = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (framesDone < kFileFrames * 3 / 4 && timer.elapsed() < 30000) {
+        if (!scheduler.isReady(file)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        ma_uint64 framesRead = 0;
+        ma_decoder_read_pcm_frames(&decoder, buffer, kChunkFrames, &framesRead);
+        framesDone += framesRead;
+    }
+    QVERIFY(framesDone >= kFileFrames * 3 / 4);
+
+    QCOMPARE(ma_decoder_seek_to_pcm_frame(&decoder, loopStartFrame), MA_SUCCESS);
+    QVERIFY(scheduler.isReady(file));
+    const uint64_t misses = scheduler.stats().misses;
+    ma_uint64 framesRead = 0;
+    QCOMPARE(ma_decoder_read_pcm_frames(&decoder, buffer, kChunkFrames, &framesRead), MA_SUCCESS);
+    ma_decoder_uninit(&decoder);
+    QCOMPARE(scheduler.stats().misses, misses);
+
+    const std::vector<float> reference = decodeFile(m_filePath, loopStartFrame);
+    QCOMPARE(framesRead, kChunkFrames);
+    QVERIFY(std::equal(buffer, buffer + kChunkFrames * kChannels, reference.begin()));
+}
+
+QTEST_GUILESS_MAIN(StreamSchedulerTest)
+#include "StreamSchedulerTest.moc"
@@ -0,0 +1,131 @@
+// tests/UsageStoreTest.cpp
+
+/*
+ * OpenSoundDeck
+ * Copyright (C) 2025 Pavel Kruhlei
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Файл статистики запусков: то, что записал save(), load() в новой сессии читает без потерь;
+// битый файл не мешает работе, а сверх лимита сохраняются самые горячие треки.
+
+#include "UsageStore.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+namespace {
+
+void compareRecords(const UsageStore::Record& actual, const UsageStore::Record& expected)
+{
+    QCOMPARE(actual.triggers, expected.triggers);
+    QCOMPARE(actual.lastTriggerMs, expected.lastTriggerMs);
+    QCOMPARE(actual.weight, expected.weight);
+    QCOMPARE(actual.weightTimeMs, expected.weightTimeMs);
+    for (int phase = 0; phase < UsageStore::kPhaseCount; ++phase) {
+        QCOMPARE(actual.phaseTriggers[phase], expected.phaseTriggers[phase]);
+    }
+}
+
+} // namespace
+
+class UsageStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void saveLoadRoundTrip();
+    void corruptFileStartsEmpty();
+    void saveKeepsHottestRecords();
+};
+
+void UsageStoreTest::saveLoadRoundTrip()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString filePath = directory.filePath("state/usage.dat"); // Папку создает save()
+    const QStringList tracks = {"/music/jingle.wav", "/music/Заставка эфира.flac", "/music/bed.mp3"};
+
+    UsageStore written;
+    QVERIFY(written.load(filePath));
+    for (int i = 0; i < 3; ++i) {
+        written.recordTrigger(tracks[0]);
+    }
+    written.recordTrigger(tracks[1]);
+    written.recordTrigger(tracks[1]);
+    written.recordTrigger(tracks[2]);
+    QVERIFY(written.isDirty());
+    QVERIFY(written.save());
+    QVERIFY(!written.isDirty());
+
+    UsageStore read;
+    QVERIFY(read.load(filePath));
+    QCOMPARE(read.recordCount(), written.recordCount());
+    for (const QString& track : tracks) {
+        compareRecords(read.record(track), written.record(track));
+    }
+    QCOMPARE(read.record(tracks[0]).triggers, 3u);
+    QCOMPARE(read.ranked(3), written.ranked(3));
+    QCOMPARE(read.ranked(1), QStringList{tracks[0]});
+}
+
+void UsageStoreTest::corruptFileStartsEmpty()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString filePath = directory.filePath("usage.dat");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not a usage file");
+    file.close();
+
+    UsageStore store;
+    QVERIFY(!store.load(filePath));
+    QCOMPARE(store.recordCount(), 0);
+
+    // Статистика начинается заново и перезаписывает битый файл
+    store.recordTrigger("/music/jingle.wav");
+    QVERIFY(store.save());
+    UsageStore read;
+    QVERIFY(read.load(filePath));
+    QCOMPARE(read.recordCount(), 1);
+}
+
+void UsageStoreTest::saveKeepsHottestRecords()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString filePath = directory.filePath("usage.dat");
+    const QString hotTrack = "/music/hot.wav";
+
+    UsageStore written;
+    QVERIFY(written.load(filePath));
+    for (int i = 0; i < UsageStore::kMaxRecords + 10; ++i) {
+        written.recordTrigger(QString("/music/%1.wav").arg(i));
+    }
+    for (int i = 0; i < 5; ++i) {
+        written.recordTrigger(hotTrack);
+    }
+    QVERIFY(written.save());
+
+    UsageStore read;
+    QVERIFY(read.load(filePath));
+    QCOMPARE(read.recordCount(), UsageStore::kMaxRecords);
+    compareRecords(read.record(hotTrack), written.record(hotTrack));
+}
+
+QTEST_GUILESS_MAIN(UsageStoreTest)
+#include "UsageStoreTest.moc"
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# tests/fixtures/generate_fixtures.py
+#
+# Generates the golden-test fixtures. Only the standard library is used, so the
+# files can be regenerated anywhere; the output is byte-identical on every run.
+# The FLAC writer stores verbatim subframes: larger than a real encoder's output,
+# but a valid stream that exercises the engine's FLAC decoder.
+
+import math
+import os
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def ramp_sample(frame):
+    # Value encodes the frame index: a decoded sample tells the exact source position
+    return frame % 32768
+
+
+def write_wav_s16(path, rate, samples):
+    data = struct.pack('<%dh' % len(samples), *samples)
+    header = struct.pack('<4sI4s4sIHHIIHH4sI', b'RIFF', 36 + len(data), b'WAVE', b'fmt ', 16,
+                         1, 1, rate, rate * 2, 2, 16, b'data', len(data))
+    with open(path, 'wb') as f:
+        f.write(header + data)
+
+
+def write_wav_f32(path, rate, samples):
+    data = struct.pack('<%df' % len(samples), *samples)
+    header = struct.pack('<4sI4s4sIHHIIHH4sI', b'RIFF', 36 + len(data), b'WAVE', b'fmt ', 16,
+                         3, 1, rate, rate * 4, 4, 32, b'data', len(data))
+    with open(path, 'wb') as f:
+        f.write(header + data)
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x8005) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def utf8_number(value):
+    if value < 0x80:
+        return bytes([value])
+    if value < 0x800:
+        return bytes([0xC0 | (value >> 6), 0x80 | (value & 0x3F)])
+    return bytes([0xE0 | (value >> 12), 0x80 | ((value >> 6) & 0x3F), 0x80 | (value & 0x3F)])
+
+
+def write_flac_s16_mono(path, rate, samples, block_size=4096):
+    rate_codes = {44100: 0b1001, 48000: 0b1010}
+    streaminfo = struct.pack('>HH', block_size, block_size)
+    streaminfo += b'\0\0\0' + b'\0\0\0'  # Frame sizes unknown
+    # 20 bits rate, 3 bits channels-1, 5 bits bps-1, 36 bits total samples
+    packed = (rate << 44) | (0 << 41) | (15 << 36) | len(samples)
+    streaminfo += packed.to_bytes(8, 'big')
+    streaminfo += b'\0' * 16  # MD5 not computed
+    out = b'fLaC' + bytes([0x80]) + len(streaminfo).to_bytes(3, 'big') + streaminfo
+
+    for number, start in enumerate(range(0, len(samples), block_size)):
+        block = samples[start:start + block_size]
+        size_code = 0b1100 if len(block) == 4096 else 0b0111
+        header = bytes([0xFF, 0xF8, (size_code << 4) | rate_codes[rate], (0b0000 << 4) | (0b100 << 1)])
+        header += utf8_number(number)
+        if size_code == 0b0111:
+            header += struct.pack('>H', len(block) - 1)
+        header += bytes([crc8(header)])
+        frame = header + bytes([0x02]) + struct.pack('>%dh' % len(block), *block)
+        out += frame + struct.pack('>H', crc16(frame))
+
+    with open(path, 'wb') as f:
+        f.write(out)
+
+
+def main():
+    ramp = [ramp_sample(i) for i in range(48000)]
+    write_wav_s16(os.path.join(HERE, 'ramp_48k.wav'), 48000, ramp)
+    write_flac_s16_mono(os.path.join(HERE, 'ramp_48k.flac'), 48000, ramp)
+
+    sine = [0.5 * math.sin(2.0 * math.pi * 440.0 * i / 48000) for i in range(24000)]
+    write_wav_f32(os.path.join(HERE, 'sine440_48k_f32.wav'), 48000, sine)
+
+    sine44 = [int(round(16384 * math.sin(2.0 * math.pi * 1000.0 * i / 44100))) for i in range(22050)]
+    write_wav_s16(os.path.join(HERE, 'sine1k_44k1.wav'), 44100, sine44)
+
+
+if __name__ == '__main__':
+    main()